@@ -3,8 +3,7 @@
 #include <ros/ros.h>
 #include <string>
 
-#define CAN_NVIDIA_TX2_BOARD_ID 0x103
-#define CAN_RUNE 0x104
+#include "cmd_frame.h"
 
 ros::Publisher can_publisher;
 ros::Subscriber cmd_vel_subscriber;
@@ -15,54 +14,14 @@ std::string rune_cmd_topic;
 
 void rune_cb(const geometry_msgs::Twist &t) {
 	static can_msgs::Frame f;
-	f.header.stamp = ros::Time::now();
-
-  f.id = CAN_RUNE;
-  f.dlc = 4;
-
-	int16_t py = (int16_t)(t.angular.y * 1000);  // convert to mm/s
-	int16_t pz = (int16_t)(t.angular.z * 1000);  // convert to mm/s
-
-	f.data[1] = (uint8_t)(py >> 8) & 0xff;
-	f.data[0] = (uint8_t)py & 0xff;
-
-	f.data[3] = (uint8_t)(pz >> 8) & 0xff;
-	f.data[2] = (uint8_t)pz & 0xff;
-
+	rune_to_frame(t, f);
 	can_publisher.publish(f);
 }
 
 void cmd_cb(const geometry_msgs::Twist &t) {
   // void cmd_cb(const geometry_msgs::Vector3 &t){
   static can_msgs::Frame f;
-
-  // ROS_INFO("Received cmd_vel py=%f vy=%f
-  // vw=%f",t.linear.x,t.linear.y,t.angular.z);
-  // f.header.frame_id="0";
-  f.header.stamp = ros::Time::now();
-
-  f.id = CAN_NVIDIA_TX2_BOARD_ID;
-  f.dlc = (16 / 8) * 4;
-
-  int16_t px = (int16_t)(t.linear.x * 1000);  // convert to mm/s
-  int16_t py = (int16_t)(t.linear.y * 1000);  // convert to mm/s
-  int16_t vy = (int16_t)(t.angular.y * 1000); // pitch, rotate by Y axis
-  int16_t vz = (int16_t)(t.angular.z * 1000); // yaw,   rotate by Z axis
-  // int16_t py = (int16_t) (t.z * 100000); // convert to mm/s
-  // int16_t vy = (int16_t) (t.x * 100000); // convert to mm/s
-  // int16_t vw = (int16_t) (t.y * 100000); // convert to mm/s
-  f.data[1] = (uint8_t)(px >> 8) & 0xff;
-  f.data[0] = (uint8_t)px & 0xff;
-
-  f.data[3] = (uint8_t)(py >> 8) & 0xff;
-  f.data[2] = (uint8_t)py & 0xff;
-
-  f.data[5] = (uint8_t)(vy >> 8) & 0xff;
-  f.data[4] = (uint8_t)vy & 0xff;
-
-  f.data[7] = (uint8_t)(vz >> 8) & 0xff;
-  f.data[6] = (uint8_t)vz & 0xff;
-
+  cmd_to_frame(t, f);
   can_publisher.publish(f);
 }
 
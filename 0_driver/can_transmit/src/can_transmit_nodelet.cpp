@@ -0,0 +1,47 @@
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+#include <ros/ros.h>
+#include <string>
+
+#include "cmd_frame.h"
+
+namespace can_transmit {
+
+// can_transmit in the nodelet manager of the controllers, so that their commands
+// are passed by pointer instead of serialized
+class CanTransmitNodelet : public nodelet::Nodelet {
+ private:
+  virtual void onInit() {
+    ros::NodeHandle &nh = getPrivateNodeHandle();
+
+    std::string cmd_topic;
+    std::string rune_cmd_topic;
+    nh.param("cmd_topic", cmd_topic, std::string("/cmd_vel"));
+    nh.param("rune_cmd_topic", rune_cmd_topic, std::string("/rune_cmd"));
+
+    can_publisher = nh.advertise<can_msgs::Frame>("/sent_messages", 10);
+    cmd_vel_subscriber = nh.subscribe(cmd_topic, 10, &CanTransmitNodelet::cmd_cb, this);
+    rune_cmd_subscriber = nh.subscribe(rune_cmd_topic, 10, &CanTransmitNodelet::rune_cb, this);
+
+    NODELET_INFO("CAN transmission started");
+  }
+
+  void rune_cb(const geometry_msgs::Twist::ConstPtr &t) {
+    can_msgs::FramePtr f(new can_msgs::Frame);
+    rune_to_frame(*t, *f);
+    can_publisher.publish(f);
+  }
+
+  void cmd_cb(const geometry_msgs::Twist::ConstPtr &t) {
+    can_msgs::FramePtr f(new can_msgs::Frame);
+    cmd_to_frame(*t, *f);
+    can_publisher.publish(f);
+  }
+
+  ros::Publisher can_publisher;
+  ros::Subscriber cmd_vel_subscriber;
+  ros::Subscriber rune_cmd_subscriber;
+};
+}
+
+PLUGINLIB_EXPORT_CLASS(can_transmit::CanTransmitNodelet, nodelet::Nodelet)
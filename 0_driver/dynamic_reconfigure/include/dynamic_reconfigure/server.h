@@ -46,6 +46,7 @@
 #define __SERVER_H__
 
 #include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/recursive_mutex.hpp>
 #include <ros/node_handle.h>
 #include <dynamic_reconfigure/ConfigDescription.h>
@@ -67,7 +68,8 @@ public:
   Server(const ros::NodeHandle &nh = ros::NodeHandle("~")) :
     node_handle_(nh),
     mutex_(own_mutex_),
-    own_mutex_warn_(true)
+    own_mutex_warn_(true),
+    snapshot_version_(0)
   {
     init();
   }
@@ -75,12 +77,14 @@ public:
   Server(boost::recursive_mutex &mutex, const ros::NodeHandle &nh = ros::NodeHandle("~")) :
     node_handle_(nh),
     mutex_(mutex),
-    own_mutex_warn_(false)
+    own_mutex_warn_(false),
+    snapshot_version_(0)
   {
     init();
   }
 
   typedef boost::function<void(ConfigType &, uint32_t level)> CallbackType;
+  typedef boost::shared_ptr<const ConfigType> ConfigConstPtr;
 
   void setCallback(const CallbackType &callback)
   {
@@ -140,6 +144,23 @@ public:
     PublishDescription();
   }
 
+  /**
+   * The last accepted config, as it was after the callback, in an immutable
+   * snapshot. Does not take the server mutex; see SnapshotReader for hot loops.
+   */
+  ConfigConstPtr getSnapshot() const
+  {
+    return boost::atomic_load(&snapshot_);
+  }
+
+  /**
+   * Incremented after each snapshot, a single atomic load.
+   */
+  uint32_t getSnapshotVersion() const
+  {
+    return __atomic_load_n(&snapshot_version_, __ATOMIC_ACQUIRE);
+  }
+
 
 private:
   ros::NodeHandle node_handle_;
@@ -154,6 +175,8 @@ private:
   boost::recursive_mutex &mutex_;
   boost::recursive_mutex own_mutex_; // Used only if an external one isn't specified.
   bool own_mutex_warn_;
+  ConfigConstPtr snapshot_;
+  uint32_t snapshot_version_;
 
 
 
@@ -231,6 +254,8 @@ private:
   {
     boost::recursive_mutex::scoped_lock lock(mutex_);
     config_ = config;
+    boost::atomic_store(&snapshot_, ConfigConstPtr(new ConfigType(config_)));
+    __atomic_fetch_add(&snapshot_version_, 1, __ATOMIC_RELEASE);
     config_.__toServer__(node_handle_);
     dynamic_reconfigure::Config msg;
     config_.__toMessage__(msg);
@@ -238,5 +263,66 @@ private:
   }
 };
 
+/**
+ * Reads the configs accepted by a Server from a hot loop, without locks.
+ *
+ * update() is a single atomic load while no new config was accepted. Once one
+ * was, it takes the new snapshot and returns the levels of the parameters that
+ * changed (all of them on the first call), so that the values derived from the
+ * config are only recomputed when their level changed:
+ *
+ *   dynamic_reconfigure::SnapshotReader<MyConfig> reader(server);
+ *   ...
+ *   if (reader.update() & GAINS_LEVEL)
+ *     gains = computeGains(reader->kp, reader->ki);
+ *
+ * A reader belongs to the thread that calls update(). The previous snapshot is
+ * released in update(), so freed there if the server is done with it.
+ */
+template <class ConfigType>
+class SnapshotReader
+{
+public:
+  SnapshotReader(const Server<ConfigType> &server) :
+    server_(server),
+    version_(server.getSnapshotVersion()),
+    config_(server.getSnapshot()),
+    pending_levels_(~0)
+  {
+  }
+
+  uint32_t update()
+  {
+    uint32_t levels = pending_levels_;
+    pending_levels_ = 0;
+    uint32_t version = server_.getSnapshotVersion();
+    if (version == version_)
+      return levels;
+
+    // the snapshot may already be newer than version, then the next update returns 0
+    version_ = version;
+    typename Server<ConfigType>::ConfigConstPtr config = server_.getSnapshot();
+    levels |= config_->__level__(*config);
+    config_ = config;
+    return levels;
+  }
+
+  const ConfigType &operator*() const
+  {
+    return *config_;
+  }
+
+  const ConfigType *operator->() const
+  {
+    return config_.get();
+  }
+
+private:
+  const Server<ConfigType> &server_;
+  uint32_t version_;
+  typename Server<ConfigType>::ConfigConstPtr config_;
+  uint32_t pending_levels_;
+};
+
 }
 #endif
@@ -0,0 +1,176 @@
+/**
+ Cost of reading the config from a 1 kHz loop while set_parameters is
+ called back to back, reading
+   - a copy made by the callback, under the mutex given to the Server
+     (held during the whole reconfigure, parameter server writes included),
+   - a copy made by the callback, under a mutex of the node,
+   - a SnapshotReader, re-deriving only on the levels that changed.
+
+ Needs a master:
+   roscore &
+   rosrun dynamic_reconfigure dynamic_reconfigure-snapshot_benchmark [seconds]
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <time.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/recursive_mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <ros/ros.h>
+#include <dynamic_reconfigure/Reconfigure.h>
+#include <dynamic_reconfigure/server.h>
+#include <dynamic_reconfigure/TestConfig.h>
+
+typedef dynamic_reconfigure_test::TestConfig Config;
+
+namespace
+{
+
+inline long long nowNs()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// What a controller derives from its config, level 1 and level 2 parameters
+struct Derived
+{
+  Derived() : gain(0), offset(0) {}
+  void fromLevel1(const Config &config) { gain = 0.5 * config.int_; }
+  void fromLevel2(const Config &config) { offset = config.double_ - config.double_no_minmax; }
+  double gain;
+  double offset;
+};
+
+boost::recursive_mutex server_mutex;
+Config server_mutex_copy;
+boost::mutex node_mutex;
+Config node_mutex_copy;
+
+void callback(Config &config, uint32_t /*level*/)
+{
+  // already under server_mutex
+  server_mutex_copy = config;
+  boost::mutex::scoped_lock lock(node_mutex);
+  node_mutex_copy = config;
+}
+
+volatile bool writing = true;
+volatile long reconfigures = 0;
+
+void writer(const std::string &service)
+{
+  dynamic_reconfigure::Reconfigure srv;
+  dynamic_reconfigure::IntParameter i;
+  dynamic_reconfigure::DoubleParameter d;
+  i.name = "int_";
+  d.name = "double_";
+  srv.request.config.ints.push_back(i);
+  srv.request.config.doubles.push_back(d);
+  for (int n = 0; writing; ++n)
+  {
+    // alternately level 1 and level 2 changes
+    if (n % 2)
+      srv.request.config.ints[0].value = n % 10;
+    else
+      srv.request.config.doubles[0].value = (n % 100) * 0.1;
+    if (ros::service::call(service, srv))
+      ++reconfigures;
+  }
+}
+
+enum Mode { SERVER_MUTEX, NODE_MUTEX, SNAPSHOT };
+
+void run(Mode mode, const char *name, dynamic_reconfigure::Server<Config> &server, double seconds)
+{
+  dynamic_reconfigure::SnapshotReader<Config> reader(server);
+  Derived derived;
+  std::vector<long long> ns;
+  long derivations = 0;
+  double sink = 0;
+
+  long start_reconfigures = reconfigures;
+  long long next = nowNs();
+  const long long end = next + (long long)(seconds * 1e9);
+  while (next < end)
+  {
+    next += 1000000;
+    timespec ts;
+    ts.tv_sec = next / 1000000000LL;
+    ts.tv_nsec = next % 1000000000LL;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+
+    long long start = nowNs();
+    if (mode == SERVER_MUTEX)
+    {
+      boost::recursive_mutex::scoped_lock lock(server_mutex);
+      derived.fromLevel1(server_mutex_copy);
+      derived.fromLevel2(server_mutex_copy);
+      derivations += 2;
+    }
+    else if (mode == NODE_MUTEX)
+    {
+      boost::mutex::scoped_lock lock(node_mutex);
+      derived.fromLevel1(node_mutex_copy);
+      derived.fromLevel2(node_mutex_copy);
+      derivations += 2;
+    }
+    else
+    {
+      uint32_t levels = reader.update();
+      if (levels & 1)
+      {
+        derived.fromLevel1(*reader);
+        ++derivations;
+      }
+      if (levels & 2)
+      {
+        derived.fromLevel2(*reader);
+        ++derivations;
+      }
+    }
+    ns.push_back(nowNs() - start);
+    sink += derived.gain + derived.offset;
+  }
+
+  std::sort(ns.begin(), ns.end());
+  size_t n = ns.size();
+  printf("%-14s %8.2f %8.2f %8.2f %10.2f %8ld %12ld\n", name, ns[n / 2] * 1e-3, ns[n * 99 / 100] * 1e-3,
+         ns[n * 999 / 1000] * 1e-3, ns.back() * 1e-3, reconfigures - start_reconfigures, derivations);
+  if (sink == 12345.6789)
+    printf("%f\n", sink);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "dynamic_reconfigure_snapshot_benchmark");
+  double seconds = (argc > 1) ? atof(argv[1]) : 10.0;
+
+  ros::NodeHandle nh("~");
+  ros::AsyncSpinner spinner(2);
+  spinner.start();
+
+  dynamic_reconfigure::Server<Config> server(server_mutex, nh);
+  server.setCallback(boost::bind(&callback, _1, _2));
+
+  boost::thread writer_thread(boost::bind(&writer, nh.resolveName("set_parameters")));
+
+  printf("1 kHz reader for %.0f s per run while set_parameters is called back to back, us per read\n", seconds);
+  printf("%-14s %8s %8s %8s %10s %8s %12s\n", "read", "p50", "p99", "p99.9", "max", "updates", "derivations");
+  run(SERVER_MUTEX, "server mutex", server, seconds);
+  run(NODE_MUTEX, "node mutex", server, seconds);
+  run(SNAPSHOT, "snapshot", server, seconds);
+
+  writing = false;
+  writer_thread.join();
+  return 0;
+}
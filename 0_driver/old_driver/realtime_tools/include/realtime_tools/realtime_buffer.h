@@ -44,16 +44,24 @@
 namespace realtime_tools
 {
 
+/*
+ * Triple buffer: the realtime side owns one copy of the data, the
+ * non-realtime side writes into another one, and the third one holds the
+ * latest complete write. Handing a buffer over is a single atomic exchange
+ * of its index with the shared one, so readFromRT never waits, and neither
+ * does writeFromNonRT on the realtime side (writers only serialize among
+ * themselves).
+ */
 template <class T>
 class RealtimeBuffer
 {
  public:
   RealtimeBuffer()
-    : new_data_available_(false)
   {
     // allocate memory
-    non_realtime_data_ = new T();
-    realtime_data_ = new T();
+    for (int i = 0; i < 3; ++i)
+      data_[i] = new T();
+    init();
   }
 
   /**
@@ -64,23 +72,23 @@ class RealtimeBuffer
   RealtimeBuffer(const T& data)
   {
     // allocate memory
-    non_realtime_data_ = new T(data);
-    realtime_data_ = new T(data);
+    for (int i = 0; i < 3; ++i)
+      data_[i] = new T(data);
+    init();
   }
 
   ~RealtimeBuffer()
   {
-    if (non_realtime_data_)
-      delete non_realtime_data_;
-    if (realtime_data_)
-      delete realtime_data_;
+    for (int i = 0; i < 3; ++i)
+      delete data_[i];
   }
 
   RealtimeBuffer(RealtimeBuffer &source)
   {
     // allocate memory
-    non_realtime_data_ = new T();
-    realtime_data_ = new T();
+    for (int i = 0; i < 3; ++i)
+      data_[i] = new T();
+    init();
 
     // Copy the data from old RTB to new RTB
     writeFromNonRT(*source.readFromNonRT());
@@ -100,69 +108,59 @@ class RealtimeBuffer
     return *this;
   }
 
+  /// Latest data written, wait-free. The pointer is valid until the next call.
   T* readFromRT()
   {
-    // Check if the data is currently being written to (is locked)
-    if (mutex_.try_lock())
+    if (__atomic_load_n(&shared_, __ATOMIC_ACQUIRE) & NEW_DATA)
     {
-      // swap pointers
-      if (new_data_available_)
-      {
-        T* tmp = realtime_data_;
-	realtime_data_ = non_realtime_data_;
-        non_realtime_data_ = tmp;
-	new_data_available_ = false;
-      }
-      mutex_.unlock();
+      // give back the buffer read so far, take the latest one
+      realtime_ = __atomic_exchange_n(&shared_, realtime_, __ATOMIC_ACQ_REL) & INDEX;
     }
-    return realtime_data_;
+    return data_[realtime_];
   }
 
+  /// Latest data written, valid until the next write
   T* readFromNonRT() const
   {
     boost::mutex::scoped_lock lock(mutex_);
-
-    if (new_data_available_)
-      return non_realtime_data_;
-    else
-      return realtime_data_;
+    return data_[latest_];
   }
 
   void writeFromNonRT(const T& data)
   {
-    // get lock
-    lock();
-
-    // copy data into non-realtime buffer
-    *non_realtime_data_ = data;
-    new_data_available_ = true;
+    boost::mutex::scoped_lock lock(mutex_);
 
-    // release lock
-    mutex_.unlock();
+    // the back buffer is neither read by the realtime side nor the latest one
+    *data_[back_] = data;
+    latest_ = back_;
+    back_ = __atomic_exchange_n(&shared_, back_ | NEW_DATA, __ATOMIC_ACQ_REL) & INDEX;
   }
 
   void initRT(const T& data)
   {
-    *non_realtime_data_ = data;    
-    *realtime_data_ = data;    
+    for (int i = 0; i < 3; ++i)
+      *data_[i] = data;
   }
 
  private:
-  void lock()
+  enum {INDEX = 3, NEW_DATA = 4};
+
+  void init()
   {
-#ifdef NON_POLLING
-    mutex_.lock();
-#else
-    while (!mutex_.try_lock())
-      usleep(500);
-#endif
+    realtime_ = 0;
+    shared_ = 1;
+    back_ = 2;
+    latest_ = 0;
   }
 
-  T* realtime_data_;
-  T* non_realtime_data_;
-  bool new_data_available_;
+  T* data_[3];
+
+  int realtime_;  // owned by the realtime side
+  int shared_;    // index of the latest complete write, with NEW_DATA until the realtime side takes it
+  int back_;      // owned by the writers
+  int latest_;    // last buffer written, for readFromNonRT
 
-  // Set as mutable so that readFromNonRT() can be performed on a const buffer
+  // Serializes the non-realtime writers; set as mutable so that readFromNonRT() can be performed on a const buffer
   mutable boost::mutex mutex_;
 
 }; // class
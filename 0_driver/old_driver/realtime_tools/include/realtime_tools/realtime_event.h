@@ -0,0 +1,93 @@
+/*
+ * A one-way wakeup from a realtime thread to a non-realtime one.
+ *
+ * notify() is wait-free and only makes a syscall (FUTEX_WAKE, which never
+ * blocks) when a thread is actually asleep in wait(). The waiting side
+ * takes a key before checking its condition, so that a notify() between the
+ * check and the sleep is never lost:
+ *
+ *   for (;;)
+ *   {
+ *     unsigned key = event.prepareWait();
+ *     if (condition)
+ *       break;
+ *     event.wait(key);
+ *   }
+ */
+
+#ifndef REALTIME_TOOLS__REALTIME_EVENT_H_
+#define REALTIME_TOOLS__REALTIME_EVENT_H_
+
+#include <climits>
+#include <ctime>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <boost/thread/thread.hpp>
+#endif
+
+namespace realtime_tools
+{
+
+class RealtimeEvent
+{
+ public:
+  RealtimeEvent()
+    : sequence_(0), waiters_(0)
+  {
+  }
+
+  /// Wake up every thread in wait(), realtime safe
+  void notify()
+  {
+    // ordered before the load of waiters_, see wait()
+    __atomic_fetch_add(&sequence_, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&waiters_, __ATOMIC_SEQ_CST) > 0)
+    {
+#ifdef __linux__
+      syscall(SYS_futex, &sequence_, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#endif
+    }
+  }
+
+  /// Key for wait(), to take before checking the condition waited for
+  unsigned prepareWait() const
+  {
+    return __atomic_load_n(&sequence_, __ATOMIC_SEQ_CST);
+  }
+
+  /// Sleep until notify() is called, unless it was since prepareWait() returned key,
+  /// or for at most timeout seconds if timeout is not negative
+  void wait(unsigned key, double timeout = -1.0)
+  {
+    __atomic_fetch_add(&waiters_, 1, __ATOMIC_SEQ_CST);
+#ifdef __linux__
+    timespec relative;
+    relative.tv_sec = static_cast<time_t>(timeout);
+    relative.tv_nsec = static_cast<long>((timeout - relative.tv_sec) * 1e9);
+    // the kernel only sleeps if sequence_ still equals key
+    syscall(SYS_futex, &sequence_, FUTEX_WAIT_PRIVATE, key, timeout < 0.0 ? NULL : &relative, NULL, 0);
+#else
+    for (double slept = 0.0; __atomic_load_n(&sequence_, __ATOMIC_SEQ_CST) == key; slept += 1e-4)
+    {
+      if (timeout >= 0.0 && slept >= timeout)
+        break;
+      boost::this_thread::sleep(boost::posix_time::microseconds(100));
+    }
+#endif
+    __atomic_fetch_sub(&waiters_, 1, __ATOMIC_SEQ_CST);
+  }
+
+ private:
+  unsigned sequence_;  // futex word, bumped by every notify()
+  int waiters_;
+
+  RealtimeEvent(const RealtimeEvent&);
+  RealtimeEvent& operator=(const RealtimeEvent&);
+};
+
+}
+
+#endif
@@ -41,12 +41,18 @@
 #include <string>
 #include <ros/node_handle.h>
 #include <boost/utility.hpp>
-#include <boost/thread/mutex.hpp>
 #include <boost/thread/thread.hpp>
-#include <boost/thread/condition.hpp>
+#include <realtime_tools/realtime_event.h>
 
 namespace realtime_tools {
 
+/*
+ * The turn and the lock of msg_ are one atomic word: trylock and
+ * unlockAndPublish are a single compare-and-swap and a single store, and
+ * the publishing thread sleeps on a RealtimeEvent until it is its turn, so
+ * that the realtime side only makes a (non-blocking) wake up syscall when
+ * the publishing thread is actually asleep.
+ */
 template <class Msg>
 class RealtimePublisher : boost::noncopyable
 {
@@ -63,13 +69,13 @@ public:
    * \param latched . optional argument (defaults to false) to specify is publisher is latched or not
    */
   RealtimePublisher(const ros::NodeHandle &node, const std::string &topic, int queue_size, bool latched=false)
-    : topic_(topic), node_(node), is_running_(false), keep_running_(false), turn_(REALTIME)
+    : topic_(topic), node_(node), is_running_(false), keep_running_(false), state_(REALTIME)
   {
     construct(queue_size, latched);
   }
 
   RealtimePublisher()
-    : is_running_(false), keep_running_(false), turn_(REALTIME)
+    : is_running_(false), keep_running_(false), state_(REALTIME)
   {
   }
 
@@ -77,8 +83,8 @@ public:
   ~RealtimePublisher()
   {
     stop();
-    while (is_running())
-      usleep(100);
+    if (thread_.joinable())
+      thread_.join();
 
     publisher_.shutdown();
   }
@@ -93,10 +99,8 @@ public:
   /// Stop the realtime publisher from sending out more ROS messages
   void stop()
   {
-    keep_running_ = false;
-#ifdef NON_POLLING
-    updated_cond_.notify_one();  // So the publishing loop can exit
-#endif
+    __atomic_store_n(&keep_running_, false, __ATOMIC_SEQ_CST);
+    updated_.notify();  // So the publishing loop can exit
   }
 
   /**  \brief Try to get the data lock from realtime
@@ -104,25 +108,13 @@ public:
    * To publish data from the realtime loop, you need to run trylock to
    * attempt to get unique access to the msg_ variable. Trylock returns
    * true if the lock was aquired, and false if it failed to get the lock.
+   * Wait-free: it fails while the previous message is not copied out yet.
    */
   bool trylock()
   {
-    if (msg_mutex_.try_lock())
-    {
-      if (turn_ == REALTIME)
-      {
-        return true;
-      }
-      else
-      {
-        msg_mutex_.unlock();
-        return false;
-      }
-    }
-    else
-    {
-      return false;
-    }
+    int expected = REALTIME;
+    return __atomic_compare_exchange_n(&state_, &expected, REALTIME | LOCKED, false,
+                                       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
   }
 
   /**  \brief Unlock the msg_ variable
@@ -133,28 +125,27 @@ public:
    */
   void unlockAndPublish()
   {
-    turn_ = NON_REALTIME;
-    msg_mutex_.unlock();
-#ifdef NON_POLLING
-    updated_cond_.notify_one();
-#endif
+    __atomic_store_n(&state_, NON_REALTIME, __ATOMIC_RELEASE);
+    updated_.notify();
   }
 
   /**  \brief Get the data lock form non-realtime
    *
-   * To publish data from the realtime loop, you need to run trylock to
-   * attempt to get unique access to the msg_ variable. Trylock returns
-   * true if the lock was aquired, and false if it failed to get the lock.
+   * Blocks (without polling) until msg_ is not locked, whoever's turn it
+   * is, like a mutex. Not for the realtime thread.
    */
   void lock()
   {
-#ifdef NON_POLLING
-    msg_mutex_.lock();
-#else
-    // never actually block on the lock
-    while (!msg_mutex_.try_lock())
-      usleep(200);
-#endif
+    for (;;)
+    {
+      unsigned key = updated_.prepareWait();
+      int state = __atomic_load_n(&state_, __ATOMIC_RELAXED);
+      if (!(state & LOCKED) &&
+          __atomic_compare_exchange_n(&state_, &state, state | LOCKED, false,
+                                      __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return;
+      updated_.wait(key);
+    }
   }
 
   /**  \brief Unlocks the data without publishing anything
@@ -162,7 +153,8 @@ public:
    */
   void unlock()
   {
-    msg_mutex_.unlock();
+    __atomic_fetch_and(&state_, ~LOCKED, __ATOMIC_RELEASE);
+    updated_.notify();
   }
 
 private:
@@ -174,57 +166,60 @@ private:
   }
 
 
-  bool is_running() const { return is_running_; }
+  bool is_running() const { return __atomic_load_n(&is_running_, __ATOMIC_SEQ_CST); }
 
-  void publishingLoop()
+  /// Take msg_ once it is handed over by unlockAndPublish, false when stopped
+  bool waitForTurn()
   {
-    is_running_ = true;
-    turn_ = REALTIME;
-
-    while (keep_running_)
+    for (;;)
     {
-      Msg outgoing;
+      unsigned key = updated_.prepareWait();
+      if (!__atomic_load_n(&keep_running_, __ATOMIC_SEQ_CST))
+        return false;
 
-      // Locks msg_ and copies it
-      lock();
-      while (turn_ != NON_REALTIME && keep_running_)
+      // spin a little first, at high rates the next message is often there already
+      for (int i = 0; i < SPIN; ++i)
       {
-#ifdef NON_POLLING
-	updated_cond_.wait(lock);
-#else
-	unlock();
-	usleep(500);
-	lock();
-#endif
+        int expected = NON_REALTIME;
+        if (__atomic_compare_exchange_n(&state_, &expected, NON_REALTIME | LOCKED, false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+          return true;
       }
-      outgoing = msg_;
-      turn_ = REALTIME;
+      updated_.wait(key);
+    }
+  }
+
+  void publishingLoop()
+  {
+    __atomic_store_n(&is_running_, true, __ATOMIC_SEQ_CST);
 
-      unlock();
+    Msg outgoing;
+    while (waitForTurn())
+    {
+      // Copies msg_ and gives it back to the realtime side
+      outgoing = msg_;
+      __atomic_store_n(&state_, REALTIME, __ATOMIC_RELEASE);
+      updated_.notify();  // for lock()
 
       // Sends the outgoing message
-      if (keep_running_)
-        publisher_.publish(outgoing);
+      publisher_.publish(outgoing);
     }
-    is_running_ = false;
+    __atomic_store_n(&is_running_, false, __ATOMIC_SEQ_CST);
   }
 
   std::string topic_;
   ros::NodeHandle node_;
   ros::Publisher publisher_;
-  volatile bool is_running_;
-  volatile bool keep_running_;
+  bool is_running_;
+  bool keep_running_;
 
   boost::thread thread_;
 
-  boost::mutex msg_mutex_;  // Protects msg_
-
-#ifdef NON_POLLING
-  boost::condition_variable updated_cond_;
-#endif
+  enum {REALTIME = 0, NON_REALTIME = 2, LOCKED = 1};  // turn, with the lock bit
+  enum {SPIN = 100};
+  int state_;  // Who's turn is it to use msg_, and is it locked?
 
-  enum {REALTIME, NON_REALTIME};
-  int turn_;  // Who's turn is it to use msg_?
+  RealtimeEvent updated_;  // state_ or keep_running_ changed
 };
 
 }
@@ -0,0 +1,363 @@
+/*
+ * Latency histograms of RealtimeBuffer and RealtimePublisher under load,
+ * against the former mutex + usleep polling implementations.
+ *
+ *   buffer:    a realtime thread at 1 kHz reads what a non-realtime thread
+ *              writes at 5 kHz; cost of readFromRT / writeFromNonRT, and
+ *              age of the data read
+ *   publisher: a realtime thread at 1 kHz publishes its wall time; cost of
+ *              trylock + unlockAndPublish, and latency to a subscriber of
+ *              the same process
+ *
+ * The publisher part advertises a topic, so a master must be running:
+ *   roscore &
+ *   rosrun realtime_tools realtime_tools_benchmark [seconds] [load threads]
+ * The load threads (default: one per core) spin on the cpu all along.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <pthread.h>
+#include <time.h>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <ros/ros.h>
+#include <rosgraph_msgs/Clock.h>
+#include <realtime_tools/realtime_buffer.h>
+#include <realtime_tools/realtime_publisher.h>
+
+namespace
+{
+
+inline long long nowNs()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/// log2 histogram, from 64 ns to 64 ms
+class Histogram
+{
+public:
+  Histogram() : buckets_(21, 0) { samples_.reserve(1 << 20); }
+
+  void add(long long ns)
+  {
+    int b = 0;
+    while (b < 20 && (64LL << b) <= ns)
+      ++b;
+    ++buckets_[b];
+    samples_.push_back(ns);
+  }
+
+  void print(const char* name)
+  {
+    if (samples_.empty())
+    {
+      printf("%s: no sample\n", name);
+      return;
+    }
+    std::sort(samples_.begin(), samples_.end());
+    size_t n = samples_.size();
+    printf("%s: %zu samples, p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n", name, n,
+           samples_[n / 2] * 1e-3, samples_[n * 99 / 100] * 1e-3, samples_[n * 999 / 1000] * 1e-3,
+           samples_.back() * 1e-3);
+    for (size_t b = 0; b < buckets_.size(); ++b)
+    {
+      if (!buckets_[b])
+        continue;
+      printf("  %s%8.2f us %8ld ", b == 0 ? "<" : ">=", (b == 0 ? 64 : (32LL << b)) * 1e-3, buckets_[b]);
+      for (int i = 0; i < 50 * buckets_[b] / (long)n; ++i)
+        printf("#");
+      printf("\n");
+    }
+  }
+
+private:
+  std::vector<long> buckets_;
+  std::vector<long long> samples_;
+};
+
+/// sleep until an absolute CLOCK_MONOTONIC time, for the realtime loops
+inline void sleepUntil(long long ns)
+{
+  timespec ts;
+  ts.tv_sec = ns / 1000000000LL;
+  ts.tv_nsec = ns % 1000000000LL;
+  clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+/// SCHED_FIFO for the scope of a realtime loop, as a ros_control loop runs;
+/// the threads it talks to are started before, so they do not inherit it
+class RealtimeScope
+{
+public:
+  RealtimeScope()
+  {
+    pthread_getschedparam(pthread_self(), &policy_, &param_);
+    sched_param fifo;
+    fifo.sched_priority = 80;
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &fifo) != 0)
+      printf("(could not switch to SCHED_FIFO, the realtime loop runs SCHED_OTHER)\n");
+  }
+  ~RealtimeScope() { pthread_setschedparam(pthread_self(), policy_, &param_); }
+
+private:
+  int policy_;
+  sched_param param_;
+};
+
+volatile bool loaded = true;
+
+void load()
+{
+  volatile double x = 1.0;
+  while (loaded)
+    x = x * 1.0000001 + 1e-9;
+}
+
+// The implementations before the wait-free ones
+namespace polling
+{
+
+template <class T>
+class RealtimeBuffer
+{
+public:
+  RealtimeBuffer() : realtime_data_(new T()), non_realtime_data_(new T()), new_data_available_(false) {}
+  ~RealtimeBuffer() { delete realtime_data_; delete non_realtime_data_; }
+
+  T* readFromRT()
+  {
+    if (mutex_.try_lock())
+    {
+      if (new_data_available_)
+      {
+        std::swap(realtime_data_, non_realtime_data_);
+        new_data_available_ = false;
+      }
+      mutex_.unlock();
+    }
+    return realtime_data_;
+  }
+
+  void writeFromNonRT(const T& data)
+  {
+    while (!mutex_.try_lock())
+      usleep(500);
+    *non_realtime_data_ = data;
+    new_data_available_ = true;
+    mutex_.unlock();
+  }
+
+private:
+  T* realtime_data_;
+  T* non_realtime_data_;
+  bool new_data_available_;
+  boost::mutex mutex_;
+};
+
+template <class Msg>
+class RealtimePublisher : boost::noncopyable
+{
+public:
+  Msg msg_;
+
+  RealtimePublisher(const ros::NodeHandle& node, const std::string& topic, int queue_size)
+    : keep_running_(true), turn_(REALTIME)
+  {
+    publisher_ = ros::NodeHandle(node).advertise<Msg>(topic, queue_size);
+    thread_ = boost::thread(&RealtimePublisher::publishingLoop, this);
+  }
+  ~RealtimePublisher() { keep_running_ = false; thread_.join(); publisher_.shutdown(); }
+
+  bool trylock()
+  {
+    if (!msg_mutex_.try_lock())
+      return false;
+    if (turn_ == REALTIME)
+      return true;
+    msg_mutex_.unlock();
+    return false;
+  }
+  void unlockAndPublish() { turn_ = NON_REALTIME; msg_mutex_.unlock(); }
+
+private:
+  void lock()
+  {
+    while (!msg_mutex_.try_lock())
+      usleep(200);
+  }
+  void publishingLoop()
+  {
+    while (keep_running_)
+    {
+      Msg outgoing;
+      lock();
+      while (turn_ != NON_REALTIME && keep_running_)
+      {
+        msg_mutex_.unlock();
+        usleep(500);
+        lock();
+      }
+      outgoing = msg_;
+      turn_ = REALTIME;
+      msg_mutex_.unlock();
+      if (keep_running_)
+        publisher_.publish(outgoing);
+    }
+  }
+
+  ros::Publisher publisher_;
+  volatile bool keep_running_;
+  boost::thread thread_;
+  boost::mutex msg_mutex_;
+  enum {REALTIME, NON_REALTIME};
+  volatile int turn_;
+};
+
+}
+
+struct Sample
+{
+  long long stamp;
+  double payload[30];
+};
+
+// the non-realtime side of the buffer, at 5 kHz
+template <class Buffer>
+struct Writer
+{
+  Writer(Buffer& buffer, Histogram& write_ns, volatile bool& running)
+    : buffer(buffer), write_ns(write_ns), running(running) {}
+  void operator()()
+  {
+    Sample s;
+    while (running)
+    {
+      s.stamp = nowNs();
+      buffer.writeFromNonRT(s);
+      write_ns.add(nowNs() - s.stamp);
+      usleep(200);
+    }
+  }
+  Buffer& buffer;
+  Histogram& write_ns;
+  volatile bool& running;
+};
+
+template <class Buffer>
+void benchmarkBuffer(const char* name, double seconds)
+{
+  Buffer buffer;
+  Histogram read_ns, write_ns, age_ns;
+  volatile bool running = true;
+  boost::thread writer_thread(Writer<Buffer>(buffer, write_ns, running));
+
+  {
+    RealtimeScope rt;
+    long long next = nowNs();
+    long long end = next + (long long)(seconds * 1e9);
+    while (next < end)
+    {
+      next += 1000000;
+      sleepUntil(next);
+      long long start = nowNs();
+      const Sample* s = buffer.readFromRT();
+      long long stop = nowNs();
+      read_ns.add(stop - start);
+      if (s->stamp)
+        age_ns.add(stop - s->stamp);
+    }
+  }
+  running = false;
+  writer_thread.join();
+
+  printf("\n== %s RealtimeBuffer\n", name);
+  read_ns.print("readFromRT");
+  write_ns.print("writeFromNonRT");
+  age_ns.print("age of the data read");
+}
+
+// the subscriber, the stamp is the CLOCK_MONOTONIC time of the publish
+struct Receiver
+{
+  void callback(const rosgraph_msgs::ClockConstPtr& msg)
+  {
+    latency_ns.add(nowNs() - (msg->clock.sec * 1000000000LL + msg->clock.nsec));
+  }
+  Histogram latency_ns;
+};
+
+template <class Publisher>
+void benchmarkPublisher(const char* name, double seconds)
+{
+  ros::NodeHandle nh("realtime_tools_benchmark");
+  Histogram rt_ns;
+  Receiver receiver;
+  long dropped = 0;
+  ros::Subscriber sub = nh.subscribe(name, 1000, &Receiver::callback, &receiver,
+                                     ros::TransportHints().tcpNoDelay());
+  {
+    Publisher pub(nh, name, 1000);
+    ros::WallDuration(1.0).sleep();  // for the subscriber to connect
+
+    RealtimeScope rt;
+    long long next = nowNs();
+    long long end = next + (long long)(seconds * 1e9);
+    while (next < end)
+    {
+      next += 1000000;
+      sleepUntil(next);
+      long long start = nowNs();
+      if (pub.trylock())
+      {
+        pub.msg_.clock.sec = start / 1000000000LL;
+        pub.msg_.clock.nsec = start % 1000000000LL;
+        pub.unlockAndPublish();
+        rt_ns.add(nowNs() - start);
+      }
+      else
+      {
+        ++dropped;
+      }
+    }
+    ros::WallDuration(0.5).sleep();
+  }
+  sub.shutdown();
+
+  printf("\n== %s RealtimePublisher, %ld messages not published (previous one not sent yet)\n", name, dropped);
+  rt_ns.print("trylock + unlockAndPublish");
+  receiver.latency_ns.print("latency to the subscriber");
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "realtime_tools_benchmark");
+  double seconds = (argc > 1) ? atof(argv[1]) : 10.0;
+  int load_threads = (argc > 2) ? atoi(argv[2]) : (int)boost::thread::hardware_concurrency();
+
+  ros::AsyncSpinner spinner(1);
+  spinner.start();
+
+  boost::thread_group load_group;
+  for (int i = 0; i < load_threads; ++i)
+    load_group.create_thread(load);
+  printf("%.0f s per run, %d load threads\n", seconds, load_threads);
+
+  benchmarkBuffer<polling::RealtimeBuffer<Sample> >("polling", seconds);
+  benchmarkBuffer<realtime_tools::RealtimeBuffer<Sample> >("wait_free", seconds);
+  benchmarkPublisher<polling::RealtimePublisher<rosgraph_msgs::Clock> >("polling", seconds);
+  benchmarkPublisher<realtime_tools::RealtimePublisher<rosgraph_msgs::Clock> >("wait_free", seconds);
+
+  loaded = false;
+  load_group.join_all();
+  return 0;
+}
@@ -49,6 +49,7 @@
 #include <controller_manager_msgs/LoadController.h>
 #include <controller_manager_msgs/UnloadController.h>
 #include <controller_manager_msgs/SwitchController.h>
+#include <realtime_tools/realtime_event.h>
 #include <boost/thread/condition.hpp>
 #include <boost/thread/recursive_mutex.hpp>
 #include <controller_manager/controller_loader_interface.h>
@@ -82,7 +83,9 @@ public:
   /** \brief Update all active controllers.
    *
    * When controllers are started or stopped (or switched), those calls are
-   * made in this function.
+   * made in this function, from the switch prepared by \ref
+   * switchControllerAsync. The update of every running controller is timed
+   * for the diagnostics.
    *
    * \param time The current time
    * \param period The change in time since the last call to \ref update
@@ -140,6 +143,26 @@ public:
                         const std::vector<std::string>& stop_controllers,
                         const int strictness);
 
+  /** \brief Switch multiple controllers without waiting for the real-time loop.
+   *
+   * Checks the request and prepares the hardware as \ref switchController
+   * does, then hands the switch over to \ref update, which applies it at the
+   * end of its next cycle.
+   *
+   * \returns False if the request is rejected, or if the previous switch was
+   * not applied yet
+   */
+  bool switchControllerAsync(const std::vector<std::string>& start_controllers,
+                             const std::vector<std::string>& stop_controllers,
+                             int strictness);
+
+  /** \brief Wait for \ref update to apply the switch requested last.
+   *
+   * \param timeout In seconds, negative to wait as long as ROS is ok
+   * \returns True once no switch is pending, false on timeout or shutdown
+   */
+  bool waitForSwitch(double timeout=-1.0);
+
   /** \brief Get a controller by name.
    *
    * \param name The name of a controller
@@ -166,6 +189,10 @@ public:
 
 private:
   void getControllerNames(std::vector<std::string> &v);
+  /// Wait until the real-time loop no longer uses the controllers list \c list
+  bool waitForRealtimeList(int list);
+
+  void publishDiagnostics(const ros::WallTimerEvent&);
 
   hardware_interface::RobotHW* robot_hw_;
 
@@ -175,11 +202,17 @@ private:
   std::list<LoaderPtr> controller_loaders_;
 
   /** \name Controller Switching
+   * The switch is prepared in the non-real-time thread while \ref
+   * switch_state_ is \c SWITCH_IDLE, and belongs to the real-time thread once
+   * it is \c SWITCH_PENDING.
    *\{*/
   std::vector<controller_interface::ControllerBase*> start_request_, stop_request_;
   std::list<hardware_interface::ControllerInfo> switch_start_list_, switch_stop_list_;
-  bool please_switch_;
+  enum {SWITCH_IDLE, SWITCH_PENDING};
+  int switch_state_;
   int switch_strictness_;
+  /// Signalled by the real-time thread when it applied a switch or took a new controllers list
+  realtime_tools::RealtimeEvent realtime_event_;
   /*\}*/
 
   /** \name Controllers List
@@ -196,6 +229,16 @@ private:
   int used_by_realtime_;
   /*\}*/
 
+  /** \name Diagnostics
+   *\{*/
+  /// Cycle period given to \ref update, in ns
+  boost::uint64_t period_ns_;
+  /// Time the real-time thread took to apply the last switch, in ns
+  boost::uint64_t switch_ns_;
+  ros::Publisher diagnostics_pub_;
+  ros::WallTimer diagnostics_timer_;
+  /*\}*/
+
 
   /** \name ROS Service API
    *\{*/
@@ -39,12 +39,41 @@
 #include <string>
 #include <vector>
 #include <controller_interface/controller_base.h>
+#include <boost/cstdint.hpp>
 #include <boost/shared_ptr.hpp>
 #include <hardware_interface/controller_info.h>
 
 namespace controller_manager
 {
 
+/** \brief Execution time of the updates of a controller
+ *
+ * Written by the real-time loop and read by the diagnostics, with atomic
+ * accesses only. The \c reported_ fields belong to the diagnostics.
+ */
+struct ControllerStatistics
+{
+  ControllerStatistics()
+    : updates(0), total_ns(0), max_ns(0), last_ns(0), reported_updates(0), reported_total_ns(0)
+  {}
+
+  /// Must be realtime safe.
+  void add(boost::uint64_t ns)
+  {
+    __atomic_store_n(&last_ns, ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&total_ns, total_ns + ns, __ATOMIC_RELAXED);
+    if (ns > __atomic_load_n(&max_ns, __ATOMIC_RELAXED))
+      __atomic_store_n(&max_ns, ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&updates, updates + 1, __ATOMIC_RELEASE);
+  }
+
+  boost::uint64_t updates;
+  boost::uint64_t total_ns;
+  boost::uint64_t max_ns;  ///< since the last report, reset by the diagnostics
+  boost::uint64_t last_ns;
+  boost::uint64_t reported_updates, reported_total_ns;
+};
+
 /** \brief Controller Specification
  *
  * This struct contains both a pointer to a given controller, \ref c, as well
@@ -55,6 +84,8 @@ struct ControllerSpec
 {
   hardware_interface::ControllerInfo info;
   boost::shared_ptr<controller_interface::ControllerBase> c;
+  /// Shared by the copies of the spec in both controllers lists
+  boost::shared_ptr<ControllerStatistics> stats;
 };
 
 }
@@ -33,12 +33,36 @@
 #include <boost/thread/thread.hpp>
 #include <boost/thread/condition.hpp>
 #include <sstream>
+#include <time.h>
 #include <ros/console.h>
 #include <controller_manager/controller_loader.h>
 #include <controller_manager_msgs/ControllerState.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
 
 namespace controller_manager{
 
+namespace
+{
+
+inline boost::uint64_t monotonicNs()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<boost::uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+void addValue(diagnostic_msgs::DiagnosticStatus& status, const std::string& key, double value)
+{
+  std::ostringstream ss;
+  ss << value;
+  diagnostic_msgs::KeyValue kv;
+  kv.key = key;
+  kv.value = ss.str();
+  status.values.push_back(kv);
+}
+
+}
+
 
 ControllerManager::ControllerManager(hardware_interface::RobotHW *robot_hw, const ros::NodeHandle& nh) :
   robot_hw_(robot_hw),
@@ -46,14 +70,26 @@ ControllerManager::ControllerManager(hardware_interface::RobotHW *robot_hw, cons
   cm_node_(nh, "controller_manager"),
   start_request_(0),
   stop_request_(0),
-  please_switch_(false),
+  switch_state_(SWITCH_IDLE),
   current_controllers_list_(0),
-  used_by_realtime_(-1)
+  used_by_realtime_(-1),
+  period_ns_(0),
+  switch_ns_(0)
 {
   // create controller loader
   controller_loaders_.push_back( LoaderPtr(new ControllerLoader<controller_interface::ControllerBase>("controller_interface",
                                                                                                       "controller_interface::ControllerBase") ) );
 
+  // Publish the update times of the controllers
+  double diagnostics_period;
+  cm_node_.param("diagnostics_period", diagnostics_period, 1.0);
+  if (diagnostics_period > 0.0)
+  {
+    diagnostics_pub_ = cm_node_.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 1);
+    diagnostics_timer_ = cm_node_.createWallTimer(ros::WallDuration(diagnostics_period),
+                                                  &ControllerManager::publishDiagnostics, this);
+  }
+
   // Advertise services (this should be the last thing we do in init)
   srv_list_controllers_ = cm_node_.advertiseService("list_controllers", &ControllerManager::listControllersSrv, this);
   srv_list_controller_types_ = cm_node_.advertiseService("list_controller_types", &ControllerManager::listControllerTypesSrv, this);
@@ -73,8 +109,15 @@ ControllerManager::~ControllerManager()
 // Must be realtime safe.
 void ControllerManager::update(const ros::Time& time, const ros::Duration& period, bool reset_controllers)
 {
-  used_by_realtime_ = current_controllers_list_;
-  std::vector<ControllerSpec> &controllers = controllers_lists_[used_by_realtime_];
+  // Take the current controllers list, and tell loadController/unloadController when it changed
+  const int current = __atomic_load_n(&current_controllers_list_, __ATOMIC_ACQUIRE);
+  if (current != used_by_realtime_)
+  {
+    __atomic_store_n(&used_by_realtime_, current, __ATOMIC_RELEASE);
+    realtime_event_.notify();
+  }
+  std::vector<ControllerSpec> &controllers = controllers_lists_[current];
+  __atomic_store_n(&period_ns_, static_cast<boost::uint64_t>(period.toNSec()), __ATOMIC_RELAXED);
 
   // Restart all running controllers if motors are re-enabled
   if (reset_controllers){
@@ -87,13 +130,20 @@ void ControllerManager::update(const ros::Time& time, const ros::Duration& perio
   }
 
 
-  // Update all controllers
-  for (size_t i=0; i<controllers.size(); i++)
+  // Update all controllers, timing the running ones
+  for (size_t i=0; i<controllers.size(); i++){
+    const bool running = controllers[i].c->isRunning();
+    const boost::uint64_t start = monotonicNs();
     controllers[i].c->updateRequest(time, period);
+    if (running && controllers[i].stats)
+      controllers[i].stats->add(monotonicNs() - start);
+  }
 
-  // there are controllers to start/stop
-  if (please_switch_)
+  // there are controllers to start/stop, prepared by switchControllerAsync
+  if (__atomic_load_n(&switch_state_, __ATOMIC_ACQUIRE) == SWITCH_PENDING)
   {
+    const boost::uint64_t switch_start = monotonicNs();
+
     // switch hardware interfaces (if any)
     robot_hw_->doSwitch(switch_start_list_, switch_stop_list_);
 
@@ -107,7 +157,10 @@ void ControllerManager::update(const ros::Time& time, const ros::Duration& perio
       if (!start_request_[i]->startRequest(time))
         ROS_FATAL("Failed to start controller in realtime loop. This should never happen.");
 
-    please_switch_ = false;
+    // hand the switch back to the non-realtime side, waking switchController
+    __atomic_store_n(&switch_ns_, monotonicNs() - switch_start, __ATOMIC_RELAXED);
+    __atomic_store_n(&switch_state_, SWITCH_IDLE, __ATOMIC_RELEASE);
+    realtime_event_.notify();
   }
 }
 
@@ -136,6 +189,20 @@ void ControllerManager::getControllerNames(std::vector<std::string> &names)
   }
 }
 
+bool ControllerManager::waitForRealtimeList(int list)
+{
+  for (;;)
+  {
+    unsigned key = realtime_event_.prepareWait();
+    if (__atomic_load_n(&used_by_realtime_, __ATOMIC_ACQUIRE) != list)
+      return true;
+    if (!ros::ok())
+      return false;
+    // the timeout only bounds the time to notice a shutdown
+    realtime_event_.wait(key, 0.1);
+  }
+}
+
 
 bool ControllerManager::loadController(const std::string& name)
 {
@@ -146,11 +213,8 @@ bool ControllerManager::loadController(const std::string& name)
 
   // get reference to controller list
   int free_controllers_list = (current_controllers_list_ + 1) % 2;
-  while (ros::ok() && free_controllers_list == used_by_realtime_){
-    if (!ros::ok())
-      return false;
-    usleep(200);
-  }
+  if (!waitForRealtimeList(free_controllers_list))
+    return false;
   std::vector<ControllerSpec>
     &from = controllers_lists_[current_controllers_list_],
     &to = controllers_lists_[free_controllers_list];
@@ -254,15 +318,13 @@ bool ControllerManager::loadController(const std::string& name)
   to.back().info.name = name;
   to.back().info.claimed_resources = claimed_resources;
   to.back().c = c;
+  to.back().stats.reset(new ControllerStatistics);
 
   // Destroys the old controllers list when the realtime thread is finished with it.
   int former_current_controllers_list_ = current_controllers_list_;
-  current_controllers_list_ = free_controllers_list;
-  while (ros::ok() && used_by_realtime_ == former_current_controllers_list_){
-    if (!ros::ok())
-      return false;
-    usleep(200);
-  }
+  __atomic_store_n(&current_controllers_list_, free_controllers_list, __ATOMIC_RELEASE);
+  if (!waitForRealtimeList(former_current_controllers_list_))
+    return false;
   from.clear();
 
   ROS_DEBUG("Successfully load controller '%s'", name.c_str());
@@ -279,13 +341,14 @@ bool ControllerManager::unloadController(const std::string &name)
   // lock the controllers
   boost::recursive_mutex::scoped_lock guard(controllers_lock_);
 
+  // a pending switch may still start or stop this controller
+  if (!waitForSwitch())
+    return false;
+
   // get reference to controller list
   int free_controllers_list = (current_controllers_list_ + 1) % 2;
-  while (ros::ok() && free_controllers_list == used_by_realtime_){
-    if (!ros::ok())
-      return false;
-    usleep(200);
-  }
+  if (!waitForRealtimeList(free_controllers_list))
+    return false;
   std::vector<ControllerSpec>
     &from = controllers_lists_[current_controllers_list_],
     &to = controllers_lists_[free_controllers_list];
@@ -320,12 +383,9 @@ bool ControllerManager::unloadController(const std::string &name)
   // Destroys the old controllers list when the realtime thread is finished with it.
   ROS_DEBUG("Realtime switches over to new controller list");
   int former_current_controllers_list_ = current_controllers_list_;
-  current_controllers_list_ = free_controllers_list;
-  while (ros::ok() && used_by_realtime_ == former_current_controllers_list_){
-    if (!ros::ok())
-      return false;
-    usleep(200);
-  }
+  __atomic_store_n(&current_controllers_list_, free_controllers_list, __ATOMIC_RELEASE);
+  if (!waitForRealtimeList(former_current_controllers_list_))
+    return false;
   ROS_DEBUG("Destruct controller");
   from.clear();
   ROS_DEBUG("Destruct controller finished");
@@ -340,9 +400,23 @@ bool ControllerManager::switchController(const std::vector<std::string>& start_c
                                          const std::vector<std::string>& stop_controllers,
                                          int strictness)
 {
-  if (!stop_request_.empty() || !start_request_.empty())
-    ROS_FATAL("The internal stop and start request lists are not empty at the beginning of the swithController() call. This should not happen.");
+  if (!switchControllerAsync(start_controllers, stop_controllers, strictness))
+    return false;
+
+  // wait until switch is finished
+  if (!waitForSwitch())
+    return false;
+
+  ROS_DEBUG("Successfully switched controllers");
+  return true;
+}
+
+
 
+bool ControllerManager::switchControllerAsync(const std::vector<std::string>& start_controllers,
+                                              const std::vector<std::string>& stop_controllers,
+                                              int strictness)
+{
   if (strictness == 0){
     ROS_WARN("Controller Manager: To switch controllers you need to specify a strictness level of controller_manager_msgs::SwitchController::STRICT (%d) or ::BEST_EFFORT (%d). Defaulting to ::BEST_EFFORT.",
              controller_manager_msgs::SwitchController::Request::STRICT,
@@ -359,6 +433,14 @@ bool ControllerManager::switchController(const std::vector<std::string>& start_c
   // lock controllers
   boost::recursive_mutex::scoped_lock guard(controllers_lock_);
 
+  // the request lists belong to the realtime loop until it applied the previous switch
+  if (__atomic_load_n(&switch_state_, __ATOMIC_ACQUIRE) == SWITCH_PENDING){
+    ROS_ERROR("Could not switch controllers, the previous switch was not applied by the realtime loop yet");
+    return false;
+  }
+  stop_request_.clear();
+  start_request_.clear();
+
   controller_interface::ControllerBase* ct;
   // list all controllers to stop
   for (unsigned int i=0; i<stop_controllers.size(); i++)
@@ -498,20 +580,91 @@ bool ControllerManager::switchController(const std::vector<std::string>& start_c
 
   // start the atomic controller switching
   switch_strictness_ = strictness;
-  please_switch_ = true;
+  __atomic_store_n(&switch_state_, SWITCH_PENDING, __ATOMIC_RELEASE);
 
-  // wait until switch is finished
   ROS_DEBUG("Request atomic controller switch from realtime loop");
-  while (ros::ok() && please_switch_){
+  return true;
+}
+
+
+bool ControllerManager::waitForSwitch(double timeout)
+{
+  const ros::WallTime deadline = ros::WallTime::now() + ros::WallDuration(std::max(timeout, 0.0));
+  for (;;)
+  {
+    unsigned key = realtime_event_.prepareWait();
+    if (__atomic_load_n(&switch_state_, __ATOMIC_ACQUIRE) == SWITCH_IDLE)
+      return true;
     if (!ros::ok())
       return false;
-    usleep(100);
+    // the timeout also bounds the time to notice a shutdown
+    double wait = 0.1;
+    if (timeout >= 0.0)
+    {
+      wait = std::min(wait, (deadline - ros::WallTime::now()).toSec());
+      if (wait <= 0.0)
+        return false;
+    }
+    realtime_event_.wait(key, wait);
   }
-  start_request_.clear();
-  stop_request_.clear();
+}
 
-  ROS_DEBUG("Successfully switched controllers");
-  return true;
+
+void ControllerManager::publishDiagnostics(const ros::WallTimerEvent&)
+{
+  // skip this report rather than wait for a load, unload or switch
+  boost::recursive_mutex::scoped_try_lock guard(controllers_lock_);
+  if (!guard.owns_lock())
+    return;
+
+  const double period_us = __atomic_load_n(&period_ns_, __ATOMIC_RELAXED) * 1e-3;
+  diagnostic_msgs::DiagnosticArray msg;
+  msg.header.stamp = ros::Time::now();
+
+  diagnostic_msgs::DiagnosticStatus manager;
+  manager.name = cm_node_.getNamespace();
+  manager.hardware_id = root_nh_.getNamespace();
+  manager.level = diagnostic_msgs::DiagnosticStatus::OK;
+  manager.message = (__atomic_load_n(&switch_state_, __ATOMIC_ACQUIRE) == SWITCH_PENDING) ? "switch pending" : "ok";
+  addValue(manager, "cycle period (us)", period_us);
+  addValue(manager, "last switch time (us)", __atomic_load_n(&switch_ns_, __ATOMIC_RELAXED) * 1e-3);
+  msg.status.push_back(manager);
+
+  std::vector<ControllerSpec> &controllers = controllers_lists_[current_controllers_list_];
+  for (size_t i = 0; i < controllers.size(); ++i)
+  {
+    if (!controllers[i].stats)
+      continue;
+    ControllerStatistics& stats = *controllers[i].stats;
+    const boost::uint64_t updates = __atomic_load_n(&stats.updates, __ATOMIC_ACQUIRE);
+    const boost::uint64_t total_ns = __atomic_load_n(&stats.total_ns, __ATOMIC_RELAXED);
+    const boost::uint64_t max_ns = __atomic_exchange_n(&stats.max_ns, 0, __ATOMIC_RELAXED);
+    const boost::uint64_t last_ns = __atomic_load_n(&stats.last_ns, __ATOMIC_RELAXED);
+    const boost::uint64_t window_updates = updates - stats.reported_updates;
+    const boost::uint64_t window_ns = total_ns - stats.reported_total_ns;
+    stats.reported_updates = updates;
+    stats.reported_total_ns = total_ns;
+
+    diagnostic_msgs::DiagnosticStatus status;
+    status.name = cm_node_.getNamespace() + ": " + controllers[i].info.name;
+    status.hardware_id = controllers[i].info.type;
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    if (!controllers[i].c->isRunning())
+      status.message = "stopped";
+    else if (period_us > 0.0 && max_ns * 1e-3 > period_us)
+    {
+      status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+      status.message = "update longer than the cycle period";
+    }
+    else
+      status.message = "running";
+    addValue(status, "updates", window_updates);
+    addValue(status, "mean update time (us)", window_updates ? window_ns * 1e-3 / window_updates : 0.0);
+    addValue(status, "max update time (us)", max_ns * 1e-3);
+    addValue(status, "last update time (us)", last_ns * 1e-3);
+    msg.status.push_back(status);
+  }
+  diagnostics_pub_.publish(msg);
 }
 
 
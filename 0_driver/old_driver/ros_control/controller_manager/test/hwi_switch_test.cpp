@@ -452,6 +452,19 @@ TEST(SwitchInterfacesTest, SwitchInterfaces)
         ASSERT_TRUE(cm.switchController(start, stop, controller_manager_msgs::SwitchControllerRequest::BEST_EFFORT));
         ASSERT_TRUE(cm.switchController(stop, start, controller_manager_msgs::SwitchControllerRequest::STRICT)); // clean-up
     }
+    {   // test asynchronous switch
+        std::vector<std::string> start, stop;
+        start.push_back("group_vel");
+        ASSERT_TRUE(cm.waitForSwitch(0.0)); // nothing pending
+        ASSERT_TRUE(cm.switchControllerAsync(start, stop, controller_manager_msgs::SwitchControllerRequest::STRICT));
+        ASSERT_TRUE(cm.waitForSwitch(1.0));
+        ASSERT_TRUE(cm.getControllerByName("group_vel")->isRunning());
+
+        ASSERT_FALSE(cm.unloadController("group_vel")); // still running
+        ASSERT_TRUE(cm.switchControllerAsync(stop, start, controller_manager_msgs::SwitchControllerRequest::STRICT));
+        ASSERT_TRUE(cm.unloadController("group_vel")); // waits for the switch
+        ASSERT_TRUE(cm.getControllerByName("group_vel") == NULL);
+    }
     ASSERT_TRUE(bot.checkNotRunning());
 }
 
@@ -0,0 +1,249 @@
+///////////////////////////////////////////////////////////////////////////////
+// Cycle time of ControllerManager::update for 4 to 16 effort joints, with a
+// controller that gets its joint handles
+//   - by name every cycle (map lookup, and claim, in the real-time loop),
+//   - by index every cycle, from frozen interfaces (index resolved in init),
+//   - from handles copied in init, the usual ros_control controller.
+//
+// ControllerManager advertises its services, so a master must be running:
+//   roscore &
+//   rosrun controller_manager_tests update_benchmark [cycles]
+//////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <boost/thread/thread.hpp>
+#include <boost/atomic.hpp>
+#include <boost/chrono.hpp>
+
+#include <ros/ros.h>
+#include <controller_interface/controller.h>
+#include <controller_manager/controller_manager.h>
+#include <controller_manager/controller_loader_interface.h>
+#include <controller_manager_msgs/SwitchController.h>
+#include <hardware_interface/joint_command_interface.h>
+#include <hardware_interface/robot_hw.h>
+
+using namespace hardware_interface;
+
+namespace
+{
+
+class BenchRobotHW : public RobotHW
+{
+public:
+  BenchRobotHW(size_t joints)
+    : pos_(joints, 0.1), vel_(joints, 0.0), eff_(joints, 0.0), cmd_(joints, 0.0)
+  {
+    for (size_t i = 0; i < joints; ++i)
+    {
+      char name[32];
+      snprintf(name, sizeof(name), "joint%02zu", i);
+      js_interface_.registerHandle(JointStateHandle(name, &pos_[i], &vel_[i], &eff_[i]));
+      ej_interface_.registerHandle(JointHandle(js_interface_.getHandle(name), &cmd_[i]));
+    }
+    // registration is over, allow the access by index
+    js_interface_.freeze();
+    ej_interface_.freeze();
+
+    registerInterface(&js_interface_);
+    registerInterface(&ej_interface_);
+  }
+
+private:
+  JointStateInterface js_interface_;
+  EffortJointInterface ej_interface_;
+  std::vector<double> pos_, vel_, eff_, cmd_;
+};
+
+// PD to zero on every joint of the interface
+class ByNameController : public controller_interface::Controller<EffortJointInterface>
+{
+public:
+  bool init(EffortJointInterface* hw, ros::NodeHandle& /*n*/)
+  {
+    hw_ = hw;
+    names_ = hw->getNames();
+    return true;
+  }
+  void update(const ros::Time& /*time*/, const ros::Duration& /*period*/)
+  {
+    for (size_t i = 0; i < names_.size(); ++i)
+    {
+      JointHandle joint = hw_->getHandle(names_[i]);
+      joint.setCommand(-10.0 * joint.getPosition() - 0.5 * joint.getVelocity());
+    }
+  }
+
+private:
+  EffortJointInterface* hw_;
+  std::vector<std::string> names_;
+};
+
+class ByIndexController : public controller_interface::Controller<EffortJointInterface>
+{
+public:
+  bool init(EffortJointInterface* hw, ros::NodeHandle& /*n*/)
+  {
+    hw_ = hw;
+    std::vector<std::string> names = hw->getNames();
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+      indices_.push_back(hw->getIndex(names[i]));
+    }
+    return true;
+  }
+  void update(const ros::Time& /*time*/, const ros::Duration& /*period*/)
+  {
+    for (size_t i = 0; i < indices_.size(); ++i)
+    {
+      JointHandle& joint = hw_->getHandle(indices_[i]);
+      joint.setCommand(-10.0 * joint.getPosition() - 0.5 * joint.getVelocity());
+    }
+  }
+
+private:
+  EffortJointInterface* hw_;
+  std::vector<size_t> indices_;
+};
+
+class CachedController : public controller_interface::Controller<EffortJointInterface>
+{
+public:
+  bool init(EffortJointInterface* hw, ros::NodeHandle& /*n*/)
+  {
+    std::vector<std::string> names = hw->getNames();
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+      joints_.push_back(hw->getHandle(names[i]));
+    }
+    return true;
+  }
+  void update(const ros::Time& /*time*/, const ros::Duration& /*period*/)
+  {
+    for (size_t i = 0; i < joints_.size(); ++i)
+    {
+      joints_[i].setCommand(-10.0 * joints_[i].getPosition() - 0.5 * joints_[i].getVelocity());
+    }
+  }
+
+private:
+  std::vector<JointHandle> joints_;
+};
+
+class BenchLoader : public controller_manager::ControllerLoaderInterface
+{
+public:
+  BenchLoader() : ControllerLoaderInterface("bench") {}
+
+  boost::shared_ptr<controller_interface::ControllerBase> createInstance(const std::string& lookup_name)
+  {
+    if (lookup_name == "bench/ByName")
+      return boost::shared_ptr<controller_interface::ControllerBase>(new ByNameController);
+    if (lookup_name == "bench/ByIndex")
+      return boost::shared_ptr<controller_interface::ControllerBase>(new ByIndexController);
+    if (lookup_name == "bench/Cached")
+      return boost::shared_ptr<controller_interface::ControllerBase>(new CachedController);
+    return boost::shared_ptr<controller_interface::ControllerBase>();
+  }
+  std::vector<std::string> getDeclaredClasses()
+  {
+    std::vector<std::string> out;
+    out.push_back("bench/ByName");
+    out.push_back("bench/ByIndex");
+    out.push_back("bench/Cached");
+    return out;
+  }
+  void reload() {}
+};
+
+// switchController waits for the real-time loop to apply the switch
+struct UpdateLoop
+{
+  UpdateLoop(controller_manager::ControllerManager& cm, boost::atomic<bool>& done) : cm(cm), done(done) {}
+  void operator()()
+  {
+    while (!done)
+    {
+      cm.update(ros::Time::now(), ros::Duration(0.001));
+      boost::this_thread::sleep_for(boost::chrono::microseconds(100));
+    }
+  }
+  controller_manager::ControllerManager& cm;
+  boost::atomic<bool>& done;
+};
+
+bool switchWhileUpdating(controller_manager::ControllerManager& cm,
+                         const std::vector<std::string>& start,
+                         const std::vector<std::string>& stop)
+{
+  boost::atomic<bool> done(false);
+  boost::thread rt(UpdateLoop(cm, done));
+  bool ok = cm.switchController(start, stop, controller_manager_msgs::SwitchController::Request::STRICT);
+  done = true;
+  rt.join();
+  return ok;
+}
+
+void run(size_t joints, const std::string& type, int cycles)
+{
+  BenchRobotHW hw(joints);
+  ros::NodeHandle nh("update_benchmark");
+  controller_manager::ControllerManager cm(&hw, nh);
+  cm.registerControllerLoader(boost::shared_ptr<controller_manager::ControllerLoaderInterface>(new BenchLoader));
+
+  std::string name = "pd";
+  nh.setParam(name + "/type", "bench/" + type);
+  if (!cm.loadController(name) || !switchWhileUpdating(cm, std::vector<std::string>(1, name), std::vector<std::string>()))
+  {
+    ROS_ERROR_STREAM("Could not start the " << type << " controller");
+    return;
+  }
+
+  std::vector<double> ns(cycles);
+  ros::Time time = ros::Time::now();
+  const ros::Duration period(0.001);
+  for (int i = 0; i < cycles; ++i)
+  {
+    boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+    cm.update(time, period);
+    ns[i] = boost::chrono::duration<double, boost::nano>(boost::chrono::steady_clock::now() - start).count();
+    time += period;
+  }
+  std::sort(ns.begin(), ns.end());
+  double mean = 0;
+  for (int i = 0; i < cycles; ++i)
+    mean += ns[i] / cycles;
+  printf("%6zu %10s %10.0f %10.0f %10.0f %10.0f\n", joints, type.c_str(),
+         mean, ns[cycles / 2], ns[cycles * 99 / 100], ns.back());
+
+  switchWhileUpdating(cm, std::vector<std::string>(), std::vector<std::string>(1, name));
+  cm.unloadController(name);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "update_benchmark");
+  int cycles = (argc > 1) ? atoi(argv[1]) : 100000;
+
+  ros::AsyncSpinner spinner(1);
+  spinner.start();
+
+  printf("%d cycles of ControllerManager::update, ns per cycle\n", cycles);
+  printf("%6s %10s %10s %10s %10s %10s\n", "joints", "handles", "mean", "median", "p99", "max");
+  const char* types[] = {"ByName", "ByIndex", "Cached"};
+  for (size_t joints = 4; joints <= 16; joints += 4)
+  {
+    for (int t = 0; t < 3; ++t)
+    {
+      run(joints, types[t], cycles);
+    }
+  }
+  return 0;
+}
@@ -81,6 +81,8 @@ class HardwareResourceManager : public HardwareInterface, public ResourceManager
 public:
   typedef ResourceHandle ResourceHandleType;
 
+  using ResourceManager<ResourceHandle>::getHandle;
+
   /** \name Non Real-Time Safe Functions
    *\{*/
 
@@ -110,6 +112,29 @@ public:
     }
   }
 
+  /**
+   * \brief Get the index of a resource, for the real-time access by index of a frozen manager.
+   *
+   * \note Like \ref getHandle(const std::string&), this claims the resource if the \b ClaimPolicy template
+   * parameter is set to \b ClaimResources; the access by index itself never claims.
+   * \param name Resource name.
+   * \return Index of the resource. If the manager is not frozen or the resource name is not found, an exception
+   * is thrown.
+   */
+  std::size_t getIndex(const std::string& name)
+  {
+    try
+    {
+      std::size_t out = this->ResourceManager<ResourceHandle>::getIndex(name);
+      ClaimPolicy::claim(this, name);
+      return out;
+    }
+    catch(const std::logic_error& e)
+    {
+      throw HardwareInterfaceException(e.what());
+    }
+  }
+
   /*\}*/
 };
 
@@ -31,6 +31,8 @@
 #ifndef HARDWARE_INTERFACE_RESOURCE_MANAGER_H
 #define HARDWARE_INTERFACE_RESOURCE_MANAGER_H
 
+#include <cassert>
+#include <cstddef>
 #include <stdexcept>
 #include <string>
 #include <map>
@@ -60,6 +62,15 @@ public:
  *
  * Resources are encapsulated inside handle instances, and this class allows to register and get them by name.
  *
+ * Once registration is over, the handles can be frozen (\ref freeze), after which they can also be accessed by an
+ * integer index (\ref getIndex, resolved once outside the real-time loop) instead of the name lookup. Both
+ * accesses reach the same handle instance, so the state kept by a handle is shared between them:
+ * \code
+ *   m.freeze();
+ *   std::size_t i = m.getIndex("joint1");  // non real-time
+ *   m.getHandle(i).setCommand(cmd);        // real-time
+ * \endcode
+ *
  * \tparam ResourceHandle Resource handle type. Must implement the following method:
  *  \code
  *   std::string getName() const;
@@ -73,8 +84,29 @@ public:
   /** \name Non Real-Time Safe Functions
    *\{*/
 
+  ResourceManager() : frozen_(false) {}
+
   virtual ~ResourceManager() {}
 
+  /** Copies the handles, with handles_ pointing into the map of the copy. */
+  ResourceManager(const ResourceManager& other)
+    : resource_map_(other.resource_map_), handle_index_(other.handle_index_), frozen_(other.frozen_)
+  {
+    copyHandles(other);
+  }
+
+  ResourceManager& operator=(const ResourceManager& other)
+  {
+    if (this != &other)
+    {
+      resource_map_ = other.resource_map_;
+      handle_index_ = other.handle_index_;
+      frozen_ = other.frozen_;
+      copyHandles(other);
+    }
+    return *this;
+  }
+
   /** \return Vector of resource names registered to this interface. */
   std::vector<std::string> getNames() const
   {
@@ -97,7 +129,11 @@ public:
     typename ResourceMap::iterator it = resource_map_.find(handle.getName());
     if (it == resource_map_.end())
     {
-      resource_map_.insert(std::make_pair(handle.getName(), handle));
+      it = resource_map_.insert(std::make_pair(handle.getName(), handle)).first;
+
+      // map nodes are never moved, new ones are appended so that the indices given out stay valid
+      if (frozen_) {handle_index_.insert(std::make_pair(handle.getName(), handles_.size()));}
+      handles_.push_back(&it->second);
     }
     else
     {
@@ -107,6 +143,52 @@ public:
     }
   }
 
+  /**
+   * \brief Freeze the registered handles, for access by index.
+   * Indices follow the order of \ref getNames at the time of the call. Calling it again rebuilds the indices, so
+   * indices obtained before are only guaranteed to stay valid if no handle was registered in between.
+   */
+  void freeze()
+  {
+    handles_.clear();
+    handle_index_.clear();
+    handles_.reserve(resource_map_.size());
+    for(typename ResourceMap::iterator it = resource_map_.begin(); it != resource_map_.end(); ++it)
+    {
+      handle_index_.insert(std::make_pair(it->first, handles_.size()));
+      handles_.push_back(&it->second);
+    }
+    frozen_ = true;
+  }
+
+  /** \return Whether \ref freeze has been called, enabling the access by index. */
+  bool isFrozen() const {return frozen_;}
+
+  /**
+   * \brief Get the index of a resource, for \ref getHandle(std::size_t).
+   * \param name Resource name.
+   * \return Index of the resource. If the manager is not frozen or the resource name is not found, an exception
+   * is thrown.
+   */
+  std::size_t getIndex(const std::string& name) const
+  {
+    if (!frozen_)
+    {
+      throw std::logic_error("Could not get the index of resource '" + name + "' in '" +
+                             internal::demangledTypeName(*this) + "', which is not frozen.");
+    }
+
+    typename IndexMap::const_iterator it = handle_index_.find(name);
+
+    if (it == handle_index_.end())
+    {
+      throw std::logic_error("Could not find resource '" + name + "' in '" +
+                             internal::demangledTypeName(*this) + "'.");
+    }
+
+    return it->second;
+  }
+
   /**
    * \brief Get a resource handle by name.
    * \param name Resource name.
@@ -144,6 +226,42 @@ public:
         result->registerHandle((*it_man)->getHandle(*it_nms));
       }
     }
+
+    // a combination of frozen managers is frozen as well
+    bool all_frozen = !managers.empty();
+    for(typename std::vector<resource_manager_type*>::iterator it_man = managers.begin();
+        it_man != managers.end(); ++it_man) {
+      all_frozen = all_frozen && (*it_man)->isFrozen();
+    }
+    if (all_frozen) {
+      result->freeze();
+    }
+  }
+
+  /*\}*/
+
+  /** \name Real-Time Safe Functions
+   *\{*/
+
+  /** \return Number of registered resources. */
+  std::size_t size() const {return resource_map_.size();}
+
+  /**
+   * \brief Get a resource handle by index, without lookup.
+   * The reference is the handle stored by the manager, and stays valid as long as the manager.
+   * \pre The manager is frozen and \e index was returned by \ref getIndex.
+   * \param index Resource index.
+   */
+  ResourceHandle& getHandle(std::size_t index)
+  {
+    assert(frozen_ && index < handles_.size());
+    return *handles_[index];
+  }
+
+  const ResourceHandle& getHandle(std::size_t index) const
+  {
+    assert(frozen_ && index < handles_.size());
+    return *handles_[index];
   }
 
   /*\}*/
@@ -151,6 +269,27 @@ public:
 protected:
   typedef std::map<std::string, ResourceHandle> ResourceMap;
   ResourceMap resource_map_;
+
+  /**
+   * \name The handles of resource_map_ in a vector, in registration order until \ref freeze sorts them by name.
+   * They point into the map nodes, which are stable, so that there is a single copy of each handle.
+   *\{*/
+  typedef std::map<std::string, std::size_t> IndexMap;
+  std::vector<ResourceHandle*> handles_;
+  IndexMap handle_index_;
+  bool frozen_;
+  /*\}*/
+
+private:
+  void copyHandles(const ResourceManager& other)
+  {
+    handles_.clear();
+    handles_.reserve(other.handles_.size());
+    for(std::size_t i = 0; i < other.handles_.size(); ++i)
+    {
+      handles_.push_back(&resource_map_.find(other.handles_[i]->getName())->second);
+    }
+  }
 };
 
 }
@@ -178,6 +178,60 @@ TEST_F(HardwareResourceManagerTest, ResourceClaims)
   }
 }
 
+TEST_F(HardwareResourceManagerTest, FrozenAccess)
+{
+  HardwareResourceManager<HandleType> mgr;
+  mgr.registerHandle(h2);
+  mgr.registerHandle(h1);
+
+  // No index access before freezing
+  EXPECT_FALSE(mgr.isFrozen());
+  EXPECT_THROW(mgr.getIndex(h1.getName()), HardwareInterfaceException);
+
+  mgr.freeze();
+  EXPECT_TRUE(mgr.isFrozen());
+  EXPECT_EQ(2, mgr.size());
+
+  // Indices follow the name order
+  size_t i1 = mgr.getIndex(h1.getName());
+  size_t i2 = mgr.getIndex(h2.getName());
+  EXPECT_EQ(0, i1);
+  EXPECT_EQ(1, i2);
+  EXPECT_EQ(h1.getName(), mgr.getHandle(i1).getName());
+  EXPECT_EQ(h2.getValue(), mgr.getHandle(i2).getValue());
+  EXPECT_THROW(mgr.getIndex("no_resource"), HardwareInterfaceException);
+
+  // Name access is unchanged
+  EXPECT_EQ(h1.getValue(), mgr.getHandle(h1.getName()).getValue());
+
+  // Re-registering updates the frozen handle in place, new handles are appended
+  HandleType h3(h1.getName(), 3);
+  HandleType h0("resource0", 0);
+  mgr.registerHandle(h3);
+  mgr.registerHandle(h0);
+  EXPECT_EQ(i1, mgr.getIndex(h1.getName()));
+  EXPECT_EQ(i2, mgr.getIndex(h2.getName()));
+  EXPECT_EQ(2, mgr.getIndex(h0.getName()));
+  EXPECT_EQ(3, mgr.getHandle(i1).getValue());
+  EXPECT_EQ(0, mgr.getHandle(2).getValue());
+  EXPECT_EQ(3, mgr.size());
+}
+
+TEST_F(HardwareResourceManagerTest, FrozenResourceClaims)
+{
+  HardwareResourceManager<HandleType, ClaimResources> mgr;
+  mgr.registerHandle(h1);
+  mgr.registerHandle(h2);
+  mgr.freeze();
+
+  // Getting the index is the resource-claiming operation, the access by index does not claim
+  size_t i1 = mgr.getIndex(h1.getName());
+  EXPECT_EQ(1, mgr.getClaims().size());
+  mgr.clearClaims();
+  mgr.getHandle(i1);
+  EXPECT_TRUE(mgr.getClaims().empty());
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,425 @@
+/// \file joint_limits_batch.h
+///
+/// Structure-of-arrays counterparts of the limits handles of joint_limits_interface.h, for robot abstractions that
+/// keep their joint states and commands in contiguous arrays. A batch stores the limits of all its joints one array
+/// per field, and enforces them in a single pass without per-joint branches, which the compiler can vectorize.
+///
+/// For the same inputs, a batch computes the same commands as the corresponding handles, with the same expressions
+/// evaluated in the same order; a missing limit selects the same bound the handle would. The results are bit for
+/// bit identical unless the compiler contracts a * b + c into fused multiply-adds (the GCC default where FMA is
+/// available, e.g. -march=native or aarch64): it may fuse the vectorized pass and not the scalar handle, a one ulp
+/// difference on the limits. Build with -ffp-contract=off where the two must agree exactly.
+///
+/// The command array is written in place and must not overlap the other arrays given to enforceLimits(). GCC
+/// vectorizes the passes at -O3, or at -O2 with -fvect-cost-model=dynamic.
+
+#ifndef JOINT_LIMITS_INTERFACE_JOINT_LIMITS_BATCH_H
+#define JOINT_LIMITS_INTERFACE_JOINT_LIMITS_BATCH_H
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <ros/duration.h>
+
+#include <joint_limits_interface/joint_limits_interface.h>
+
+namespace joint_limits_interface
+{
+
+namespace internal
+{
+
+/** \brief Limits of a set of joints, one array per field, indexed like the joint arrays of the batch. */
+class JointLimitsBatch
+{
+public:
+  /** \return Number of joints. */
+  std::size_t size() const {return names_.size();}
+
+  /** \return Name of joint \p i. */
+  const std::string& getName(std::size_t i) const {return names_[i];}
+
+protected:
+  void add(const std::string& name, const JointLimits& limits, const SoftJointLimits& soft_limits)
+  {
+    names_.push_back(name);
+    min_pos_.push_back(limits.min_position);
+    max_pos_.push_back(limits.max_position);
+    max_vel_.push_back(limits.max_velocity);
+    max_acc_.push_back(limits.max_acceleration);
+    max_eff_.push_back(limits.max_effort);
+    soft_min_pos_.push_back(soft_limits.min_position);
+    soft_max_pos_.push_back(soft_limits.max_position);
+    k_pos_.push_back(soft_limits.k_position);
+    k_vel_.push_back(soft_limits.k_velocity);
+    has_pos_.push_back(limits.has_position_limits ? 1.0 : 0.0);
+    has_acc_.push_back(limits.has_acceleration_limits ? 1.0 : 0.0);
+  }
+
+  void requireVelocityLimits(const std::string& name, const JointLimits& limits) const
+  {
+    if (!limits.has_velocity_limits)
+    {
+      throw JointLimitsInterfaceException("Cannot enforce limits for joint '" + name +
+                                           "'. It has no velocity limits specification.");
+    }
+  }
+
+  void requireEffortLimits(const std::string& name, const JointLimits& limits) const
+  {
+    if (!limits.has_effort_limits)
+    {
+      throw JointLimitsInterfaceException("Cannot enforce limits for joint '" + name +
+                                          "'. It has no efforts limits specification.");
+    }
+  }
+
+  std::vector<std::string> names_;
+  std::vector<double> min_pos_, max_pos_, max_vel_, max_acc_, max_eff_;
+  std::vector<double> soft_min_pos_, soft_max_pos_, k_pos_, k_vel_;
+  // 1.0 or 0.0: compared as doubles, the selects stay in the vector lanes of the limits
+  std::vector<double> has_pos_, has_acc_;
+};
+
+}
+
+/** \brief Batch of PositionJointSaturationHandle. */
+class PositionJointSaturationBatch : public internal::JointLimitsBatch
+{
+public:
+  void addJoint(const std::string& name, const JointLimits& limits)
+  {
+    add(name, limits, SoftJointLimits());
+    if (!limits.has_position_limits)
+    {
+      min_pos_.back() = -std::numeric_limits<double>::max();
+      max_pos_.back() =  std::numeric_limits<double>::max();
+    }
+    has_vel_.push_back(limits.has_velocity_limits ? 1.0 : 0.0);
+    prev_cmd_.push_back(std::numeric_limits<double>::quiet_NaN());
+  }
+
+  /**
+   * \brief Enforce position and velocity limits.
+   *
+   * \param period Control period.
+   * \param pos Joint positions, read until the first command after a reset.
+   * \param cmd Position commands, saturated in place.
+   */
+  void enforceLimits(const ros::Duration& period, const double* pos, double* __restrict__ cmd)
+  {
+    const std::size_t n = size();
+    if (n == 0)
+      return;
+
+    const double dt = period.toSec();
+    const double* min_pos_limit = &min_pos_[0];
+    const double* max_pos_limit = &max_pos_[0];
+    const double* max_vel = &max_vel_[0];
+    const double* has_vel = &has_vel_[0];
+    double* __restrict__ prev_cmd = &prev_cmd_[0];
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const double pos_i = pos[i];
+      const double prev_i = prev_cmd[i];
+      const double prev = std::isnan(prev_i) ? pos_i : prev_i;
+      const double delta_pos = max_vel[i] * dt;
+      const double min_pos = std::max(prev - delta_pos, min_pos_limit[i]);
+      const double max_pos = std::min(prev + delta_pos, max_pos_limit[i]);
+      const double low  = has_vel[i] != 0.0 ? min_pos : min_pos_limit[i];
+      const double high = has_vel[i] != 0.0 ? max_pos : max_pos_limit[i];
+
+      const double c = internal::saturate(cmd[i], low, high);
+      cmd[i] = c;
+      prev_cmd[i] = c;
+    }
+  }
+
+  /** \brief Reset state, in case of mode switch or e-stop */
+  void reset()
+  {
+    std::fill(prev_cmd_.begin(), prev_cmd_.end(), std::numeric_limits<double>::quiet_NaN());
+  }
+
+private:
+  std::vector<double> has_vel_;
+  std::vector<double> prev_cmd_;
+};
+
+/** \brief Batch of PositionJointSoftLimitsHandle. */
+class PositionJointSoftLimitsBatch : public internal::JointLimitsBatch
+{
+public:
+  void addJoint(const std::string& name, const JointLimits& limits, const SoftJointLimits& soft_limits)
+  {
+    requireVelocityLimits(name, limits);
+    add(name, limits, soft_limits);
+    prev_cmd_.push_back(std::numeric_limits<double>::quiet_NaN());
+  }
+
+  /**
+   * \brief Enforce position and velocity limits for joints subject to soft limits.
+   *
+   * \param period Control period.
+   * \param pos Joint positions, read until the first command after a reset.
+   * \param cmd Position commands, saturated in place.
+   */
+  void enforceLimits(const ros::Duration& period, const double* pos, double* __restrict__ cmd)
+  {
+    assert(period.toSec() > 0.0);
+
+    const std::size_t n = size();
+    if (n == 0)
+      return;
+
+    const double dt = period.toSec();
+    const double* min_pos_limit = &min_pos_[0];
+    const double* max_pos_limit = &max_pos_[0];
+    const double* max_vel_limit = &max_vel_[0];
+    const double* soft_min_pos = &soft_min_pos_[0];
+    const double* soft_max_pos = &soft_max_pos_[0];
+    const double* k_pos = &k_pos_[0];
+    const double* has_pos = &has_pos_[0];
+    double* __restrict__ prev_cmd = &prev_cmd_[0];
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const double pos_i = pos[i];
+      const double prev_i = prev_cmd[i];
+      const double prev = std::isnan(prev_i) ? pos_i : prev_i;
+      const double max_vel = max_vel_limit[i];
+
+      // Velocity bounds, from the proximity to the soft position limits if any
+      const double min_vel_pos = internal::saturate(-k_pos[i] * (prev - soft_min_pos[i]), -max_vel, max_vel);
+      const double max_vel_pos = internal::saturate(-k_pos[i] * (prev - soft_max_pos[i]), -max_vel, max_vel);
+      const double soft_min_vel = has_pos[i] != 0.0 ? min_vel_pos : -max_vel;
+      const double soft_max_vel = has_pos[i] != 0.0 ? max_vel_pos :  max_vel;
+
+      // Position bounds
+      const double pos_low  = prev + soft_min_vel * dt;
+      const double pos_high = prev + soft_max_vel * dt;
+      const double min_pos = std::max(pos_low,  min_pos_limit[i]);
+      const double max_pos = std::min(pos_high, max_pos_limit[i]);
+      const double low  = has_pos[i] != 0.0 ? min_pos : pos_low;
+      const double high = has_pos[i] != 0.0 ? max_pos : pos_high;
+
+      const double c = internal::saturate(cmd[i], low, high);
+      cmd[i] = c;
+      prev_cmd[i] = c;
+    }
+  }
+
+  /** \brief Reset state, in case of mode switch or e-stop */
+  void reset()
+  {
+    std::fill(prev_cmd_.begin(), prev_cmd_.end(), std::numeric_limits<double>::quiet_NaN());
+  }
+
+private:
+  std::vector<double> prev_cmd_;
+};
+
+/** \brief Batch of EffortJointSaturationHandle. */
+class EffortJointSaturationBatch : public internal::JointLimitsBatch
+{
+public:
+  void addJoint(const std::string& name, const JointLimits& limits)
+  {
+    requireVelocityLimits(name, limits);
+    requireEffortLimits(name, limits);
+    add(name, limits, SoftJointLimits());
+  }
+
+  /**
+   * \brief Enforce position, velocity, and effort limits.
+   *
+   * \param pos Joint positions.
+   * \param vel Joint velocities.
+   * \param cmd Effort commands, saturated in place.
+   */
+  void enforceLimits(const ros::Duration& /* period */, const double* pos, const double* vel,
+                     double* __restrict__ cmd)
+  {
+    const std::size_t n = size();
+    if (n == 0)
+      return;
+
+    const double* min_pos_limit = &min_pos_[0];
+    const double* max_pos_limit = &max_pos_[0];
+    const double* max_vel = &max_vel_[0];
+    const double* max_eff_limit = &max_eff_[0];
+    const double* has_pos = &has_pos_[0];
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      // No effort pushing further beyond a position or velocity limit; the else-if of the handle is the
+      // negated first condition
+      const double pos_i = pos[i];
+      const double vel_i = vel[i];
+      const bool below_pos = (has_pos[i] != 0.0) & (pos_i < min_pos_limit[i]);
+      const bool above_pos = (has_pos[i] != 0.0) & !(pos_i < min_pos_limit[i]) & (pos_i > max_pos_limit[i]);
+      const bool below_vel = vel_i < -max_vel[i];
+      const bool above_vel = !below_vel & (vel_i > max_vel[i]);
+      const double max_eff_i = max_eff_limit[i];
+      const double min_eff = (below_pos | below_vel) ? 0.0 : -max_eff_i;
+      const double max_eff = (above_pos | above_vel) ? 0.0 :  max_eff_i;
+
+      cmd[i] = internal::saturate(cmd[i], min_eff, max_eff);
+    }
+  }
+};
+
+/** \brief Batch of EffortJointSoftLimitsHandle. */
+class EffortJointSoftLimitsBatch : public internal::JointLimitsBatch
+{
+public:
+  void addJoint(const std::string& name, const JointLimits& limits, const SoftJointLimits& soft_limits)
+  {
+    requireVelocityLimits(name, limits);
+    requireEffortLimits(name, limits);
+    add(name, limits, soft_limits);
+  }
+
+  /**
+   * \brief Enforce position, velocity and effort limits for joints subject to soft limits.
+   *
+   * \param pos Joint positions.
+   * \param vel Joint velocities.
+   * \param cmd Effort commands, saturated in place.
+   */
+  void enforceLimits(const ros::Duration& /* period */, const double* pos, const double* vel,
+                     double* __restrict__ cmd)
+  {
+    const std::size_t n = size();
+    if (n == 0)
+      return;
+
+    const double* max_vel_limit = &max_vel_[0];
+    const double* max_eff_limit = &max_eff_[0];
+    const double* soft_min_pos = &soft_min_pos_[0];
+    const double* soft_max_pos = &soft_max_pos_[0];
+    const double* k_pos = &k_pos_[0];
+    const double* k_vel = &k_vel_[0];
+    const double* has_pos = &has_pos_[0];
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const double max_vel = max_vel_limit[i];
+
+      // Velocity bounds, from the proximity to the soft position limits if any
+      const double min_vel_pos = internal::saturate(-k_pos[i] * (pos[i] - soft_min_pos[i]), -max_vel, max_vel);
+      const double max_vel_pos = internal::saturate(-k_pos[i] * (pos[i] - soft_max_pos[i]), -max_vel, max_vel);
+      const double soft_min_vel = has_pos[i] != 0.0 ? min_vel_pos : -max_vel;
+      const double soft_max_vel = has_pos[i] != 0.0 ? max_vel_pos :  max_vel;
+
+      // Effort bounds, from the velocity bounds
+      const double max_eff = max_eff_limit[i];
+      const double soft_min_eff = internal::saturate(-k_vel[i] * (vel[i] - soft_min_vel), -max_eff, max_eff);
+      const double soft_max_eff = internal::saturate(-k_vel[i] * (vel[i] - soft_max_vel), -max_eff, max_eff);
+
+      cmd[i] = internal::saturate(cmd[i], soft_min_eff, soft_max_eff);
+    }
+  }
+};
+
+/** \brief Batch of VelocityJointSaturationHandle. */
+class VelocityJointSaturationBatch : public internal::JointLimitsBatch
+{
+public:
+  void addJoint(const std::string& name, const JointLimits& limits)
+  {
+    requireVelocityLimits(name, limits);
+    add(name, limits, SoftJointLimits());
+  }
+
+  /**
+   * \brief Enforce joint velocity and acceleration limits.
+   *
+   * \param period Control period.
+   * \param vel Joint velocities.
+   * \param cmd Velocity commands, saturated in place.
+   */
+  void enforceLimits(const ros::Duration& period, const double* vel, double* __restrict__ cmd)
+  {
+    const std::size_t n = size();
+    if (n == 0)
+      return;
+
+    const double dt = period.toSec();
+    const double* max_vel_limit = &max_vel_[0];
+    const double* max_acc = &max_acc_[0];
+    const double* has_acc = &has_acc_[0];
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const double max_vel = max_vel_limit[i];
+      const double delta_vel = max_acc[i] * dt;
+      const double vel_low  = std::max(vel[i] - delta_vel, -max_vel);
+      const double vel_high = std::min(vel[i] + delta_vel,  max_vel);
+      const double low  = has_acc[i] != 0.0 ? vel_low  : -max_vel;
+      const double high = has_acc[i] != 0.0 ? vel_high :  max_vel;
+
+      cmd[i] = internal::saturate(cmd[i], low, high);
+    }
+  }
+};
+
+/** \brief Batch of VelocityJointSoftLimitsHandle. */
+class VelocityJointSoftLimitsBatch : public internal::JointLimitsBatch
+{
+public:
+  void addJoint(const std::string& name, const JointLimits& limits, const SoftJointLimits& soft_limits)
+  {
+    add(name, limits, soft_limits);
+    if (!limits.has_velocity_limits)
+      max_vel_.back() = std::numeric_limits<double>::max();
+  }
+
+  /**
+   * \brief Enforce position, velocity, and acceleration limits for joints subject to soft limits.
+   *
+   * \param period Control period.
+   * \param pos Joint positions.
+   * \param vel Joint velocities.
+   * \param cmd Velocity commands, saturated in place.
+   */
+  void enforceLimits(const ros::Duration& period, const double* pos, const double* vel,
+                     double* __restrict__ cmd)
+  {
+    const std::size_t n = size();
+    if (n == 0)
+      return;
+
+    const double dt = period.toSec();
+    const double* max_vel_limit = &max_vel_[0];
+    const double* max_acc = &max_acc_[0];
+    const double* soft_min_pos = &soft_min_pos_[0];
+    const double* soft_max_pos = &soft_max_pos_[0];
+    const double* k_pos = &k_pos_[0];
+    const double* has_pos = &has_pos_[0];
+    const double* has_acc = &has_acc_[0];
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      const double max_vel_i = max_vel_limit[i];
+
+      // Velocity bounds, from the proximity to the soft position limits if any
+      const double min_vel_pos = internal::saturate(-k_pos[i] * (pos[i] - soft_min_pos[i]), -max_vel_i, max_vel_i);
+      const double max_vel_pos = internal::saturate(-k_pos[i] * (pos[i] - soft_max_pos[i]), -max_vel_i, max_vel_i);
+      double min_vel = has_pos[i] != 0.0 ? min_vel_pos : -max_vel_i;
+      double max_vel = has_pos[i] != 0.0 ? max_vel_pos :  max_vel_i;
+
+      // and from the acceleration limits if any
+      const double delta_vel = max_acc[i] * dt;
+      const double min_vel_acc = std::max(vel[i] - delta_vel, min_vel);
+      const double max_vel_acc = std::min(vel[i] + delta_vel, max_vel);
+      min_vel = has_acc[i] != 0.0 ? min_vel_acc : min_vel;
+      max_vel = has_acc[i] != 0.0 ? max_vel_acc : max_vel;
+
+      cmd[i] = internal::saturate(cmd[i], min_vel, max_vel);
+    }
+  }
+};
+
+}
+
+#endif
@@ -536,6 +536,8 @@ template <class HandleType>
 class JointLimitsInterface : public hardware_interface::ResourceManager<HandleType>
 {
 public:
+  using hardware_interface::ResourceManager<HandleType>::getHandle;
+
   HandleType getHandle(const std::string& name)
   {
     // Rethrow exception with a meaningful type
@@ -554,10 +556,9 @@ public:
   /** \brief Enforce limits for all managed handles. */
   void enforceLimits(const ros::Duration& period)
   {
-    typedef typename hardware_interface::ResourceManager<HandleType>::ResourceMap::iterator ItratorType;
-    for (ItratorType it = this->resource_map_.begin(); it != this->resource_map_.end(); ++it)
+    for (std::size_t i = 0; i < this->handles_.size(); ++i)
     {
-      it->second.enforceLimits(period);
+      this->handles_[i]->enforceLimits(period);
     }
   }
   /*\}*/
@@ -571,10 +572,9 @@ public:
   /** \brief Reset all managed handles. */
   void reset()
   {
-    typedef hardware_interface::ResourceManager<PositionJointSaturationHandle>::ResourceMap::iterator ItratorType;
-    for (ItratorType it = this->resource_map_.begin(); it != this->resource_map_.end(); ++it)
+    for (std::size_t i = 0; i < this->handles_.size(); ++i)
     {
-      it->second.reset();
+      this->handles_[i]->reset();
     }
   }
   /*\}*/
@@ -588,10 +588,9 @@ public:
   /** \brief Reset all managed handles. */
   void reset()
   {
-    typedef hardware_interface::ResourceManager<PositionJointSoftLimitsHandle>::ResourceMap::iterator ItratorType;
-    for (ItratorType it = this->resource_map_.begin(); it != this->resource_map_.end(); ++it)
+    for (std::size_t i = 0; i < this->handles_.size(); ++i)
     {
-      it->second.reset();
+      this->handles_[i]->reset();
     }
   }
   /*\}*/
@@ -0,0 +1,204 @@
+///////////////////////////////////////////////////////////////////////////////
+// Cycle time of the enforcement of the limits of 6 to 24 joints, with
+//   - the handles of a JointLimitsInterface, one joint after the other,
+//   - the corresponding batch, in one pass over the joint arrays.
+// Every cycle starts from new commands, copied in the command array with the
+// same cost for both.
+//
+//   rosrun joint_limits_interface joint_limits_batch_benchmark [cycles]
+//////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <time.h>
+
+#include <joint_limits_interface/joint_limits_batch.h>
+#include <joint_limits_interface/joint_limits_interface.h>
+
+using namespace hardware_interface;
+using namespace joint_limits_interface;
+
+namespace
+{
+
+inline long long nowNs()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Cycles timed together, a single one is too short for the clock
+const int BLOCK = 100;
+
+struct Robot
+{
+  Robot(size_t joints) : pos(joints), vel(joints), eff(joints), cmd(joints), next_cmd(BLOCK * joints)
+  {
+    for (size_t i = 0; i < joints; ++i)
+    {
+      char name[32];
+      snprintf(name, sizeof(name), "joint%02zu", i);
+      names.push_back(name);
+      handles.push_back(JointHandle(JointStateHandle(name, &pos[i], &vel[i], &eff[i]), &cmd[i]));
+      pos[i] = 0.9 - 0.1 * i;
+      vel[i] = 0.5 * (i % 3) - 0.5;
+
+      // every joint has velocity and effort limits, which some handles require
+      JointLimits l;
+      l.has_position_limits = true;
+      l.min_position = -1.0;
+      l.max_position = 1.0;
+      l.has_velocity_limits = true;
+      l.max_velocity = 2.0;
+      l.has_acceleration_limits = i % 2;
+      l.max_acceleration = 50.0;
+      l.has_effort_limits = true;
+      l.max_effort = 8.0;
+      limits.push_back(l);
+
+      SoftJointLimits s;
+      s.min_position = -0.8;
+      s.max_position = 0.8;
+      s.k_position = 20.0;
+      s.k_velocity = 40.0;
+      soft_limits.push_back(s);
+    }
+    for (size_t i = 0; i < next_cmd.size(); ++i)
+      next_cmd[i] = 10.0 * rand() / RAND_MAX - 5.0;
+  }
+
+  std::vector<double> pos, vel, eff, cmd, next_cmd;
+  std::vector<std::string> names;
+  std::vector<JointHandle> handles;
+  std::vector<JointLimits> limits;
+  std::vector<SoftJointLimits> soft_limits;
+};
+
+void add(Robot& r, size_t i, PositionJointSaturationInterface& iface, PositionJointSaturationBatch& batch)
+{
+  iface.registerHandle(PositionJointSaturationHandle(r.handles[i], r.limits[i]));
+  batch.addJoint(r.names[i], r.limits[i]);
+}
+void add(Robot& r, size_t i, PositionJointSoftLimitsInterface& iface, PositionJointSoftLimitsBatch& batch)
+{
+  iface.registerHandle(PositionJointSoftLimitsHandle(r.handles[i], r.limits[i], r.soft_limits[i]));
+  batch.addJoint(r.names[i], r.limits[i], r.soft_limits[i]);
+}
+void add(Robot& r, size_t i, EffortJointSaturationInterface& iface, EffortJointSaturationBatch& batch)
+{
+  iface.registerHandle(EffortJointSaturationHandle(r.handles[i], r.limits[i]));
+  batch.addJoint(r.names[i], r.limits[i]);
+}
+void add(Robot& r, size_t i, EffortJointSoftLimitsInterface& iface, EffortJointSoftLimitsBatch& batch)
+{
+  iface.registerHandle(EffortJointSoftLimitsHandle(r.handles[i], r.limits[i], r.soft_limits[i]));
+  batch.addJoint(r.names[i], r.limits[i], r.soft_limits[i]);
+}
+void add(Robot& r, size_t i, VelocityJointSaturationInterface& iface, VelocityJointSaturationBatch& batch)
+{
+  iface.registerHandle(VelocityJointSaturationHandle(r.handles[i], r.limits[i]));
+  batch.addJoint(r.names[i], r.limits[i]);
+}
+void add(Robot& r, size_t i, VelocityJointSoftLimitsInterface& iface, VelocityJointSoftLimitsBatch& batch)
+{
+  iface.registerHandle(VelocityJointSoftLimitsHandle(r.handles[i], r.limits[i], r.soft_limits[i]));
+  batch.addJoint(r.names[i], r.limits[i], r.soft_limits[i]);
+}
+
+void enforce(PositionJointSaturationBatch& b, const ros::Duration& p, Robot& r)
+{
+  b.enforceLimits(p, &r.pos[0], &r.cmd[0]);
+}
+void enforce(PositionJointSoftLimitsBatch& b, const ros::Duration& p, Robot& r)
+{
+  b.enforceLimits(p, &r.pos[0], &r.cmd[0]);
+}
+void enforce(EffortJointSaturationBatch& b, const ros::Duration& p, Robot& r)
+{
+  b.enforceLimits(p, &r.pos[0], &r.vel[0], &r.cmd[0]);
+}
+void enforce(EffortJointSoftLimitsBatch& b, const ros::Duration& p, Robot& r)
+{
+  b.enforceLimits(p, &r.pos[0], &r.vel[0], &r.cmd[0]);
+}
+void enforce(VelocityJointSaturationBatch& b, const ros::Duration& p, Robot& r)
+{
+  b.enforceLimits(p, &r.vel[0], &r.cmd[0]);
+}
+void enforce(VelocityJointSoftLimitsBatch& b, const ros::Duration& p, Robot& r)
+{
+  b.enforceLimits(p, &r.pos[0], &r.vel[0], &r.cmd[0]);
+}
+
+void print(const char* name, size_t joints, const char* enforcer, std::vector<double>& ns)
+{
+  std::sort(ns.begin(), ns.end());
+  size_t n = ns.size();
+  printf("%-24s %6zu %8s %8.1f %8.1f %8.1f\n", name, joints, enforcer, ns[n / 2], ns[n * 99 / 100], ns.back());
+}
+
+template <class Interface, class Batch>
+void run(const char* name, size_t joints, int cycles)
+{
+  Robot robot(joints);
+  Interface iface;
+  Batch batch;
+  for (size_t i = 0; i < joints; ++i)
+  {
+    add(robot, i, iface, batch);
+  }
+
+  const ros::Duration period(0.001);
+  const int blocks = std::max(cycles / BLOCK, 1);
+  std::vector<double> iface_ns(blocks), batch_ns(blocks);
+  double sink = 0.0;
+  for (int b = 0; b < blocks; ++b)
+  {
+    long long start = nowNs();
+    for (int c = 0; c < BLOCK; ++c)
+    {
+      std::copy(&robot.next_cmd[c * joints], &robot.next_cmd[c * joints] + joints, robot.cmd.begin());
+      iface.enforceLimits(period);
+      sink += robot.cmd[0];
+    }
+    iface_ns[b] = double(nowNs() - start) / BLOCK;
+
+    start = nowNs();
+    for (int c = 0; c < BLOCK; ++c)
+    {
+      std::copy(&robot.next_cmd[c * joints], &robot.next_cmd[c * joints] + joints, robot.cmd.begin());
+      enforce(batch, period, robot);
+      sink += robot.cmd[0];
+    }
+    batch_ns[b] = double(nowNs() - start) / BLOCK;
+  }
+  print(name, joints, "handles", iface_ns);
+  print(name, joints, "batch", batch_ns);
+  if (sink == 12345.6789)
+    printf("%f\n", sink);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  int cycles = (argc > 1) ? atoi(argv[1]) : 1000000;
+
+  printf("%d cycles, ns per cycle\n", cycles);
+  printf("%-24s %6s %8s %8s %8s %8s\n", "limits", "joints", "enforcer", "median", "p99", "max");
+  const size_t joints[] = {6, 7, 12, 24};
+  for (int j = 0; j < 4; ++j)
+  {
+    run<PositionJointSaturationInterface, PositionJointSaturationBatch>("PositionJointSaturation", joints[j], cycles);
+    run<PositionJointSoftLimitsInterface, PositionJointSoftLimitsBatch>("PositionJointSoftLimits", joints[j], cycles);
+    run<EffortJointSaturationInterface, EffortJointSaturationBatch>("EffortJointSaturation", joints[j], cycles);
+    run<EffortJointSoftLimitsInterface, EffortJointSoftLimitsBatch>("EffortJointSoftLimits", joints[j], cycles);
+    run<VelocityJointSaturationInterface, VelocityJointSaturationBatch>("VelocityJointSaturation", joints[j], cycles);
+    run<VelocityJointSoftLimitsInterface, VelocityJointSoftLimitsBatch>("VelocityJointSoftLimits", joints[j], cycles);
+  }
+  return 0;
+}
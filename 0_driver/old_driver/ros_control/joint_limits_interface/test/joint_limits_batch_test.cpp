@@ -0,0 +1,249 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <joint_limits_interface/joint_limits_batch.h>
+#include <joint_limits_interface/joint_limits_interface.h>
+
+using std::string;
+using std::vector;
+using namespace hardware_interface;
+using namespace joint_limits_interface;
+
+// Joints covering every combination of position, velocity and acceleration limits, checked against the handles
+// of the corresponding interfaces on the same pseudo-random states and commands
+class JointLimitsBatchTest : public ::testing::Test
+{
+public:
+  static const size_t JOINTS = 16;
+
+  JointLimitsBatchTest()
+    : pos(JOINTS), vel(JOINTS), eff(JOINTS), cmd(JOINTS), batch_cmd(JOINTS),
+      period(0.01),
+      seed(12345)
+  {
+    for (size_t i = 0; i < JOINTS; ++i)
+    {
+      char name[32];
+      snprintf(name, sizeof(name), "joint%02zu", i);
+      names.push_back(name);
+      handles.push_back(JointHandle(JointStateHandle(name, &pos[i], &vel[i], &eff[i]), &cmd[i]));
+
+      JointLimits l;
+      l.has_position_limits = i & 1;
+      l.min_position = -1.0 - 0.1 * i;
+      l.max_position =  1.0 + 0.05 * i;
+      l.has_velocity_limits = i & 2;
+      l.max_velocity = 2.0 + 0.1 * i;
+      l.has_acceleration_limits = i & 4;
+      l.max_acceleration = 50.0 + i;
+      l.has_effort_limits = i & 8;
+      l.max_effort = 8.0 + i;
+      limits.push_back(l);
+
+      SoftJointLimits s;
+      s.min_position = l.min_position + 0.2;
+      s.max_position = l.max_position - 0.2;
+      s.k_position = 20.0 + i;
+      s.k_velocity = 40.0 - i;
+      soft_limits.push_back(s);
+    }
+  }
+
+protected:
+  // Limits with velocity and effort limits, for the handles requiring them
+  JointLimits withVelocityAndEffort(size_t i) const
+  {
+    JointLimits l = limits[i];
+    l.has_velocity_limits = true;
+    l.has_effort_limits = true;
+    return l;
+  }
+
+  double random(double min, double max)
+  {
+    seed = seed * 1103515245 + 12345;
+    return min + (max - min) * ((seed >> 16) & 0x7fff) / 32767.0;
+  }
+
+  // New state and command, the same for the handles and the batch
+  void step()
+  {
+    for (size_t i = 0; i < JOINTS; ++i)
+    {
+      pos[i] = random(-2.0, 2.0);
+      vel[i] = random(-4.0, 4.0);
+      cmd[i] = random(-10.0, 10.0);
+      batch_cmd[i] = cmd[i];
+    }
+  }
+
+  void expectSameCommands(int s)
+  {
+    for (size_t i = 0; i < JOINTS; ++i)
+    {
+      EXPECT_EQ(cmd[i], batch_cmd[i]) << "joint " << i << ", step " << s;
+    }
+  }
+
+  vector<double> pos, vel, eff, cmd, batch_cmd;
+  vector<string> names;
+  vector<JointHandle> handles;
+  vector<JointLimits> limits;
+  vector<SoftJointLimits> soft_limits;
+  ros::Duration period;
+  unsigned seed;
+};
+
+TEST_F(JointLimitsBatchTest, BatchConstruction)
+{
+  JointLimits limits_bad;
+  EXPECT_THROW(PositionJointSoftLimitsBatch().addJoint("bad", limits_bad, soft_limits[0]),
+               JointLimitsInterfaceException);
+  EXPECT_THROW(VelocityJointSaturationBatch().addJoint("bad", limits_bad), JointLimitsInterfaceException);
+  limits_bad.has_velocity_limits = true;
+  EXPECT_THROW(EffortJointSaturationBatch().addJoint("bad", limits_bad), JointLimitsInterfaceException);
+  EXPECT_THROW(EffortJointSoftLimitsBatch().addJoint("bad", limits_bad, soft_limits[0]),
+               JointLimitsInterfaceException);
+
+  EXPECT_NO_THROW(PositionJointSaturationBatch().addJoint("good", JointLimits()));
+  EXPECT_NO_THROW(VelocityJointSoftLimitsBatch().addJoint("good", JointLimits(), SoftJointLimits()));
+
+  PositionJointSaturationBatch batch;
+  EXPECT_EQ(0u, batch.size());
+  batch.enforceLimits(period, &pos[0], &batch_cmd[0]); // no joint, no effect
+  batch.addJoint(names[0], limits[0]);
+  batch.addJoint(names[1], limits[1]);
+  EXPECT_EQ(2u, batch.size());
+  EXPECT_EQ(names[1], batch.getName(1));
+}
+
+TEST_F(JointLimitsBatchTest, PositionJointSaturation)
+{
+  PositionJointSaturationInterface iface;
+  PositionJointSaturationBatch batch;
+  for (size_t i = 0; i < JOINTS; ++i)
+  {
+    iface.registerHandle(PositionJointSaturationHandle(handles[i], limits[i]));
+    batch.addJoint(names[i], limits[i]);
+  }
+
+  for (int s = 0; s < 200; ++s)
+  {
+    if (s == 100)
+    {
+      iface.reset();
+      batch.reset();
+    }
+    step();
+    iface.enforceLimits(period);
+    batch.enforceLimits(period, &pos[0], &batch_cmd[0]);
+    expectSameCommands(s);
+  }
+}
+
+TEST_F(JointLimitsBatchTest, PositionJointSoftLimits)
+{
+  PositionJointSoftLimitsInterface iface;
+  PositionJointSoftLimitsBatch batch;
+  for (size_t i = 0; i < JOINTS; ++i)
+  {
+    iface.registerHandle(PositionJointSoftLimitsHandle(handles[i], withVelocityAndEffort(i), soft_limits[i]));
+    batch.addJoint(names[i], withVelocityAndEffort(i), soft_limits[i]);
+  }
+
+  for (int s = 0; s < 200; ++s)
+  {
+    if (s == 100)
+    {
+      iface.reset();
+      batch.reset();
+    }
+    step();
+    iface.enforceLimits(period);
+    batch.enforceLimits(period, &pos[0], &batch_cmd[0]);
+    expectSameCommands(s);
+  }
+}
+
+TEST_F(JointLimitsBatchTest, EffortJointSaturation)
+{
+  EffortJointSaturationInterface iface;
+  EffortJointSaturationBatch batch;
+  for (size_t i = 0; i < JOINTS; ++i)
+  {
+    iface.registerHandle(EffortJointSaturationHandle(handles[i], withVelocityAndEffort(i)));
+    batch.addJoint(names[i], withVelocityAndEffort(i));
+  }
+
+  for (int s = 0; s < 200; ++s)
+  {
+    step();
+    iface.enforceLimits(period);
+    batch.enforceLimits(period, &pos[0], &vel[0], &batch_cmd[0]);
+    expectSameCommands(s);
+  }
+}
+
+TEST_F(JointLimitsBatchTest, EffortJointSoftLimits)
+{
+  EffortJointSoftLimitsInterface iface;
+  EffortJointSoftLimitsBatch batch;
+  for (size_t i = 0; i < JOINTS; ++i)
+  {
+    iface.registerHandle(EffortJointSoftLimitsHandle(handles[i], withVelocityAndEffort(i), soft_limits[i]));
+    batch.addJoint(names[i], withVelocityAndEffort(i), soft_limits[i]);
+  }
+
+  for (int s = 0; s < 200; ++s)
+  {
+    step();
+    iface.enforceLimits(period);
+    batch.enforceLimits(period, &pos[0], &vel[0], &batch_cmd[0]);
+    expectSameCommands(s);
+  }
+}
+
+TEST_F(JointLimitsBatchTest, VelocityJointSaturation)
+{
+  VelocityJointSaturationInterface iface;
+  VelocityJointSaturationBatch batch;
+  for (size_t i = 0; i < JOINTS; ++i)
+  {
+    iface.registerHandle(VelocityJointSaturationHandle(handles[i], withVelocityAndEffort(i)));
+    batch.addJoint(names[i], withVelocityAndEffort(i));
+  }
+
+  for (int s = 0; s < 200; ++s)
+  {
+    step();
+    iface.enforceLimits(period);
+    batch.enforceLimits(period, &vel[0], &batch_cmd[0]);
+    expectSameCommands(s);
+  }
+}
+
+TEST_F(JointLimitsBatchTest, VelocityJointSoftLimits)
+{
+  VelocityJointSoftLimitsInterface iface;
+  VelocityJointSoftLimitsBatch batch;
+  for (size_t i = 0; i < JOINTS; ++i)
+  {
+    iface.registerHandle(VelocityJointSoftLimitsHandle(handles[i], limits[i], soft_limits[i]));
+    batch.addJoint(names[i], limits[i], soft_limits[i]);
+  }
+
+  for (int s = 0; s < 200; ++s)
+  {
+    step();
+    iface.enforceLimits(period);
+    batch.enforceLimits(period, &pos[0], &vel[0], &batch_cmd[0]);
+    expectSameCommands(s);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -481,6 +481,35 @@ TEST_F(JointLimitsHandleTest, ResetSaturationInterface)
 }
 
 
+TEST_F(JointLimitsHandleTest, ResetFrozenSaturationInterface)
+{
+  // Populate interface
+  PositionJointSaturationHandle limits_handle1(cmd_handle, limits);
+
+  PositionJointSaturationInterface iface;
+  iface.registerHandle(limits_handle1);
+  iface.freeze();
+  const std::size_t index = iface.getIndex(name);
+
+  iface.getHandle(index).enforceLimits(period); // initialize limit handles through their index
+
+  const double max_increment = period.toSec() * limits.max_velocity;
+
+  cmd_handle.setCommand(limits.max_position);
+  iface.enforceLimits(period);
+
+  EXPECT_NEAR(cmd_handle.getCommand(),  max_increment, EPS);
+
+  // the handle reset by the interface is the one accessed by index
+  iface.reset();
+  pos = limits.max_position;
+  cmd_handle.setCommand(limits.max_position);
+  iface.getHandle(index).enforceLimits(period);
+
+  EXPECT_NEAR(cmd_handle.getCommand(),  limits.max_position, EPS);
+}
+
+
 TEST_F(JointLimitsHandleTest, ResetSoftLimitsInterface)
 {
   // Populate interface
@@ -341,6 +341,8 @@ template <class HandleType>
 class TransmissionInterface : public hardware_interface::ResourceManager<HandleType>
 {
 public:
+  using hardware_interface::ResourceManager<HandleType>::getHandle;
+
 
   HandleType getHandle(const std::string& name)
   {
@@ -360,10 +362,9 @@ public:
   /** \brief Propagate the transmission maps of all managed handles. */
   void propagate()
   {
-    typedef typename hardware_interface::ResourceManager<HandleType>::ResourceMap::iterator ItratorType;
-    for (ItratorType it = this->resource_map_.begin(); it != this->resource_map_.end(); ++it)
+    for (std::size_t i = 0; i < this->handles_.size(); ++i)
     {
-      it->second.propagate();
+      this->handles_[i]->propagate();
     }
   }
   /*\}*/
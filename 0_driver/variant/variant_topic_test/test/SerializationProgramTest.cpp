@@ -0,0 +1,216 @@
+/******************************************************************************
+ * Copyright (C) 2014 by Ralf Kaestner                                        *
+ * ralf.kaestner@gmail.com                                                    *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the               *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+#include <variant_msgs/Test.h>
+
+#include <variant_topic_tools/ArrayVariant.h>
+#include <variant_topic_tools/DataTypeRegistry.h>
+#include <variant_topic_tools/MessageDefinition.h>
+#include <variant_topic_tools/MessageSerializer.h>
+#include <variant_topic_tools/MessageVariant.h>
+#include <variant_topic_tools/SerializationProgram.h>
+
+using namespace variant_topic_tools;
+
+namespace {
+  variant_msgs::Test createTestMessage() {
+    variant_msgs::Test m;
+    m.header.seq = 7;
+    m.header.stamp = ros::Time(42, 17);
+    m.header.frame_id = "frame";
+    m.builtin_int = 42;
+    m.builtin_boolean = true;
+    m.boolean.data = true;
+    m.builtin_string = "Test";
+    m.string.data = "Test";
+    m.builtin_int_array[0] = 0;
+    m.builtin_int_array[1] = 1;
+    m.builtin_int_array[2] = 2;
+    m.builtin_int_vector.resize(64, 3);
+    m.string_array[1].data = "Array";
+    m.string_vector.resize(16);
+    m.string_vector[3].data = "Vector";
+    m.builtin_boolean_array[2] = true;
+
+    return m;
+  }
+}
+
+TEST(SerializationProgram, Layout) {
+  DataTypeRegistry registry;
+
+  MessageType m1("my_msgs/Test", "*",
+    ros::message_traits::definition<variant_msgs::Test>());
+  MessageDataType t1 = MessageDefinition(m1).getMessageDataType();
+  SerializationProgram p1(t1);
+
+  variant_msgs::Test m2 = createTestMessage();
+  std::vector<uint8_t> d1(ros::serialization::serializationLength(m2));
+  ros::serialization::OStream o1(d1.data(), d1.size());
+  ros::serialization::serialize(o1, m2);
+
+  EXPECT_TRUE(p1.isValid());
+  EXPECT_TRUE(p1.hasInstructions());
+  EXPECT_EQ(t1.getMD5Sum(), p1.getIdentifier());
+  EXPECT_EQ(d1.size(), p1.getSerializedLength(d1.data(), d1.size()));
+  EXPECT_ANY_THROW(p1.getSerializedLength(d1.data(), d1.size()-1));
+
+  std::stringstream s1;
+  p1.save(s1);
+  SerializationProgram p2;
+  p2.load(s1);
+
+  EXPECT_EQ(p1.getIdentifier(), p2.getIdentifier());
+  EXPECT_EQ(p1.getLayout().size(), p2.getLayout().size());
+  EXPECT_FALSE(p2.hasInstructions());
+  EXPECT_EQ(d1.size(), p2.getSerializedLength(d1.data(), d1.size()));
+  EXPECT_ANY_THROW(p2.getSerializedLength(t1.createVariant()));
+
+  registry.clear();
+}
+
+TEST(SerializationProgram, Message) {
+  DataTypeRegistry registry;
+
+  MessageType m1("my_msgs/Test", "*",
+    ros::message_traits::definition<variant_msgs::Test>());
+  MessageDataType t1 = MessageDefinition(m1).getMessageDataType();
+  Serializer s1 = t1.createSerializer();
+  Serializer s2 = SerializationProgram::get(t1).createSerializer();
+
+  variant_msgs::Test m2 = createTestMessage();
+  std::vector<uint8_t> d1(ros::serialization::serializationLength(m2));
+  ros::serialization::OStream o1(d1.data(), d1.size());
+  ros::serialization::serialize(o1, m2);
+
+  MessageVariant v1 = t1.createVariant();
+  MessageVariant v2 = t1.createVariant();
+  ros::serialization::IStream i1(d1.data(), d1.size());
+  ros::serialization::IStream i2(d1.data(), d1.size());
+  s1.deserialize(i1, v1);
+  s2.deserialize(i2, v2);
+
+  EXPECT_EQ(v1, v2);
+  EXPECT_EQ(m2.builtin_int, v2["builtin_int"].getValue<int>());
+  EXPECT_EQ(m2.header.frame_id,
+    v2["header/frame_id"].getValue<std::string>());
+  EXPECT_EQ(m2.builtin_int_vector.size(),
+    ArrayVariant(v2["builtin_int_vector"]).getNumMembers());
+  EXPECT_EQ(m2.string_vector[3].data, MessageVariant(ArrayVariant(
+    v2["string_vector"])[3])["data"].getValue<std::string>());
+  EXPECT_EQ(s1.getSerializedLength(v1), s2.getSerializedLength(v2));
+
+  std::vector<uint8_t> d2(d1.size());
+  ros::serialization::OStream o2(d2.data(), d2.size());
+  s2.serialize(o2, v2);
+
+  EXPECT_EQ(d1, d2);
+  EXPECT_EQ(SerializationProgram::get(t1).getIdentifier(),
+    SerializationProgram::find(t1.getMD5Sum()).getIdentifier());
+
+  SerializationProgram::clearCache();
+  registry.clear();
+}
+
+TEST(SerializationProgram, StrongTyped) {
+  DataTypeRegistry registry;
+
+  MessageType m1("variant_msgs/Test",
+    ros::message_traits::md5sum<variant_msgs::Test>(),
+    ros::message_traits::definition<variant_msgs::Test>());
+  MessageDataType t1 = MessageDefinition(m1).getMessageDataType();
+  MessageDataType t2 = registry.addMessageDataType<variant_msgs::Test>();
+  SerializationProgram p2 = SerializationProgram::get(t2);
+  SerializationProgram p1 = SerializationProgram::get(t1);
+
+  EXPECT_EQ(p1.getIdentifier(), p2.getIdentifier());
+  EXPECT_EQ(1, p2.getNumInstructions());
+  EXPECT_LT(1, p1.getNumInstructions());
+
+  variant_msgs::Test m2 = createTestMessage();
+  std::vector<uint8_t> d1(ros::serialization::serializationLength(m2));
+  ros::serialization::OStream o1(d1.data(), d1.size());
+  ros::serialization::serialize(o1, m2);
+
+  MessageVariant v1 = t1.createVariant();
+  MessageVariant v2 = t2.createVariant();
+  ros::serialization::IStream i1(d1.data(), d1.size());
+  ros::serialization::IStream i2(d1.data(), d1.size());
+  p1.deserialize(i1, v1);
+  p2.deserialize(i2, v2);
+
+  EXPECT_EQ(m2.builtin_int, v1["builtin_int"].getValue<int>());
+  EXPECT_EQ(m2.builtin_int, v2["builtin_int"].getValue<int>());
+
+  std::vector<uint8_t> d2(d1.size());
+  ros::serialization::OStream o2(d2.data(), d2.size());
+  p1.serialize(o2, v1);
+
+  EXPECT_EQ(d1, d2);
+
+  SerializationProgram::clearCache();
+  registry.clear();
+}
+
+TEST(SerializationProgram, ArrayMessage) {
+  DataTypeRegistry registry;
+
+  registry.addMessageDataType("my_msgs/Point", "float64 x\n"
+    "float64 y\nfloat64 z");
+  MessageDataType t1 = registry.addMessageDataType("my_msgs/Cloud",
+    "my_msgs/Point[] points\nfloat32[] intensities\nstring[] labels");
+  Serializer s1 = t1.createSerializer();
+  Serializer s2 = SerializationProgram::get(t1).createSerializer();
+
+  MessageVariant v1 = t1.createVariant();
+  ArrayVariant points = v1["points"];
+  ArrayVariant labels = v1["labels"];
+  points.resize(16);
+  labels.resize(4);
+  for (size_t i = 0; i < 16; ++i) {
+    MessageVariant point = points[i];
+    point["x"] = (double)i;
+  }
+  labels[2] = std::string("Label");
+
+  EXPECT_EQ(s1.getSerializedLength(v1), s2.getSerializedLength(v1));
+
+  std::vector<uint8_t> d1(s1.getSerializedLength(v1));
+  ros::serialization::OStream o1(d1.data(), d1.size());
+  s1.serialize(o1, v1);
+  std::vector<uint8_t> d2(d1.size());
+  ros::serialization::OStream o2(d2.data(), d2.size());
+  s2.serialize(o2, v1);
+
+  EXPECT_EQ(d1, d2);
+  EXPECT_EQ(d1.size(), SerializationProgram::get(t1).getSerializedLength(
+    d1.data(), d1.size()));
+
+  MessageVariant v2 = t1.createVariant();
+  ros::serialization::IStream i2(d2.data(), d2.size());
+  s2.deserialize(i2, v2);
+
+  EXPECT_EQ(v1, v2);
+
+  SerializationProgram::clearCache();
+  registry.clear();
+}
@@ -0,0 +1,109 @@
+/******************************************************************************
+ * Copyright (C) 2014 by Ralf Kaestner                                        *
+ * ralf.kaestner@gmail.com                                                    *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the               *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file serialization_program_benchmark.cpp
+  * \brief Timing of the serializer tree against the serialization program,
+  *   on a nested and on an array-heavy message
+  *
+  * usage: serialization_program_benchmark [runs]
+  */
+
+#include <cstdlib>
+#include <iostream>
+
+#include <variant_msgs/Test.h>
+
+#include <variant_topic_tools/ArrayVariant.h>
+#include <variant_topic_tools/DataTypeRegistry.h>
+#include <variant_topic_tools/MessageDefinition.h>
+#include <variant_topic_tools/MessageSerializer.h>
+#include <variant_topic_tools/MessageVariant.h>
+#include <variant_topic_tools/SerializationProgram.h>
+
+using namespace variant_topic_tools;
+
+namespace {
+  double benchmark(Serializer serializer, const DataType& dataType,
+      std::vector<uint8_t>& data, size_t numRuns) {
+    Variant variant = dataType.createVariant();
+    ros::WallTime start = ros::WallTime::now();
+
+    for (size_t i = 0; i < numRuns; ++i) {
+      ros::serialization::IStream i1(data.data(), data.size());
+      serializer.deserialize(i1, variant);
+      ros::serialization::OStream o1(data.data(), data.size());
+      serializer.serialize(o1, variant);
+    }
+
+    return (ros::WallTime::now()-start).toSec()/numRuns;
+  }
+}
+
+int main(int argc, char** argv) {
+  DataTypeRegistry registry;
+  const size_t numRuns = (argc > 1) ? std::atoi(argv[1]) : 1000;
+
+  MessageType m1("my_msgs/Test", "*",
+    ros::message_traits::definition<variant_msgs::Test>());
+  MessageDataType t1 = MessageDefinition(m1).getMessageDataType();
+  registry.addMessageDataType("my_msgs/Point", "float64 x\n"
+    "float64 y\nfloat64 z");
+  MessageDataType t2 = registry.addMessageDataType("my_msgs/Cloud",
+    "my_msgs/Point[] points\nfloat32[] intensities\nstring[] labels");
+
+  variant_msgs::Test m2;
+  m2.header.frame_id = "frame";
+  m2.builtin_string = "Test";
+  m2.builtin_int_vector.resize(64, 3);
+  m2.string_vector.resize(16);
+  std::vector<uint8_t> d1(ros::serialization::serializationLength(m2));
+  ros::serialization::OStream o1(d1.data(), d1.size());
+  ros::serialization::serialize(o1, m2);
+
+  MessageVariant v2 = t2.createVariant();
+  ArrayVariant points = v2["points"];
+  ArrayVariant intensities = v2["intensities"];
+  ArrayVariant labels = v2["labels"];
+  points.resize(512);
+  intensities.resize(512);
+  labels.resize(32);
+  for (size_t i = 0; i < 512; ++i) {
+    MessageVariant point = points[i];
+    point["x"] = (double)i;
+  }
+  std::vector<uint8_t> d2(t2.createSerializer().getSerializedLength(v2));
+  ros::serialization::OStream o2(d2.data(), d2.size());
+  t2.createSerializer().serialize(o2, v2);
+
+  double tree1 = benchmark(t1.createSerializer(), t1, d1, numRuns);
+  double program1 = benchmark(SerializationProgram::get(t1).
+    createSerializer(), t1, d1, numRuns);
+  double tree2 = benchmark(t2.createSerializer(), t2, d2, numRuns/10+1);
+  double program2 = benchmark(SerializationProgram::get(t2).
+    createSerializer(), t2, d2, numRuns/10+1);
+
+  std::cout << "nested message: tree " << tree1*1e6 << " us, program " <<
+    program1*1e6 << " us" << std::endl;
+  std::cout << "array message: tree " << tree2*1e6 << " us, program " <<
+    program2*1e6 << " us" << std::endl;
+
+  SerializationProgram::clearCache();
+  registry.clear();
+
+  return 0;
+}
@@ -34,6 +34,7 @@ namespace variant_topic_tools {
   class ArrayVariant :
     public CollectionVariant {
   friend class ArrayDataType;
+  friend class SerializationProgram;
   friend class Variant;
   public:
     /** \brief Default constructor
@@ -91,6 +91,10 @@ namespace variant_topic_tools {
     */
   class MessageSerializer;
   
+  /** \brief Forward declaration of the serialization program
+    */
+  class SerializationProgram;
+  
   /** \brief Forward declaration of the variant
     */
   class Variant;
@@ -25,6 +25,7 @@
 
 #include <variant_topic_tools/MessageFieldCollection.h>
 #include <variant_topic_tools/MessageTypeTraits.h>
+#include <variant_topic_tools/SerializationProgram.h>
 #include <variant_topic_tools/Serializer.h>
 
 namespace variant_topic_tools {
@@ -34,6 +35,7 @@ namespace variant_topic_tools {
     public Serializer {
   friend class MessageDataType;
   friend class MessageVariant;
+  friend class SerializationProgram;
   public:
     /** \brief Default constructor
       */ 
@@ -99,6 +101,38 @@ namespace variant_topic_tools {
       MessageFieldCollection<Serializer> memberSerializers;
     };
     
+    /** \brief Message serializer implementation (precompiled version)
+      */
+    class ImplP :
+      public Impl {
+    public:
+      /** \brief Constructor
+        */
+      ImplP(const SerializationProgram& program);
+      
+      /** \brief Destructor
+        */
+      virtual ~ImplP();
+    
+      /** \brief Retrieve the serialized length of a variant value
+        *   (implementation)
+        */ 
+      size_t getSerializedLength(const Variant& value) const;
+      
+      /** \brief Serialize a variant value (implementation)
+        */ 
+      void serialize(ros::serialization::OStream& stream, const
+        Variant& value);
+      
+      /** \brief Deserialize a variant value (implementation)
+        */ 
+      void deserialize(ros::serialization::IStream& stream, Variant& value);
+        
+      /** \brief The serialization program
+        */
+      SerializationProgram program;
+    };
+    
     /** \brief Message serializer implementation (templated strong-typed
       *   version)
       */
@@ -140,6 +174,10 @@ namespace variant_topic_tools {
     MessageSerializer(const MessageFieldCollection<Serializer>&
       memberSerializers);
     
+    /** \brief Constructor (overloaded version taking a serialization
+      *   program)
+      */ 
+    MessageSerializer(const SerializationProgram& program);
     
     /** \brief Create a message serializer
       */ 
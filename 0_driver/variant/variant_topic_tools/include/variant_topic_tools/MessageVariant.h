@@ -35,6 +35,7 @@ namespace variant_topic_tools {
   class MessageVariant :
     public CollectionVariant {
   friend class MessageDataType;
+  friend class SerializationProgram;
   friend class Variant;
   public:
     /** \brief Default constructor
@@ -0,0 +1,422 @@
+/******************************************************************************
+ * Copyright (C) 2014 by Ralf Kaestner                                        *
+ * ralf.kaestner@gmail.com                                                    *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the               *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+/** \file SerializationProgram.h
+  * \brief Header file providing the SerializationProgram class interface
+  */
+
+#ifndef VARIANT_TOPIC_TOOLS_SERIALIZATION_PROGRAM_H
+#define VARIANT_TOPIC_TOOLS_SERIALIZATION_PROGRAM_H
+
+#include <utility>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <ros/ros.h>
+
+#include <variant_topic_tools/DataType.h>
+#include <variant_topic_tools/Forwards.h>
+#include <variant_topic_tools/Serializer.h>
+
+namespace variant_topic_tools {
+  /** \brief Precompiled serialization program
+    *
+    * A serialization program is the flattened form of the serializer tree
+    * built for a data type. It consists of two linear instruction lists
+    * which are executed by a non-recursive interpreter loop:
+    *
+    * - The variant instructions visit the members of a variant value in
+    *   wire order and carry a direct reference to the read, write, and
+    *   measure routine of each built-in leaf, thus avoiding the virtual
+    *   serializer dispatch per member. Runs of consecutive fixed-size
+    *   built-in members are measured at once and read or written within
+    *   a single stream advance.
+    * - The layout instructions describe the wire format only, with runs of
+    *   consecutive fixed-size members coalesced into single copy operations
+    *   and length-prefixed arrays of fixed-size members reduced to a single
+    *   sequence operation. They operate on serialized data without any
+    *   variant value and can be persisted to disk.
+    *
+    * Programs are cached process-wide by the MD5 sum of the message data
+    * type they were compiled for and by whether this data type is
+    * strong-typed.
+    */
+  class SerializationProgram {
+  public:
+    /** \brief Definition of the layout operation codes
+      */
+    enum LayoutOpcode {
+      Copy,
+      String,
+      Sequence,
+      Loop,
+      End
+    };
+
+    /** \brief Definition of the layout instruction type
+      */
+    struct LayoutInstruction {
+      /** \brief Constructor
+        */
+      LayoutInstruction(LayoutOpcode opcode = Copy, size_t size = 0,
+        size_t numMembers = 0, size_t jump = 0);
+
+      /** \brief The operation code of this instruction
+        */
+      LayoutOpcode opcode;
+
+      /** \brief The number of bytes copied by a copy instruction or the
+        *   member size of a sequence instruction
+        */
+      size_t size;
+
+      /** \brief The number of iterations of a fixed-size loop instruction,
+        *   zero for a length-prefixed loop
+        */
+      size_t numMembers;
+
+      /** \brief The index of the matching loop or end instruction
+        */
+      size_t jump;
+    };
+
+    /** \brief Default constructor
+      */
+    SerializationProgram();
+
+    /** \brief Constructor (overloaded version taking a data type)
+      *
+      * \note This constructor compiles the program for the specified data
+      *   type. Use get() in order to share compiled programs.
+      */
+    SerializationProgram(const DataType& dataType);
+
+    /** \brief Copy constructor
+      */
+    SerializationProgram(const SerializationProgram& src);
+
+    /** \brief Destructor
+      */
+    ~SerializationProgram();
+
+    /** \brief Retrieve the data type this program was compiled for
+      *
+      * \note The data type of a program loaded from disk is invalid.
+      */
+    const DataType& getDataType() const;
+
+    /** \brief Retrieve the identifier of this program
+      *
+      * \note For message data types, the identifier is the MD5 sum of
+      *   the message definition.
+      */
+    const std::string& getIdentifier() const;
+
+    /** \brief Retrieve the number of variant instructions
+      */
+    size_t getNumInstructions() const;
+
+    /** \brief Retrieve the layout instructions
+      */
+    const std::vector<LayoutInstruction>& getLayout() const;
+
+    /** \brief Retrieve the serialized length of a variant value
+      */
+    size_t getSerializedLength(const Variant& value) const;
+
+    /** \brief Retrieve the serialized length of serialized data
+      *
+      * \note This method only executes the layout instructions and
+      *   therefore does not require any variant value. It throws an
+      *   exception if the data is truncated.
+      */
+    size_t getSerializedLength(const uint8_t* data, size_t size) const;
+
+    /** \brief True, if this program supports variant serialization
+      */
+    bool hasInstructions() const;
+
+    /** \brief True, if this program is valid
+      */
+    bool isValid() const;
+
+    /** \brief Serialize a variant value to an output stream
+      */
+    void serialize(ros::serialization::OStream& stream, const Variant&
+      value) const;
+
+    /** \brief Deserialize a variant value from an input stream
+      */
+    void deserialize(ros::serialization::IStream& stream, Variant& value)
+      const;
+
+    /** \brief Advance a stream by the length of the serialized data it
+      *   currently points to
+      */
+    void advance(ros::serialization::Stream& stream) const;
+
+    /** \brief Create a message serializer executing this program
+      */
+    MessageSerializer createSerializer() const;
+
+    /** \brief Save the layout instructions of this program to a stream
+      */
+    void save(std::ostream& stream) const;
+
+    /** \brief Load layout instructions from a stream
+      */
+    void load(std::istream& stream);
+
+    /** \brief Write the program to a stream
+      */
+    void write(std::ostream& stream) const;
+
+    /** \brief Retrieve the shared program for a data type, compiling it
+      *   on first use
+      */
+    static SerializationProgram get(const DataType& dataType);
+
+    /** \brief Find a program by identifier
+      *
+      * \note If the program has not been compiled in this process, the
+      *   cache directory is searched for a persisted layout. A program
+      *   loaded this way only supports the layout operations. If no
+      *   program can be found, the returned program will be invalid.
+      */
+    static SerializationProgram find(const std::string& identifier);
+
+    /** \brief Set the directory used for persisting compiled programs
+      *
+      * \note An empty directory disables persistence.
+      */
+    static void setCacheDirectory(const std::string& directory);
+
+    /** \brief Retrieve the directory used for persisting compiled programs
+      */
+    static std::string getCacheDirectory();
+
+    /** \brief Clear the process-wide program cache
+      */
+    static void clearCache();
+
+    /** \brief Void pointer conversion
+      */
+    inline operator void*() const {
+      return (impl) ? (void*)1 : (void*)0;
+    };
+
+  protected:
+    /** \brief Definition of the variant operation codes
+      */
+    enum Opcode {
+      Builtin,
+      Typed,
+      Fixed,
+      BeginMessage,
+      EndMessage,
+      BeginArray,
+      EndArray
+    };
+
+    /** \brief Definition of the built-in read function type
+      */
+    typedef void (*ReadFunction)(ros::serialization::IStream&, Variant&);
+
+    /** \brief Definition of the built-in write function type
+      */
+    typedef void (*WriteFunction)(ros::serialization::OStream&, const
+      Variant&);
+
+    /** \brief Definition of the built-in measure function type
+      */
+    typedef size_t (*MeasureFunction)(const Variant&);
+
+    /** \brief Definition of the variant instruction type
+      */
+    struct Instruction {
+      /** \brief Default constructor
+        */
+      Instruction(Opcode opcode = Builtin);
+
+      /** \brief The operation code of this instruction
+        */
+      Opcode opcode;
+
+      /** \brief The number of array members, zero for dynamic arrays, or
+        *   the number of members of a fixed-size run
+        */
+      size_t numMembers;
+
+      /** \brief The index of the matching begin or end instruction, or
+        *   the index past a fixed-size run
+        */
+      size_t jump;
+
+      /** \brief The read function of a built-in instruction
+        */
+      ReadFunction read;
+
+      /** \brief The write function of a built-in instruction
+        */
+      WriteFunction write;
+
+      /** \brief The measure function of a built-in instruction
+        */
+      MeasureFunction measure;
+
+      /** \brief The fixed serialized length of a built-in instruction or
+        *   a fixed-size run, zero if the length depends on the value
+        */
+      size_t size;
+
+      /** \brief The delegate serializer of a strong-typed instruction
+        */
+      mutable Serializer serializer;
+    };
+
+    /** \brief Definition of the interpreter frame type
+      */
+    struct Frame;
+
+    /** \brief Definition of the interpreter frame stack type
+      */
+    class FrameStack;
+
+    /** \brief Serialization program implementation
+      */
+    class Impl {
+    public:
+      /** \brief Default constructor
+        */
+      Impl();
+
+      /** \brief Destructor
+        */
+      ~Impl();
+
+      /** \brief Compile the instructions for a data type
+        */
+      void compile(const DataType& dataType, size_t depth);
+
+      /** \brief Compile the layout instructions for a data type
+        */
+      void compileLayout(const DataType& dataType);
+
+      /** \brief Append a copy instruction to the layout, coalescing it
+        *   with a preceding copy instruction
+        */
+      void appendCopy(size_t size);
+
+      /** \brief The data type this program was compiled for
+        */
+      DataType dataType;
+
+      /** \brief The identifier of this program
+        */
+      std::string identifier;
+
+      /** \brief The variant instructions
+        */
+      std::vector<Instruction> instructions;
+
+      /** \brief The layout instructions
+        */
+      std::vector<LayoutInstruction> layout;
+
+      /** \brief The maximum nesting depth of the variant instructions
+        */
+      size_t maxDepth;
+    };
+
+    /** \brief Declaration of the program implementation pointer type
+      */
+    typedef boost::shared_ptr<Impl> ImplPtr;
+
+    /** \brief Declaration of the program implementation weak pointer type
+      */
+    typedef boost::weak_ptr<Impl> ImplWPtr;
+
+    /** \brief Declaration of the program cache key type, the identifier
+      *   and whether the data type is strong-typed
+      */
+    typedef std::pair<std::string, bool> CacheKey;
+
+    /** \brief Program cache
+      */
+    class Cache {
+    public:
+      /** \brief Default constructor
+        */
+      Cache();
+
+      /** \brief Destructor
+        */
+      ~Cache();
+
+      /** \brief The mutex guarding the cache
+        */
+      boost::mutex mutex;
+
+      /** \brief The cached programs by key
+        */
+      boost::unordered_map<CacheKey, ImplPtr> programs;
+
+      /** \brief The directory used for persisting compiled programs
+        */
+      std::string directory;
+    };
+
+    /** \brief Declaration of the program cache pointer type
+      */
+    typedef boost::shared_ptr<Cache> CachePtr;
+
+    /** \brief The program's implementation
+      */
+    ImplPtr impl;
+
+    /** \brief The process-wide program cache
+      */
+    static CachePtr cache;
+
+    /** \brief Retrieve the identifier of a data type
+      */
+    static std::string getIdentifier(const DataType& dataType);
+
+    /** \brief Retrieve the cache key of a data type
+      *
+      * \note A strong-typed data type is compiled into a single delegating
+      *   instruction which cannot serialize the variant-typed data type
+      *   of the same MD5 sum. The two are thus cached separately.
+      */
+    static CacheKey getKey(const DataType& dataType);
+
+    /** \brief Retrieve the file name of a persisted program
+      */
+    static std::string getFilename(const std::string& directory, const
+      std::string& identifier);
+  };
+
+  /** \brief Operator for writing the serialization program to a stream
+    */
+  std::ostream& operator<<(std::ostream& stream, const SerializationProgram&
+    program);
+};
+
+#endif
@@ -38,6 +38,7 @@ namespace variant_topic_tools {
     */
   class Variant {
   friend class MessageVariable;
+  friend class SerializationProgram;
   public:
     /** \brief Default constructor
       */
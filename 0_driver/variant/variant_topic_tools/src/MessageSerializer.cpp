@@ -33,6 +33,10 @@ MessageSerializer::MessageSerializer(const MessageFieldCollection<Serializer>&
   impl.reset(new ImplV(memberSerializers));
 }
 
+MessageSerializer::MessageSerializer(const SerializationProgram& program) {
+  impl.reset(new ImplP(program));
+}
+
 MessageSerializer::MessageSerializer(const MessageSerializer& src) :
   Serializer(src) {
 }
@@ -60,6 +64,13 @@ MessageSerializer::ImplV::ImplV(const MessageFieldCollection<Serializer>&
 MessageSerializer::ImplV::~ImplV() {
 }
 
+MessageSerializer::ImplP::ImplP(const SerializationProgram& program) :
+  program(program) {
+}
+
+MessageSerializer::ImplP::~ImplP() {
+}
+
 /*****************************************************************************/
 /* Accessors                                                                 */
 /*****************************************************************************/
@@ -76,6 +87,11 @@ size_t MessageSerializer::ImplV::getSerializedLength(const Variant& value)
   return length;
 }
 
+size_t MessageSerializer::ImplP::getSerializedLength(const Variant& value)
+    const {
+  return program.getSerializedLength(value);
+}
+
 /*****************************************************************************/
 /* Methods                                                                   */
 /*****************************************************************************/
@@ -98,4 +114,14 @@ void MessageSerializer::ImplV::deserialize(ros::serialization::IStream& stream,
   }
 }
 
+void MessageSerializer::ImplP::serialize(ros::serialization::OStream& stream,
+    const Variant& value) {
+  program.serialize(stream, value);
+}
+
+void MessageSerializer::ImplP::deserialize(ros::serialization::IStream& stream,
+    Variant& value) {
+  program.deserialize(stream, value);
+}
+
 }
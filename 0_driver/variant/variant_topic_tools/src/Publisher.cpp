@@ -22,6 +22,7 @@
 #include "variant_topic_tools/Exceptions.h"
 #include "variant_topic_tools/Message.h"
 #include "variant_topic_tools/Publisher.h"
+#include "variant_topic_tools/SerializationProgram.h"
 
 namespace variant_topic_tools {
 
@@ -52,7 +53,7 @@ Publisher::Impl::Impl(ros::NodeHandle& nodeHandle, const MessageType&
     dataType = definition.getMessageDataType();
   }
   
-  serializer = dataType.createSerializer();  
+  serializer = SerializationProgram::get(dataType).createSerializer();
   
   ros::AdvertiseOptions options(topic, queueSize, type.getMD5Sum(),
     type.getDataType(), type.getDefinition(), connectCallback);
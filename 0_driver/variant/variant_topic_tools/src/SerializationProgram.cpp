@@ -0,0 +1,908 @@
+/******************************************************************************
+ * Copyright (C) 2014 by Ralf Kaestner                                        *
+ * ralf.kaestner@gmail.com                                                    *
+ *                                                                            *
+ * This program is free software; you can redistribute it and/or modify       *
+ * it under the terms of the Lesser GNU General Public License as published by*
+ * the Free Software Foundation; either version 3 of the License, or          *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the               *
+ * Lesser GNU General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the Lesser GNU General Public License   *
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.       *
+ ******************************************************************************/
+
+#include <cstring>
+#include <fstream>
+
+#include "variant_topic_tools/ArrayDataType.h"
+#include "variant_topic_tools/ArrayVariant.h"
+#include "variant_topic_tools/CollectionVariant.h"
+#include "variant_topic_tools/Exceptions.h"
+#include "variant_topic_tools/MessageDataType.h"
+#include "variant_topic_tools/MessageSerializer.h"
+#include "variant_topic_tools/MessageVariable.h"
+#include "variant_topic_tools/MessageVariant.h"
+#include "variant_topic_tools/SerializationProgram.h"
+
+namespace variant_topic_tools {
+
+/*****************************************************************************/
+/* Built-in instruction functions                                            */
+/*****************************************************************************/
+
+namespace {
+  template <typename T> void readBuiltin(ros::serialization::IStream& stream,
+      Variant& value) {
+    ros::serialization::deserialize(stream, value.template getValue<T>());
+  }
+
+  template <typename T> void writeBuiltin(ros::serialization::OStream&
+      stream, const Variant& value) {
+    ros::serialization::serialize(stream, value.template getValue<T>());
+  }
+
+  template <typename T> size_t measureBuiltin(const Variant& value) {
+    return ros::serialization::serializationLength(
+      value.template getValue<T>());
+  }
+
+  template <typename T, typename I> bool bindBuiltin(const DataType& type,
+      I& instruction) {
+    if (type.getTypeInfo() != typeid(T))
+      return false;
+
+    instruction.read = &readBuiltin<T>;
+    instruction.write = &writeBuiltin<T>;
+    instruction.measure = &measureBuiltin<T>;
+    instruction.size = type.isFixedSize() ? type.getSize() : 0;
+
+    return true;
+  }
+
+  uint32_t readLength(const uint8_t* data, size_t size, size_t position) {
+    if (position+sizeof(uint32_t) > size)
+      ros::serialization::throwStreamOverrun();
+
+    uint32_t length;
+    std::memcpy(&length, data+position, sizeof(uint32_t));
+
+    return length;
+  }
+}
+
+/*****************************************************************************/
+/* Static initializations                                                    */
+/*****************************************************************************/
+
+SerializationProgram::CachePtr SerializationProgram::cache(
+  new SerializationProgram::Cache());
+
+/*****************************************************************************/
+/* Interpreter frame                                                         */
+/*****************************************************************************/
+
+struct SerializationProgram::Frame {
+  Frame() :
+    messageMembers(0),
+    arrayMembers(0),
+    member(0),
+    numMembers(0) {
+  };
+
+  void set(const Variant& value) {
+    collection = value;
+    member = 0;
+    numMembers = collection.getNumMembers();
+
+    // the members of variant-typed collections are visited in place, the
+    // ones of strong-typed collections are built per member
+    MessageVariant::ValueImplV* messageValue = dynamic_cast<
+      MessageVariant::ValueImplV*>(collection.value.get());
+    ArrayVariant::ValueImplV* arrayValue = dynamic_cast<
+      ArrayVariant::ValueImplV*>(collection.value.get());
+
+    messageMembers = messageValue ? &messageValue->members : 0;
+    arrayMembers = arrayValue ? &arrayValue->members : 0;
+  };
+
+  inline Variant& next() {
+    if (messageMembers)
+      return messageMembers->getField(member++).getValue();
+    else if (arrayMembers)
+      return (*arrayMembers)[member++];
+    else {
+      current = collection[member++];
+      return current;
+    }
+  };
+
+  CollectionVariant collection;
+  MessageFieldCollection<Variant>* messageMembers;
+  std::vector<Variant>* arrayMembers;
+  Variant current;
+  size_t member;
+  size_t numMembers;
+};
+
+/*****************************************************************************/
+/* Interpreter frame stack                                                   */
+/*****************************************************************************/
+
+class SerializationProgram::FrameStack {
+public:
+  FrameStack(size_t maxDepth) :
+    frames(local),
+    size(0) {
+    if (maxDepth+1 > sizeof(local)/sizeof(local[0])) {
+      heap.resize(maxDepth+1);
+      frames = &heap[0];
+    }
+  };
+
+  inline bool empty() const {
+    return !size;
+  };
+
+  inline Frame& back() {
+    return frames[size-1];
+  };
+
+  inline Frame& push(const Variant& value) {
+    frames[size].set(value);
+    return frames[size++];
+  };
+
+  inline void pop() {
+    --size;
+  };
+
+private:
+  // the frames of the usual nesting depths live on the stack of the call
+  Frame local[8];
+  std::vector<Frame> heap;
+  Frame* frames;
+  size_t size;
+};
+
+/*****************************************************************************/
+/* Constructors and Destructor                                               */
+/*****************************************************************************/
+
+SerializationProgram::SerializationProgram() {
+}
+
+SerializationProgram::SerializationProgram(const DataType& dataType) :
+  impl(new Impl()) {
+  impl->dataType = dataType;
+  impl->identifier = getIdentifier(dataType);
+
+  impl->compile(dataType, 0);
+  impl->compileLayout(dataType);
+}
+
+SerializationProgram::SerializationProgram(const SerializationProgram& src) :
+  impl(src.impl) {
+}
+
+SerializationProgram::~SerializationProgram() {
+}
+
+SerializationProgram::LayoutInstruction::LayoutInstruction(LayoutOpcode
+    opcode, size_t size, size_t numMembers, size_t jump) :
+  opcode(opcode),
+  size(size),
+  numMembers(numMembers),
+  jump(jump) {
+}
+
+SerializationProgram::Instruction::Instruction(Opcode opcode) :
+  opcode(opcode),
+  numMembers(0),
+  jump(0),
+  read(0),
+  write(0),
+  measure(0),
+  size(0) {
+}
+
+SerializationProgram::Impl::Impl() :
+  maxDepth(0) {
+}
+
+SerializationProgram::Impl::~Impl() {
+}
+
+SerializationProgram::Cache::Cache() {
+}
+
+SerializationProgram::Cache::~Cache() {
+}
+
+/*****************************************************************************/
+/* Accessors                                                                 */
+/*****************************************************************************/
+
+const DataType& SerializationProgram::getDataType() const {
+  if (!impl) {
+    static DataType dataType;
+    return dataType;
+  }
+  else
+    return impl->dataType;
+}
+
+const std::string& SerializationProgram::getIdentifier() const {
+  if (!impl) {
+    static std::string identifier;
+    return identifier;
+  }
+  else
+    return impl->identifier;
+}
+
+size_t SerializationProgram::getNumInstructions() const {
+  if (impl)
+    return impl->instructions.size();
+  else
+    return 0;
+}
+
+const std::vector<SerializationProgram::LayoutInstruction>&
+    SerializationProgram::getLayout() const {
+  if (!impl) {
+    static std::vector<LayoutInstruction> layout;
+    return layout;
+  }
+  else
+    return impl->layout;
+}
+
+size_t SerializationProgram::getSerializedLength(const Variant& value)
+    const {
+  if (!hasInstructions())
+    throw InvalidOperationException(
+      "Attempted variant operation on a layout-only serialization program");
+
+  const std::vector<Instruction>& instructions = impl->instructions;
+  FrameStack frames(impl->maxDepth);
+
+  size_t length = 0;
+  size_t i = 0;
+
+  while (i < instructions.size()) {
+    const Instruction& instruction = instructions[i];
+
+    switch (instruction.opcode) {
+      case Builtin:
+        if (instruction.size) {
+          length += instruction.size;
+          if (!frames.empty())
+            ++frames.back().member;
+        }
+        else
+          length += instruction.measure(frames.empty() ? value :
+            frames.back().next());
+        ++i;
+        break;
+      case Typed:
+        length += instruction.serializer.getSerializedLength(frames.empty() ?
+          value : frames.back().next());
+        ++i;
+        break;
+      case Fixed:
+        length += instruction.size;
+        frames.back().member += instruction.numMembers;
+        i = instruction.jump;
+        break;
+      case BeginMessage:
+        if (instruction.size) {
+          length += instruction.size;
+          if (!frames.empty())
+            ++frames.back().member;
+          i = instruction.jump+1;
+        }
+        else {
+          frames.push(frames.empty() ? value : frames.back().next());
+          ++i;
+        }
+        break;
+      case BeginArray:
+        if (instruction.numMembers && instruction.size) {
+          length += instruction.numMembers*instruction.size;
+          if (!frames.empty())
+            ++frames.back().member;
+          i = instruction.jump+1;
+        }
+        else {
+          Frame& frame = frames.push(frames.empty() ? value :
+            frames.back().next());
+
+          if (!instruction.numMembers)
+            length += sizeof(uint32_t);
+
+          if (instruction.size || !frame.numMembers) {
+            length += frame.numMembers*instruction.size;
+            frames.pop();
+            i = instruction.jump+1;
+          }
+          else
+            ++i;
+        }
+        break;
+      case EndArray:
+        if (frames.back().member < frames.back().numMembers) {
+          i = instruction.jump+1;
+          break;
+        }
+        // all members visited, the array frame is popped like a message's
+      case EndMessage:
+        frames.pop();
+        ++i;
+        break;
+    }
+  }
+
+  return length;
+}
+
+size_t SerializationProgram::getSerializedLength(const uint8_t* data, size_t
+    size) const {
+  if (!impl)
+    throw InvalidOperationException(
+      "Attempted use of an invalid serialization program");
+
+  const std::vector<LayoutInstruction>& layout = impl->layout;
+  std::vector<std::pair<size_t, size_t> > loops;
+
+  size_t position = 0;
+  size_t i = 0;
+
+  while (i < layout.size()) {
+    const LayoutInstruction& instruction = layout[i];
+
+    switch (instruction.opcode) {
+      case Copy:
+        position += instruction.size;
+        ++i;
+        break;
+      case String:
+        position += sizeof(uint32_t)+readLength(data, size, position);
+        ++i;
+        break;
+      case Sequence:
+        position += sizeof(uint32_t)+instruction.size*
+          readLength(data, size, position);
+        ++i;
+        break;
+      case Loop: {
+          size_t numMembers = instruction.numMembers;
+
+          if (!numMembers) {
+            numMembers = readLength(data, size, position);
+            position += sizeof(uint32_t);
+          }
+
+          if (numMembers) {
+            loops.push_back(std::make_pair(i, numMembers));
+            ++i;
+          }
+          else
+            i = instruction.jump+1;
+        }
+        break;
+      case End:
+        if (--loops.back().second)
+          i = loops.back().first+1;
+        else {
+          loops.pop_back();
+          ++i;
+        }
+        break;
+    }
+
+    if (position > size)
+      ros::serialization::throwStreamOverrun();
+  }
+
+  return position;
+}
+
+bool SerializationProgram::hasInstructions() const {
+  return impl && !impl->instructions.empty();
+}
+
+bool SerializationProgram::isValid() const {
+  return impl;
+}
+
+std::string SerializationProgram::getIdentifier(const DataType& dataType) {
+  if (dataType.isMessage())
+    return MessageDataType(dataType).getMD5Sum();
+  else
+    return dataType.getIdentifier();
+}
+
+SerializationProgram::CacheKey SerializationProgram::getKey(const DataType&
+    dataType) {
+  return CacheKey(getIdentifier(dataType), dataType.hasTypeInfo());
+}
+
+std::string SerializationProgram::getFilename(const std::string& directory,
+    const std::string& identifier) {
+  std::string filename = identifier;
+
+  for (size_t i = 0; i < filename.size(); ++i)
+    if ((filename[i] == '/') || (filename[i] == '[') || (filename[i] == ']'))
+      filename[i] = '_';
+
+  return directory+"/"+filename+".program";
+}
+
+void SerializationProgram::setCacheDirectory(const std::string& directory) {
+  boost::mutex::scoped_lock lock(cache->mutex);
+  cache->directory = directory;
+}
+
+std::string SerializationProgram::getCacheDirectory() {
+  boost::mutex::scoped_lock lock(cache->mutex);
+  return cache->directory;
+}
+
+/*****************************************************************************/
+/* Methods                                                                   */
+/*****************************************************************************/
+
+void SerializationProgram::Impl::compile(const DataType& dataType, size_t
+    depth) {
+  maxDepth = std::max(maxDepth, depth);
+
+  if (dataType.isBuiltin()) {
+    Instruction instruction(Builtin);
+
+    if (!bindBuiltin<bool>(dataType, instruction) &&
+        !bindBuiltin<double>(dataType, instruction) &&
+        !bindBuiltin<float>(dataType, instruction) &&
+        !bindBuiltin<int16_t>(dataType, instruction) &&
+        !bindBuiltin<int32_t>(dataType, instruction) &&
+        !bindBuiltin<int64_t>(dataType, instruction) &&
+        !bindBuiltin<int8_t>(dataType, instruction) &&
+        !bindBuiltin<uint16_t>(dataType, instruction) &&
+        !bindBuiltin<uint32_t>(dataType, instruction) &&
+        !bindBuiltin<uint64_t>(dataType, instruction) &&
+        !bindBuiltin<uint8_t>(dataType, instruction) &&
+        !bindBuiltin<ros::Duration>(dataType, instruction) &&
+        !bindBuiltin<std::string>(dataType, instruction) &&
+        !bindBuiltin<ros::Time>(dataType, instruction)) {
+      instruction.opcode = Typed;
+      instruction.serializer = dataType.createSerializer();
+    }
+
+    instructions.push_back(instruction);
+  }
+  else if (dataType.hasTypeInfo()) {
+    Instruction instruction(Typed);
+    instruction.serializer = dataType.createSerializer();
+
+    instructions.push_back(instruction);
+  }
+  else if (dataType.isArray()) {
+    ArrayDataType arrayType(dataType);
+    const DataType& memberType = arrayType.getMemberType();
+    size_t begin = instructions.size();
+
+    Instruction instruction(BeginArray);
+    instruction.numMembers = arrayType.getNumMembers();
+    instruction.size = memberType.isFixedSize() ? memberType.getSize() : 0;
+    instructions.push_back(instruction);
+
+    compile(memberType, depth+1);
+
+    Instruction end(EndArray);
+    end.jump = begin;
+    instructions[begin].jump = instructions.size();
+    instructions.push_back(end);
+  }
+  else if (dataType.isMessage()) {
+    MessageDataType messageType(dataType);
+    size_t begin = instructions.size();
+
+    Instruction instruction(BeginMessage);
+    instruction.size = messageType.isFixedSize() ? messageType.getSize() : 0;
+    instructions.push_back(instruction);
+
+    size_t i = 0;
+
+    while (i < messageType.getNumVariableMembers()) {
+      size_t numMembers = 0;
+      size_t size = 0;
+
+      for ( ; i+numMembers < messageType.getNumVariableMembers();
+          ++numMembers) {
+        const DataType& memberType = messageType.getVariableMember(
+          i+numMembers).getType();
+
+        if (!memberType.isBuiltin() || !memberType.isFixedSize())
+          break;
+        size += memberType.getSize();
+      }
+
+      if (numMembers > 1) {
+        size_t run = instructions.size();
+
+        Instruction fixed(Fixed);
+        fixed.numMembers = numMembers;
+        fixed.size = size;
+        instructions.push_back(fixed);
+
+        for ( ; numMembers; --numMembers, ++i)
+          compile(messageType.getVariableMember(i).getType(), depth+1);
+
+        instructions[run].jump = instructions.size();
+      }
+      else
+        compile(messageType.getVariableMember(i++).getType(), depth+1);
+    }
+
+    Instruction end(EndMessage);
+    end.jump = begin;
+    instructions[begin].jump = instructions.size();
+    instructions.push_back(end);
+  }
+  else
+    throw InvalidDataTypeException();
+}
+
+void SerializationProgram::Impl::compileLayout(const DataType& dataType) {
+  if (dataType.isFixedSize())
+    appendCopy(dataType.getSize());
+  else if (dataType.isBuiltin())
+    layout.push_back(LayoutInstruction(String));
+  else if (dataType.isArray()) {
+    ArrayDataType arrayType(dataType);
+    const DataType& memberType = arrayType.getMemberType();
+
+    if (arrayType.isDynamic() && memberType.isFixedSize())
+      layout.push_back(LayoutInstruction(Sequence, memberType.getSize()));
+    else {
+      size_t begin = layout.size();
+      layout.push_back(LayoutInstruction(Loop, 0,
+        arrayType.getNumMembers()));
+
+      compileLayout(memberType);
+
+      layout[begin].jump = layout.size();
+      layout.push_back(LayoutInstruction(End, 0, 0, begin));
+    }
+  }
+  else if (dataType.isMessage()) {
+    MessageDataType messageType(dataType);
+
+    for (size_t i = 0; i < messageType.getNumVariableMembers(); ++i)
+      compileLayout(messageType.getVariableMember(i).getType());
+  }
+  else
+    throw InvalidDataTypeException();
+}
+
+void SerializationProgram::Impl::appendCopy(size_t size) {
+  if (!size)
+    return;
+
+  if (!layout.empty() && (layout.back().opcode == Copy))
+    layout.back().size += size;
+  else
+    layout.push_back(LayoutInstruction(Copy, size));
+}
+
+void SerializationProgram::serialize(ros::serialization::OStream& stream,
+    const Variant& value) const {
+  if (!hasInstructions())
+    throw InvalidOperationException(
+      "Attempted variant operation on a layout-only serialization program");
+
+  const std::vector<Instruction>& instructions = impl->instructions;
+  FrameStack frames(impl->maxDepth);
+
+  size_t i = 0;
+
+  while (i < instructions.size()) {
+    const Instruction& instruction = instructions[i];
+
+    switch (instruction.opcode) {
+      case Builtin:
+        instruction.write(stream, frames.empty() ? value :
+          frames.back().next());
+        ++i;
+        break;
+      case Typed:
+        instruction.serializer.serialize(stream, frames.empty() ? value :
+          frames.back().next());
+        ++i;
+        break;
+      case Fixed: {
+          ros::serialization::OStream run(stream.advance(instruction.size),
+            instruction.size);
+
+          for (++i; i < instruction.jump; ++i) {
+            if (instructions[i].opcode == Builtin)
+              instructions[i].write(run, frames.back().next());
+            else
+              instructions[i].serializer.serialize(run,
+                frames.back().next());
+          }
+        }
+        break;
+      case BeginMessage:
+        frames.push(frames.empty() ? value : frames.back().next());
+        ++i;
+        break;
+      case BeginArray: {
+          Frame& frame = frames.push(frames.empty() ? value :
+            frames.back().next());
+
+          if (!instruction.numMembers)
+            stream.next((uint32_t)frame.numMembers);
+
+          if (frame.numMembers)
+            ++i;
+          else {
+            frames.pop();
+            i = instruction.jump+1;
+          }
+        }
+        break;
+      case EndArray:
+        if (frames.back().member < frames.back().numMembers) {
+          i = instruction.jump+1;
+          break;
+        }
+        // all members visited, the array frame is popped like a message's
+      case EndMessage:
+        frames.pop();
+        ++i;
+        break;
+    }
+  }
+}
+
+void SerializationProgram::deserialize(ros::serialization::IStream& stream,
+    Variant& value) const {
+  if (!hasInstructions())
+    throw InvalidOperationException(
+      "Attempted variant operation on a layout-only serialization program");
+
+  const std::vector<Instruction>& instructions = impl->instructions;
+  FrameStack frames(impl->maxDepth);
+
+  size_t i = 0;
+
+  while (i < instructions.size()) {
+    const Instruction& instruction = instructions[i];
+
+    switch (instruction.opcode) {
+      case Builtin:
+        instruction.read(stream, frames.empty() ? value :
+          frames.back().next());
+        ++i;
+        break;
+      case Typed:
+        instruction.serializer.deserialize(stream, frames.empty() ? value :
+          frames.back().next());
+        ++i;
+        break;
+      case Fixed: {
+          ros::serialization::IStream run(stream.advance(instruction.size),
+            instruction.size);
+
+          for (++i; i < instruction.jump; ++i) {
+            if (instructions[i].opcode == Builtin)
+              instructions[i].read(run, frames.back().next());
+            else
+              instructions[i].serializer.deserialize(run,
+                frames.back().next());
+          }
+        }
+        break;
+      case BeginMessage:
+        frames.push(frames.empty() ? value : frames.back().next());
+        ++i;
+        break;
+      case BeginArray: {
+          Variant& array = frames.empty() ? value : frames.back().next();
+
+          if (!instruction.numMembers) {
+            uint32_t numMembers = 0;
+            stream.next(numMembers);
+
+            ArrayVariant(array).resize(numMembers);
+          }
+
+          if (frames.push(array).numMembers)
+            ++i;
+          else {
+            frames.pop();
+            i = instruction.jump+1;
+          }
+        }
+        break;
+      case EndArray:
+        if (frames.back().member < frames.back().numMembers) {
+          i = instruction.jump+1;
+          break;
+        }
+        // all members visited, the array frame is popped like a message's
+      case EndMessage:
+        frames.pop();
+        ++i;
+        break;
+    }
+  }
+}
+
+void SerializationProgram::advance(ros::serialization::Stream& stream)
+    const {
+  stream.advance(getSerializedLength(stream.getData(), stream.getLength()));
+}
+
+MessageSerializer SerializationProgram::createSerializer() const {
+  return MessageSerializer(*this);
+}
+
+void SerializationProgram::save(std::ostream& stream) const {
+  stream << getIdentifier() << "\n";
+
+  const std::vector<LayoutInstruction>& layout = getLayout();
+
+  for (size_t i = 0; i < layout.size(); ++i) {
+    switch (layout[i].opcode) {
+      case Copy:
+        stream << "copy " << layout[i].size << "\n";
+        break;
+      case String:
+        stream << "string\n";
+        break;
+      case Sequence:
+        stream << "sequence " << layout[i].size << "\n";
+        break;
+      case Loop:
+        stream << "loop " << layout[i].numMembers << "\n";
+        break;
+      case End:
+        stream << "end\n";
+        break;
+    }
+  }
+}
+
+void SerializationProgram::load(std::istream& stream) {
+  impl.reset(new Impl());
+  std::getline(stream, impl->identifier);
+
+  std::vector<size_t> loops;
+  std::string opcode;
+
+  while (stream >> opcode) {
+    if (opcode == "copy") {
+      size_t size = 0;
+      stream >> size;
+      impl->appendCopy(size);
+    }
+    else if (opcode == "string")
+      impl->layout.push_back(LayoutInstruction(String));
+    else if (opcode == "sequence") {
+      size_t size = 0;
+      stream >> size;
+      impl->layout.push_back(LayoutInstruction(Sequence, size));
+    }
+    else if (opcode == "loop") {
+      size_t numMembers = 0;
+      stream >> numMembers;
+      loops.push_back(impl->layout.size());
+      impl->layout.push_back(LayoutInstruction(Loop, 0, numMembers));
+    }
+    else if ((opcode == "end") && !loops.empty()) {
+      impl->layout[loops.back()].jump = impl->layout.size();
+      impl->layout.push_back(LayoutInstruction(End, 0, 0, loops.back()));
+      loops.pop_back();
+    }
+    else {
+      impl.reset();
+      throw InvalidOperationException(
+        "Malformed serialization program ["+opcode+"]");
+    }
+  }
+
+  if (!loops.empty()) {
+    impl.reset();
+    throw InvalidOperationException(
+      "Malformed serialization program [unterminated loop]");
+  }
+}
+
+void SerializationProgram::write(std::ostream& stream) const {
+  save(stream);
+}
+
+SerializationProgram SerializationProgram::get(const DataType& dataType) {
+  if (!dataType.isValid())
+    throw InvalidDataTypeException();
+
+  CacheKey key = getKey(dataType);
+  SerializationProgram program;
+
+  {
+    boost::mutex::scoped_lock lock(cache->mutex);
+    boost::unordered_map<CacheKey, ImplPtr>::const_iterator it =
+      cache->programs.find(key);
+
+    if ((it != cache->programs.end()) && !it->second->instructions.empty()) {
+      program.impl = it->second;
+      return program;
+    }
+  }
+
+  program = SerializationProgram(dataType);
+
+  boost::mutex::scoped_lock lock(cache->mutex);
+  cache->programs[key] = program.impl;
+
+  if (!cache->directory.empty()) {
+    std::ofstream file(getFilename(cache->directory, key.first).c_str());
+
+    if (file)
+      program.save(file);
+  }
+
+  return program;
+}
+
+SerializationProgram SerializationProgram::find(const std::string&
+    identifier) {
+  SerializationProgram program;
+  boost::mutex::scoped_lock lock(cache->mutex);
+
+  // the layout does not depend on whether the data type is strong-typed
+  boost::unordered_map<CacheKey, ImplPtr>::const_iterator it =
+    cache->programs.find(CacheKey(identifier, false));
+  if (it == cache->programs.end())
+    it = cache->programs.find(CacheKey(identifier, true));
+
+  if (it != cache->programs.end())
+    program.impl = it->second;
+  else if (!cache->directory.empty()) {
+    std::ifstream file(getFilename(cache->directory, identifier).c_str());
+
+    if (file) {
+      program.load(file);
+
+      if (program.impl->identifier == identifier)
+        cache->programs[CacheKey(identifier, false)] = program.impl;
+      else
+        program.impl.reset();
+    }
+  }
+
+  return program;
+}
+
+void SerializationProgram::clearCache() {
+  boost::mutex::scoped_lock lock(cache->mutex);
+  cache->programs.clear();
+}
+
+/*****************************************************************************/
+/* Operators                                                                 */
+/*****************************************************************************/
+
+std::ostream& operator<<(std::ostream& stream, const SerializationProgram&
+    program) {
+  program.write(stream);
+  return stream;
+}
+
+}
@@ -19,6 +19,7 @@
 #include "variant_topic_tools/DataTypeRegistry.h"
 #include "variant_topic_tools/Exceptions.h"
 #include "variant_topic_tools/Message.h"
+#include "variant_topic_tools/SerializationProgram.h"
 #include "variant_topic_tools/Subscriber.h"
 
 namespace variant_topic_tools {
@@ -123,7 +124,7 @@ void Subscriber::Impl::eventCallback(const ros::MessageEvent<Message const>&
       }
         
       if (dataType && !serializer)
-        serializer = dataType.createSerializer();
+        serializer = SerializationProgram::get(dataType).createSerializer();
 
       if (serializer) {
         MessageVariant variant = dataType.createVariant();
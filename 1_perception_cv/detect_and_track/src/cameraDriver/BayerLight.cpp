@@ -0,0 +1,112 @@
+#include "BayerLight.hpp"
+
+int bayerToBGRCode(BayerPattern pattern)
+{
+    //opencv names the patterns after the second row, RGGB is BayerBG
+    switch (pattern)
+    {
+    case BAYER_RGGB:
+        return COLOR_BayerBG2BGR;
+    case BAYER_GRBG:
+        return COLOR_BayerGB2BGR;
+    case BAYER_GBRG:
+        return COLOR_BayerGR2BGR;
+    case BAYER_BGGR:
+        return COLOR_BayerRG2BGR;
+    default:
+        return -1;
+    }
+}
+
+string bayerEncoding(BayerPattern pattern)
+{
+    switch (pattern)
+    {
+    case BAYER_RGGB:
+        return "bayer_rggb8";
+    case BAYER_GRBG:
+        return "bayer_grbg8";
+    case BAYER_GBRG:
+        return "bayer_gbrg8";
+    case BAYER_BGGR:
+        return "bayer_bggr8";
+    default:
+        return "bgr8";
+    }
+}
+
+BayerPattern bayerPatternFromEncoding(const string &encoding)
+{
+    if (encoding == "bayer_rggb8")
+        return BAYER_RGGB;
+    if (encoding == "bayer_grbg8")
+        return BAYER_GRBG;
+    if (encoding == "bayer_gbrg8")
+        return BAYER_GBRG;
+    if (encoding == "bayer_bggr8")
+        return BAYER_BGGR;
+    return BAYER_NONE;
+}
+
+void bayerLightMasks(const Mat &raw, BayerPattern pattern,
+                     const Vec3i &minBlue, const Vec3i &maxBlue,
+                     const Vec3i &minRed, const Vec3i &maxRed,
+                     Mat &maskB, Mat &maskR)
+{
+    CV_Assert(raw.type() == CV_8UC1 && pattern != BAYER_NONE);
+
+    const int cols = raw.cols / 2, rows = raw.rows / 2;
+    maskB.create(rows, cols, CV_8UC1);
+    maskR.create(rows, cols, CV_8UC1);
+
+    //position of the red sample in the cell, blue is on the other diagonal
+    const int rx = (pattern == BAYER_GRBG || pattern == BAYER_BGGR) ? 1 : 0;
+    const int ry = (pattern == BAYER_GBRG || pattern == BAYER_BGGR) ? 1 : 0;
+
+    for (int y = 0; y < rows; y++)
+    {
+        const uchar *redRow = raw.ptr<uchar>(2 * y + ry);
+        const uchar *blueRow = raw.ptr<uchar>(2 * y + 1 - ry);
+        const uchar *pr = redRow + rx, *pg0 = redRow + 1 - rx;
+        const uchar *pb = blueRow + 1 - rx, *pg1 = blueRow + rx;
+        uchar *outB = maskB.ptr<uchar>(y);
+        uchar *outR = maskR.ptr<uchar>(y);
+
+        //branch free so that the compiler can vectorise the row
+        for (int x = 0; x < cols; x++)
+        {
+            int r = pr[2 * x];
+            int g = (pg0[2 * x] + pg1[2 * x] + 1) >> 1;
+            int b = pb[2 * x];
+
+            bool blue = (b >= minBlue[0]) & (b <= maxBlue[0]) &
+                        (g >= minBlue[1]) & (g <= maxBlue[1]) &
+                        (r >= minBlue[2]) & (r <= maxBlue[2]);
+            bool red = (b >= minRed[0]) & (b <= maxRed[0]) &
+                       (g >= minRed[1]) & (g <= maxRed[1]) &
+                       (r >= minRed[2]) & (r <= maxRed[2]);
+            outB[x] = blue ? 255 : 0;
+            outR[x] = red ? 255 : 0;
+        }
+    }
+}
+
+void debayerROI(const Mat &raw, BayerPattern pattern, Rect roi, Mat &dst)
+{
+    CV_Assert(raw.type() == CV_8UC1 && pattern != BAYER_NONE);
+    dst = Mat::zeros(raw.size(), CV_8UC3);
+
+    //whole cells only, with one cell of margin so that the demosaic border stays outside the roi
+    const int cols = raw.cols & ~1, rows = raw.rows & ~1;
+    int x0 = max(0, (roi.x & ~1) - 2);
+    int y0 = max(0, (roi.y & ~1) - 2);
+    int x1 = min(cols, ((roi.x + roi.width + 1) & ~1) + 2);
+    int y1 = min(rows, ((roi.y + roi.height + 1) & ~1) + 2);
+    if (roi.area() <= 0 || x1 <= x0 || y1 <= y0)
+        return;
+
+    //an even offset keeps the pattern of the sub-image
+    Rect cell(x0, y0, x1 - x0, y1 - y0);
+    Mat bgr = dst(cell);
+    cvtColor(raw(cell), bgr, bayerToBGRCode(pattern));
+}
@@ -0,0 +1,58 @@
+/**
+ * @file BayerLight.hpp
+ * @brief light thresholding directly on the raw Bayer mosaic of a color camera
+ *
+ * Each 2x2 Bayer cell carries one red, two green and one blue sample, so the cell
+ * is thresholded as one BGR pixel of a half resolution image without demosaicing.
+ * The armor lights are large saturated blobs, half resolution is enough to find them.
+ */
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <string>
+
+using namespace std;
+using namespace cv;
+
+/**
+ * @brief color of the upper-left 2x2 cell of the sensor, named like the ROS encodings
+ */
+enum BayerPattern
+{
+  BAYER_NONE = -1, //not a mosaic, the image is BGR
+  BAYER_RGGB = 0,
+  BAYER_GRBG = 1,
+  BAYER_GBRG = 2,
+  BAYER_BGGR = 3
+};
+
+/**
+ * @brief the cv::cvtColor code that demosaics the pattern into BGR
+ */
+int bayerToBGRCode(BayerPattern pattern);
+
+/**
+ * @brief ROS image encoding of an 8 bit mosaic, e.g. "bayer_rggb8"
+ */
+string bayerEncoding(BayerPattern pattern);
+
+/**
+ * @return BAYER_NONE if the encoding is not an 8 bit Bayer mosaic
+ */
+BayerPattern bayerPatternFromEncoding(const string &encoding);
+
+/**
+ * @brief same test as cv::inRange with the BGR bounds of LightFilterSetting, on each 2x2 cell of the mosaic
+ * the two greens are averaged, every cell gives one pixel of maskB and maskR, 255 when in range
+ * @param raw: CV_8UC1 mosaic, an odd last row or column is ignored
+ * @param maskB, maskR: CV_8UC1 of size (raw.cols / 2, raw.rows / 2)
+ */
+void bayerLightMasks(const Mat &raw, BayerPattern pattern,
+                     const Vec3i &minBlue, const Vec3i &maxBlue,
+                     const Vec3i &minRed, const Vec3i &maxRed,
+                     Mat &maskB, Mat &maskR);
+
+/**
+ * @brief demosaic only roi of the mosaic, for debug display
+ * dst becomes a new full size BGR image, black outside the roi
+ */
+void debayerROI(const Mat &raw, BayerPattern pattern, Rect roi, Mat &dst);
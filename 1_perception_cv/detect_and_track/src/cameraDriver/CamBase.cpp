@@ -28,6 +28,7 @@ void FrameInfo::deepCopyTo(FrameInfo &dst)
 {
     //perform deep copy
     this->img.copyTo(dst.img);
+    dst.bayer = this->bayer;
     dst.rosheader = this->rosheader;
     dst.sourceCamPtr = this->sourceCamPtr;
 };
@@ -60,6 +61,11 @@ const Mat &CamBase::getDistCoeffs() const
     return distCoeffs;
 };
 
+ros::Time CamBase::hostStamp(double deviceTime, const ros::Time &arrival)
+{
+    return ros::Time(clockFilter.update(deviceTime, arrival.toSec()));
+};
+
 bool CamBase::setnGetConfig()
 {
     bool success = true;
@@ -134,6 +140,9 @@ bool CamBase::loadBaseParameters(const FileStorage &fs)
     fsHelper::readOrDefault(node["translationVec"], translationVec, {0, 0, 0});
     fsHelper::readOrDefault(node["minReadDelay_ms"], minReadDelay_ms, 0);
     fsHelper::readOrDefault(node["maxReadDelay_ms"], maxReadDelay_ms, 100);
+    fsHelper::readOrDefault(node["clockWindow_s"], clockWindow_s, 30.0);
+    fsHelper::readOrDefault(node["clockJump_s"], clockJump_s, 0.05);
+    clockFilter = TimestampFilter(clockWindow_s, clockJump_s);
 
     //check camera matrix
     //calculate the value of rotaiton matrix and its inverse
@@ -151,6 +160,8 @@ bool CamBase::storeBaseParameters(FileStorage &fs)
        << "translationVec" << translationVec
        << "minReadDelay_ms" << minReadDelay_ms
        << "maxReadDelay_ms" << maxReadDelay_ms
+       << "clockWindow_s" << clockWindow_s
+       << "clockJump_s" << clockJump_s
        << "}";
 };
 
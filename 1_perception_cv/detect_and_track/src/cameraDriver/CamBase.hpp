@@ -16,6 +16,8 @@
 #include <string>
 #include <mutex>
 #include "defines.hpp"
+#include "BayerLight.hpp"
+#include "TimestampFilter.hpp"
 
 using namespace std;
 using namespace cv;
@@ -36,8 +38,9 @@ public:
   ~FrameInfo();
   void deepCopyTo(FrameInfo &dst);
 
-  //BGR format image
+  //BGR format image, or the raw CV_8UC1 mosaic when bayer is not BAYER_NONE
   Mat img;
+  BayerPattern bayer = BAYER_NONE;
   std_msgs::Header rosheader;
 
   const CamBase *sourceCamPtr;
@@ -55,6 +58,11 @@ public:
   const Mat &getCameraMatrix() const;
   const Mat &getDistCoeffs() const;
 
+  /**
+   * @brief the device to host clock estimate of the driver, for diagnostics
+   */
+  const TimestampFilter &getClockFilter() const { return clockFilter; };
+
   /**
  * @brief Get the uniqu ID specifying the driver operating the camera object 
  */
@@ -160,6 +168,17 @@ protected:
 
   int failCount = 0;
 
+  /**
+   * @brief host time of a frame stamped by the device clock, drift and offset jumps corrected
+   * @param deviceTime: the frame's stamp by the device clock, seconds
+   * @param arrival: when the driver received the frame, as early as possible
+   */
+  ros::Time hostStamp(double deviceTime, const ros::Time &arrival);
+
+  double clockWindow_s;
+  double clockJump_s;
+  TimestampFilter clockFilter;
+
   //try read one CamBase
   friend CamBase *startCamFromFile(const string &filename);
 };
@@ -152,6 +152,7 @@ FrameInfo *FlycapCam::getFrame()
         ROS_INFO("Error in RetrieveBuffer, captureOneImage");
         return NULL;
     }
+    ros::Time arrival = ros::Time::now();
 
     FlyCapture2::TimeStamp ts = rawImage.GetTimeStamp();
     //    std::cout << "time " << time.seconds << " " << time.microSeconds << std::endl;
@@ -178,8 +179,17 @@ FrameInfo *FlycapCam::getFrame()
     else
         tempimg.copyTo(tempOut->img);
 
-    tempOut->rosheader.stamp.nsec = ts.microSeconds * 1000;
-    tempOut->rosheader.stamp.sec = ts.seconds;
+    //stamp by the camera's cycle timer, or by the driver's receive time if the camera does not fill it
+    double deviceTime = ts.seconds + ts.microSeconds * 1e-6;
+    if (ts.cycleSeconds || ts.cycleCount || ts.cycleOffset)
+    {
+        double cycleTime = ts.cycleSeconds + ts.cycleCount / 8000.0 + ts.cycleOffset / (8000.0 * 3072.0);
+        if (cycleTime < lastCycleTime)
+            cycleTimeBase += 128.0;
+        lastCycleTime = cycleTime;
+        deviceTime = cycleTimeBase + cycleTime;
+    }
+    tempOut->rosheader.stamp = hostStamp(deviceTime, arrival);
 
     return tempOut;
 };
@@ -85,4 +85,8 @@ class FlycapCam : public CamBase
     float packagesizepercent;
 
     FlyCapture2::Property properties[17];
+
+    //the camera's 1394 cycle timer wraps every 128 s
+    double lastCycleTime = 0;
+    double cycleTimeBase = 0;
 };
@@ -0,0 +1,141 @@
+#include "TimestampFilter.hpp"
+#include <algorithm>
+
+TimestampFilter::TimestampFilter(double window_s, double jump_s, int maxLate, double minSpan_s)
+    : window(window_s),
+      jumpThreshold(jump_s),
+      minSpan(minSpan_s),
+      maxLate(maxLate){};
+
+void TimestampFilter::reset()
+{
+    points.clear();
+    hull.clear();
+    sumX = 0;
+    intercept = slope = residual = 0;
+    lateCount = 0;
+};
+
+double TimestampFilter::update(double device, double arrival)
+{
+    if (!points.empty())
+    {
+        double x = device - originX;
+        double y = arrival - device - originY;
+        if (x < points.back().x)
+        {
+            //the device clock went back, it was reset or wrapped
+            reset();
+            jumpCount++;
+        }
+        else if (x == points.back().x)
+        {
+            //same frame again, nothing new to learn
+            return correct(device);
+        }
+        else
+        {
+            double r = y - (intercept + slope * x);
+            if (r < -jumpThreshold)
+            {
+                reset();
+                jumpCount++;
+            }
+            else if (r > jumpThreshold && ++lateCount > maxLate)
+            {
+                //one late frame is a delay, a run of them is a jump of the host clock
+                reset();
+                jumpCount++;
+            }
+            else if (r <= jumpThreshold)
+            {
+                lateCount = 0;
+            }
+        }
+    }
+
+    if (points.empty())
+    {
+        originX = device;
+        originY = arrival - device;
+    }
+
+    pushBack({device - originX, arrival - device - originY});
+    while (points.size() > 2 && points.back().x - points.front().x > window)
+        popFront();
+
+    fit();
+    residual = points.back().y - (intercept + slope * points.back().x);
+    return correct(device);
+};
+
+double TimestampFilter::correct(double device) const
+{
+    double x = device - originX;
+    return device + originY + intercept + slope * x;
+};
+
+double TimestampFilter::offset() const
+{
+    if (points.empty())
+        return 0;
+    return originY + intercept + slope * points.back().x;
+};
+
+void TimestampFilter::chain(vector<Sample> &hull, const Sample &p)
+{
+    while (hull.size() >= 2)
+    {
+        const Sample &a = hull[hull.size() - 2], &b = hull.back();
+        double cross = (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+        if (cross > 0)
+            break;
+        hull.pop_back();
+    }
+    hull.push_back(p);
+};
+
+void TimestampFilter::pushBack(const Sample &p)
+{
+    //the samples come sorted by device time, so the lower hull only changes at its end
+    points.push_back(p);
+    sumX += p.x;
+    chain(hull, p);
+};
+
+void TimestampFilter::popFront()
+{
+    sumX -= points.front().x;
+    points.pop_front();
+
+    //the oldest sample is always hull[0]. Without it, the samples before hull[1] may join the hull,
+    //while the edges from hull[1] on stay as they are
+    head.clear();
+    for (size_t i = 0; i < points.size() && points[i].x <= hull[1].x; i++)
+        chain(head, points[i]);
+    hull.erase(hull.begin(), hull.begin() + 2);
+    hull.insert(hull.begin(), head.begin(), head.end());
+};
+
+void TimestampFilter::fit()
+{
+    double meanX = sumX / points.size();
+
+    if (hull.size() < 2 || points.back().x - points.front().x < minSpan)
+    {
+        //too short to tell the skew from the delays, only the offset. The lowest sample is on the hull
+        double minY = hull.front().y;
+        for (const Sample &p : hull)
+            minY = min(minY, p.y);
+        slope = 0;
+        intercept = minY;
+        return;
+    }
+
+    //the hull edge above the mean device time minimises the total delay of the window
+    size_t i = 0;
+    while (i + 2 < hull.size() && hull[i + 1].x < meanX)
+        i++;
+    slope = (hull[i + 1].y - hull[i].y) / (hull[i + 1].x - hull[i].x);
+    intercept = hull[i].y - slope * hull[i].x;
+};
@@ -0,0 +1,81 @@
+/**
+ * @file TimestampFilter.hpp
+ * @brief maps the clock of a camera onto the host clock from the arrival times of its frames
+ *
+ * arrival = device + offset + skew * device + delay, where the transport delay is positive and random.
+ * The points (device, arrival - device) of a sliding window all lie on or above the line,
+ * so the line is taken on the lower convex hull of the window, at its mean device time
+ * (Moon, Skelly and Towsley, 1999), which is not biased by the delay like a regression would be.
+ * Offset jumps and device clock resets are detected and restart the estimation.
+ */
+#pragma once
+#include <deque>
+#include <vector>
+
+using namespace std;
+
+class TimestampFilter
+{
+public:
+  /**
+   * @param window_s: length of the window of samples, in device seconds
+   * @param jump_s: a frame arriving this much earlier than the line allows is an offset jump,
+   * maxLate frames in a row arriving this much later as well
+   * @param minSpan_s: the skew is only estimated once the window is that long
+   */
+  TimestampFilter(double window_s = 30.0, double jump_s = 0.05, int maxLate = 10, double minSpan_s = 1.0);
+
+  /**
+   * @brief add a frame and get its stamp in host time
+   * @param device: time of the frame by the device clock, seconds
+   * @param arrival: host time at which the frame was received, seconds
+   * @return the host time of the device stamp, the minimum transport delay included
+   */
+  double update(double device, double arrival);
+
+  /**
+   * @brief host time of a device stamp with the current estimate
+   */
+  double correct(double device) const;
+
+  void reset();
+
+  //host minus device time at the latest frame
+  double offset() const;
+  //rate of the device clock relative to the host, minus one
+  double skew() const { return slope; };
+  //delay of the latest frame above the minimum, seconds
+  double lastDelay() const { return residual; };
+  //offset jumps and device clock resets seen so far
+  int jumps() const { return jumpCount; };
+  size_t size() const { return points.size(); };
+
+private:
+  struct Sample
+  {
+    double x; //device - originX
+    double y; //arrival - device - originY
+  };
+
+  //monotone chain step, appends p to the lower hull of the samples before it
+  static void chain(vector<Sample> &hull, const Sample &p);
+  //append a sample to the window and to the lower hull
+  void pushBack(const Sample &p);
+  //drop the oldest sample of the window, rebuilding only the first hull edge
+  void popFront();
+  void fit();
+
+  double window, jumpThreshold, minSpan;
+  int maxLate;
+
+  deque<Sample> points;
+  vector<Sample> hull, head;
+  //sum of the device times of the window, for its mean
+  double sumX = 0;
+  double originX = 0, originY = 0;
+  //y = intercept + slope * x
+  double intercept = 0, slope = 0;
+  double residual = 0;
+  int lateCount = 0;
+  int jumpCount = 0;
+};
@@ -143,14 +143,6 @@ bool V4LCamDriver::initMMap()
 
 bool V4LCamDriver::startStream()
 {
-	//rectify time to ros standard (wall time)
-	struct timespec uptime;
-	clock_gettime(CLOCK_MONOTONIC, &uptime);
-	ros::Time sysTime;
-	sysTime.sec = uptime.tv_sec;
-	sysTime.nsec = uptime.tv_nsec;
-	toEpochOffset = ros::Time::now() - sysTime;
-
 	cur_frame = 0;
 
 	refreshVideoFormat();
@@ -521,6 +513,7 @@ FrameInfo *V4LCamDriver::getFrame()
 		perror("VIDIOC_DQBUF Error");
 		exit(1);
 	}
+	ros::Time arrival = ros::Time::now();
 	//decode raw data into mat
 	if (!mb[buffr_idx].ptr)
 		return NULL;
@@ -534,11 +527,8 @@ FrameInfo *V4LCamDriver::getFrame()
 	{
 	}
 
-	//convert v4l2's timestamp (system time) to ros's time (wall time)
-	ros::Time capTime(bufferinfo.timestamp.tv_sec,
-					  bufferinfo.timestamp.tv_usec * 1000);
-
-	out->rosheader.stamp = capTime + toEpochOffset;
+	//v4l2's timestamp is by the monotonic clock, mapped to ros's time (wall time) with the drift between the two
+	out->rosheader.stamp = hostStamp(bufferinfo.timestamp.tv_sec + bufferinfo.timestamp.tv_usec * 1e-6, arrival);
 
 	//queue a buffer back allowing the driver to read again
 	bufferinfo.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
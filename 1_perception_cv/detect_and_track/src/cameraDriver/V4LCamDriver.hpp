@@ -61,6 +61,4 @@ private:
 
   int cur_frame;
   string video_path;
-
-  ros::Duration toEpochOffset;
 };
\ No newline at end of file
@@ -0,0 +1,89 @@
+/**
+ * @brief benchmark of the light thresholding on the raw Bayer mosaic against demosaicing first
+ *
+ * usage: bayer_benchmark [image] [iterations]
+ * the image (or a synthetic one with red and blue bars) is mosaiced into RGGB, then
+ *  - demosaic: cvtColor to BGR and two inRange at full resolution, what follows the ISP path
+ *    (the SDK's CameraImageProcess also does white balance, color matrix and gamma, so this is a lower bound)
+ *  - bayer: bayerLightMasks on the mosaic at half resolution
+ */
+#include "BayerLight.hpp"
+#include "defines.hpp"
+#include <iostream>
+
+using namespace std;
+using namespace cv;
+
+static Mat syntheticScene()
+{
+    Mat img(1024, 1280, CV_8UC3);
+    randu(img, Scalar::all(0), Scalar::all(120));
+    RNG rng(1);
+    for (int i = 0; i < 20; i++)
+    {
+        Point c(rng.uniform(50, 1230), rng.uniform(50, 974));
+        Scalar color = (i % 2) ? Scalar(250, 200, 120) : Scalar(120, 200, 250);
+        rectangle(img, Rect(c.x, c.y - 25, 8, 50), color, FILLED);
+        rectangle(img, Rect(c.x + 60, c.y - 25, 8, 50), color, FILLED);
+    }
+    return img;
+}
+
+//sample the BGR image with an RGGB pattern
+static Mat mosaic(const Mat &bgr)
+{
+    Mat raw(bgr.rows & ~1, bgr.cols & ~1, CV_8UC1);
+    for (int y = 0; y < raw.rows; y++)
+        for (int x = 0; x < raw.cols; x++)
+        {
+            int channel = (y % 2 == 0) ? ((x % 2 == 0) ? 2 : 1) : ((x % 2 == 0) ? 1 : 0);
+            raw.at<uchar>(y, x) = bgr.at<Vec3b>(y, x)[channel];
+        }
+    return raw;
+}
+
+int main(int argc, char **argv)
+{
+    Mat scene = argc > 1 ? imread(argv[1], IMREAD_COLOR) : syntheticScene();
+    int iterations = argc > 2 ? atoi(argv[2]) : 200;
+    if (scene.empty())
+    {
+        cout << "cannot read " << argv[1] << endl;
+        return 1;
+    }
+    Mat raw = mosaic(scene);
+
+    Vec3i minBlue = ARMOR_LIGHT_BGRMinBlue;
+    Vec3i maxBlue = ARMOR_LIGHT_BGRMaxBlue;
+    Vec3i minRed = ARMOR_LIGHT_BGRMinRed;
+    Vec3i maxRed = ARMOR_LIGHT_BGRMaxRed;
+
+    Mat bgr, fullB, fullR, halfB, halfR;
+    TickMeter demosaicTime, bayerTime;
+    for (int i = 0; i < iterations; i++)
+    {
+        demosaicTime.start();
+        cvtColor(raw, bgr, bayerToBGRCode(BAYER_RGGB));
+        inRange(bgr, minBlue, maxBlue, fullB);
+        inRange(bgr, minRed, maxRed, fullR);
+        demosaicTime.stop();
+
+        bayerTime.start();
+        bayerLightMasks(raw, BAYER_RGGB, minBlue, maxBlue, minRed, maxRed, halfB, halfR);
+        bayerTime.stop();
+    }
+
+    //agreement of the half resolution masks with the full resolution ones, sampled at the cell centres
+    Mat downB, downR;
+    resize(fullB, downB, halfB.size(), 0, 0, INTER_NEAREST);
+    resize(fullR, downR, halfR.size(), 0, 0, INTER_NEAREST);
+    double total = (double)halfB.total();
+    double agreeB = 1.0 - countNonZero(downB != halfB) / total;
+    double agreeR = 1.0 - countNonZero(downR != halfR) / total;
+
+    cout << "image " << raw.cols << "x" << raw.rows << ", " << iterations << " iterations" << endl
+         << "demosaic + inRange: " << demosaicTime.getTimeMilli() / iterations << " ms/frame" << endl
+         << "bayer thresholding: " << bayerTime.getTimeMilli() / iterations << " ms/frame" << endl
+         << "mask agreement: blue " << agreeB * 100 << "%, red " << agreeR * 100 << "%" << endl;
+    return 0;
+}
@@ -10,6 +10,7 @@
 #include <thread>
 #include <opencv2/opencv.hpp>
 #include <cv_bridge/cv_bridge.h>
+#include <geometry_msgs/Vector3Stamped.h>
 #include "CamBase.hpp"
 #include "defines.hpp"
 #include <signal.h>
@@ -18,14 +19,16 @@ using namespace std;
 using namespace cv;
 
 vector<pair<ros::Publisher *, CamBase *>> image_publishers;
+vector<ros::Publisher *> clock_publishers;
 vector<thread *> readers;
 
 volatile bool thdShouldTerminate = false;
 
 /**
  * @brief a thread function to keep reading from a camera object and publish result to ROS
+ * the clock estimate of the camera goes to clockPub: x offset (s), y skew (ppm), z delay of the frame (s)
  */
-void reader(ros::Publisher *pub, CamBase *cam)
+void reader(ros::Publisher *pub, ros::Publisher *clockPub, CamBase *cam)
 {
     if (pub && cam)
         while (!thdShouldTerminate)
@@ -38,11 +41,23 @@ void reader(ros::Publisher *pub, CamBase *cam)
                 std_msgs::Header h;
                 h.stamp = f->rosheader.stamp;
                 rosimg.image = f->img;
-                rosimg.encoding = sensor_msgs::image_encodings::BGR8;
+                //a raw mosaic is published as is, subscribers demosaic only what they display
+                rosimg.encoding = f->bayer == BAYER_NONE ? sensor_msgs::image_encodings::BGR8 : bayerEncoding(f->bayer);
                 rosimg.header = f->rosheader;
                 sensor_msgs::Image imgMsg;
                 rosimg.toImageMsg(imgMsg);
                 pub->publish(imgMsg);
+
+                const TimestampFilter &clock = cam->getClockFilter();
+                geometry_msgs::Vector3Stamped clockMsg;
+                clockMsg.header = f->rosheader;
+                clockMsg.vector.x = clock.offset();
+                clockMsg.vector.y = clock.skew() * 1e6;
+                clockMsg.vector.z = clock.lastDelay();
+                clockPub->publish(clockMsg);
+                ROS_INFO_THROTTLE(5, "%s clock: offset %.6f s, skew %.2f ppm, %d jumps",
+                                  cam->getName().c_str(), clock.offset(), clock.skew() * 1e6, clock.jumps());
+
                 printf("captured from %s, latency: %f\n", cam->getName().c_str(), (ros::Time::now() - imgMsg.header.stamp).toSec());
                 delete f;
             }
@@ -74,8 +89,10 @@ int main(int argc, char **argv)
                 image_publishers.push_back(pair<ros::Publisher *, CamBase *>());
                 image_publishers.back().first = new ros::Publisher(nh.advertise<sensor_msgs::Image>("/cam" + to_string(i), 3));
                 image_publishers.back().second = tempCam;
+                clock_publishers.push_back(new ros::Publisher(nh.advertise<geometry_msgs::Vector3Stamped>("/cam" + to_string(i) + "/clock", 3)));
                 readers.push_back(new thread(&reader,
                                              image_publishers.back().first,
+                                             clock_publishers.back(),
                                              image_publishers.back().second));
 
                 ros::param::set("/cam" + to_string(i) + "/cameraMatrix/fx", tempCam->getCameraMatrix().at<float>(1, 1));
@@ -108,6 +125,7 @@ int main(int argc, char **argv)
     {
         readers[i]->join(); //join before delete!
         delete image_publishers[i].first;
+        delete clock_publishers[i];
         delete image_publishers[i].second;
     };
 
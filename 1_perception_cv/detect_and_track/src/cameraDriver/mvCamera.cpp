@@ -6,6 +6,26 @@
 
 using namespace cv;
 
+/**
+ * @brief pattern of an 8 bit Bayer media type of the SDK, BAYER_NONE for any other format
+ */
+static BayerPattern bayerPatternOf(UINT mediaType)
+{
+	switch (mediaType)
+	{
+	case CAMERA_MEDIA_TYPE_BAYRG8:
+		return BAYER_RGGB;
+	case CAMERA_MEDIA_TYPE_BAYGR8:
+		return BAYER_GRBG;
+	case CAMERA_MEDIA_TYPE_BAYGB8:
+		return BAYER_GBRG;
+	case CAMERA_MEDIA_TYPE_BAYBG8:
+		return BAYER_BGGR;
+	default:
+		return BAYER_NONE;
+	}
+}
+
 mvCamera::mvCamera(const string &config_path)
 	: CamBase(config_path){};
 
@@ -45,10 +65,7 @@ bool mvCamera::initialize()
 	if (CameraRstTimeStamp(hCamera) != CAMERA_STATUS_SUCCESS)
 		ROS_ERROR("MindVision cam RstTimeStamp Failed!!!!!!");
 	else
-	{
-		camSetTime = ros::Time::now();
-		ROS_INFO("MindVision cam RstTimeStamp done to %ds %dns", camSetTime.sec, camSetTime.nsec);
-	}
+		ROS_INFO("MindVision cam RstTimeStamp done");
 
 	info();
 
@@ -57,7 +74,6 @@ bool mvCamera::initialize()
 
 void mvCamera::discardFrame()
 {
-	FrameInfo *pFrame = new FrameInfo(this);
 	CameraSdkStatus temp;
 	if ((temp = CameraGetImageBuffer(hCamera, &sFrameInfo, &pbyBuffer, 1000)) == CAMERA_STATUS_SUCCESS)
 	{
@@ -75,21 +91,30 @@ FrameInfo *mvCamera::getFrame()
 	CameraSdkStatus temp;
 	if ((temp = CameraGetImageBuffer(hCamera, &sFrameInfo, &pbyBuffer, 1000)) == CAMERA_STATUS_SUCCESS)
 	{
-		pFrame->img = Mat(sFrameInfo.iHeight, sFrameInfo.iWidth, CV_8UC3);
-		//directly write to mat's data location so that the mat object will own the data and delete for me
-		CameraImageProcess(hCamera, pbyBuffer, pFrame->img.ptr(), &sFrameInfo);
-		//cvtColor(pFrame->img, pFrame->img, COLOR_RGB2BGR);
+		ros::Time arrival = ros::Time::now();
+		BayerPattern pattern = rawCapture ? bayerPatternOf(sFrameInfo.uiMediaType) : BAYER_NONE;
+		if (pattern != BAYER_NONE)
+		{
+			//raw capture, only copy the mosaic out of the SDK's buffer, the lights are thresholded on it directly
+			Mat(sFrameInfo.iHeight, sFrameInfo.iWidth, CV_8UC1, pbyBuffer).copyTo(pFrame->img);
+			pFrame->bayer = pattern;
+		}
+		else
+		{
+			pFrame->img = Mat(sFrameInfo.iHeight, sFrameInfo.iWidth, CV_8UC3);
+			//directly write to mat's data location so that the mat object will own the data and delete for me
+			CameraImageProcess(hCamera, pbyBuffer, pFrame->img.ptr(), &sFrameInfo);
+			//cvtColor(pFrame->img, pFrame->img, COLOR_RGB2BGR);
+		}
 		CameraReleaseImageBuffer(hCamera, pbyBuffer);
-		//uiTimeStamp is in 0.1ms from reset
-		pFrame->rosheader.stamp = camSetTime;
-		ros::Duration dt;
-		dt.fromSec(sFrameInfo.uiTimeStamp / 10000.0);
-		pFrame->rosheader.stamp += dt;
+		//uiTimeStamp is in 0.1ms from reset, by the camera's clock
+		pFrame->rosheader.stamp = hostStamp(sFrameInfo.uiTimeStamp / 10000.0, arrival);
 		return pFrame;
 	}
 	else
 	{
 		cout << "\n\nmvCamera::getFrame error!! no:" << temp << endl;
+		delete pFrame;
 		return NULL;
 	}
 }
@@ -106,6 +131,7 @@ bool mvCamera::loadDriverParameters(const FileStorage &fs)
 	fsHelper::readOrDefault(node["iFrameSpeed"], iFrameSpeed, 1);
 	fsHelper::readOrDefault(node["frameWidth"], tImageResolution.iWidth, 640);
 	fsHelper::readOrDefault(node["frameHeight"], tImageResolution.iHeight, 480);
+	fsHelper::readOrDefault(node["rawBayer"], rawBayer, false);
 	return true;
 };
 
@@ -122,6 +148,7 @@ bool mvCamera::storeDriverParameters(FileStorage &fs)
 	   << "iFrameSpeed" << iFrameSpeed
 	   << "frameWidth" << tImageResolution.iWidth
 	   << "frameHeight" << tImageResolution.iHeight
+	   << "rawBayer" << rawBayer
 	   << "}";
 };
 
@@ -142,6 +169,19 @@ bool mvCamera::setCamConfig()
 		CameraSetIspOutFormat(hCamera, CAMERA_MEDIA_TYPE_BGR8);
 	}
 
+	//raw capture needs the sensor to send an 8 bit mosaic, otherwise frames go through the ISP
+	rawCapture = false;
+	if (rawBayer && channel == 3)
+	{
+		for (int i = 0; i < tCapability.iMediaTypdeDesc && !rawCapture; i++)
+		{
+			if (bayerPatternOf(tCapability.pMediaTypeDesc[i].iMediaType) != BAYER_NONE)
+				rawCapture = CameraSetMediaType(hCamera, i) == CAMERA_STATUS_SUCCESS;
+		}
+		if (!rawCapture)
+			std::cout << "MindVision cam has no 8 bit Bayer output, rawBayer ignored\n";
+	}
+
 	if (CameraSetAeState(hCamera, auto_exp) != CAMERA_STATUS_SUCCESS)
 		std::cout << "MindVision cam CameraSetAeState Failed!!!!!!\n";
 
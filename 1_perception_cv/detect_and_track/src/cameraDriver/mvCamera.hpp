@@ -66,5 +66,8 @@ private:
   int frameWidth;
   int frameHeight;
 
-  ros::Time camSetTime;
+  //hand out the raw Bayer mosaic instead of running the ISP on the CPU
+  bool rawBayer;
+  //rawBayer and the sensor does have an 8 bit Bayer output
+  bool rawCapture = false;
 };
@@ -22,6 +22,9 @@
 #define BIG_ARMOR_WIDTH 225
 #define ALL_ARMOR_HEIGHT 55
 
+//standard deviation of a detected armor vertex in pixels, scales the pose covariance
+#define PNP_PIXEL_SIGMA 1.0
+
 //default countour filtering criteria
 //DEFAULT ONLY, CAN BE CAHNGED BY THE "settings.xml"!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 #define ARMOR_LIGHT_MIN_RATIO 2.6
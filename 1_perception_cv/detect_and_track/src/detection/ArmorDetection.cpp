@@ -266,6 +266,18 @@ void ArmorStorage::drawArmors()
     }
 };
 
+/**
+ * @brief bring contours found on a half resolution mask back to image coordinates
+ */
+static void scaleContours(vector<vector<Point>> &contours, int scale)
+{
+    if (scale == 1)
+        return;
+    for (auto &contour : contours)
+        for (auto &p : contour)
+            p *= scale;
+}
+
 LightStorage *LightFinder::findLight(FrameInfo *frame)
 {
     LightStorage *result = new LightStorage(Mat(), Mat(), frame);
@@ -273,8 +285,24 @@ LightStorage *LightFinder::findLight(FrameInfo *frame)
 
     //TODO: improved feature extraction
     Mat tempHSV;
+    //a raw mosaic is thresholded per 2x2 cell, every mask and contour is then at half resolution
+    int scale = 1;
+    int morphoRadius = frame->sourceCamPtr->lightFilterSetting.morphoRadius;
 
-    if (frame->sourceCamPtr->lightFilterSetting.UseHSV != 0)
+    if (frame->bayer != BAYER_NONE)
+    {
+        //the BGR bounds are applied to the sensor values, there is no HSV on the mosaic
+        bayerLightMasks(frame->img, frame->bayer,
+                        frame->sourceCamPtr->lightFilterSetting.BGRMinBlue,
+                        frame->sourceCamPtr->lightFilterSetting.BGRMaxBlue,
+                        frame->sourceCamPtr->lightFilterSetting.BGRMinRed,
+                        frame->sourceCamPtr->lightFilterSetting.BGRMaxRed,
+                        result->preprocessedImgB,
+                        result->preprocessedImgR);
+        scale = 2;
+        morphoRadius = (morphoRadius + 1) / 2;
+    }
+    else if (frame->sourceCamPtr->lightFilterSetting.UseHSV != 0)
     {
         cvtColor(frame->img, tempHSV, CV_BGR2HSV);
 
@@ -312,7 +340,7 @@ LightStorage *LightFinder::findLight(FrameInfo *frame)
     // morphologyEx(result->preprocessedImgB, result->preprocessedImgB, MORPH_OPEN, ele);
     // morphologyEx(result->preprocessedImgR, result->preprocessedImgR, MORPH_OPEN, ele);
 
-    Mat ele2 = getStructuringElement(MORPH_RECT, Size(frame->sourceCamPtr->lightFilterSetting.morphoRadius * 2 + 1, frame->sourceCamPtr->lightFilterSetting.morphoRadius * 2 + 1));
+    Mat ele2 = getStructuringElement(MORPH_RECT, Size(morphoRadius * 2 + 1, morphoRadius * 2 + 1));
     morphologyEx(result->preprocessedImgR,
                  result->preprocessedImgR,
                  MORPH_CLOSE, ele2);
@@ -334,8 +362,9 @@ LightStorage *LightFinder::findLight(FrameInfo *frame)
     vector<Vec4i> hierarchy;
 
     findContours(result->preprocessedImgOR, white_contours_crude, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_SIMPLE);
-    contour_B_area.reserve(white_contours_crude.size());
-    contour_R_area.reserve(white_contours_crude.size());
+    scaleContours(white_contours_crude, scale);
+    contour_B_area.resize(white_contours_crude.size());
+    contour_R_area.resize(white_contours_crude.size());
     light_rect.reserve(white_contours_crude.size());
 
     for (int i = 0; i < white_contours_crude.size(); i++)
@@ -355,11 +384,13 @@ LightStorage *LightFinder::findLight(FrameInfo *frame)
     }
 
     findContours(result->preprocessedImgB, Bcontours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_SIMPLE);
+    scaleContours(Bcontours, scale);
 
     // if (detectionNodeShared::settings.Debug)
     //     drawContours(result->img, Bcontours, -1, (255, 0, 0), 3);
 
     findContours(result->preprocessedImgR, Rcontours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_SIMPLE);
+    scaleContours(Rcontours, scale);
 
     // if (detectionNodeShared::settings.Debug)
     //     drawContours(result->img, Rcontours, -1, (0, 0, 255), 3);
@@ -451,6 +482,21 @@ bool LightFinder::tryProcess(ConcurrentQueue<FrameInfo> &inputQ, ConcurrentQueue
 
         if (detectionNodeShared::settings.Debug)
         {
+            if (tempout->bayer != BAYER_NONE)
+            {
+                //demosaic only around the lights for display
+                Rect roi;
+                for (auto &l : tempout->lightsB)
+                    roi |= l.rect.boundingRect();
+                for (auto &l : tempout->lightsR)
+                    roi |= l.rect.boundingRect();
+                //with a margin of half its size, so that the armor between the lights shows as well
+                roi = Rect(roi.x - roi.width / 2, roi.y - roi.height / 2, roi.width * 2, roi.height * 2);
+                Mat bgr;
+                debayerROI(tempout->img, tempout->bayer, roi, bgr);
+                tempout->img = bgr;
+                tempout->bayer = BAYER_NONE;
+            }
             tempout->drawLights();
         }
         //push the result to the output queue
@@ -546,10 +592,13 @@ void ArmorProcessor::armorLocator(const vector<LightGp> &ArmorLightGps,
                                   ArmorStorage &result)
 {
     cv::Vec3d rotationVec,
-        translationVec,
-        shiftedTranslationVec,
-        oversizedTranslationVec;
+        translationVec;
     cv::Matx33d translationCov;
+    PlanarPoseSolver solver(sourceCamPtr->getCameraMatrix(), sourceCamPtr->getDistCoeffs(), PNP_PIXEL_SIGMA);
+
+    //camera frame poses found in the previous frame, to warm start the solver
+    static thread_local vector<PreviousPose> previousPoses[2];
+    vector<PreviousPose> currentPoses;
     int index = 0;
     for (vector<LightGp>::const_iterator i = ArmorLightGps.begin(); i != ArmorLightGps.end(); i++, index++)
     {
@@ -615,97 +664,42 @@ void ArmorProcessor::armorLocator(const vector<LightGp> &ArmorLightGps,
             cv::Point2f center = bestvertices[0] + bestvertices[1] + bestvertices[2] + bestvertices[3];
             center /= 4.0;
 
-            //solve result if oversized
-            vector<Point2f> oversizedVertices;
-            oversizedVertices.reserve(4);
-            for (int j = 0; j < 4; j++)
+            //warm start from the previous pose of the armor seen at about the same place
+            float diagonal = cv::norm(bestvertices[0] - bestvertices[3]);
+            bool useGuess = false;
+            for (const PreviousPose &previous : previousPoses[isBlue])
             {
-                oversizedVertices.push_back((bestvertices[j] - center) * (1.0 + 2 / cv::norm(bestvertices[j] - center)) + center);
+                if (previous.camera == sourceCamPtr && previous.isBig == isBig &&
+                    cv::norm(previous.center - center) < diagonal / 2)
+                {
+                    rotationVec = previous.rotationVec;
+                    translationVec = previous.translationVec;
+                    useGuess = true;
+                    break;
+                }
             }
 
-            sourceCamPtr->solvePNP(*points,
-                                   oversizedVertices,
-                                   rotationVec,
-                                   oversizedTranslationVec,
-                                   false,
-                                   SOLVEPNP_P3P);
-
-            //solve  result if shifted
-            vector<Point2f> shiftedVertices;
-            shiftedVertices.reserve(4);
-            for (int j = 0; j < 4; j++)
-            {
-                shiftedVertices.push_back(bestvertices[j] + cv::Point2f(1, 1));
-            }
+            //pose and first order translation covariance from the vertex reprojection error
+            if (!solver.solve(*points, bestvertices, rotationVec, translationVec, translationCov, useGuess))
+                continue;
 
-            sourceCamPtr->solvePNP(*points,
-                                   shiftedVertices,
-                                   rotationVec,
-                                   shiftedTranslationVec,
-                                   false,
-                                   SOLVEPNP_P3P);
-
-            //solve best estimate
-            sourceCamPtr->solvePNP(*points,
-                                   bestvertices,
-                                   rotationVec,
-                                   translationVec,
-                                   false,
-                                   SOLVEPNP_P3P);
+            currentPoses.push_back({sourceCamPtr, center, rotationVec, translationVec, isBig});
 
             if (detectionNodeShared::settings.Debug)
             {
                 cout << "translationVec\n"
                      << translationVec << endl;
-                cout << "shiftedTranslationVec\n"
-                     << shiftedTranslationVec << endl;
-                cout << "oversizedTranslationVec\n"
-                     << oversizedTranslationVec << endl;
-            }
-
-            //solve covariance
-            double dx = abs(shiftedTranslationVec[0] - translationVec[0]) + abs(oversizedTranslationVec[0] - translationVec[0]);
-            double dy = abs(shiftedTranslationVec[1] - translationVec[1]) + abs(oversizedTranslationVec[1] - translationVec[1]);
-            double dz = abs(shiftedTranslationVec[2] - translationVec[2]) + abs(oversizedTranslationVec[2] - translationVec[2]);
-            double cov_xx = pow(dx * 2, 2) / 12.0;
-            double cov_yy = pow(dy * 2, 2) / 12.0;
-            double cov_zz = pow(dz * 2, 2) / 12.0;
-
-            // double cov_xx = 0;
-            // double cov_yy = 0;
-            // double cov_zz = 0;
-
-            //somewhat linearly correlated
-            double cov_xy = sqrt(cov_xx * cov_yy) / 2.0;
-            double cov_xz = sqrt(cov_xx * cov_zz) / 2.0;
-            double cov_yz = sqrt(cov_yy * cov_zz) / 2.0;
-
-            if (translationVec[0] < 0)
-            {
-                cov_xz = -cov_xz;
-                if (translationVec[1] > 0)
-                    //x -, y+
-                    cov_xy = -cov_xy;
-                else
-                    //x-, y-
-                    cov_yz = -cov_yz;
-            }
-            else if (translationVec[1] < 0)
-            {
-                //x+, y-
-                cov_xy = -cov_xy;
-                cov_yz = -cov_yz;
+                cout << "translationCov\n"
+                     << translationCov << endl;
             }
 
-            translationCov = Matx33d(cov_xx, cov_xy, cov_xz,
-                                     cov_xy, cov_yy, cov_yz,
-                                     cov_xz, cov_yz, cov_zz);
             //apply camera transformation and translation
             sourceCamPtr->rectifyCoor(translationVec, translationCov);
 
             result.armors.push_back(Armor(rotationVec, translationVec, translationCov, bestvertices, isBig, isBlue));
         }
     }
+    previousPoses[isBlue].swap(currentPoses);
 };
 
 bool ArmorProcessor::testSeparation(const Light *a, const Light *b)
@@ -4,6 +4,7 @@
 #include "Settings.hpp"
 #include "ConcurrentQueue.hpp"
 #include "Camera.hpp"
+#include "PlanarPose.hpp"
 #include <time.h>
 #include <string>
 
@@ -175,6 +176,16 @@ void armorGrouper(const vector<Light> &srcLights, vector<LightGp> &dstLightGps);
  * @brief break light groups if something of different color is in between
  */
 void armorBreaker(vector<LightGp> &BLightGps, vector<LightGp> &RLightGps);
+//camera frame pose of an armor found in the last frame
+struct PreviousPose
+{
+  const Camera *camera;
+  Point2f center;
+  Vec3d rotationVec;
+  Vec3d translationVec;
+  bool isBig;
+};
+
 //finding coordinates
 void armorLocator(const vector<LightGp> &ArmorLightGps,
                   bool isBlue,
@@ -23,6 +23,7 @@ void FrameInfo::copyTo(FrameInfo &dst)
 {
     //perform deep copy
     this->img.copyTo(dst.img);
+    dst.bayer = this->bayer;
     dst.rosheader = this->rosheader;
     dst.rotationVec = this->rotationVec;
     dst.translationVec = this->translationVec;
@@ -36,31 +37,112 @@ string Camera::getName() const
     return config_filename;
 };
 
-bool Camera::tryRead()
+void Camera::startCapture()
 {
-    ros::Time startTime = ros::Time::now();
-    if (this->lockcam.try_lock())
+    if (captureThread)
+        return;
+    clock_gettime(CLOCK_MONOTONIC, &lastRead);
+    capturing = true;
+    captureThread = new thread(&Camera::captureLoop, this);
+};
+
+void Camera::stopCapture()
+{
+    if (!captureThread)
+        return;
+    capturing = false;
+    captureThread->join();
+    delete captureThread;
+    captureThread = NULL;
+};
+
+static double elapsed_ms(const timespec &from, const timespec &to)
+{
+    return (to.tv_sec - from.tv_sec) * 1000.0 + (to.tv_nsec - from.tv_nsec) / 1000000.0;
+}
+
+void Camera::captureLoop()
+{
+    const int minBackoff_ms = 100, maxBackoff_ms = 5000;
+    int backoff_ms = minBackoff_ms;
+
+    //statistics of the last report period
+    int frames = 0, restarts = 0;
+    double readSum_ms = 0, latencySum_ms = 0, latencyMax_ms = 0;
+    ros::WallTime reportTime = ros::WallTime::now();
+
+    while (capturing)
     {
-        FrameInfo *tempout = getFrame();
+        //software limit of the frame rate
+        timespec next = lastRead;
+        next.tv_nsec += minReadDelay_ms * 1000000L;
+        next.tv_sec += next.tv_nsec / 1000000000L;
+        next.tv_nsec %= 1000000000L;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        ros::WallTime readStart = ros::WallTime::now();
+        FrameInfo *tempout;
+        {
+            lock_guard<mutex> guard(lockcam);
+            tempout = getFrame();
+        }
+
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
         if (tempout)
         {
-            clock_gettime(CLOCK_MONOTONIC, &lastRead);
+            //capture to enqueue latency, from the frame's capture stamp
+            double latency_ms = (ros::Time::now() - tempout->rosheader.stamp).toSec() * 1000.0;
             outQ.enqueue(tempout);
-            this->lockcam.unlock();
-            ROS_INFO("Camera read from %s took %f ms with latency: %f ms",
-                     this->config_filename.c_str(),
-                     (ros::Time::now() - startTime).toSec() * 1000.0,
-                     (ros::Time::now() - tempout->rosheader.stamp).toSec() * 1000.0);
+            lastRead = now;
+            backoff_ms = minBackoff_ms;
 
-            return true;
+            frames++;
+            readSum_ms += (ros::WallTime::now() - readStart).toSec() * 1000.0;
+            latencySum_ms += latency_ms;
+            latencyMax_ms = max(latencyMax_ms, latency_ms);
         }
-        else
+        else if (elapsed_ms(lastRead, now) > maxReadDelay_ms)
+        {
+            //camera failed, wait and restart it here, only this camera's thread is held up
+            ROS_WARN("camera from %s timeout, restarting in %d ms", config_filename.c_str(), backoff_ms);
+            for (int waited = 0; waited < backoff_ms && capturing; waited += 10)
+                this_thread::sleep_for(chrono::milliseconds(10));
+            if (!capturing)
+                break;
+
+            if (!restart())
+                ROS_WARN("camera from %s restart failed", config_filename.c_str());
+            restarts++;
+            backoff_ms = min(backoff_ms * 2, maxBackoff_ms);
+            clock_gettime(CLOCK_MONOTONIC, &lastRead);
+        }
+
+        double reportElapsed = (ros::WallTime::now() - reportTime).toSec();
+        if (reportElapsed >= 5.0)
         {
-            this->lockcam.unlock();
-            return false;
+            ROS_INFO("%s capture: %.1f fps, read %.2f ms, capture to enqueue latency mean %.2f ms max %.2f ms, %d restarts",
+                     config_filename.c_str(),
+                     frames / reportElapsed,
+                     frames ? readSum_ms / frames : 0.0,
+                     frames ? latencySum_ms / frames : 0.0,
+                     latencyMax_ms,
+                     restarts);
+            frames = restarts = 0;
+            readSum_ms = latencySum_ms = latencyMax_ms = 0;
+            reportTime = ros::WallTime::now();
         }
     }
-    return false;
+};
+
+bool Camera::restart()
+{
+    lock_guard<mutex> guard(lockcam);
+    closeStream();
+    bool success = initialize();
+    success &= applySetting();
+    success &= startStream();
+    return success;
 };
 
 void Camera::rectifyCoor(cv::Vec3d &crude_Coordinate, cv::Matx33d &cov) const
@@ -94,37 +176,6 @@ bool Camera::applySetting()
     return success;
 };
 
-void tryReadCam(const Settings &settings, vector<Camera *> &cams)
-{
-    timespec uptime;
-    clock_gettime(CLOCK_MONOTONIC, &uptime);
-    int tempReadDelay[cams.size()];
-    for (int i = 0; i < cams.size(); i++)
-        if (cams[i])
-        {
-            tempReadDelay[i] = (uptime.tv_sec - cams[i]->lastRead.tv_sec) * 1000 +
-                               (uptime.tv_nsec - cams[i]->lastRead.tv_nsec) / 1000000;
-            if (tempReadDelay[i] > cams[i]->minReadDelay_ms)
-            {
-                bool readSucess = cams[i]->tryRead();
-                if (!readSucess && (tempReadDelay[i] > cams[i]->maxReadDelay_ms))
-                {
-                    if (cams[i]->lockcam.try_lock())
-                    {
-
-                        //camera failed, try to restart here
-                        ROS_WARN("camera from %s timout, restarting", cams[i]->config_filename.c_str());
-                        cams[i]->initialize();
-                        cams[i]->applySetting();
-                        cams[i]->startStream();
-                        cams[i]->lockcam.unlock();
-                    }
-                }
-                return;
-            }
-        }
-};
-
 /**
  * @brief initiallize a camera object form the specified file name, and check if the camera is accessable
  * 
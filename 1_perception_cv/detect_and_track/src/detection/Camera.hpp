@@ -5,9 +5,12 @@
 #include "linux/videodev2.h"
 #include "Settings.hpp"
 #include "ConcurrentQueue.hpp"
+#include "cameraDriver/BayerLight.hpp"
 #include <time.h>
 #include <string>
 #include <mutex>
+#include <thread>
+#include <atomic>
 
 //a class for handling all sort of camera things,
 //one class for one camera/ one set of stereo camera
@@ -32,8 +35,9 @@ public:
   ~FrameInfo();
   void copyTo(FrameInfo &dst);
 
-  //BGR format image
+  //BGR format image, or the raw CV_8UC1 mosaic when bayer is not BAYER_NONE
   Mat img;
+  BayerPattern bayer = BAYER_NONE;
   std_msgs::Header rosheader;
 
   //Captured coordinate relative to robot's origin/main camera, coordinate frame specified in the header
@@ -51,7 +55,12 @@ public:
 
   void showSettingWindow();
 
-  bool tryRead(); //this function is probably blocking, limited by camera's fps
+  /**
+   * @brief start a thread that keeps reading this camera into outQ, at most once every minReadDelay_ms,
+   * the camera is restarted with an increasing backoff when no frame came for maxReadDelay_ms
+   */
+  void startCapture();
+  void stopCapture();
 
   void rectifyCoor(cv::Vec3d &crude_Coordinate, cv::Matx33d &cov) const;
 
@@ -166,25 +175,19 @@ protected:
 
   //try read one camera
   friend void startCams(const Settings &settings, vector<Camera *> &cams);
-  friend void tryReadCam(const Settings &settings, vector<Camera *> &cams);
   friend bool updateCams(vector<Camera *> &cams);
   friend void storeCams(vector<Camera *> &cams);
   friend Camera *startCamFromFile(const string &filename);
 
 private:
-  int failCount = 0;
-};
+  //body of the capture thread, blocks on getFrame
+  void captureLoop();
+  //stop, reconfigure and start the stream again
+  bool restart();
 
-/**
-  * @brief 
-  *     try to read from one camera, according to the actual reading rate
-  *     it will not try to read camera faster than the maximum rate specified
-  *     while if some camera's minimum rate is reached, this function will try to read it first
-  *  
-  * @param settings 
-  * @param cams 
- */
-void tryReadCam(const Settings &settings, vector<Camera *> &cams);
+  thread *captureThread = NULL;
+  atomic<bool> capturing{false};
+};
 
 //construct objects for all cameras descripted in settings
 void startCams(const Settings &settings, vector<Camera *> &cams);
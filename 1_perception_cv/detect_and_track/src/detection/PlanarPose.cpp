@@ -0,0 +1,233 @@
+#include "PlanarPose.hpp"
+#include <cfloat>
+
+PlanarPoseSolver::PlanarPoseSolver(const Mat &cameraMatrix, const Mat &distCoeffs, double pixelSigma)
+    : distCoeffs(distCoeffs),
+      sigma(pixelSigma)
+{
+    Mat k;
+    cameraMatrix.convertTo(k, CV_64F);
+    K = Matx33d((double *)k.ptr());
+    distorted = !distCoeffs.empty() && countNonZero(distCoeffs) > 0;
+}
+
+double PlanarPoseSolver::reprojectionError(const Matx33d &R, const Vec3d &t) const
+{
+    double err = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        Vec3d P = R * object[i] + t;
+        if (P[2] <= 0)
+            return DBL_MAX;
+        double ex = K(0, 0) * (P[0] / P[2] - normalised[i][0]);
+        double ey = K(1, 1) * (P[1] / P[2] - normalised[i][1]);
+        err += ex * ex + ey * ey;
+    }
+    return err;
+}
+
+Vec3d PlanarPoseSolver::solveTranslation(const Matx33d &R) const
+{
+    //x * Pz - Px = 0, y * Pz - Py = 0 with P = R * X + t, linear in t
+    Matx33d AtA = Matx33d::zeros();
+    Vec3d Atb(0, 0, 0);
+    for (int i = 0; i < 4; i++)
+    {
+        Vec3d RX = R * object[i];
+        double x = normalised[i][0], y = normalised[i][1];
+        Vec3d a0(-1, 0, x), a1(0, -1, y);
+        double b0 = RX[0] - x * RX[2], b1 = RX[1] - y * RX[2];
+        AtA += a0 * a0.t() + a1 * a1.t();
+        Atb += a0 * b0 + a1 * b1;
+    }
+    return AtA.solve(Atb, DECOMP_CHOLESKY);
+}
+
+Matx66d PlanarPoseSolver::refine(Matx33d &R, Vec3d &t) const
+{
+    Matx66d JtJ;
+    bool converged = false;
+    for (int iter = 0;; iter++)
+    {
+        JtJ = Matx66d::zeros();
+        Vec6d Jtr = Vec6d::all(0);
+
+        for (int i = 0; i < 4; i++)
+        {
+            Vec3d RX = R * object[i];
+            Vec3d P = RX + t;
+            double iz = 1.0 / P[2];
+            double fx = K(0, 0), fy = K(1, 1);
+            Vec2d r(fx * (P[0] * iz - normalised[i][0]), fy * (P[1] * iz - normalised[i][1]));
+
+            //d(pixel)/dP
+            Matx23d dp(fx * iz, 0, -fx * P[0] * iz * iz,
+                       0, fy * iz, -fy * P[1] * iz * iz);
+            //dP/d(rotation perturbation) = -[RX]x, dP/dt = I
+            Matx33d skew(0, RX[2], -RX[1],
+                         -RX[2], 0, RX[0],
+                         RX[1], -RX[0], 0);
+            Matx23d Jr = dp * skew;
+
+            Matx<double, 2, 6> J;
+            for (int row = 0; row < 2; row++)
+                for (int col = 0; col < 3; col++)
+                {
+                    J(row, col) = Jr(row, col);
+                    J(row, col + 3) = dp(row, col);
+                }
+
+            JtJ += J.t() * J;
+            Jtr += J.t() * r;
+        }
+
+        //the normal matrix of the final pose is kept for the covariance
+        if (iter >= maxIterations || converged)
+            break;
+
+        Vec6d delta = JtJ.solve(-Jtr, DECOMP_CHOLESKY);
+        Matx33d dR;
+        Rodrigues(Vec3d(delta[0], delta[1], delta[2]), dR);
+        R = dR * R;
+        t += Vec3d(delta[3], delta[4], delta[5]);
+
+        converged = norm(delta) < 1e-6;
+    }
+    return JtJ;
+}
+
+bool PlanarPoseSolver::solve(const vector<Point3f> &objectPoints, const vector<Point2f> &imagePoints,
+                             Vec3d &rvec, Vec3d &tvec, Matx33d &translationCov, bool useGuess)
+{
+    if (objectPoints.size() != 4 || imagePoints.size() != 4)
+        return false;
+
+    //normalised, undistorted image coordinates
+    Vec2f pixels[4], undistorted[4];
+    for (int i = 0; i < 4; i++)
+    {
+        pixels[i] = Vec2f(imagePoints[i].x, imagePoints[i].y);
+        object[i] = Vec3d(objectPoints[i].x, objectPoints[i].y, objectPoints[i].z);
+    }
+    if (distorted)
+    {
+        Mat src(4, 1, CV_32FC2, pixels), dst(4, 1, CV_32FC2, undistorted);
+        undistortPoints(src, dst, Mat(K), distCoeffs);
+        for (int i = 0; i < 4; i++)
+            normalised[i] = Vec2d(undistorted[i][0], undistorted[i][1]);
+    }
+    else
+    {
+        for (int i = 0; i < 4; i++)
+            normalised[i] = Vec2d((pixels[i][0] - K(0, 2)) / K(0, 0), (pixels[i][1] - K(1, 2)) / K(1, 1));
+    }
+
+    //homography from the centred, unit-scaled plane to the normalised image
+    Vec2d centroid(0, 0);
+    for (int i = 0; i < 4; i++)
+        centroid += Vec2d(object[i][0], object[i][1]) * 0.25;
+    double scale = 0;
+    for (int i = 0; i < 4; i++)
+        scale = max(scale, norm(Vec2d(object[i][0], object[i][1]) - centroid));
+    if (scale <= 0)
+        return false;
+
+    Matx<double, 8, 8> M;
+    Matx<double, 8, 1> b;
+    for (int i = 0; i < 4; i++)
+    {
+        double X = (object[i][0] - centroid[0]) / scale, Y = (object[i][1] - centroid[1]) / scale;
+        double x = normalised[i][0], y = normalised[i][1];
+        double r0[8] = {X, Y, 1, 0, 0, 0, -x * X, -x * Y};
+        double r1[8] = {0, 0, 0, X, Y, 1, -y * X, -y * Y};
+        for (int j = 0; j < 8; j++)
+        {
+            M(2 * i, j) = r0[j];
+            M(2 * i + 1, j) = r1[j];
+        }
+        b(2 * i) = x;
+        b(2 * i + 1) = y;
+    }
+    Matx<double, 8, 1> h;
+    if (!cv::solve(M, b, h, DECOMP_LU))
+        return false;
+
+    //IPPE: Jacobian of the homography at the plane's origin, which projects to (p, q)
+    double p = h(2), q = h(5);
+    Matx22d J(h(0) - h(6) * p, h(1) - h(7) * p,
+              h(3) - h(6) * q, h(4) - h(7) * q);
+
+    //Rv rotates the optical axis onto the viewing ray of (p, q)
+    Matx33d Rv = Matx33d::eye();
+    double s = sqrt(p * p + q * q + 1), st = sqrt(p * p + q * q);
+    if (st > 1e-12)
+    {
+        Matx33d Kc(0, 0, p / st,
+                   0, 0, q / st,
+                   -p / st, -q / st, 0);
+        Rv += sqrt(1 - 1 / (s * s)) * Kc + (1 - 1 / s) * Kc * Kc;
+    }
+    Matx22d B(Rv(0, 0) - p * Rv(2, 0), Rv(0, 1) - p * Rv(2, 1),
+              Rv(1, 0) - q * Rv(2, 0), Rv(1, 1) - q * Rv(2, 1));
+    Matx22d A = B.inv() * J;
+
+    //the largest singular value of A is the scale, A / gamma the upper 2x2 of the rotation
+    double a00 = A(0, 0) * A(0, 0) + A(1, 0) * A(1, 0);
+    double a01 = A(0, 0) * A(0, 1) + A(1, 0) * A(1, 1);
+    double a11 = A(0, 1) * A(0, 1) + A(1, 1) * A(1, 1);
+    double gamma = sqrt(0.5 * (a00 + a11 + sqrt((a00 - a11) * (a00 - a11) + 4 * a01 * a01)));
+    if (gamma <= 0)
+        return false;
+    Matx22d Rt = A * (1.0 / gamma);
+    double b0 = sqrt(max(0.0, 1 - Rt(0, 0) * Rt(0, 0) - Rt(1, 0) * Rt(1, 0)));
+    double b1 = sqrt(max(0.0, 1 - Rt(0, 1) * Rt(0, 1) - Rt(1, 1) * Rt(1, 1)));
+    if (Rt(0, 0) * Rt(0, 1) + Rt(1, 0) * Rt(1, 1) > 0)
+        b1 = -b1;
+
+    //two mirror solutions, keep the one (or the previous pose) with the smallest error
+    Matx33d bestR;
+    Vec3d bestT;
+    double bestErr = DBL_MAX;
+    for (int k = 0; k < 2; k++)
+    {
+        double sign = k ? -1 : 1;
+        Vec3d c0(Rt(0, 0), Rt(1, 0), sign * b0), c1(Rt(0, 1), Rt(1, 1), sign * b1);
+        Vec3d c2 = c0.cross(c1);
+        Matx33d Rp(c0[0], c1[0], c2[0],
+                   c0[1], c1[1], c2[1],
+                   c0[2], c1[2], c2[2]);
+        Matx33d R = Rv * Rp;
+        Vec3d t = solveTranslation(R);
+        double err = reprojectionError(R, t);
+        if (err < bestErr)
+        {
+            bestErr = err;
+            bestR = R;
+            bestT = t;
+        }
+    }
+    if (useGuess)
+    {
+        Matx33d R;
+        Rodrigues(rvec, R);
+        double err = reprojectionError(R, tvec);
+        if (err < bestErr)
+        {
+            bestErr = err;
+            bestR = R;
+            bestT = tvec;
+        }
+    }
+    if (bestErr == DBL_MAX)
+        return false;
+
+    Matx66d JtJ = refine(bestR, bestT);
+
+    //first order covariance of the pose, the translation block is returned
+    Matx66d cov = JtJ.inv(DECOMP_CHOLESKY) * (sigma * sigma);
+    translationCov = cov.get_minor<3, 3>(3, 3);
+
+    Rodrigues(bestR, rvec);
+    tvec = bestT;
+    return true;
+}
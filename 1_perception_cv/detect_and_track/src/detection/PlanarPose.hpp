@@ -0,0 +1,50 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+using namespace std;
+using namespace cv;
+
+/**
+ * @brief pose of a planar 4-point target (an armor plate) from one image, with the covariance
+ * closed form IPPE (Collins and Bartoli, 2014) gives the two candidate poses of the plane,
+ * Gauss-Newton on the pixel reprojection error refines the better one (or the previous pose,
+ * when given and closer), and the covariance is sigma^2 (J^T J)^-1 of that last step,
+ * all with fixed-size matrices
+ */
+class PlanarPoseSolver
+{
+public:
+  /**
+   * @param cameraMatrix, distCoeffs: as for cv::solvePnP
+   * @param pixelSigma: standard deviation of a detected vertex, in pixels
+   */
+  PlanarPoseSolver(const Mat &cameraMatrix, const Mat &distCoeffs, double pixelSigma = 1.0);
+
+  /**
+   * @brief objectPoints must lie on the z = 0 plane, 4 points each
+   * @param useGuess: rvec and tvec hold a previous pose to start from if it reprojects better
+   * @return false if the points are degenerate
+   */
+  bool solve(const vector<Point3f> &objectPoints, const vector<Point2f> &imagePoints,
+             Vec3d &rvec, Vec3d &tvec, Matx33d &translationCov, bool useGuess = false);
+
+  int maxIterations = 5;
+
+private:
+  //squared pixel reprojection error of a pose
+  double reprojectionError(const Matx33d &R, const Vec3d &t) const;
+  //least squares translation for a given rotation
+  Vec3d solveTranslation(const Matx33d &R) const;
+  //gauss-newton refinement, returns the final normal matrix J^T J
+  Matx66d refine(Matx33d &R, Vec3d &t) const;
+
+  Matx33d K;
+  Mat distCoeffs;
+  bool distorted;
+  double sigma;
+
+  //per-solve working set, normalised image points and centred object points
+  Vec2d normalised[4];
+  Vec3d object[4];
+};
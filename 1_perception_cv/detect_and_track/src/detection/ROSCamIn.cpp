@@ -21,14 +21,24 @@ void ROSCamIn::pushImg(const boost::shared_ptr<sensor_msgs::Image> msg)
     // static std::mutex lock;
     // std::lock_guard<std::mutex> gl(lock);
     boost::shared_ptr<sensor_msgs::Image> *temp = new boost::shared_ptr<sensor_msgs::Image>(msg);
-    inputq.enqueue(temp);
+    {
+        std::lock_guard<std::mutex> guard(inputLock);
+        inputq.enqueue(temp);
+    }
+    inputReady.notify_one();
     ROS_INFO("%s incoming image with latency: %f ms", this->config_filename.c_str(), (ros::Time::now() - msg->header.stamp).toSec() * 1000.0);
 }
 
-FrameInfo *ROSCamIn::()
+FrameInfo *ROSCamIn::getFrame()
 {
     //const sensor_msgs::Image *tempin;
     const boost::shared_ptr<sensor_msgs::Image> *tempin;
+    {
+        //wait for the subscriber, at most until the camera would count as timed out
+        std::unique_lock<std::mutex> guard(inputLock);
+        inputReady.wait_for(guard, std::chrono::milliseconds(maxReadDelay_ms),
+                            [this] { return inputq.count() > 0; });
+    }
     if (inputq.dequeue(tempin))
     {
         cv_bridge::CvImagePtr cv_ptr;
@@ -39,12 +49,14 @@ FrameInfo *ROSCamIn::()
         catch (cv_bridge::Exception &e)
         {
             ROS_ERROR("cv_bridge exception: %s", e.what());
+            delete tempin;
             return NULL;
         }
 
         FrameInfo *tempout = new FrameInfo(this);
         tempout->rosheader = (*tempin)->header;
         tempout->img = cv_ptr->image;
+        tempout->bayer = bayerPatternFromEncoding((*tempin)->encoding);
 
         delete tempin;
         return tempout;
@@ -65,6 +77,8 @@ bool ROSCamIn::startStream()
 };
 bool ROSCamIn::closeStream()
 {
+    if (!imgSub_Ptr)
+        return true;
     imgSub_Ptr->shutdown();
     delete imgSub_Ptr;
     imgSub_Ptr = NULL;
@@ -5,6 +5,8 @@
 #include "sensor_msgs/Image.h"
 #include "ConcurrentQueue.hpp"
 #include <string>
+#include <mutex>
+#include <condition_variable>
 
 class ROSCamIn : public Camera
 {
@@ -33,6 +35,9 @@ private:
   //void pushImg(const sensor_msgs::Image &newimg);
 
   ConcurrentQueue<const boost::shared_ptr<sensor_msgs::Image>> inputq;
+  //getFrame blocks on this until the subscriber pushes an image
+  std::mutex inputLock;
+  std::condition_variable inputReady;
   //ros::Time lastReadTime;
   ros::Subscriber *imgSub_Ptr;
   std::string topicName;
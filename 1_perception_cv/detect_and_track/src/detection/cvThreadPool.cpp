@@ -45,29 +45,31 @@ bool ThreadPool::initialize()
 	return true;
 };
 
-void ThreadPool::doWork()
+bool ThreadPool::doWork()
 {
 	if (detectionNodeShared::rosIntertface->tryProcess(armorStoragesQ, displayQ))
-		return;
+		return true;
 
 
 	if (ArmorProcessor::tryProcess(lightStoragesQ, armorStoragesQ))
-		return;
+		return true;
 
 	for (int i = 0; i < cams.size(); i++)
 	{
 		if (LightFinder::tryProcess(cams[i]->outQ, lightStoragesQ))
-			return;
+			return true;
 	}
 
-	tryReadCam(detectionNodeShared::settings, cams);
+	//cameras are read by their own capture threads, nothing to do until a frame arrives
+	return false;
 };
 
 void ThreadPool::worker()
 {
 	while (run)
 	{
-		doWork();
+		if (!doWork())
+			this_thread::sleep_for(chrono::microseconds(500));
 	}
 };
 
@@ -118,18 +120,27 @@ bool ThreadPool::startThreads(const int &count)
 	else
 	{
 		run = true;
+		for (int i = 0; i < cams.size(); i++)
+		{
+			cams[i]->startCapture();
+		}
 		for (int i = 0; i < count; i++)
 		{
 			workers.push_back(new thread(&ThreadPool::worker, this));
 
 			cout << "created thread " << i << endl;
 		}
+		return true;
 	}
 };
 
 void ThreadPool::stopThreads()
 {
 	run = false;
+	for (int i = 0; i < cams.size(); i++)
+	{
+		cams[i]->stopCapture();
+	}
 	while (workers.size() != 0)
 	{
 		workers.back()->join();
@@ -29,7 +29,8 @@ public:
 
   bool initialize();
 
-  void doWork();
+  //one step of the processing pipeline, false if there was nothing to do
+  bool doWork();
 
   void worker();
 
@@ -260,8 +260,8 @@ LightStorage *LightFinder::findLight(Mat image, LightFilterSetting *setting, Set
     findContours(result->preprocessedImgB, blue_contours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_SIMPLE);
     findContours(result->preprocessedImgR, red_contours, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_SIMPLE);
 
-    contour_B_area.reserve(white_contours.size());
-    contour_R_area.reserve(white_contours.size());
+    contour_B_area.resize(white_contours.size());
+    contour_R_area.resize(white_contours.size());
     light_rect.reserve(white_contours.size());
 
     for (size_t i = 0; i < white_contours.size(); i++) {
@@ -2,13 +2,23 @@
  * ROS node to update the detection algorithm with tracking and data association
  * @author Beck Pang
  * @date 2018-11-17
+ *
+ * Every frame goes to the tracker thread, which follows the 4 armor vertices with
+ * pyramidal Lucas-Kanade flow and publishes them. The full LightFinder detection
+ * runs on its own thread at detection_freq on the latest frame, to start a track,
+ * confirm it or re-seed it. A detection is carried up to the newest frame by
+ * tracking it through the frames kept since it was captured, so the detection
+ * latency does not show in the output.
  */
 #include <iostream>
 #include <vector>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include <opencv2/opencv.hpp>
-#include <opencv2/tracking.hpp>
-#include <opencv2/core/ocl.hpp>
 #include <cv_bridge/cv_bridge.h>
 
 #include <ros/ros.h>
@@ -25,209 +35,433 @@ using namespace std;
 ros::Publisher bbox_pub;
 string cv_topic;
 string bbox_topic;
-double tracking_freq = 80;
+string video_file;
 double detection_freq = 30;
-double redetection_freq = 1;
-
-bool image_received = false;
-
-Rect2d bbox_detect;
-Rect2d bbox_detect_prev;
+int verify_count_max = 3;
+int miss_count_max = 3;
+int history_size = 8;
 
 enum _detect_state_t { IDLE, DETECTION, ASSOCIATION, TRACKING };
 _detect_state_t state = IDLE;
 
+Settings settings("settings.xml");
+LightFilterSetting lightSetting;
+
+const Size flow_window(21, 21);
+const int flow_levels = 3;
+
+// latest frame for each thread, older frames are dropped rather than queued
+struct FrameSlot
+{
+    Mat image;
+    ros::Time stamp;
+    unsigned long seq = 0;
+};
+
+mutex frame_mutex;
+condition_variable frame_cond;
+FrameSlot latest_frame;
+atomic<bool> running(true);
+atomic<unsigned long> dropped_frames(0);
+
+mutex detection_mutex;
+bool detection_ready = false;
+DetectionResult detection_result;
+
+// Kalman filter on the armor center
+KalmanFilter kalman(4, 2, 0, CV_64F);
+ros::Time kalman_stamp;
+bool kalman_initialized = false;
 
-// image tracker
-vector<Mat> image_stack;
-Ptr<Tracker> tracker;
+bool
+pairLights(const vector<Light> &lights, ArmorVertices &vertices) {
+    const ADSetting &ad = settings.adSetting;
+    double best_score = -1;
+
+    for (size_t i = 0; i < lights.size(); i++) {
+        for (size_t j = i + 1; j < lights.size(); j++) {
+            const Light &a = lights[i], &b = lights[j];
+
+            float tilt_diff = abs(a.rect.angle - b.rect.angle);
+            if (tilt_diff > 90)
+                tilt_diff = 180 - tilt_diff;
+            if (tilt_diff > ad.armor_max_tilt_diff_)
+                continue;
+
+            double mean_length = 0.5 * (a.length() + b.length());
+            double ratio = norm(a.rect.center - b.rect.center) / mean_length;
+            if (ratio < ad.armor_min_aspect_ratio_ || ratio > ad.armor_max_aspect_ratio_)
+                continue;
+
+            double length_diff = abs(a.length() - b.length()) / (a.length() + b.length());
+            if (length_diff > ad.armor_max_light_length_diff_proportion_)
+                continue;
+
+            // prefer large armors with lights of equal length
+            double score = mean_length * (1.0 - length_diff);
+            if (score > best_score) {
+                best_score = score;
+                const Light &left = (a.rect.center.x < b.rect.center.x) ? a : b;
+                const Light &right = (a.rect.center.x < b.rect.center.x) ? b : a;
+                vertices = {left.vertex[0], left.vertex[1], right.vertex[0], right.vertex[1]};
+            }
+        }
+    }
+    return best_score > 0;
+}
 
-Settings settings("settings.xml");
+bool
+detect(const Mat &cur_frame, ArmorVertices &vertices) {
+    unique_ptr<LightStorage> lights(LightFinder::findLight(cur_frame, &lightSetting, &settings));
+
+    if (settings.adSetting.enemyColor == ArmorColor_BLUE)
+        return pairLights(lights->lightsB, vertices);
+    else
+        return pairLights(lights->lightsR, vertices);
+}
 
 bool
-detect(const Mat cur_frame, Rect2d &bbox) {
-    LightFilterSetting *lightSetting = new LightFilterSetting();
+trackVertices(const TrackFrame &prev, const TrackFrame &cur, ArmorVertices &vertices) {
+    vector<Point2f> points(vertices.begin(), vertices.end()), next, back;
+    vector<uchar> status, back_status;
+    vector<float> error;
 
-    LightStorage* lights = LightFinder::findLight(cur_frame, lightSetting, &settings);
+    calcOpticalFlowPyrLK(prev.pyramid, cur.pyramid, points, next, status, error, flow_window, flow_levels);
+    calcOpticalFlowPyrLK(cur.pyramid, prev.pyramid, next, back, back_status, error, flow_window, flow_levels);
 
-//    vector<ArmorProcessor::LightGp> RLightGps;
-//    vector<ArmorProcessor::LightGp> BLightGps;
-//    armorGrouper(lights->lightsR, RLightGps);
-//    armorGrouper(lights->lightsB, BLightGps);
-    return false;
+    for (size_t i = 0; i < points.size(); i++) {
+        if (!status[i] || !back_status[i] || norm(back[i] - points[i]) > 1.0)
+            return false;
+    }
+    for (size_t i = 0; i < points.size(); i++)
+        vertices[i] = next[i];
+    return true;
 }
 
-void
-kalman_filter_init(const Rect2d &bbox) {
+static Point2d
+center(const ArmorVertices &vertices) {
+    return Point2d((vertices[0] + vertices[1] + vertices[2] + vertices[3]) / 4.0);
+}
 
+static void
+kalman_filter_predict(const ros::Time &stamp) {
+    double dt = max(0.0, (stamp - kalman_stamp).toSec());
+    kalman.transitionMatrix = (Mat_<double>(4, 4) << 1, 0, dt, 0,
+                                                      0, 1, 0, dt,
+                                                      0, 0, 1, 0,
+                                                      0, 0, 0, 1);
+    // white acceleration noise, in pixel / s^2
+    double q = 4000.0 * 4000.0;
+    kalman.processNoiseCov = (Mat_<double>(4, 4) << q * pow(dt, 4) / 4, 0, q * pow(dt, 3) / 2, 0,
+                                                     0, q * pow(dt, 4) / 4, 0, q * pow(dt, 3) / 2,
+                                                     q * pow(dt, 3) / 2, 0, q * dt * dt, 0,
+                                                     0, q * pow(dt, 3) / 2, 0, q * dt * dt);
+    kalman.predict();
+    kalman_stamp = stamp;
+}
+
+void
+kalman_filter_init(const ArmorVertices &vertices, const ros::Time &stamp) {
+    Point2d c = center(vertices);
+    kalman.statePost = (Mat_<double>(4, 1) << c.x, c.y, 0, 0);
+    kalman.errorCovPost = Mat::diag((Mat_<double>(4, 1) << 25, 25, 1e5, 1e5));
+    kalman.measurementMatrix = (Mat_<double>(2, 4) << 1, 0, 0, 0,
+                                                      0, 1, 0, 0);
+    kalman.measurementNoiseCov = Mat::eye(2, 2, CV_64F) * 4.0;
+    kalman_stamp = stamp;
+    kalman_initialized = true;
 }
 
 bool
-kalman_filter_update(const Rect2d &bbox) {
-    return false;
+kalman_filter_update(const ArmorVertices &vertices, const ros::Time &stamp) {
+    if (!kalman_initialized)
+        return false;
+
+    kalman_filter_predict(stamp);
+
+    // chi-square gate at 99.9% for 2 degrees of freedom
+    Point2d c = center(vertices);
+    Mat z = (Mat_<double>(2, 1) << c.x, c.y);
+    Mat innovation = z - kalman.measurementMatrix * kalman.statePre;
+    Mat S = kalman.measurementMatrix * kalman.errorCovPre * kalman.measurementMatrix.t() + kalman.measurementNoiseCov;
+    double d2 = Mat(innovation.t() * S.inv() * innovation).at<double>(0);
+    if (d2 > 13.8) {
+        // keep the prediction as the posterior
+        kalman.statePre.copyTo(kalman.statePost);
+        kalman.errorCovPre.copyTo(kalman.errorCovPost);
+        return false;
+    }
+
+    kalman.correct(z);
+    return true;
 }
 
 void
 kalman_filter_clear() {
+    kalman_initialized = false;
+}
 
+void
+publishVertices(const ArmorVertices &vertices, const ros::Time &stamp) {
+    rm_cv::vertice msg;
+    msg.header.stamp = stamp;
+    for (int i = 0; i < 4; i++) {
+        msg.vertex[i].x = vertices[i].x;
+        msg.vertex[i].y = vertices[i].y;
+        msg.vertex[i].z = 0;
+    }
+    bbox_pub.publish(msg);
 }
 
 void
-init_tracker(const Mat &cur_frame, const Rect2d &bbox) {
-    tracker = TrackerKCF::create();
-    tracker->init(cur_frame, bbox);
+pushFrame(const Mat &image, const ros::Time &stamp) {
+    {
+        lock_guard<mutex> lock(frame_mutex);
+        latest_frame.image = image;
+        latest_frame.stamp = stamp;
+        latest_frame.seq++;
+    }
+    frame_cond.notify_all();
 }
 
-/* TODO: Add 2D feature correspondence
-    bool feature_correspondence
- */
+bool
+waitFrame(unsigned long &seq, FrameSlot &frame, bool count_dropped) {
+    unique_lock<mutex> lock(frame_mutex);
+    frame_cond.wait(lock, [&] { return !running || latest_frame.seq != seq; });
+    if (!running)
+        return false;
+    if (count_dropped && latest_frame.seq > seq + 1 && seq != 0)
+        dropped_frames += latest_frame.seq - seq - 1;
+    frame = latest_frame;
+    seq = latest_frame.seq;
+    return true;
+}
 
 void
 cv_callback(const sensor_msgs::Image::ConstPtr image_ptr) {
-    /* code */
+    // own copy, the message buffer is released once the callback returns
+    pushFrame(cv_bridge::toCvCopy(image_ptr, "bgr8")->image, image_ptr->header.stamp);
 }
 
-int main(int argc, char **argv) {
-    ros::init(argc, argv, "armor_detect_and_track");
-    ros::NodeHandle nh("~");
-
-    nh.param("cv_topic", cv_topic, string("/cam1"));
-    nh.param("bbox_topic", bbox_topic, string("/rm_cv/bbox"));
+void
+detectionThread() {
+    ros::WallDuration period(1.0 / detection_freq);
+    unsigned long seq = 0;
+    FrameSlot frame;
+
+    while (running) {
+        ros::WallTime start = ros::WallTime::now();
+        if (!waitFrame(seq, frame, false))
+            break;
+
+        ros::WallTime detect_start = ros::WallTime::now();
+        DetectionResult result;
+        result.stamp = frame.stamp;
+        result.found = detect(frame.image, result.vertices);
+        result.elapsed_ms = (ros::WallTime::now() - detect_start).toSec() * 1000.0;
+        {
+            lock_guard<mutex> lock(detection_mutex);
+            detection_result = result;
+            detection_ready = true;
+        }
 
-    ros::Subscriber sub_frame = nh.subscribe(cv_topic, 10, cv_callback);
-    bbox_pub = nh.advertise<rm_cv::vertice>(bbox_topic, 10);
+        ros::WallDuration left = period - (ros::WallTime::now() - start);
+        if (left > ros::WallDuration(0))
+            left.sleep();
+    }
+}
 
-    ros::Rate rate_track(tracking_freq);
-    ros::Rate rate_detect(detection_freq);
+/**
+ * @brief carry a detection from its own frame up to the newest frame in the history
+ * @return false if no armor was found, its frame has left the history or the flow lost it on the way
+ */
+bool
+handleDetection(const DetectionResult &detection, const deque<TrackFrame> &history,
+                ArmorVertices &detected, int &miss_count) {
+    if (!detection.found) {
+        if (++miss_count >= miss_count_max && state != DETECTION) {
+            state = DETECTION;
+            kalman_filter_clear();
+        }
+        return false;
+    }
 
-    // For state machine
-    unsigned int verify_count = 0;
-    unsigned int tracking_count = 0;
-    unsigned int verify_count_max = 5;
-    unsigned int tracking_count_max = (unsigned int)(tracking_freq / redetection_freq);
+    size_t k = 0;
+    while (k < history.size() && history[k].stamp != detection.stamp)
+        k++;
+    if (k == history.size())
+        return false;
+    miss_count = 0;
+
+    detected = detection.vertices;
+    for (; k + 1 < history.size(); k++) {
+        if (!trackVertices(history[k], history[k + 1], detected))
+            return false;
+    }
+    return true;
+}
 
-    settings.load();
+/**
+ * @brief advance the state machine by one frame, with a single Kalman update:
+ * the carried detection if there is one, otherwise the vertices followed by the flow
+ */
+void
+updateTrack(const ArmorVertices *detected, bool flow_ok, const ros::Time &stamp,
+            ArmorVertices &vertices, int &verify_count) {
+    if (!detected) {
+        if ((state == ASSOCIATION || state == TRACKING) &&
+            !(flow_ok && kalman_filter_update(vertices, stamp))) {
+            state = DETECTION;
+            kalman_filter_clear();
+        }
+        return;
+    }
 
-    while (ros::ok()) {
-        // state machine
-        switch (state) {
-            case IDLE: {
-                state = image_received ? DETECTION : IDLE;
-                break;
+    switch (state) {
+        case IDLE:
+        case DETECTION:
+            kalman_filter_init(*detected, stamp);
+            verify_count = 1;
+            state = (verify_count >= verify_count_max) ? TRACKING : ASSOCIATION;
+            break;
+        case ASSOCIATION:
+            if (kalman_filter_update(*detected, stamp)) {
+                if (++verify_count >= verify_count_max)
+                    state = TRACKING;
+            } else {
+                kalman_filter_init(*detected, stamp);
+                verify_count = 1;
             }
-            case DETECTION: {
-                bool armor_detected = false;
-                // Action
-                if (image_received) {
-                    armor_detected = detect(image_stack.front(), bbox_detect);
-                }
-
-                // Change state condition
-                if (!image_received)
-                    state = IDLE;
-                else if (!armor_detected)
-                    state = DETECTION;
-                else
-                    state = ASSOCIATION;
-
-                // Describe the state edge
-                switch (state) {
-                    case IDLE:          break;
-                    case DETECTION:     break;
-                    case ASSOCIATION:
-                        verify_count = 0;
-                        kalman_filter_init(bbox_detect);
-                        break;
-                    case TRACKING:      break;
-                }
-                break;
+            break;
+        case TRACKING:
+            if (!kalman_filter_update(*detected, stamp)) {
+                // a different armor than the tracked one, confirm it before publishing again
+                kalman_filter_init(*detected, stamp);
+                verify_count = 1;
+                state = ASSOCIATION;
             }
-            case ASSOCIATION: {
-                bool armor_detected = false;
-                bool detection_verified = false;
-                bool count_pass = false;
-
-                // Action
-                if (image_received) {
-                    armor_detected = detect(image_stack.front(), bbox_detect);
-                    if (armor_detected) {
-                        detection_verified = kalman_filter_update(bbox_detect);
-                        if (detection_verified) {
-                            verify_count++;
-                            count_pass = !(verify_count < verify_count_max);
-                        }
-                    }
-                }
-
-                // Change state condition
-                if (!image_received)
-                    state = IDLE;
-                else if (!armor_detected || !detection_verified )
-                    state = DETECTION;
-                else if (!count_pass)
-                    state = ASSOCIATION;
-                else
-                    state = TRACKING;
+            break;
+    }
+    // re-seed to remove the drift of the flow
+    vertices = *detected;
+}
 
-                // Describe the state edge
-                switch (state) {
-                    case IDLE:          kalman_filter_clear(); break;
-                    case DETECTION:     kalman_filter_clear(); break;
-                    case ASSOCIATION:   break;
-                    case TRACKING:
-                        tracking_count = 0;
-                        init_tracker(image_stack.front(), bbox_detect);
-                        break;
-                }
-                break;
+void
+trackerThread() {
+    deque<TrackFrame> history;
+    ArmorVertices vertices;
+    int verify_count = 0;
+    int miss_count = 0;
+    unsigned long seq = 0;
+    FrameSlot frame;
+    Mat gray;
+
+    // statistics over the report period
+    ros::WallTime report_time = ros::WallTime::now();
+    int frames = 0, published = 0, detections = 0;
+    double track_ms = 0, track_ms_max = 0, detect_ms = 0, latency_ms = 0;
+
+    while (running) {
+        if (!waitFrame(seq, frame, true))
+            break;
+        ros::WallTime start = ros::WallTime::now();
+
+        if (state == IDLE)
+            state = DETECTION;
+
+        TrackFrame current;
+        current.stamp = frame.stamp;
+        cvtColor(frame.image, gray, COLOR_BGR2GRAY);
+        buildOpticalFlowPyramid(gray, current.pyramid, flow_window, flow_levels);
+        history.push_back(current);
+        while (history.size() > (size_t)history_size)
+            history.pop_front();
+
+        // follow the current armor into the new frame
+        bool flow_ok = (state == ASSOCIATION || state == TRACKING) && history.size() >= 2 &&
+                       trackVertices(history[history.size() - 2], history.back(), vertices);
+
+        DetectionResult detection;
+        bool have_detection = false;
+        {
+            lock_guard<mutex> lock(detection_mutex);
+            if (detection_ready) {
+                detection = detection_result;
+                detection_ready = false;
+                have_detection = true;
             }
-            case TRACKING: {
-                bool tracking_ok = false;
-                bool count_pass = false;
-
-                // Action
-                if (image_received) {
-                    tracking_ok = tracker->update(image_stack.front(), bbox_detect);
-                    if (tracking_ok) {
-                        tracking_count++;
-                        count_pass = !(tracking_count < tracking_count_max);
-                    }
-                }
-
-                // Change state condition
-                if (!image_received)
-                    state = IDLE;
-                else if (!tracking_ok)
-                    state = DETECTION;
-                else if (count_pass)
-                    state = ASSOCIATION;
-                else
-                    state = TRACKING;
+        }
+        ArmorVertices detected;
+        bool reseed = false;
+        if (have_detection) {
+            reseed = handleDetection(detection, history, detected, miss_count);
+            detections++;
+            detect_ms += detection.elapsed_ms;
+        }
+        updateTrack(reseed ? &detected : nullptr, flow_ok, current.stamp, vertices, verify_count);
 
-                switch (state) {
-                    case IDLE:          break;
-                    case DETECTION:     break;
-                    case ASSOCIATION:   break;
-                    case TRACKING:
-                        verify_count = 0;
-                        kalman_filter_init(bbox_detect);
-                        break;
-                }
-                break;
-            }
+        if (state == TRACKING) {
+            publishVertices(vertices, current.stamp);
+            published++;
+            latency_ms += (ros::Time::now() - current.stamp).toSec() * 1000.0;
         }
 
-        // control update rate
-        switch (state) {
-            case IDLE:
-            case DETECTION:
-            case ASSOCIATION:
-                rate_detect.sleep();
-                break;
-            case TRACKING:
-                rate_track.sleep();
-                break;
+        double elapsed = (ros::WallTime::now() - start).toSec() * 1000.0;
+        frames++;
+        track_ms += elapsed;
+        track_ms_max = max(track_ms_max, elapsed);
+
+        double report_period = (ros::WallTime::now() - report_time).toSec();
+        if (report_period > 5.0) {
+            ROS_INFO("tracking: %.1f fps in, %.1f fps out, track %.2f ms (max %.2f), detect %.1f Hz %.2f ms, "
+                     "latency %.2f ms, %lu dropped",
+                     frames / report_period, published / report_period,
+                     track_ms / frames, track_ms_max,
+                     detections / report_period, detections ? detect_ms / detections : 0.0,
+                     published ? latency_ms / published : 0.0, dropped_frames.exchange(0));
+            report_time = ros::WallTime::now();
+            frames = published = detections = 0;
+            track_ms = track_ms_max = detect_ms = latency_ms = 0;
         }
-        ros::spinOnce();
     }
 }
+
+int main(int argc, char **argv) {
+    ros::init(argc, argv, "armor_detect_and_track");
+    ros::NodeHandle nh("~");
+
+    nh.param("cv_topic", cv_topic, string("/cam1"));
+    nh.param("bbox_topic", bbox_topic, string("/rm_cv/bbox"));
+    nh.param("video_file", video_file, string(""));
+    nh.param("detection_freq", detection_freq, 30.0);
+    nh.param("verify_count_max", verify_count_max, 3);
+    nh.param("miss_count_max", miss_count_max, 3);
+    nh.param("history_size", history_size, 8);
+
+    settings.load();
+
+    bbox_pub = nh.advertise<rm_cv::vertice>(bbox_topic, 10);
+
+    thread tracker(trackerThread);
+    thread detector(detectionThread);
+
+    if (video_file.empty()) {
+        ros::Subscriber sub_frame = nh.subscribe(cv_topic, 10, cv_callback);
+        ros::spin();
+    } else {
+        // recorded video, played at its own frame rate to measure latency and throughput
+        VideoCapture video(video_file);
+        double fps = video.get(CAP_PROP_FPS);
+        ros::Rate rate(fps > 0 ? fps : 30.0);
+        Mat image;
+        while (ros::ok() && video.read(image)) {
+            pushFrame(image.clone(), ros::Time::now());
+            rate.sleep();
+        }
+    }
+
+    running = false;
+    frame_cond.notify_all();
+    tracker.join();
+    detector.join();
+}
@@ -0,0 +1,56 @@
+/**
+ * Detect-then-track engine for the armor vertices
+ * @author Beck Pang
+ * @date 2018-11-17
+ */
+#pragma once
+
+#include <array>
+#include <deque>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+#include <ros/ros.h>
+
+#include "armor_detect.h"
+
+//four armor vertices in the order of realArmorPoints: upper-left, lower-left, upper-right, lower-right
+typedef std::array<cv::Point2f, 4> ArmorVertices;
+
+//a frame kept by the tracker, the pyramid is built once and reused by every flow step
+struct TrackFrame
+{
+    ros::Time stamp;
+    std::vector<cv::Mat> pyramid;
+};
+
+//result of one asynchronous detection, for the frame captured at stamp
+struct DetectionResult
+{
+    ros::Time stamp;
+    bool found;
+    ArmorVertices vertices;
+    double elapsed_ms;
+};
+
+/**
+ * @brief full LightFinder detection and light pairing on one BGR frame
+ * @return true if an armor of the enemy color is found
+ */
+bool detect(const cv::Mat &cur_frame, ArmorVertices &vertices);
+
+/**
+ * @brief choose the pair of lights that looks most like an armor plate
+ */
+bool pairLights(const std::vector<Light> &lights, ArmorVertices &vertices);
+
+/**
+ * @brief move the vertices from prev to cur with pyramidal Lucas-Kanade flow,
+ * every vertex must pass the forward-backward check
+ */
+bool trackVertices(const TrackFrame &prev, const TrackFrame &cur, ArmorVertices &vertices);
+
+//constant velocity filter on the armor center, used to gate detections and tracks
+void kalman_filter_init(const ArmorVertices &vertices, const ros::Time &stamp);
+bool kalman_filter_update(const ArmorVertices &vertices, const ros::Time &stamp);
+void kalman_filter_clear();
@@ -0,0 +1,110 @@
+/**
+ * @brief synthetic drift test of the camera timestamp filter
+ * a device clock with an offset and a skew sends frames at 100 Hz with random transport delays,
+ * the corrected stamps must follow the host time of the frames
+ */
+#include <gtest/gtest.h>
+#include <random>
+#include "cameraDriver/TimestampFilter.hpp"
+
+namespace
+{
+const double rate = 100.0;
+const double minDelay = 0.002;
+
+struct DriftingCamera
+{
+  double offset; //device time at host time 0
+  double skew;   //device rate minus one
+  std::mt19937 rng{42};
+  std::exponential_distribution<double> delay{1.0 / 0.003};
+
+  double device(double host) const { return offset + (1 + skew) * host; }
+  double arrival(double host) { return host + minDelay + delay(rng); }
+};
+} // namespace
+
+TEST(TimestampFilter, EstimatesSkewAndOffset)
+{
+  DriftingCamera cam{1000.0, 80e-6};
+  TimestampFilter filter;
+
+  double maxError = 0;
+  for (int i = 0; i < 60 * rate; i++)
+  {
+    double host = i / rate;
+    double stamp = filter.update(cam.device(host), cam.arrival(host));
+    //the filter is locked after the first window of samples
+    if (host > 10)
+      maxError = std::max(maxError, std::abs(stamp - (host + minDelay)));
+  }
+
+  //host = device / (1 + skew) - ..., so the filter sees a skew of -skew / (1 + skew)
+  EXPECT_NEAR(filter.skew(), -80e-6 / (1 + 80e-6), 5e-6);
+  EXPECT_LT(maxError, 0.5e-3);
+  EXPECT_EQ(filter.jumps(), 0);
+}
+
+TEST(TimestampFilter, RecoversFromOffsetJump)
+{
+  DriftingCamera cam{5.0, -30e-6};
+  TimestampFilter filter;
+
+  double error = 0;
+  for (int i = 0; i < 40 * rate; i++)
+  {
+    double host = i / rate;
+    //the device clock jumps one second ahead after 20 s
+    if (host >= 20)
+      cam.offset = 6.0;
+    double stamp = filter.update(cam.device(host), cam.arrival(host));
+    error = std::abs(stamp - (host + minDelay));
+  }
+
+  EXPECT_EQ(filter.jumps(), 1);
+  EXPECT_LT(error, 0.5e-3);
+}
+
+TEST(TimestampFilter, ResetsWhenDeviceClockGoesBack)
+{
+  DriftingCamera cam{100.0, 0};
+  TimestampFilter filter;
+
+  for (int i = 0; i < 5 * rate; i++)
+    filter.update(cam.device(i / rate), cam.arrival(i / rate));
+
+  //the camera restarted its clock
+  cam.offset = -5.0;
+  double host = 5.0;
+  filter.update(cam.device(host), cam.arrival(host));
+
+  EXPECT_EQ(filter.jumps(), 1);
+  EXPECT_EQ(filter.size(), 1u);
+}
+
+TEST(TimestampFilter, ToleratesIsolatedLateFrames)
+{
+  DriftingCamera cam{0.0, 20e-6};
+  TimestampFilter filter;
+
+  double error = 0;
+  for (int i = 0; i < 20 * rate; i++)
+  {
+    double host = i / rate;
+    double arrival = cam.arrival(host);
+    //a scheduling hiccup every 2 s delays a frame by 200 ms
+    if (i % 200 == 199)
+      arrival += 0.2;
+    double stamp = filter.update(cam.device(host), arrival);
+    error = std::abs(stamp - (host + minDelay));
+  }
+
+  EXPECT_EQ(filter.jumps(), 0);
+  EXPECT_LT(error, 0.5e-3);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
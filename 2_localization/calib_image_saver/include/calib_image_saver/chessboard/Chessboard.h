@@ -36,6 +36,18 @@ private:
                                        std::vector<cv::Point2f>& corners,
                                        int flags);
 
+    // one resolution: every threshold run, its dilation levels in parallel, no subpixel refinement
+    bool findBoardQuads(const cv::Mat& img,
+                        const cv::Size& patternSize,
+                        std::vector<cv::Point2f>& corners,
+                        int flags);
+
+    bool findBoardAtDilation(cv::Mat& threshImg,
+                             const cv::Size& patternSize,
+                             int flags, int dilations,
+                             std::vector<ChessboardCornerPtr>& outputCorners,
+                             int& sqrSize);
+
     void cleanFoundConnectedQuads(std::vector<ChessboardQuadPtr>& quadGroup, cv::Size patternSize);
 
     void findConnectedQuads(std::vector<ChessboardQuadPtr>& quads,
@@ -60,7 +72,8 @@ private:
 
     bool checkQuadGroup(std::vector<ChessboardQuadPtr>& quads,
                         std::vector<ChessboardCornerPtr>& corners,
-                        cv::Size patternSize);
+                        cv::Size patternSize,
+                        cv::Size imageSize);
 
     void getQuadrangleHypotheses(const std::vector< std::vector<cv::Point> >& contours,
                                  std::vector< std::pair<float, int> >& quads,
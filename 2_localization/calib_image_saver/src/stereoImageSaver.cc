@@ -31,12 +31,14 @@ cv::Size image_size;
 int image_count       = 0;
 bool is_first_run     = true;
 bool is_get_chessbord = false;
-ros::Time time_last, time_now;
+ros::Time time_last, time_now, time_processed;
 int max_freq = 10;
 cv::Mat image_in_l, image_in_r, image_show_l, image_show_r;
 cv::Mat DistributedImage;
 std::vector< std::vector< cv::Point2f > > total_image_points_left;
 std::vector< std::vector< cv::Point2f > > total_image_points_right;
+// around the board in the last frame, empty when it was not found
+cv::Rect last_board_left, last_board_right;
 
 void
 showImage( cv::Mat& image, cv::Mat& image1, cv::Mat& _DistributedImage )
@@ -147,30 +149,76 @@ imageProcessCallback( const sensor_msgs::ImageConstPtr& left_image_msg,
         showImage( image_in_l, image_in_r, DistributedImage );
 }
 
+cv::Rect
+boardRegion( const std::vector< cv::Point2f >& corners, cv::Size image_size )
+{
+    cv::Rect box    = cv::boundingRect( corners );
+    cv::Rect region = cv::Rect( box.x - box.width / 2, box.y - box.height / 2, box.width * 2, box.height * 2 );
+    return region & cv::Rect( 0, 0, image_size.width, image_size.height );
+}
+
+// The board moves little between two frames, so it is searched around its
+// last position first, which is a fraction of the image, then on the whole image.
+bool
+findBoard( cv::Mat& image, cv::Rect& last_board, std::vector< cv::Point2f >& corners )
+{
+    if ( last_board.area( ) > 0 )
+    {
+        cv::Mat image_roi = image( last_board );
+        camera_model::Chessboard chessboard( boardSize, image_roi );
+        chessboard.findCorners( is_use_OpenCV );
+        if ( chessboard.cornersFound( ) )
+        {
+            corners = chessboard.getCorners( );
+            for ( size_t i = 0; i < corners.size( ); ++i )
+                corners[i] += cv::Point2f( last_board.x, last_board.y );
+            last_board = boardRegion( corners, image.size( ) );
+            return true;
+        }
+    }
+
+    camera_model::Chessboard chessboard( boardSize, image );
+    chessboard.findCorners( is_use_OpenCV );
+    if ( !chessboard.cornersFound( ) )
+    {
+        last_board = cv::Rect( );
+        return false;
+    }
+
+    corners    = chessboard.getCorners( );
+    last_board = boardRegion( corners, image.size( ) );
+    return true;
+}
+
 void
 process( )
 {
     if ( is_first_run )
         return;
 
+    // the loop runs at the rate of the images, but a frame must not be saved twice
+    if ( time_now == time_processed )
+        return;
+    time_processed = time_now;
+
     cv::Mat image_left  = image_in_l;
     cv::Mat image_right = image_in_r;
 
-    camera_model::Chessboard chessboard_left( boardSize, image_left );
-    camera_model::Chessboard chessboard_right( boardSize, image_right );
+    bool found_left = false, found_right = false;
+    std::vector< cv::Point2f > corners_left, corners_right;
 #pragma omp parallel sections
     {
 #pragma omp section
         {
-            chessboard_left.findCorners( is_use_OpenCV );
+            found_left = findBoard( image_left, last_board_left, corners_left );
         }
 #pragma omp section
         {
-            chessboard_right.findCorners( is_use_OpenCV );
+            found_right = findBoard( image_right, last_board_right, corners_right );
         }
     }
 
-    if ( chessboard_left.cornersFound( ) && chessboard_right.cornersFound( ) )
+    if ( found_left && found_right )
     {
         std::stringstream ss_num;
         ss_num << image_count;
@@ -188,8 +236,8 @@ process( )
         cv::imwrite( image_file_right, image_right );
 
         ++image_count;
-        total_image_points_left.push_back( chessboard_left.getCorners( ) );
-        total_image_points_right.push_back( chessboard_right.getCorners( ) );
+        total_image_points_left.push_back( corners_left );
+        total_image_points_right.push_back( corners_right );
 
         if ( is_show )
         {
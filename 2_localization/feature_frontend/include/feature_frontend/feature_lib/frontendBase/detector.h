@@ -11,10 +11,16 @@ class Detector
     public:
     Detector( )
     : m_minFeatureDist( 0 )
+    , occupancySize( 1 )
+    , occupancyNumWidth( 0 )
+    , occupancyNumHeight( 0 )
     {
     }
     Detector( int minFeatureDist )
     : m_minFeatureDist( minFeatureDist )
+    , occupancySize( 1 )
+    , occupancyNumWidth( 0 )
+    , occupancyNumHeight( 0 )
     {
     }
 
@@ -42,13 +48,31 @@ class Detector
                   const std::vector< cv::Rect >& mask_rect );
     int pointInMask( const cv::Point2f& pt );
 
+    // occupancy grid with cells of m_minFeatureDist pixels, which replaces the mask image
+    // drawn every frame: a cell holding a track or a new point takes no other new point
+    void initOccupancyGrid( const int image_width, const int image_height );
+    void setOccupied( const std::vector< cv::Point2f >& existPoints );
+    int newNumInRect( const int rect_index, const int max_new_num, const int exist_num ) const;
+    void selectInRect( const std::vector< cv::KeyPoint >& keyPoints, // in rect
+                       const cv::Rect& rect,
+                       const int max_new_num,
+                       std::vector< cv::Point2f >& newPoints );
+
     virtual void detectNewFeatures( const cv::Mat& image_in,
                                     const std::vector< cv::Point2f >& existPoints, //
                                     const int _max_new_num,
                                     std::vector< cv::Point2f >& newPoints )
     = 0;
 
-    void setMinFeatureDist( int minFeatureDist ) { m_minFeatureDist = minFeatureDist; }
+    void setMinFeatureDist( int minFeatureDist )
+    {
+        m_minFeatureDist = minFeatureDist;
+        if ( !mask.empty( ) )
+            initOccupancyGrid( mask.cols, mask.rows );
+    }
+
+    private:
+    int occupancyCell( const cv::Point2f& pt ) const;
 
     public:
     int maskPerWidth;
@@ -59,6 +83,18 @@ class Detector
     int numMask;
     cv::Mat mask;
     int m_minFeatureDist;
+
+    int occupancySize; // pixels
+    int occupancyNumWidth;
+    int occupancyNumHeight;
+    std::vector< uchar > occupancy;
+    std::vector< int > rectCount; // tracks in each maskRect
+
+    private:
+    // per cell, the best keypoint of selectInRect, -1 when none
+    std::vector< int > occupancyBest;
+    std::vector< int > cellsTouched;
+    std::vector< int > keyPointsSelected;
 };
 }
 #endif // DETECTOR_H
@@ -22,7 +22,6 @@ class DetectorFast : public Detector
                             std::vector< cv::Point2f >& newPoints );
 
     private:
-    void insertionSort( std::vector< cv::KeyPoint >& arr );
     int calcThresholdLinear( int index )
     {
         return fastMaxThreshold - fastPerThreshold * index; // linear
@@ -36,12 +36,21 @@ class FeatureStereoTracker : public frontend::FeatureTracker
     std::vector< Eigen::Vector3d > getUndistortedPointsRight( );
 
     private:
-    void trackFeatures( const cv::Mat& left_image, const cv::Mat& right_image, bool is_track_right );
+    void trackFeatures( const cv::Mat& right_image, bool is_track_right );
+    void buildPyramid( const cv::Mat& image, std::vector< cv::Mat >& pyramid ) const;
 
     public:
     frontend::FeatureBase* m_tracker_r;
     cv::Ptr< cv::SparsePyrLKOpticalFlow > m_sparseFlowLeft2Right;
+    cv::Ptr< cv::CLAHE > m_clahe;
     cv::Rect rightRect;
+
+    private:
+    // LK pyramids, each built once per image and shared by the flows:
+    // the last left image, this left image and this right image
+    std::vector< cv::Mat > m_pyramid_pre;
+    std::vector< cv::Mat > m_pyramid_left;
+    std::vector< cv::Mat > m_pyramid_right;
 };
 
 typedef boost::shared_ptr< FeatureStereoTracker > FeatureStereoPtr;
@@ -0,0 +1,178 @@
+#include <feature_frontend/feature_lib/frontendBase/detectorfast.h>
+#include <feature_frontend/feature_lib/frontendBase/detectorharris.h>
+#include <feature_frontend/feature_lib/frontendBase/tic_toc.h>
+#include <iomanip>
+#include <iostream>
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <ros/ros.h>
+
+// DetectorFast::detectNewFeatures before the occupancy grid: a copy of the mask with a
+// circle on every track, FAST in every rect, insertion sort on the response
+void
+detectWithMaskImage( frontend::Detector& detector,
+                     cv::Ptr< cv::FastFeatureDetector > fast,
+                     const cv::Mat& image_in,
+                     const std::vector< cv::Point2f >& existPoints,
+                     const int _max_new_num,
+                     std::vector< cv::Point2f >& newPoints )
+{
+    cv::Mat new_masks;
+    newPoints.clear( );
+
+    if ( _max_new_num < 3 )
+        return;
+
+    if ( existPoints.empty( ) )
+        detector.mask.copyTo( new_masks );
+    else
+        new_masks = detector.setMask( existPoints );
+
+    int new_num = std::max( _max_new_num / detector.numMask, 2 );
+
+    for ( auto& rect : detector.maskRect )
+    {
+        std::vector< cv::KeyPoint > keyPointsTmp;
+        fast->detect( image_in( rect ), keyPointsTmp, new_masks( rect ) );
+
+        for ( int i = 1; i < int( keyPointsTmp.size( ) ); i++ )
+        {
+            cv::KeyPoint temp = keyPointsTmp[i];
+            int j             = i;
+            for ( ; j > 0 && keyPointsTmp[j - 1].response > temp.response; j-- )
+                keyPointsTmp[j] = keyPointsTmp[j - 1];
+            keyPointsTmp[j] = temp;
+        }
+
+        int first = std::max( int( keyPointsTmp.size( ) ) - new_num, 0 );
+        for ( int pt_index = int( keyPointsTmp.size( ) ) - 1; pt_index >= first; --pt_index )
+            newPoints.push_back( keyPointsTmp[pt_index].pt + cv::Point2f( rect.x, rect.y ) );
+    }
+}
+
+// spatial distribution of the tracks and the new points together
+void
+printDistribution( const std::string& name,
+                   double time,
+                   const cv::Size& size,
+                   int minDist,
+                   const std::vector< cv::Point2f >& existPoints,
+                   const std::vector< cv::Point2f >& newPoints )
+{
+    std::vector< cv::Point2f > all( existPoints );
+    all.insert( all.end( ), newPoints.begin( ), newPoints.end( ) );
+
+    // cells of a 16x16 grid with a feature
+    const int grid = 16;
+    std::vector< int > cellCount( grid * grid, 0 );
+    for ( auto& pt : all )
+    {
+        int x = std::min( int( pt.x * grid / size.width ), grid - 1 );
+        int y = std::min( int( pt.y * grid / size.height ), grid - 1 );
+        ++cellCount[y * grid + x];
+    }
+    int cellsUsed = 0;
+    for ( auto& n : cellCount )
+        cellsUsed += n > 0;
+
+    // new points closer than half the minimum distance to another feature
+    int tooClose = 0;
+    for ( size_t i = 0; i < newPoints.size( ); ++i )
+        for ( size_t j = 0; j < all.size( ); ++j )
+        {
+            if ( j == existPoints.size( ) + i )
+                continue;
+            cv::Point2f d = newPoints[i] - all[j];
+            if ( d.dot( d ) < 0.25 * minDist * minDist )
+            {
+                ++tooClose;
+                break;
+            }
+        }
+
+    std::cout << std::setw( 14 ) << name << std::setw( 10 ) << time << std::setw( 8 ) << newPoints.size( )
+              << std::setw( 10 ) << 100.0 * cellsUsed / ( grid * grid ) << std::setw( 10 ) << tooClose << std::endl;
+}
+
+int
+main( int argc, char** argv )
+{
+    ros::init( argc, argv, "detector_benchmark" );
+    ros::NodeHandle n( "~" );
+
+    std::string image_file;
+    std::string mask_file;
+    int min_dist   = 20;
+    int max_cnt    = 300;
+    int tracks     = 150;
+    int grid_x     = 3;
+    int grid_y     = 3;
+    int iterations = 100;
+
+    n.getParam( "image", image_file );
+    n.getParam( "mask", mask_file );
+    n.getParam( "min_dist", min_dist );
+    n.getParam( "max_cnt", max_cnt );
+    n.getParam( "tracks", tracks );
+    n.getParam( "grid_x", grid_x );
+    n.getParam( "grid_y", grid_y );
+    n.getParam( "iterations", iterations );
+
+    cv::Mat image;
+    if ( !image_file.empty( ) )
+        image = cv::imread( image_file, cv::IMREAD_GRAYSCALE );
+    if ( image.empty( ) )
+    {
+        std::cout << "#INFO: no image, using a synthetic one" << std::endl;
+        image = cv::Mat( 1024, 1280, CV_8UC1 );
+        cv::randu( image, cv::Scalar( 0 ), cv::Scalar( 255 ) );
+        cv::GaussianBlur( image, image, cv::Size( 7, 7 ), 0 );
+    }
+    cv::Mat mask;
+    if ( !mask_file.empty( ) )
+        mask = cv::imread( mask_file, cv::IMREAD_GRAYSCALE );
+
+    frontend::DetectorFast detectorFast( min_dist );
+    detectorFast.initMaskWithSquareNum( mask, grid_x, grid_y, image.cols, image.rows );
+    frontend::DetectorHarris detectorHarris( min_dist );
+    detectorHarris.initMaskWithSquareNum( mask, grid_x, grid_y, image.cols, image.rows );
+
+    cv::Ptr< cv::FastFeatureDetector > fast
+    = cv::FastFeatureDetector::create( 70, true, cv::FastFeatureDetector::TYPE_9_16 );
+
+    // tracks from the left half of the image, as after turning the camera
+    cv::RNG rng( 0 );
+    std::vector< cv::Point2f > existPoints;
+    for ( int i = 0; i < tracks; ++i )
+        existPoints.push_back(
+        cv::Point2f( rng.uniform( 0.f, image.cols / 2.f ), rng.uniform( 0.f, float( image.rows ) ) ) );
+    int max_new_num = std::max( max_cnt - tracks, 0 );
+
+    std::vector< cv::Point2f > pointsMaskImage, pointsFast, pointsHarris;
+    TicToc t;
+    for ( int i = 0; i < iterations; ++i )
+        detectWithMaskImage( detectorFast, fast, image, existPoints, max_new_num, pointsMaskImage );
+    double t_mask_image = t.toc( ) / iterations;
+
+    t.tic( );
+    for ( int i = 0; i < iterations; ++i )
+        detectorFast.detectNewFeatures( image, existPoints, max_new_num, pointsFast );
+    double t_fast = t.toc( ) / iterations;
+
+    t.tic( );
+    for ( int i = 0; i < iterations; ++i )
+        detectorHarris.detectNewFeatures( image, existPoints, max_new_num, pointsHarris );
+    double t_harris = t.toc( ) / iterations;
+
+    std::cout << std::fixed << std::setprecision( 3 );
+    std::cout << "#INFO: " << image.cols << "x" << image.rows << ", " << tracks << " tracks, " << max_new_num
+              << " new points wanted, grid " << grid_x << "x" << grid_y << std::endl;
+    std::cout << std::setw( 14 ) << "detector" << std::setw( 10 ) << "ms" << std::setw( 8 ) << "new"
+              << std::setw( 10 ) << "cells %" << std::setw( 10 ) << "too close" << std::endl;
+    printDistribution( "mask image", t_mask_image, image.size( ), min_dist, existPoints, pointsMaskImage );
+    printDistribution( "fast grid", t_fast, image.size( ), min_dist, existPoints, pointsFast );
+    printDistribution( "harris grid", t_harris, image.size( ), min_dist, existPoints, pointsHarris );
+
+    return 0;
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <feature_frontend/feature_lib/frontendBase/detector.h>
 
 void
@@ -22,13 +23,14 @@ frontend::Detector::initMaskWithSquareNum( const cv::Mat& _mask,
         image_height = mask.rows;
     }
 
-    maskNumWidth = numWidth;
-    maskNumWidth = numHeight;
+    maskNumWidth  = numWidth;
+    maskNumHeight = numHeight;
 
-    maskPerWidth  = std::ceil( image_width / maskNumWidth );
-    maskPerHeight = std::ceil( image_height / maskNumWidth );
+    maskPerWidth  = std::ceil( image_width / double( maskNumWidth ) );
+    maskPerHeight = std::ceil( image_height / double( maskNumHeight ) );
     std::cout << "mask num  " << maskPerWidth << " " << maskPerHeight << std::endl;
 
+    maskRect.clear( );
     for ( int index_height = 0; index_height < numHeight; ++index_height )
         for ( int index_width = 0; index_width < numWidth; ++index_width )
         {
@@ -50,6 +52,7 @@ frontend::Detector::initMaskWithSquareNum( const cv::Mat& _mask,
     std::cout << "mask image size  " << mask.cols << " " << mask.rows << std::endl;
 
     numMask = maskRect.size( );
+    initOccupancyGrid( image_width, image_height );
 }
 
 void
@@ -77,10 +80,11 @@ frontend::Detector::initMaskWithSquareSize( const cv::Mat& _mask,
     maskPerWidth  = perWidth;
     maskPerHeight = perHeight;
 
-    maskNumWidth = std::ceil( image_width / maskPerWidth );
-    maskNumWidth = std::ceil( image_height / maskPerHeight );
+    maskNumWidth  = std::ceil( image_width / double( maskPerWidth ) );
+    maskNumHeight = std::ceil( image_height / double( maskPerHeight ) );
 
-    for ( int index_height = 0; index_height < maskNumWidth; ++index_height )
+    maskRect.clear( );
+    for ( int index_height = 0; index_height < maskNumHeight; ++index_height )
         for ( int index_width = 0; index_width < maskNumWidth; ++index_width )
         {
             int width = ( index_width * maskPerWidth + maskPerWidth ) >= image_width ?
@@ -99,6 +103,7 @@ frontend::Detector::initMaskWithSquareSize( const cv::Mat& _mask,
     std::cout << "mask image size  " << mask.cols << " " << mask.rows << std::endl;
 
     numMask = maskRect.size( );
+    initOccupancyGrid( image_width, image_height );
 }
 
 cv::Mat
@@ -209,7 +214,98 @@ frontend::Detector::setMask( cv::Mat& mask,
 int
 frontend::Detector::pointInMask( const cv::Point2f& pt )
 {
-    int index_width  = std::floor( pt.x / maskPerWidth );
-    int index_height = std::floor( pt.y / maskPerHeight );
-    return index_width * maskNumWidth + index_height;
+    int index_width  = std::min( std::max( int( std::floor( pt.x / maskPerWidth ) ), 0 ), maskNumWidth - 1 );
+    int index_height = std::min( std::max( int( std::floor( pt.y / maskPerHeight ) ), 0 ), maskNumHeight - 1 );
+    return index_height * maskNumWidth + index_width;
+}
+
+void
+frontend::Detector::initOccupancyGrid( const int image_width, const int image_height )
+{
+    occupancySize      = std::max( m_minFeatureDist, 1 );
+    occupancyNumWidth  = ( image_width + occupancySize - 1 ) / occupancySize;
+    occupancyNumHeight = ( image_height + occupancySize - 1 ) / occupancySize;
+
+    occupancy.assign( occupancyNumWidth * occupancyNumHeight, 0 );
+    occupancyBest.assign( occupancy.size( ), -1 );
+    rectCount.assign( maskRect.size( ), 0 );
+}
+
+int
+frontend::Detector::occupancyCell( const cv::Point2f& pt ) const
+{
+    int index_width  = std::min( std::max( int( pt.x ) / occupancySize, 0 ), occupancyNumWidth - 1 );
+    int index_height = std::min( std::max( int( pt.y ) / occupancySize, 0 ), occupancyNumHeight - 1 );
+    return index_height * occupancyNumWidth + index_width;
+}
+
+void
+frontend::Detector::setOccupied( const std::vector< cv::Point2f >& existPoints )
+{
+    std::fill( occupancy.begin( ), occupancy.end( ), 0 );
+    std::fill( rectCount.begin( ), rectCount.end( ), 0 );
+
+    for ( auto& pt : existPoints )
+    {
+        occupancy[occupancyCell( pt )] = 1;
+        ++rectCount[pointInMask( pt )];
+    }
+}
+
+int
+frontend::Detector::newNumInRect( const int rect_index, const int max_new_num, const int exist_num ) const
+{
+    // the same share of all the features for every rect, less its tracks
+    int per_rect = std::max( ( max_new_num + exist_num + numMask - 1 ) / numMask, 2 );
+    return std::max( per_rect - rectCount[rect_index], 0 );
+}
+
+void
+frontend::Detector::selectInRect( const std::vector< cv::KeyPoint >& keyPoints,
+                                  const cv::Rect& rect,
+                                  const int max_new_num,
+                                  std::vector< cv::Point2f >& newPoints )
+{
+    cv::Point2f offset( rect.x, rect.y );
+
+    // non-maximum suppression on the free cells
+    cellsTouched.clear( );
+    for ( int index = 0; index < int( keyPoints.size( ) ); ++index )
+    {
+        int cell = occupancyCell( keyPoints[index].pt + offset );
+        if ( occupancy[cell] )
+            continue;
+
+        int& best = occupancyBest[cell];
+        if ( best < 0 )
+        {
+            best = index;
+            cellsTouched.push_back( cell );
+        }
+        else if ( keyPoints[index].response > keyPoints[best].response )
+            best = index;
+    }
+
+    keyPointsSelected.clear( );
+    for ( auto& cell : cellsTouched )
+    {
+        keyPointsSelected.push_back( occupancyBest[cell] );
+        occupancyBest[cell] = -1;
+    }
+
+    if ( int( keyPointsSelected.size( ) ) > max_new_num )
+    {
+        std::nth_element( keyPointsSelected.begin( ),
+                          keyPointsSelected.begin( ) + max_new_num,
+                          keyPointsSelected.end( ),
+                          [&keyPoints]( int a, int b ) { return keyPoints[a].response > keyPoints[b].response; } );
+        keyPointsSelected.resize( max_new_num );
+    }
+
+    for ( auto& index : keyPointsSelected )
+    {
+        cv::Point2f pt = keyPoints[index].pt + offset;
+        occupancy[occupancyCell( pt )] = 1;
+        newPoints.push_back( pt );
+    }
 }
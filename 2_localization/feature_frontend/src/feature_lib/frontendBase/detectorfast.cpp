@@ -29,92 +29,29 @@ frontend::DetectorFast::detectNewFeatures( const cv::Mat& image_in,
                                            const int _max_new_num,
                                            std::vector< cv::Point2f >& newPoints )
 {
-    cv::Mat new_masks;
     newPoints.clear( );
 
     if ( _max_new_num < 3 )
         return;
 
-    if ( existPoints.empty( ) )
-        mask.copyTo( new_masks );
-    else
-        new_masks = setMask( existPoints );
+    setOccupied( existPoints );
 
-    int new_num = _max_new_num / numMask;
-    if ( new_num < 2 )
-        new_num = 2;
-
-    for ( auto& rect : maskRect )
+    for ( int rect_index = 0; rect_index < numMask; ++rect_index )
     {
-        int size_get_new = 0;
-        int index_loop   = 0;
-        //        for ( int index_loop = 0; index_loop < fastMaxLoopNum; ++index_loop )
-        //        //FIXME
-        {
-            //            int size_need_new = new_num - size_get_new;
-            int sizeNeedNewPerGrid = new_num;
+        const cv::Rect& rect = maskRect[rect_index];
+        int new_num          = newNumInRect( rect_index, _max_new_num, existPoints.size( ) );
+        if ( new_num == 0 || rect.area( ) == 0 )
+            continue;
 
 #if FAST
-            std::vector< cv::KeyPoint > keyPointsTmp;
-
-            fast->setThreshold( calcThresholdLinear( index_loop ) );
-
-            fast->detect( image_in( rect ), keyPointsTmp, new_masks( rect ) );
-
-            size_get_new += keyPointsTmp.size( );
+        std::vector< cv::KeyPoint > keyPointsTmp;
 
-            if ( int( keyPointsTmp.size( ) ) > sizeNeedNewPerGrid )
-            {
+        fast->setThreshold( calcThresholdLinear( 0 ) );
 
-                insertionSort( keyPointsTmp );
-
-                for ( int pt_index = keyPointsTmp.size( ) - 1;
-                      pt_index >= ( keyPointsTmp.size( ) - sizeNeedNewPerGrid );
-                      --pt_index )
-                {
-                    newPoints.push_back( cv::Point2f( keyPointsTmp[pt_index].pt.x + rect.x,
-                                                      keyPointsTmp[pt_index].pt.y + rect.y ) );
-                }
-            }
-            else
-            {
-
-                for ( int pt_index = 0; pt_index < keyPointsTmp.size( ); ++pt_index )
-                {
-                    newPoints.push_back( cv::Point2f( keyPointsTmp[pt_index].pt.x + rect.x,
-                                                      keyPointsTmp[pt_index].pt.y + rect.y ) );
-                }
-
-                //                setMask( new_masks, keyPointsTmp, rect );
-            }
+        // only the static mask, the tracks are taken out by the occupancy grid
+        fast->detect( image_in( rect ), keyPointsTmp, mask( rect ) );
 
+        selectInRect( keyPointsTmp, rect, new_num, newPoints );
 #endif
-
-            // ROS_DEBUG_STREAM( "loop_time: " << index //
-            //                                 << " setThreshold: "
-            //                                 << calcThresholdLinear( index )
-            //                                 << " find keyPoints "
-            //                                 << keyPointsTmp.size( ) );
-        }
-    }
-}
-
-void
-frontend::DetectorFast::insertionSort( std::vector< cv::KeyPoint >& arr )
-{
-    // low response to high response
-
-    int num = arr.size( );
-    cv::KeyPoint temp;
-    int i, j;
-
-    for ( i = 1; i < num; i++ )
-    {
-        temp = arr[i];
-        for ( j = i; j > 0 && arr[j - 1].response > temp.response; j-- )
-        {
-            arr[j] = arr[j - 1];
-        }
-        arr[j] = temp;
     }
 }
@@ -8,52 +8,39 @@ frontend::DetectorHarris::detectNewFeatures( const cv::Mat& image_in,
                                              const int _max_new_num,
                                              std::vector< cv::Point2f >& newPoints )
 {
-    cv::Mat new_masks;
     newPoints.clear( );
 
     if ( _max_new_num < 3 )
         return;
 
-    if ( existPoints.empty( ) )
-        mask.copyTo( new_masks );
-    else
-        new_masks = setMask( existPoints );
+    setOccupied( existPoints );
 
-    int new_num = _max_new_num / numMask;
-    if ( new_num < 2 )
-        new_num = 2;
-
-    for ( auto& rect : maskRect )
+    for ( int rect_index = 0; rect_index < numMask; ++rect_index )
     {
-        {
+        const cv::Rect& rect = maskRect[rect_index];
+        int new_num          = newNumInRect( rect_index, _max_new_num, existPoints.size( ) );
+        if ( new_num == 0 || rect.area( ) == 0 )
+            continue;
 
 #if goodFeatures
+        // room for the corners that fall on the tracks of the rect
+        std::vector< cv::Point2f > cornersTmp;
+        cv::goodFeaturesToTrack( image_in( rect ), //
+                                 cornersTmp,
+                                 new_num + rectCount[rect_index],
+                                 0.1,
+                                 m_minFeatureDist,
+                                 mask( rect ) );
+
+        // the corners come strongest first
+        std::vector< cv::KeyPoint > keyPointsTmp( cornersTmp.size( ) );
+        for ( int pt_index = 0; pt_index < int( cornersTmp.size( ) ); ++pt_index )
+        {
+            keyPointsTmp[pt_index].pt       = cornersTmp[pt_index];
+            keyPointsTmp[pt_index].response = -pt_index;
+        }
 
-            std::vector< cv::Point2f > keyPointsTmp;
-
-            cv::goodFeaturesToTrack( image_in( rect ), //
-                                     keyPointsTmp,
-                                     new_num,
-                                     0.1,
-                                     m_minFeatureDist,
-                                     cv::Mat( ) /*new_masks( rect ) */ );
-
-            // std::cout << " find keyPoints " << new_num << " -> " << keyPointsTmp.size( )
-            // << "\n";
-
-            for ( int pt_index = 0; pt_index < keyPointsTmp.size( ); ++pt_index )
-            {
-                newPoints.push_back( cv::Point2f( keyPointsTmp[pt_index].x + rect.x,
-                                                  keyPointsTmp[pt_index].y + rect.y ) );
-            }
-
+        selectInRect( keyPointsTmp, rect, new_num, newPoints );
 #endif
-
-            // ROS_DEBUG_STREAM( "loop_time: " << index //
-            //                                 << " setThreshold: "
-            //                                 << calcThresholdLinear( index )
-            //                                 << " find keyPoints "
-            //                                 << keyPointsTmp.size( ) );
-        }
     }
 }
@@ -13,6 +13,7 @@ FeatureStereoTracker::FeatureStereoTracker( std::string left_cam_file,
     m_tracker_r = new FeatureBase( );
     m_tracker_r->readInPramFile( right_cam_file, right_feature_file );
     m_sparseFlowLeft2Right = cv::SparsePyrLKOpticalFlow::create( );
+    m_clahe                = cv::createCLAHE( );
 
     int widthEdge = 5;
     rightRect     = cv::Rect( widthEdge,
@@ -34,6 +35,7 @@ FeatureStereoTracker::FeatureStereoTracker( std::string left_cam_file,
     m_tracker_r = new FeatureBase( );
     m_tracker_r->readInPramFile( right_cam_file, right_err_file, right_feature_file );
     m_sparseFlowLeft2Right = cv::SparsePyrLKOpticalFlow::create( );
+    m_clahe                = cv::createCLAHE( );
 
     int widthEdge = 5;
     rightRect     = cv::Rect( widthEdge,
@@ -58,12 +60,9 @@ FeatureStereoTracker::process( bool* frontendCtrl )
 
     if ( isEqualize( ) )
     {
-        // cv::Ptr<cv::CLAHE> clahe = cv::createCLAHE(3.0, cv::Size(8, 8));
-        cv::Ptr< cv::CLAHE > clahe = cv::createCLAHE( );
-        TicToc t_c;
-        clahe->apply( image_this( ), left_image );
-        clahe->apply( m_tracker_r->image_this( ), right_image );
-        ROS_DEBUG( "CLAHE costs: %fms", t_c.toc( ) );
+        m_clahe->apply( image_this( ), left_image );
+        m_clahe->apply( m_tracker_r->image_this( ), right_image );
+        ROS_DEBUG( "CLAHE costs: %fms", t_track.toc( ) );
     }
     else
     {
@@ -71,28 +70,43 @@ FeatureStereoTracker::process( bool* frontendCtrl )
         right_image = m_tracker_r->image_this( );
     }
 
+    // kept as the last pyramid for the next frame
+    buildPyramid( left_image, m_pyramid_left );
+    ROS_DEBUG( "left pyramid costs %f", t_track.toc( ) );
+
     if ( !ptsPre( ).empty( ) )
-        trackFeatures( left_image, right_image, is_track_right );
+        trackFeatures( right_image, is_track_right );
+    ROS_DEBUG( "trackFeatures costs %f", t_track.toc( ) );
 
     if ( is_detect_new_feature )
         detectNewFeatures( left_image );
+    ROS_DEBUG( "detectNewFeatures costs %f", t_track.toc( ) );
 
     copyBack( left_image );
-
-    ROS_DEBUG( "track costs %f", t_track.toc( ) );
+    m_pyramid_pre.swap( m_pyramid_left );
 
     ROS_DEBUG_STREAM( "---" << camera( )->cameraName( ) << " costs " << t_track.tocEnd( ) );
 }
 
 void
-FeatureStereoTracker::trackFeatures( const cv::Mat& left_image, const cv::Mat& right_image, bool is_track_right )
+FeatureStereoTracker::buildPyramid( const cv::Mat& image, std::vector< cv::Mat >& pyramid ) const
+{
+    // both flows use the default window and levels, the pyramids fit either
+    cv::buildOpticalFlowPyramid( image, pyramid, getSparseFlow( )->getWinSize( ), getSparseFlow( )->getMaxLevel( ) );
+}
+
+void
+FeatureStereoTracker::trackFeatures( const cv::Mat& right_image, bool is_track_right )
 {
     std::vector< uchar > left_status, right_status, right_back_status;
     std::vector< float > left_err, right_err, right_back_err;
 
+    TicTocPart t_track;
+
     // track from last image to current image
 
-    getSparseFlow( )->calc( image_pre( ), left_image, ptsPre( ), ptsThis( ), left_status, left_err );
+    getSparseFlow( )->calc( m_pyramid_pre, m_pyramid_left, ptsPre( ), ptsThis( ), left_status, left_err );
+    ROS_DEBUG( "last to left flow costs %f", t_track.toc( ) );
 
     if ( isRansac( )             //
          && !ptsThis( ).empty( ) //
@@ -115,22 +129,27 @@ FeatureStereoTracker::trackFeatures( const cv::Mat& left_image, const cv::Mat& r
 
     if ( is_track_right && !ptsThis( ).empty( ) )
     {
+        buildPyramid( right_image, m_pyramid_right );
+        ROS_DEBUG( "right pyramid costs %f", t_track.toc( ) );
+
         // track from left image to right image
 
-        m_sparseFlowLeft2Right->calc( left_image,
-                                      right_image,
+        m_sparseFlowLeft2Right->calc( m_pyramid_left,
+                                      m_pyramid_right,
                                       ptsThis( ),
                                       m_tracker_r->ptsThis( ), //
                                       right_status,
                                       right_err );
+        ROS_DEBUG( "left to right flow costs %f", t_track.toc( ) );
 
         std::vector< cv::Point2f > pts_track_back;
-        m_sparseFlowLeft2Right->calc( right_image,
-                                      left_image,
+        m_sparseFlowLeft2Right->calc( m_pyramid_right,
+                                      m_pyramid_left,
                                       m_tracker_r->ptsThis( ),
                                       pts_track_back, //
                                       right_back_status,
                                       right_back_err );
+        ROS_DEBUG( "right to left flow costs %f", t_track.toc( ) );
 
         if ( isRansac( ) && !m_tracker_r->ptsThis( ).empty( ) )
         {
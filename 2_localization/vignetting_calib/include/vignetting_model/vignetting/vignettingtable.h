@@ -18,11 +18,37 @@ class VignettingTable
     cv::Mat removeLUT( cv::Mat& src );
     cv::Mat getTable( ) const;
 
+    // same correction as removeLUT, with the 16 bit fixed-point gain table and SIMD
+    cv::Mat removeFixed( const cv::Mat& src ) const;
+
+    // undistortion map of cam, as cam->initUndistortRectifyMap, with the gain of each
+    // output pixel taken at its source pixel, returns the rectified camera matrix
+    cv::Mat initUndistortRectifyMap( const CameraConstPtr& cam,
+                                     float fx           = -1.0f,
+                                     float fy           = -1.0f,
+                                     cv::Size imageSize = cv::Size( 0, 0 ),
+                                     float cx           = -1.0f,
+                                     float cy           = -1.0f,
+                                     cv::Mat rmat       = cv::Mat::eye( 3, 3, CV_32F ) );
+    // vignetting removal and undistortion in one pass over the image, in bands of rows
+    // that stay in cache, needs initUndistortRectifyMap first
+    cv::Mat removeAndUndistort( const cv::Mat& src ) const;
+
     std::string toString( );
 
+    // fraction bits of the fixed-point gains, gains up to 16 are representable
+    static const int GAIN_BITS = 12;
+
     private:
+    void buildFixedTable( );
+
     vignetting m_vignetting;
     cv::Mat m_table;
+    cv::Mat m_table_fixed;
+
+    // fixed-point undistortion map and the gain at each output pixel
+    cv::Mat m_map1, m_map2;
+    cv::Mat m_map_gain;
 };
 }
 
@@ -1,6 +1,35 @@
+#include <opencv2/core/hal/intrin.hpp>
 #include <opencv2/opencv.hpp>
 #include <vignetting_model/vignetting/vignettingtable.h>
 
+// dst = src * gain >> GAIN_BITS, saturated to 255, truncated like removeLUT
+static void
+applyGain( const uchar* src, const ushort* gain, uchar* dst, int n )
+{
+    const int bits = camera_model::VignettingTable::GAIN_BITS;
+    int index      = 0;
+#if CV_SIMD128
+    for ( ; index <= n - 16; index += 16 )
+    {
+        cv::v_uint16x8 src0, src1;
+        cv::v_expand( cv::v_load( src + index ), src0, src1 );
+
+        cv::v_uint32x4 prod0, prod1, prod2, prod3;
+        cv::v_mul_expand( src0, cv::v_load( gain + index ), prod0, prod1 );
+        cv::v_mul_expand( src1, cv::v_load( gain + index + 8 ), prod2, prod3 );
+
+        cv::v_uint16x8 out0 = cv::v_pack( prod0 >> bits, prod1 >> bits );
+        cv::v_uint16x8 out1 = cv::v_pack( prod2 >> bits, prod3 >> bits );
+        cv::v_store( dst + index, cv::v_pack( out0, out1 ) );
+    }
+#endif
+    for ( ; index < n; ++index )
+    {
+        unsigned value = ( unsigned( src[index] ) * gain[index] ) >> bits;
+        dst[index]     = value > 255 ? 255 : value;
+    }
+}
+
 camera_model::VignettingTable::VignettingTable( std::string _vignetting_calib )
 : m_vignetting( _vignetting_calib )
 {
@@ -50,6 +79,8 @@ camera_model::VignettingTable::buildTable( )
             }
         }
     }
+
+    buildFixedTable( );
 }
 
 cv::Mat
@@ -168,5 +199,90 @@ camera_model::VignettingTable::buildTable( const std::string file_mask )
         }
     }
 
+    buildFixedTable( );
+
     std::cout << "[#Vignet] Mask Loaded." << std::endl;
 }
+
+void
+camera_model::VignettingTable::buildFixedTable( )
+{
+    // rounded and saturated to the 16 bit range
+    m_table.convertTo( m_table_fixed, CV_16U, 1 << GAIN_BITS );
+}
+
+cv::Mat
+camera_model::VignettingTable::removeFixed( const cv::Mat& src ) const
+{
+    CV_Assert( src.depth( ) == CV_8U && src.size( ) == m_table_fixed.size( )
+               && src.channels( ) == m_table_fixed.channels( ) );
+
+    cv::Mat dst( src.rows, src.cols, src.type( ) );
+
+    int nRows = src.rows;
+    int nCols = src.cols * src.channels( );
+    if ( src.isContinuous( ) && m_table_fixed.isContinuous( ) )
+    {
+        nCols *= nRows;
+        nRows = 1;
+    }
+
+    for ( int row_index = 0; row_index < nRows; ++row_index )
+        applyGain( src.ptr< uchar >( row_index ),
+                   m_table_fixed.ptr< ushort >( row_index ),
+                   dst.ptr< uchar >( row_index ),
+                   nCols );
+
+    return dst;
+}
+
+cv::Mat
+camera_model::VignettingTable::initUndistortRectifyMap(
+const CameraConstPtr& cam, float fx, float fy, cv::Size imageSize, float cx, float cy, cv::Mat rmat )
+{
+    cv::Mat map_x, map_y;
+    cv::Mat K_rect = cam->initUndistortRectifyMap( map_x, map_y, fx, fy, imageSize, cx, cy, rmat );
+    if ( map_x.type( ) != CV_32FC1 )
+    {
+        cv::Mat float_x, float_y;
+        cv::convertMaps( map_x, map_y, float_x, float_y, CV_32FC1 );
+        map_x = float_x;
+        map_y = float_y;
+    }
+
+    // the vignetting is a property of the source pixel, sample the table there
+    cv::Mat table_float, gain_float;
+    m_table.convertTo( table_float, CV_32F );
+    cv::remap( table_float, gain_float, map_x, map_y, cv::INTER_LINEAR, cv::BORDER_REPLICATE );
+    gain_float.convertTo( m_map_gain, CV_16U, 1 << GAIN_BITS );
+
+    // fixed-point maps take the fast path of cv::remap
+    cv::convertMaps( map_x, map_y, m_map1, m_map2, CV_16SC2 );
+
+    return K_rect;
+}
+
+cv::Mat
+camera_model::VignettingTable::removeAndUndistort( const cv::Mat& src ) const
+{
+    CV_Assert( !m_map1.empty( ) && src.depth( ) == CV_8U && src.channels( ) == m_map_gain.channels( ) );
+
+    // a band of the output is remapped and then scaled while it is still in cache
+    const int band_rows = 32;
+
+    cv::Mat dst( m_map1.size( ), src.type( ) );
+    for ( int row_index = 0; row_index < dst.rows; row_index += band_rows )
+    {
+        cv::Range rows( row_index, std::min( row_index + band_rows, dst.rows ) );
+        cv::Mat band = dst.rowRange( rows );
+        cv::remap( src, band, m_map1.rowRange( rows ), m_map2.rowRange( rows ), cv::INTER_LINEAR );
+
+        for ( int band_index = 0; band_index < band.rows; ++band_index )
+            applyGain( band.ptr< uchar >( band_index ),
+                       m_map_gain.ptr< ushort >( row_index + band_index ),
+                       band.ptr< uchar >( band_index ),
+                       band.cols * band.channels( ) );
+    }
+
+    return dst;
+}
@@ -0,0 +1,128 @@
+#include <boost/program_options.hpp>
+#include <iomanip>
+#include <iostream>
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <camera_model/camera_models/CameraFactory.h>
+#include <camera_model/camera_models/PinholeCamera.h>
+#include <camera_model/gpl/gpl.h>
+#include <vignetting_model/vignetting/vignettingtable.h>
+
+// average time of f over the iterations, in ms
+template< typename F >
+double
+timeIt( int iterations, F f )
+{
+    double startTime = camera_model::timeInSeconds( );
+    for ( int i = 0; i < iterations; ++i )
+        f( );
+    return ( camera_model::timeInSeconds( ) - startTime ) * 1000 / iterations;
+}
+
+int
+main( int argc, char** argv )
+{
+    std::string vignettingFile;
+    std::string cameraFile;
+    std::string imageFile;
+    int iterations;
+    bool is_color;
+    cv::Size imageSize;
+
+    /* clang-format off */
+    using namespace boost::program_options;
+    boost::program_options::options_description desc(
+    "Vignetting removal benchmark: polynomial, double table, fixed-point table and the fused undistortion.\n"
+    "Without files, a synthetic vignetting, pinhole camera and image are used." );
+    desc.add_options( )
+        ( "help", "produce help message" )
+        ( "vignetting", value< std::string >( &vignettingFile )->default_value( "" ), "vignetting calibration yaml" )
+        ( "camera", value< std::string >( &cameraFile )->default_value( "" ), "camera_model yaml, for the fused undistortion" )
+        ( "image", value< std::string >( &imageFile )->default_value( "" ), "input image" )
+        ( "iterations,n", value< int >( &iterations )->default_value( 50 ), "iterations of each method" )
+        ( "is_color", value< bool >( &is_color )->default_value( false ), "synthetic color image" )
+        ( "width,w", value< int >( &imageSize.width )->default_value( 1280 ), "synthetic image width" )
+        ( "height,h", value< int >( &imageSize.height )->default_value( 1024 ), "synthetic image height" )
+        ;
+    /* clang-format on */
+
+    boost::program_options::variables_map vm;
+    boost::program_options::store( boost::program_options::parse_command_line( argc, argv, desc ), vm );
+    boost::program_options::notify( vm );
+
+    if ( vm.count( "help" ) )
+    {
+        std::cout << desc << std::endl;
+        return 1;
+    }
+
+    cv::Mat image_in;
+    if ( !imageFile.empty( ) )
+    {
+        image_in = cv::imread( imageFile, -1 );
+        if ( image_in.empty( ) )
+        {
+            std::cerr << "# ERROR: Cannot read " << imageFile << std::endl;
+            return 1;
+        }
+        imageSize = image_in.size( );
+        is_color  = image_in.channels( ) == 3;
+    }
+    else
+    {
+        image_in = cv::Mat( imageSize, is_color ? CV_8UC3 : CV_8UC1 );
+        cv::randu( image_in, cv::Scalar::all( 0 ), cv::Scalar::all( 200 ) );
+        cv::GaussianBlur( image_in, image_in, cv::Size( 5, 5 ), 0 );
+    }
+
+    // about a factor 2 of falloff in the corners
+    std::vector< std::vector< double > > params( is_color ? 3 : 1,
+                                                 std::vector< double >{ 1.0, -6e-7, 0.0, 0.0 } );
+    camera_model::vignetting vignetting( imageSize, is_color );
+    vignetting.setParams( params );
+    camera_model::VignettingTable vignettingTable
+    = vignettingFile.empty( ) ? camera_model::VignettingTable( imageSize, params, is_color )
+                              : camera_model::VignettingTable( vignettingFile );
+    if ( !vignettingFile.empty( ) )
+        vignetting = camera_model::vignetting( vignettingFile );
+
+    camera_model::CameraConstPtr cam;
+    if ( !cameraFile.empty( ) )
+        cam = camera_model::CameraFactory::instance( )->generateCameraFromYamlFile( cameraFile );
+    else
+        cam.reset( new camera_model::PinholeCamera( "benchmark", imageSize.width, imageSize.height,
+                                                    -0.3, 0.1, 0.0, 0.0, 800, 800,
+                                                    imageSize.width / 2.0, imageSize.height / 2.0 ) );
+
+    cv::Mat image_poly, image_lut, image_fixed;
+    double t_poly  = timeIt( 1, [&]( ) { image_poly = vignetting.remove( image_in ); } );
+    double t_lut   = timeIt( iterations, [&]( ) { image_lut = vignettingTable.removeLUT( image_in ); } );
+    double t_fixed = timeIt( iterations, [&]( ) { image_fixed = vignettingTable.removeFixed( image_in ); } );
+
+    // two passes: the double table, then cv::remap with the camera's own map
+    cv::Mat map1, map2, map1_fixed, map2_fixed;
+    cam->initUndistortRectifyMap( map1, map2 );
+    cv::convertMaps( map1, map2, map1_fixed, map2_fixed, CV_16SC2 );
+    vignettingTable.initUndistortRectifyMap( cam );
+
+    cv::Mat image_two_pass, image_fused;
+    double t_two_pass = timeIt( iterations, [&]( ) {
+        cv::remap( vignettingTable.removeLUT( image_in ), image_two_pass, map1_fixed, map2_fixed, cv::INTER_LINEAR );
+    } );
+    double t_fused = timeIt( iterations, [&]( ) { image_fused = vignettingTable.removeAndUndistort( image_in ); } );
+
+    std::cout << std::fixed << std::setprecision( 3 );
+    std::cout << "# INFO: " << imageSize.width << "x" << imageSize.height << ( is_color ? " color" : " gray" )
+              << ", " << iterations << " iterations\n";
+    std::cout << "# INFO: vignetting::remove                " << t_poly << " ms\n";
+    std::cout << "# INFO: VignettingTable::removeLUT        " << t_lut << " ms\n";
+    std::cout << "# INFO: VignettingTable::removeFixed      " << t_fixed << " ms, PSNR "
+              << cv::PSNR( image_lut, image_fixed ) << " dB against removeLUT\n";
+    std::cout << "# INFO: removeLUT + remap                 " << t_two_pass << " ms\n";
+    std::cout << "# INFO: VignettingTable::removeAndUndistort " << t_fused << " ms, PSNR "
+              << cv::PSNR( image_two_pass, image_fused ) << " dB against removeLUT + remap\n";
+
+    return 0;
+}
@@ -1,9 +1,11 @@
 #ifndef CAMERACALIBRATION_H
 #define CAMERACALIBRATION_H
 
+#include <boost/function.hpp>
 #include <opencv2/core/core.hpp>
 
 #include "camera_model/camera_models/Camera.h"
+#include "camera_model/chessboard/ChessboardCornerCache.h"
 
 namespace camera_model
 {
@@ -25,6 +27,21 @@ class CameraCalibration
     void addChessboardData( const std::vector< cv::Point2f >& corners );
     void addImage( const cv::Mat image, const std::string name );
 
+    /**
+     * \brief Detects the chessboard in a set of images and adds the detections
+     *
+     * The images are read, preprocessed and searched in parallel by the OpenMP
+     * threads, then added in the order of imageFilenames, so the calibration
+     * does not depend on the thread timing.
+     * \param preprocess applied to every image after reading, may be empty
+     * \param cache detections reused and added, may be null
+     * \return for each image, whether the board was found
+     */
+    std::vector< bool > addChessboardImages( const std::vector< std::string >& imageFilenames,
+                                             bool useOpenCV,
+                                             const boost::function< cv::Mat( const cv::Mat& ) >& preprocess,
+                                             ChessboardCornerCache* cache = 0 );
+
     bool calibrate( void );
 
     int sampleCount( void ) const;
@@ -58,6 +75,10 @@ class CameraCalibration
 
     void setVerbose( bool verbose );
 
+    // bundle adjustment setup, both on by default: the jacobians by hand where
+    // the camera model has them, and the views eliminated by a Schur complement
+    void setSolverOptions( bool analyticJacobians, bool schurComplement );
+
     private:
     bool calibrateHelper( CameraPtr& camera,
                           std::vector< cv::Mat >& rvecs,
@@ -69,7 +90,8 @@ class CameraCalibration
                                   std::vector< cv::Mat >& tvecs,
                                   std::vector< std::vector< cv::Point2f > >& imagePoints,
                                   std::vector< std::vector< cv::Point3f > >& scenePoints ) const;
-    void optimize( CameraPtr& camera,
+    // false, with the parameters left as they were, if ceres finds no usable solution
+    bool optimize( CameraPtr& camera,
                    std::vector< cv::Mat >& rvecs,
                    std::vector< cv::Mat >& tvecs,
                    const std::vector< std::vector< cv::Point2f > >& imagePoints,
@@ -99,6 +121,8 @@ class CameraCalibration
     Eigen::Matrix2d m_measurementCovariance;
 
     bool m_verbose;
+    bool m_analyticJacobians;
+    bool m_schurComplement;
 
     public:
     std::vector< cv::Mat > m_ImagesShow;
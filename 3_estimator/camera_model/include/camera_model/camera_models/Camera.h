@@ -85,6 +85,8 @@ class Camera
         int m_imageHeight;
     };
 
+    Camera( );
+
     virtual ModelType modelType( void ) const           = 0;
     virtual const std::string& cameraName( void ) const = 0;
     virtual int imageWidth( void ) const                = 0;
@@ -124,6 +126,28 @@ class Camera
 
     virtual void liftProjectiveToRay( const Eigen::Vector2d& p, Ray& ray ) const = 0;
 
+    /**
+     * \brief Lifts n image points to unit rays
+     *
+     * With a lift table the rays are interpolated from it, points outside the
+     * table go through liftProjective. Without one, every point does.
+     * \param p n image points
+     * \param P return value, n unit rays
+     */
+    virtual void liftProjectiveBatch( const cv::Point2f* p, Eigen::Vector3d* P, int n ) const;
+
+    /**
+     * \brief Precomputes the unit rays of the image for liftProjectiveBatch
+     *
+     * The nodes of the table are step pixels apart, the rays in between are
+     * interpolated bilinearly: step 1 is exact at the integer pixels, larger
+     * steps trade accuracy for memory. setParameters releases the table.
+     * \param step pixels between the nodes of the table, 0 releases it
+     */
+    void initLiftTable( int step = 1 );
+    void releaseLiftTable( void );
+    bool hasLiftTable( void ) const;
+
     virtual void rayToPlane( const Ray& ray, Eigen::Vector2d& p ) const = 0;
 
     // Projects 3D points to the image plane (Pi function)
@@ -198,6 +222,10 @@ class Camera
 
     protected:
     cv::Mat m_mask;
+
+    // CV_32FC3 unit rays of the pixels (x, y) = (j, i) * m_liftTableStep
+    cv::Mat m_liftTable;
+    int m_liftTableStep;
 };
 
 typedef boost::shared_ptr< Camera > CameraPtr;
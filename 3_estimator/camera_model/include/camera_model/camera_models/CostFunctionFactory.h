@@ -33,10 +33,14 @@ class CostFunctionFactory
 
     static boost::shared_ptr< CostFunctionFactory > instance( void );
 
+    // analyticJacobians: for CAMERA_INTRINSICS | CAMERA_POSE, the pinhole,
+    // equidistant, polyfisheye and spline models are differentiated by hand,
+    // the other models and flags always use automatic differentiation
     ceres::CostFunction* generateCostFunction( const CameraConstPtr& camera,
                                                const Eigen::Vector3d& observed_P,
                                                const Eigen::Vector2d& observed_p,
-                                               int flags ) const;
+                                               int flags,
+                                               bool analyticJacobians = true ) const;
 
     private:
     static boost::shared_ptr< CostFunctionFactory > m_instance;
@@ -282,6 +282,14 @@ class PolyFisheyeCamera : public Camera
                               const Eigen::Matrix< T, 3, 1 >& P,
                               Eigen::Matrix< T, 2, 1 >& p );
 
+    // Projects a point of the camera frame like the templated spaceToPlane,
+    // with the jacobians on the point and on the parameters (may be null)
+    static void spaceToPlaneJacobian( const double* const params,
+                                      const Eigen::Vector3d& P_c,
+                                      Eigen::Vector2d& p,
+                                      Eigen::Matrix< double, 2, 3 >& J_P,
+                                      Eigen::Matrix< double, 2, FISHEYE_PARAMS_NUM, Eigen::RowMajor >* J_params );
+
     // virtual void initUndistortMap(cv::Mat& map1, cv::Mat& map2, double fScale
     // =
     // 1.0) const = 0;
@@ -30,6 +30,16 @@ class Chessboard
 
     bool findChessboardCornersImproved( const cv::Mat& image, const cv::Size& patternSize, std::vector< cv::Point2f >& corners, int flags );
 
+    // one resolution: every threshold run, its dilation levels in parallel, no subpixel refinement
+    bool findBoardQuads( const cv::Mat& img, const cv::Size& patternSize, std::vector< cv::Point2f >& corners, int flags );
+
+    bool findBoardAtDilation( cv::Mat& threshImg,
+                              const cv::Size& patternSize,
+                              int flags,
+                              int dilations,
+                              std::vector< ChessboardCornerPtr >& outputCorners,
+                              int& sqrSize );
+
     void cleanFoundConnectedQuads( std::vector< ChessboardQuadPtr >& quadGroup, cv::Size patternSize );
 
     void findConnectedQuads( std::vector< ChessboardQuadPtr >& quads, std::vector< ChessboardQuadPtr >& group, int group_idx, int dilation );
@@ -49,7 +59,10 @@ class Chessboard
 
     void generateQuads( std::vector< ChessboardQuadPtr >& quads, cv::Mat& image, int flags, int dilation, bool firstRun );
 
-    bool checkQuadGroup( std::vector< ChessboardQuadPtr >& quads, std::vector< ChessboardCornerPtr >& corners, cv::Size patternSize );
+    bool checkQuadGroup( std::vector< ChessboardQuadPtr >& quads,
+                         std::vector< ChessboardCornerPtr >& corners,
+                         cv::Size patternSize,
+                         cv::Size imageSize );
 
     void getQuadrangleHypotheses( const std::vector< std::vector< cv::Point > >& contours,
                                   std::vector< std::pair< float, int > >& quads,
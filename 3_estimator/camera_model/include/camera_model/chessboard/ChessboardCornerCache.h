@@ -0,0 +1,49 @@
+#ifndef CHESSBOARDCORNERCACHE_H
+#define CHESSBOARDCORNERCACHE_H
+
+#include <map>
+#include <opencv2/core/core.hpp>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace camera_model
+{
+
+/**
+ * \brief Chessboard detections of images seen before, saved in a yaml file
+ *
+ * The key is a hash of the pixels of the image with the board size and the
+ * detector, so a rerun on the same images, e.g. with another camera model,
+ * skips the detection. Images without a board are remembered too.
+ * find() may run concurrently, insert() must not run with anything else.
+ */
+class ChessboardCornerCache
+{
+    public:
+    ChessboardCornerCache( const std::string& filename );
+
+    static uint64_t key( const cv::Mat& image, cv::Size boardSize, bool useOpenCV );
+
+    bool find( uint64_t key, bool& found, std::vector< cv::Point2f >& corners ) const;
+    void insert( uint64_t key, bool found, const std::vector< cv::Point2f >& corners );
+
+    // reads the file if it exists, returns the number of entries read
+    int load( void );
+    bool save( void ) const;
+
+    size_t size( void ) const;
+
+    private:
+    struct Entry
+    {
+        bool found;
+        std::vector< cv::Point2f > corners;
+    };
+
+    std::string m_filename;
+    std::map< uint64_t, Entry > m_entries;
+};
+}
+
+#endif
@@ -1,6 +1,7 @@
 #include "camera_model/calib/CameraCalibration.h"
 
 #include <algorithm>
+#include <boost/scoped_ptr.hpp>
 #include <cstdio>
 #include <eigen3/Eigen/Dense>
 #include <fstream>
@@ -9,10 +10,13 @@
 #include <opencv2/calib3d/calib3d.hpp>
 #include <opencv2/core/core.hpp>
 #include <opencv2/core/eigen.hpp>
+#include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
+#include <thread>
 
 #include "camera_model/camera_models/CameraFactory.h"
 #include "camera_model/camera_models/CostFunctionFactory.h"
+#include "camera_model/chessboard/Chessboard.h"
 #include "camera_model/gpl/EigenQuaternionParameterization.h"
 #include "camera_model/gpl/EigenUtils.h"
 #include "camera_model/sparse_graph/Transform.h"
@@ -22,10 +26,62 @@
 namespace camera_model
 {
 
+namespace
+{
+
+// the reprojection costs of CostFunctionFactory on (intrinsics, rotation,
+// translation) over (intrinsics, pose): a single block per view keeps the views
+// an independent set, as the Schur elimination of the poses requires
+class PoseBlockCostFunction : public ceres::CostFunction
+{
+    public:
+    explicit PoseBlockCostFunction( ceres::CostFunction* costFunction )
+    : m_costFunction( costFunction )
+    {
+        set_num_residuals( 2 );
+        mutable_parameter_block_sizes( )->push_back( costFunction->parameter_block_sizes( )[0] );
+        mutable_parameter_block_sizes( )->push_back( 7 );
+    }
+
+    virtual bool Evaluate( double const* const* parameters, double* residuals, double** jacobians ) const
+    {
+        const double* blocks[3] = { parameters[0], parameters[1], parameters[1] + 4 };
+        if ( !jacobians )
+        {
+            return m_costFunction->Evaluate( blocks, residuals, 0 );
+        }
+
+        double jacobianRotation[2 * 4];
+        double jacobianTranslation[2 * 3];
+        double* blockJacobians[3] = { jacobians[0], jacobians[1] ? jacobianRotation : 0, jacobians[1] ? jacobianTranslation : 0 };
+        if ( !m_costFunction->Evaluate( blocks, residuals, blockJacobians ) )
+        {
+            return false;
+        }
+
+        if ( jacobians[1] )
+        {
+            // row major, 2x7
+            for ( int r = 0; r < 2; ++r )
+            {
+                std::copy( jacobianRotation + 4 * r, jacobianRotation + 4 * r + 4, jacobians[1] + 7 * r );
+                std::copy( jacobianTranslation + 3 * r, jacobianTranslation + 3 * r + 3, jacobians[1] + 7 * r + 4 );
+            }
+        }
+        return true;
+    }
+
+    private:
+    boost::scoped_ptr< ceres::CostFunction > m_costFunction;
+};
+}
+
 CameraCalibration::CameraCalibration( )
 : m_boardSize( cv::Size( 0, 0 ) )
 , m_squareSize( 0.0f )
 , m_verbose( false )
+, m_analyticJacobians( true )
+, m_schurComplement( true )
 {
 }
 
@@ -37,6 +93,8 @@ CameraCalibration::CameraCalibration( const Camera::ModelType modelType,
 : m_boardSize( boardSize )
 , m_squareSize( squareSize )
 , m_verbose( false )
+, m_analyticJacobians( true )
+, m_schurComplement( true )
 {
     m_camera = CameraFactory::instance( )->generateCamera( modelType, cameraName, imageSize );
 }
@@ -57,6 +115,74 @@ CameraCalibration::addImage( const cv::Mat image, const std::string name )
     cbImageNames.push_back( name );
 }
 
+std::vector< bool >
+CameraCalibration::addChessboardImages( const std::vector< std::string >& imageFilenames,
+                                        bool useOpenCV,
+                                        const boost::function< cv::Mat( const cv::Mat& ) >& preprocess,
+                                        ChessboardCornerCache* cache )
+{
+    const int count = imageFilenames.size( );
+    std::vector< cv::Mat > images( count );
+    std::vector< std::vector< cv::Point2f > > corners( count );
+    std::vector< uint64_t > keys( count, 0 );
+    std::vector< char > found( count, 0 );
+    std::vector< char > cached( count, 0 );
+
+    // the detection time varies a lot between images, hand them out one by one
+#pragma omp parallel for schedule( dynamic, 1 )
+    for ( int i = 0; i < count; ++i )
+    {
+        cv::Mat image = cv::imread( imageFilenames[i], -1 );
+        if ( image.empty( ) )
+        {
+            continue;
+        }
+        if ( !preprocess.empty( ) )
+        {
+            image = preprocess( image );
+        }
+        images[i] = image;
+
+        if ( cache )
+        {
+            bool cachedFound;
+            keys[i] = ChessboardCornerCache::key( image, m_boardSize, useOpenCV );
+            if ( cache->find( keys[i], cachedFound, corners[i] ) )
+            {
+                found[i]  = cachedFound;
+                cached[i] = 1;
+                continue;
+            }
+        }
+
+        Chessboard chessboard( m_boardSize, image );
+        chessboard.findCorners( useOpenCV );
+        found[i] = chessboard.cornersFound( );
+        if ( found[i] )
+        {
+            corners[i] = chessboard.getCorners( );
+        }
+    }
+
+    std::vector< bool > added( count, false );
+    for ( int i = 0; i < count; ++i )
+    {
+        if ( cache && !images[i].empty( ) && !cached[i] )
+        {
+            cache->insert( keys[i], found[i], corners[i] );
+        }
+
+        if ( found[i] )
+        {
+            addChessboardData( corners[i] );
+            addImage( images[i], imageFilenames[i] );
+            added[i] = true;
+        }
+    }
+
+    return added;
+}
+
 void
 CameraCalibration::addChessboardData( const std::vector< cv::Point2f >& corners )
 {
@@ -105,7 +231,7 @@ CameraCalibration::calibrate( void )
     }
 
     // STEP 3: Optimizatoin
-    CalibrationOptimization( m_camera, rvecs, tvecs, m_imagePoints, m_scenePoints );
+    bool solved = CalibrationOptimization( m_camera, rvecs, tvecs, m_imagePoints, m_scenePoints );
 
     // Compute measurement covariance.
     std::vector< std::vector< cv::Point2f > > errVec( m_imagePoints.size( ) );
@@ -178,7 +304,8 @@ CameraCalibration::calibrate( void )
     // STEP 3: Optimizatoin with good measurement point
     std::cout << "Calibration again." << std::endl;
 
-    CalibrationOptimization( m_camera, rvecsGood, tvecsGood, m_imageGoodPoints, m_sceneGoodPoints );
+    solved = CalibrationOptimization( m_camera, rvecsGood, tvecsGood, m_imageGoodPoints, m_sceneGoodPoints )
+             && solved;
     std::cout << "Recalibration done." << std::endl;
 
     Eigen::Vector2d errMean = errSum / static_cast< double >( errCount );
@@ -203,7 +330,7 @@ CameraCalibration::calibrate( void )
 
     m_measurementCovariance = measurementCovariance;
 
-    return true;
+    return solved;
 }
 
 int
@@ -541,6 +668,13 @@ CameraCalibration::setVerbose( bool verbose )
     m_verbose = verbose;
 }
 
+void
+CameraCalibration::setSolverOptions( bool analyticJacobians, bool schurComplement )
+{
+    m_analyticJacobians = analyticJacobians;
+    m_schurComplement   = schurComplement;
+}
+
 bool
 CameraCalibration::calibrateHelper( CameraPtr& camera,
                                     std::vector< cv::Mat >& rvecs,
@@ -587,7 +721,10 @@ CameraCalibration::CalibrationOptimization( CameraPtr& camera,
     }
 
     // STEP 3: optimization using ceres
-    optimize( camera, rvecs, tvecs, imagePoints, scenePoints );
+    if ( !optimize( camera, rvecs, tvecs, imagePoints, scenePoints ) )
+    {
+        return false;
+    }
 
     if ( m_verbose )
     {
@@ -610,7 +747,7 @@ CameraCalibration::CalibrationOptimization( CameraPtr& camera,
     return true;
 }
 
-void
+bool
 CameraCalibration::optimize( CameraPtr& camera,
                              std::vector< cv::Mat >& rvecs,
                              std::vector< cv::Mat >& tvecs,
@@ -620,15 +757,18 @@ CameraCalibration::optimize( CameraPtr& camera,
     // Use ceres to do optimization
     ceres::Problem problem;
 
-    std::vector< Transform, Eigen::aligned_allocator< Transform > > transformVec( rvecs.size( ) );
+    // one block per view, the rotation (x, y, z, w) then the translation
+    std::vector< double > poseVec( 7 * rvecs.size( ) );
     for ( size_t i = 0; i < rvecs.size( ); ++i )
     {
         Eigen::Vector3d rvec;
         cv::cv2eigen( rvecs.at( i ), rvec );
 
-        transformVec.at( i ).rotation( ) = Eigen::AngleAxisd( rvec.norm( ), rvec.normalized( ) );
-        transformVec.at( i ).translation( ) << tvecs[i].at< double >( 0 ),
-        tvecs[i].at< double >( 1 ), tvecs[i].at< double >( 2 );
+        Eigen::Map< Eigen::Quaterniond > rotation( &poseVec[7 * i] );
+        rotation = Eigen::AngleAxisd( rvec.norm( ), rvec.normalized( ) );
+        poseVec[7 * i + 4] = tvecs[i].at< double >( 0 );
+        poseVec[7 * i + 5] = tvecs[i].at< double >( 1 );
+        poseVec[7 * i + 6] = tvecs[i].at< double >( 2 );
     }
 
     std::vector< double > intrinsicCameraParams;
@@ -647,27 +787,45 @@ CameraCalibration::optimize( CameraPtr& camera,
             camera,
             Eigen::Vector3d( spt.x, spt.y, spt.z ),
             Eigen::Vector2d( ipt.x, ipt.y ),
-            CAMERA_INTRINSICS | CAMERA_POSE );
+            CAMERA_INTRINSICS | CAMERA_POSE,
+            m_analyticJacobians );
 
             ceres::LossFunction* lossFunction = new ceres::CauchyLoss( 1.0 );
-            problem.AddResidualBlock( costFunction,
+            problem.AddResidualBlock( new PoseBlockCostFunction( costFunction ),
                                       lossFunction,
                                       intrinsicCameraParams.data( ),
-                                      transformVec.at( i ).rotationData( ),
-                                      transformVec.at( i ).translationData( ) );
+                                      &poseVec[7 * i] );
         }
 
-        ceres::LocalParameterization* quaternionParameterization = new EigenQuaternionParameterization;
+        ceres::LocalParameterization* poseParameterization
+        = new ceres::ProductParameterization( new EigenQuaternionParameterization,
+                                              new ceres::IdentityParameterization( 3 ) );
 
-        problem.SetParameterization( transformVec.at( i ).rotationData( ), quaternionParameterization );
+        problem.SetParameterization( &poseVec[7 * i], poseParameterization );
     }
 
     ceres::Solver::Options options;
     options.max_num_iterations         = 1000;
-    options.num_threads                = 4;
+    options.num_threads                = std::max( 1u, std::thread::hardware_concurrency( ) );
     options.trust_region_strategy_type = ceres::DOGLEG;
     options.logging_type               = ceres::SILENT;
 
+    if ( m_schurComplement )
+    {
+        // the views only share the intrinsics, so with the poses eliminated
+        // first the reduced system is the size of the intrinsics, and dense.
+        // The first group must be an independent set, hence one block per pose
+        ceres::ParameterBlockOrdering* ordering = new ceres::ParameterBlockOrdering;
+        for ( size_t i = 0; i < rvecs.size( ); ++i )
+        {
+            ordering->AddElementToGroup( &poseVec[7 * i], 0 );
+        }
+        ordering->AddElementToGroup( intrinsicCameraParams.data( ), 1 );
+
+        options.linear_solver_type = ceres::DENSE_SCHUR;
+        options.linear_solver_ordering.reset( ordering );
+    }
+
     if ( m_verbose )
     {
         options.minimizer_progress_to_stdout = true;
@@ -681,20 +839,29 @@ CameraCalibration::optimize( CameraPtr& camera,
         //        std::cout << summary.FullReport( ) << std::endl;
     }
 
+    if ( !summary.IsSolutionUsable( ) )
+    {
+        std::cerr << "[" << camera->cameraName( ) << "] "
+                  << "# ERROR: calibration solve failed: " << summary.message << std::endl;
+        return false;
+    }
+
     camera->readParameters( intrinsicCameraParams );
 
     for ( size_t i = 0; i < rvecs.size( ); ++i )
     {
-        Eigen::AngleAxisd aa( transformVec.at( i ).rotation( ) );
+        Eigen::AngleAxisd aa( Eigen::Map< const Eigen::Quaterniond >( &poseVec[7 * i] ) );
 
         Eigen::Vector3d rvec = aa.angle( ) * aa.axis( );
         cv::eigen2cv( rvec, rvecs.at( i ) );
 
         cv::Mat& tvec          = tvecs.at( i );
-        tvec.at< double >( 0 ) = transformVec.at( i ).translation( )( 0 );
-        tvec.at< double >( 1 ) = transformVec.at( i ).translation( )( 1 );
-        tvec.at< double >( 2 ) = transformVec.at( i ).translation( )( 2 );
+        tvec.at< double >( 0 ) = poseVec[7 * i + 4];
+        tvec.at< double >( 1 ) = poseVec[7 * i + 5];
+        tvec.at< double >( 2 ) = poseVec[7 * i + 6];
     }
+
+    return true;
 }
 
 template< typename T >
@@ -0,0 +1,160 @@
+#include <boost/program_options.hpp>
+#include <iomanip>
+#include <iostream>
+#include <opencv2/core/core.hpp>
+
+#include "camera_model/calib/CameraCalibration.h"
+#include "camera_model/camera_models/EquidistantCamera.h"
+#include "camera_model/camera_models/PinholeCamera.h"
+#include "camera_model/camera_models/PolyFisheyeCamera.h"
+#include "camera_model/camera_models/SplineCamera.h"
+#include "camera_model/gpl/gpl.h"
+
+using namespace camera_model;
+
+// the models of CostFunctionFactory with analytic jacobians, with plausible intrinsics for the image size
+std::vector< CameraPtr >
+syntheticCameras( cv::Size size )
+{
+    int w = size.width, h = size.height;
+    double cx = w / 2.0, cy = h / 2.0;
+    std::vector< CameraPtr > cameras;
+
+    PinholeCameraPtr pinhole( new PinholeCamera );
+    pinhole->setParameters( PinholeCamera::Parameters( "pinhole", w, h, -0.3, 0.1, 5e-4, -3e-4, 800, 800, cx, cy ) );
+    cameras.push_back( pinhole );
+
+    EquidistantCameraPtr equidistant( new EquidistantCamera );
+    equidistant->setParameters(
+    EquidistantCamera::Parameters( "kannala_brandt", w, h, -0.01, 0.002, 0.0, 0.0, 300, 300, cx, cy ) );
+    cameras.push_back( equidistant );
+
+    PolyFisheyeCameraPtr polyFisheye( new PolyFisheyeCamera );
+    polyFisheye->setParameters( PolyFisheyeCamera::Parameters(
+    "polyfisheye", w, h, 0.01, -0.02, 0.002, 0.0, 0.0, 0.0, 0.0, 0.0, 300, 0.0, 300, cx, cy, 0 ) );
+    cameras.push_back( polyFisheye );
+
+    SplineCameraPtr spline( new SplineCamera );
+    spline->setParameters( SplineCamera::Parameters(
+    "spline", w, h, 0.01, -0.02, 0.002, 0.0, 0.0, 0.0, 0.0, 0.0, 300, 0.0, 300, cx, cy, 0 ) );
+    cameras.push_back( spline );
+
+    return cameras;
+}
+
+// random views of the board that are seen whole by the camera, with pixel noise
+std::vector< std::vector< cv::Point2f > >
+syntheticViews( const CameraConstPtr& camera, cv::Size boardSize, float squareSize, int numViews, double noise, cv::RNG& rng )
+{
+    std::vector< std::vector< cv::Point2f > > views;
+    while ( ( int )views.size( ) < numViews )
+    {
+        // the board center 0.3 to 1.0 m in front of the camera, tilted up to 40 degrees
+        Eigen::Vector3d rvec( rng.uniform( -0.7, 0.7 ), rng.uniform( -0.7, 0.7 ), rng.uniform( -M_PI, M_PI ) );
+        Eigen::Matrix3d R = Eigen::AngleAxisd( rvec.norm( ), rvec.normalized( ) ).toRotationMatrix( );
+        Eigen::Vector3d center( ( boardSize.height - 1 ) * squareSize / 2.0, ( boardSize.width - 1 ) * squareSize / 2.0, 0.0 );
+        double depth = rng.uniform( 0.3, 1.0 );
+        Eigen::Vector3d t
+        = Eigen::Vector3d( rng.uniform( -0.5, 0.5 ) * depth, rng.uniform( -0.4, 0.4 ) * depth, depth ) - R * center;
+
+        // same corner order as CameraCalibration::addChessboardData
+        std::vector< cv::Point2f > corners;
+        for ( int i = 0; i < boardSize.height; ++i )
+        {
+            for ( int j = 0; j < boardSize.width; ++j )
+            {
+                Eigen::Vector3d P = R * Eigen::Vector3d( i * squareSize, j * squareSize, 0.0 ) + t;
+                Eigen::Vector2d p;
+                camera->spaceToPlane( P, p );
+                if ( P( 2 ) <= 0.0 || !( p( 0 ) >= 0.0 && p( 0 ) < camera->imageWidth( ) && p( 1 ) >= 0.0
+                                         && p( 1 ) < camera->imageHeight( ) ) )
+                    break;
+                corners.push_back( cv::Point2f( p( 0 ) + rng.gaussian( noise ), p( 1 ) + rng.gaussian( noise ) ) );
+            }
+        }
+        if ( ( int )corners.size( ) == boardSize.area( ) )
+            views.push_back( corners );
+    }
+    return views;
+}
+
+int
+main( int argc, char** argv )
+{
+    int numViews;
+    cv::Size boardSize;
+    float squareSize;
+    double noise;
+    cv::Size imageSize;
+
+    /* clang-format off */
+    using namespace boost::program_options;
+    boost::program_options::options_description desc(
+    "Calibration benchmark on synthetic chessboard views: automatic against analytic jacobians,\n"
+    "and the default linear solver against the Schur complement on the views." );
+    desc.add_options( )
+        ( "help", "produce help message" )
+        ( "views,n", value< int >( &numViews )->default_value( 500 ), "number of views" )
+        ( "width,w", value< int >( &boardSize.width )->default_value( 9 ), "number of inner corners on the chessboard pattern in x direction" )
+        ( "height,h", value< int >( &boardSize.height )->default_value( 6 ), "number of inner corners on the chessboard pattern in y direction" )
+        ( "size,s", value< float >( &squareSize )->default_value( 0.04f ), "size of one square in m" )
+        ( "noise", value< double >( &noise )->default_value( 0.2 ), "corner noise, pixels" )
+        ( "image-width", value< int >( &imageSize.width )->default_value( 1280 ), "synthetic image width" )
+        ( "image-height", value< int >( &imageSize.height )->default_value( 1024 ), "synthetic image height" )
+        ;
+    /* clang-format on */
+
+    boost::program_options::variables_map vm;
+    boost::program_options::store( boost::program_options::parse_command_line( argc, argv, desc ), vm );
+    boost::program_options::notify( vm );
+
+    if ( vm.count( "help" ) )
+    {
+        std::cout << desc << std::endl;
+        return 1;
+    }
+
+    const char* setupNames[4] = { "autodiff", "analytic", "autodiff+schur", "analytic+schur" };
+
+    std::cout << std::fixed << std::setprecision( 4 );
+    std::cout << "# INFO: " << numViews << " views of a " << boardSize.width << "x" << boardSize.height
+              << " board, " << noise << " pixels of noise\n";
+    std::cout << "# INFO: calibration time in s, largest intrinsic error relative to the true value\n";
+
+    cv::RNG rng( 0 );
+    std::vector< CameraPtr > cameras = syntheticCameras( imageSize );
+    for ( size_t c = 0; c < cameras.size( ); ++c )
+    {
+        const CameraPtr& truth = cameras[c];
+        std::vector< std::vector< cv::Point2f > > views
+        = syntheticViews( truth, boardSize, squareSize, numViews, noise, rng );
+
+        std::vector< double > trueParams;
+        truth->writeParameters( trueParams );
+
+        for ( int setup = 0; setup < 4; ++setup )
+        {
+            CameraCalibration calibration( truth->modelType( ), truth->cameraName( ), imageSize, boardSize, squareSize );
+            calibration.setSolverOptions( setup % 2 == 1, setup >= 2 );
+            for ( size_t i = 0; i < views.size( ); ++i )
+                calibration.addChessboardData( views[i] );
+
+            double startTime = timeInSeconds( );
+            bool solved      = calibration.calibrate( );
+            double time      = timeInSeconds( ) - startTime;
+
+            std::vector< double > params;
+            calibration.camera( )->writeParameters( params );
+            double maxError = 0.0;
+            for ( size_t i = 0; i < params.size( ); ++i )
+                if ( std::fabs( trueParams[i] ) > 1e-6 )
+                    maxError = std::max( maxError, std::fabs( params[i] / trueParams[i] - 1.0 ) );
+
+            std::cout << "# INFO: " << std::setw( 16 ) << truth->cameraName( ) << std::setw( 16 )
+                      << setupNames[setup] << std::setw( 10 ) << time << std::setw( 10 ) << maxError
+                      << ( solved ? "" : "  solve failed" ) << "\n";
+        }
+    }
+
+    return 0;
+}
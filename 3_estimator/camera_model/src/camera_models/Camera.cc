@@ -133,6 +133,11 @@ Camera::Parameters::nIntrinsics( void ) const
     return m_nIntrinsics;
 }
 
+Camera::Camera( )
+: m_liftTableStep( 0 )
+{
+}
+
 cv::Mat&
 Camera::mask( void )
 {
@@ -328,6 +333,124 @@ Camera::projectPoints( const std::vector< cv::Point3f >& objectPoints,
     }
 }
 
+// points per chunk of liftProjectiveBatch, the chunk arrays stay on the stack
+#define LIFT_BATCH_CHUNK 64
+
+void
+Camera::liftProjectiveBatch( const cv::Point2f* p, Eigen::Vector3d* P, int n ) const
+{
+    if ( m_liftTable.empty( ) )
+    {
+        for ( int i = 0; i < n; ++i )
+        {
+            liftProjective( Eigen::Vector2d( p[i].x, p[i].y ), P[i] );
+            P[i].normalize( );
+        }
+        return;
+    }
+
+    const float scale  = 1.0f / m_liftTableStep;
+    const float maxX   = m_liftTable.cols - 1;
+    const float maxY   = m_liftTable.rows - 1;
+    const int rowStep  = ( int )m_liftTable.step1( );
+    const float* table = m_liftTable.ptr< float >( );
+
+    int offset[LIFT_BATCH_CHUNK];
+    float wx[LIFT_BATCH_CHUNK], wy[LIFT_BATCH_CHUNK];
+    bool inside[LIFT_BATCH_CHUNK];
+
+    for ( int start = 0; start < n; start += LIFT_BATCH_CHUNK )
+    {
+        const int m           = std::min( LIFT_BATCH_CHUNK, n - start );
+        const cv::Point2f* pc = p + start;
+
+        // cells and weights of the chunk, without branches so that it vectorizes
+#pragma omp simd
+        for ( int i = 0; i < m; ++i )
+        {
+            float x   = pc[i].x * scale;
+            float y   = pc[i].y * scale;
+            inside[i] = x >= 0.0f && y >= 0.0f && x < maxX && y < maxY;
+
+            x         = std::min( std::max( x, 0.0f ), maxX );
+            y         = std::min( std::max( y, 0.0f ), maxY );
+            int x0    = ( int )x;
+            int y0    = ( int )y;
+            wx[i]     = x - x0;
+            wy[i]     = y - y0;
+            offset[i] = inside[i] ? y0 * rowStep + 3 * x0 : 0;
+        }
+
+        for ( int i = 0; i < m; ++i )
+        {
+            Eigen::Vector3d& Pi = P[start + i];
+            if ( !inside[i] )
+            {
+                liftProjective( Eigen::Vector2d( pc[i].x, pc[i].y ), Pi );
+                Pi.normalize( );
+                continue;
+            }
+
+            const float* a = table + offset[i];
+            const float* b = a + rowStep;
+            float w11      = wx[i] * wy[i];
+            float w10      = wy[i] - w11;
+            float w01      = wx[i] - w11;
+            float w00      = 1.0f - wx[i] - w10;
+
+            float X = w00 * a[0] + w01 * a[3] + w10 * b[0] + w11 * b[3];
+            float Y = w00 * a[1] + w01 * a[4] + w10 * b[1] + w11 * b[4];
+            float Z = w00 * a[2] + w01 * a[5] + w10 * b[2] + w11 * b[5];
+
+            float invNorm = 1.0f / std::sqrt( X * X + Y * Y + Z * Z );
+            Pi << X * invNorm, Y * invNorm, Z * invNorm;
+        }
+    }
+}
+
+void
+Camera::initLiftTable( int step )
+{
+    releaseLiftTable( );
+    if ( step <= 0 )
+        return;
+
+    // one node past the last pixel, every pixel then lies in a cell
+    int cols = ( imageWidth( ) - 1 ) / step + 2;
+    int rows = ( imageHeight( ) - 1 ) / step + 2;
+    cv::Mat table( rows, cols, CV_32FC3 );
+
+    // liftProjective is const, the rows are built in parallel
+#pragma omp parallel for
+    for ( int i = 0; i < rows; ++i )
+    {
+        cv::Vec3f* row = table.ptr< cv::Vec3f >( i );
+        for ( int j = 0; j < cols; ++j )
+        {
+            Eigen::Vector3d P;
+            liftProjective( Eigen::Vector2d( j * step, i * step ), P );
+            P.normalize( );
+            row[j] = cv::Vec3f( P( 0 ), P( 1 ), P( 2 ) );
+        }
+    }
+
+    m_liftTable     = table;
+    m_liftTableStep = step;
+}
+
+void
+Camera::releaseLiftTable( void )
+{
+    m_liftTable.release( );
+    m_liftTableStep = 0;
+}
+
+bool
+Camera::hasLiftTable( void ) const
+{
+    return !m_liftTable.empty( );
+}
+
 Ray::Ray( )
 : m_theta( 0.0 )
 , m_phi( 0.0 )
@@ -183,6 +183,13 @@ CameraFactory::generateCameraFromYamlFile( const std::string& filename )
         }
     }
 
+    // optional table of unit rays for liftProjectiveBatch, pixels between its nodes
+    int liftTableStep = 0;
+    if ( !fs["lift_table_step"].isNone( ) )
+    {
+        fs["lift_table_step"] >> liftTableStep;
+    }
+
     switch ( modelType )
     {
         case Camera::KANNALA_BRANDT:
@@ -192,6 +199,7 @@ CameraFactory::generateCameraFromYamlFile( const std::string& filename )
             EquidistantCamera::Parameters params = camera->getParameters( );
             params.readFromYamlFile( filename );
             camera->setParameters( params );
+            camera->initLiftTable( liftTableStep );
             return camera;
         }
         case Camera::PINHOLE:
@@ -201,6 +209,7 @@ CameraFactory::generateCameraFromYamlFile( const std::string& filename )
             PinholeCamera::Parameters params = camera->getParameters( );
             params.readFromYamlFile( filename );
             camera->setParameters( params );
+            camera->initLiftTable( liftTableStep );
             return camera;
         }
         case Camera::PINHOLE_FULL:
@@ -210,6 +219,7 @@ CameraFactory::generateCameraFromYamlFile( const std::string& filename )
             PinholeFullCamera::Parameters params = camera->getParameters( );
             params.readFromYamlFile( filename );
             camera->setParameters( params );
+            camera->initLiftTable( liftTableStep );
             return camera;
         }
         case Camera::SCARAMUZZA:
@@ -219,6 +229,7 @@ CameraFactory::generateCameraFromYamlFile( const std::string& filename )
             OCAMCamera::Parameters params = camera->getParameters( );
             params.readFromYamlFile( filename );
             camera->setParameters( params );
+            camera->initLiftTable( liftTableStep );
             return camera;
         }
         case Camera::POLYFISHEYE:
@@ -228,6 +239,7 @@ CameraFactory::generateCameraFromYamlFile( const std::string& filename )
             PolyFisheyeCamera::Parameters params = camera->getParameters( );
             params.readFromYamlFile( filename );
             camera->setParameters( params );
+            camera->initLiftTable( liftTableStep );
             return camera;
         }
         case Camera::SPLINE:
@@ -237,6 +249,7 @@ CameraFactory::generateCameraFromYamlFile( const std::string& filename )
             SplineCamera::Parameters params = camera->getParameters( );
             params.readFromYamlFile( filename );
             camera->setParameters( params );
+            camera->initLiftTable( liftTableStep );
             return camera;
         }
         case Camera::FOV:
@@ -246,6 +259,7 @@ CameraFactory::generateCameraFromYamlFile( const std::string& filename )
             FovCamera::Parameters params = camera->getParameters( );
             params.readFromYamlFile( filename );
             camera->setParameters( params );
+            camera->initLiftTable( liftTableStep );
             return camera;
         }
         case Camera::MEI:
@@ -256,6 +270,7 @@ CameraFactory::generateCameraFromYamlFile( const std::string& filename )
             CataCamera::Parameters params = camera->getParameters( );
             params.readFromYamlFile( filename );
             camera->setParameters( params );
+            camera->initLiftTable( liftTableStep );
             return camera;
         }
     }
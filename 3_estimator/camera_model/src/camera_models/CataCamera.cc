@@ -952,6 +952,7 @@ void
 CataCamera::setParameters( const CataCamera::Parameters& parameters )
 {
     mParameters = parameters;
+    releaseLiftTable( );
 
     if ( ( mParameters.k1( ) == 0.0 ) && ( mParameters.k2( ) == 0.0 ) && ( mParameters.p1( ) == 0.0 )
          && ( mParameters.p2( ) == 0.0 ) )
@@ -174,6 +174,85 @@ class ReprojectionError1
     Eigen::Matrix2d m_sqrtPrecisionMat;
 };
 
+// variables: camera intrinsics and camera extrinsics, differentiated by hand
+// with CameraT::spaceToPlaneJacobian instead of the jets of ReprojectionError1
+template< class CameraT, int NumParams >
+class AnalyticReprojectionError1 : public ceres::SizedCostFunction< 2, NumParams, 4, 3 >
+{
+    public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    AnalyticReprojectionError1( const Eigen::Vector3d& observed_P, const Eigen::Vector2d& observed_p )
+    : m_observed_P( observed_P )
+    , m_observed_p( observed_p )
+    {
+    }
+
+    virtual bool Evaluate( double const* const* parameters, double* residuals, double** jacobians ) const
+    {
+        // Eigen convention (x, y, z, w), normalized like ceres::QuaternionRotatePoint
+        Eigen::Map< const Eigen::Vector4d > q( parameters[1] );
+        double q_norm       = q.norm( );
+        Eigen::Vector3d q_v = q.head< 3 >( ) / q_norm;
+        double q_w          = q( 3 ) / q_norm;
+
+        const Eigen::Vector3d& P = m_observed_P;
+        Eigen::Vector3d q_v_P    = q_v.cross( P );
+        Eigen::Vector3d P_c
+        = P + 2.0 * ( q_w * q_v_P + q_v.cross( q_v_P ) ) + Eigen::Map< const Eigen::Vector3d >( parameters[2] );
+
+        bool withIntrinsics = jacobians && jacobians[0];
+        Eigen::Vector2d predicted_p;
+        Eigen::Matrix< double, 2, 3 > J_P;
+        Eigen::Matrix< double, 2, NumParams, Eigen::RowMajor > J_params;
+        CameraT::spaceToPlaneJacobian( parameters[0], P_c, predicted_p, J_P, withIntrinsics ? &J_params : 0 );
+
+        residuals[0] = predicted_p( 0 ) - m_observed_p( 0 );
+        residuals[1] = predicted_p( 1 ) - m_observed_p( 1 );
+
+        if ( !jacobians )
+            return true;
+
+        if ( withIntrinsics )
+        {
+            Eigen::Map< Eigen::Matrix< double, 2, NumParams, Eigen::RowMajor > > J_intrinsics( jacobians[0] );
+            J_intrinsics = J_params;
+        }
+
+        if ( jacobians[1] )
+        {
+            // P_c on the unit quaternion, then on q through its normalization
+            Eigen::Matrix3d P_x;
+            P_x << 0.0, -P( 2 ), P( 1 ), P( 2 ), 0.0, -P( 0 ), -P( 1 ), P( 0 ), 0.0;
+
+            Eigen::Matrix< double, 3, 4 > J_q;
+            J_q.leftCols< 3 >( ) = 2.0
+                                   * ( q_v.dot( P ) * Eigen::Matrix3d::Identity( ) + q_v * P.transpose( )
+                                       - 2.0 * P * q_v.transpose( ) - q_w * P_x );
+            J_q.col( 3 ) = 2.0 * q_v_P;
+
+            Eigen::Vector4d q_unit = q / q_norm;
+            Eigen::Map< Eigen::Matrix< double, 2, 4, Eigen::RowMajor > > J_rotation( jacobians[1] );
+            J_rotation = J_P * J_q * ( Eigen::Matrix4d::Identity( ) - q_unit * q_unit.transpose( ) ) / q_norm;
+        }
+
+        if ( jacobians[2] )
+        {
+            Eigen::Map< Eigen::Matrix< double, 2, 3, Eigen::RowMajor > > J_translation( jacobians[2] );
+            J_translation = J_P;
+        }
+
+        return true;
+    }
+
+    private:
+    // observed 3D point
+    Eigen::Vector3d m_observed_P;
+
+    // observed 2D point
+    Eigen::Vector2d m_observed_p;
+};
+
 // variables: camera extrinsics, 3D point
 template< class CameraT >
 class ReprojectionError2
@@ -494,7 +573,8 @@ ceres::CostFunction*
 CostFunctionFactory::generateCostFunction( const CameraConstPtr& camera,
                                            const Eigen::Vector3d& observed_P,
                                            const Eigen::Vector2d& observed_p,
-                                           int flags ) const
+                                           int flags,
+                                           bool analyticJacobians ) const
 {
     ceres::CostFunction* costFunction = 0;
 
@@ -552,14 +632,20 @@ CostFunctionFactory::generateCostFunction( const CameraConstPtr& camera,
             switch ( camera->modelType( ) )
             {
                 case Camera::KANNALA_BRANDT:
-                    costFunction
-                    = new ceres::AutoDiffCostFunction< ReprojectionError1< EquidistantCamera >, 2, 8, 4, 3 >(
-                    new ReprojectionError1< EquidistantCamera >( observed_P, observed_p ) );
+                    if ( analyticJacobians )
+                        costFunction = new AnalyticReprojectionError1< EquidistantCamera, 8 >( observed_P, observed_p );
+                    else
+                        costFunction
+                        = new ceres::AutoDiffCostFunction< ReprojectionError1< EquidistantCamera >, 2, 8, 4, 3 >(
+                        new ReprojectionError1< EquidistantCamera >( observed_P, observed_p ) );
                     break;
                 case Camera::PINHOLE:
-                    costFunction
-                    = new ceres::AutoDiffCostFunction< ReprojectionError1< PinholeCamera >, 2, 8, 4, 3 >(
-                    new ReprojectionError1< PinholeCamera >( observed_P, observed_p ) );
+                    if ( analyticJacobians )
+                        costFunction = new AnalyticReprojectionError1< PinholeCamera, 8 >( observed_P, observed_p );
+                    else
+                        costFunction
+                        = new ceres::AutoDiffCostFunction< ReprojectionError1< PinholeCamera >, 2, 8, 4, 3 >(
+                        new ReprojectionError1< PinholeCamera >( observed_P, observed_p ) );
                     break;
                 case Camera::PINHOLE_FULL:
                     costFunction
@@ -577,14 +663,20 @@ CostFunctionFactory::generateCostFunction( const CameraConstPtr& camera,
                     new ReprojectionError1< OCAMCamera >( observed_P, observed_p ) );
                     break;
                 case Camera::POLYFISHEYE:
-                    costFunction
-                    = new ceres::AutoDiffCostFunction< ReprojectionError1< PolyFisheyeCamera >, 2, FISHEYE_PARAMS_NUM, 4, 3 >(
-                    new ReprojectionError1< PolyFisheyeCamera >( observed_P, observed_p ) );
+                    if ( analyticJacobians )
+                        costFunction = new AnalyticReprojectionError1< PolyFisheyeCamera, FISHEYE_PARAMS_NUM >( observed_P, observed_p );
+                    else
+                        costFunction
+                        = new ceres::AutoDiffCostFunction< ReprojectionError1< PolyFisheyeCamera >, 2, FISHEYE_PARAMS_NUM, 4, 3 >(
+                        new ReprojectionError1< PolyFisheyeCamera >( observed_P, observed_p ) );
                     break;
                 case Camera::SPLINE:
-                    costFunction
-                    = new ceres::AutoDiffCostFunction< ReprojectionError1< SplineCamera >, 2, SPLINE_PARAMS_NUM, 4, 3 >(
-                    new ReprojectionError1< SplineCamera >( observed_P, observed_p ) );
+                    if ( analyticJacobians )
+                        costFunction = new AnalyticReprojectionError1< SplineCamera, SPLINE_PARAMS_NUM >( observed_P, observed_p );
+                    else
+                        costFunction
+                        = new ceres::AutoDiffCostFunction< ReprojectionError1< SplineCamera >, 2, SPLINE_PARAMS_NUM, 4, 3 >(
+                        new ReprojectionError1< SplineCamera >( observed_P, observed_p ) );
                     break;
                 case Camera::FOV:
                     costFunction
@@ -499,6 +499,72 @@ EquidistantCamera::spaceToPlane( const Eigen::Vector3d& P,
     mParameters.mv( ) * p_u( 1 ) + mParameters.v0( );
 }
 
+void
+EquidistantCamera::spaceToPlaneJacobian( const double* const params,
+                                         const Eigen::Vector3d& P_c,
+                                         Eigen::Vector2d& p,
+                                         Eigen::Matrix< double, 2, 3 >& J_P,
+                                         Eigen::Matrix< double, 2, 8, Eigen::RowMajor >* J_params )
+{
+    double k2 = params[0];
+    double k3 = params[1];
+    double k4 = params[2];
+    double k5 = params[3];
+    double mu = params[4];
+    double mv = params[5];
+    double u0 = params[6];
+    double v0 = params[7];
+
+    double rho_sqr = P_c( 0 ) * P_c( 0 ) + P_c( 1 ) * P_c( 1 );
+    double rho     = sqrt( rho_sqr );
+    double len_sqr = rho_sqr + P_c( 2 ) * P_c( 2 );
+
+    // same angle as acos( z / len ), but accurate near the optical axis
+    double theta     = atan2( rho, P_c( 2 ) );
+    double theta_sqr = theta * theta;
+    double r         = theta * ( 1.0 + theta_sqr * ( k2 + theta_sqr * ( k3 + theta_sqr * ( k4 + theta_sqr * k5 ) ) ) );
+    double dr        = 1.0 + theta_sqr * ( 3.0 * k2 + theta_sqr * ( 5.0 * k3 + theta_sqr * ( 7.0 * k4 + theta_sqr * 9.0 * k5 ) ) );
+
+    // p_u = r( theta ) * ( cos( phi ), sin( phi ) ) on P_c
+    double cos_phi = 1.0, sin_phi = 0.0;
+    Eigen::Matrix< double, 2, 3 > J_pu;
+    if ( rho > 1e-12 * P_c( 2 ) )
+    {
+        cos_phi = P_c( 0 ) / rho;
+        sin_phi = P_c( 1 ) / rho;
+
+        Eigen::RowVector3d J_theta( cos_phi * P_c( 2 ), sin_phi * P_c( 2 ), -rho );
+        J_theta /= len_sqr;
+
+        double r_rho = r / rho;
+        J_pu.row( 0 ) = dr * cos_phi * J_theta + r_rho * Eigen::RowVector3d( sin_phi * sin_phi, -cos_phi * sin_phi, 0.0 );
+        J_pu.row( 1 ) = dr * sin_phi * J_theta + r_rho * Eigen::RowVector3d( -cos_phi * sin_phi, cos_phi * cos_phi, 0.0 );
+    }
+    else
+    {
+        // on the optical axis p_u tends to ( x, y ) / z
+        J_pu << 1.0 / P_c( 2 ), 0.0, 0.0, //
+        0.0, 1.0 / P_c( 2 ), 0.0;
+    }
+
+    Eigen::Vector2d p_u( r * cos_phi, r * sin_phi );
+    p << mu * p_u( 0 ) + u0, mv * p_u( 1 ) + v0;
+
+    J_P = Eigen::Vector2d( mu, mv ).asDiagonal( ) * J_pu;
+
+    if ( J_params )
+    {
+        double theta_3 = theta * theta_sqr;
+        double theta_5 = theta_3 * theta_sqr;
+        double theta_7 = theta_5 * theta_sqr;
+        double theta_9 = theta_7 * theta_sqr;
+        double mu_c    = mu * cos_phi;
+        double mv_s    = mv * sin_phi;
+        *J_params << mu_c * theta_3, mu_c * theta_5, mu_c * theta_7, mu_c * theta_9, p_u( 0 ), 0.0, 1.0, 0.0, //
+        mv_s * theta_3, mv_s * theta_5, mv_s * theta_7, mv_s * theta_9, 0.0, p_u( 1 ), 0.0, 1.0;
+    }
+}
+
 /**
  * \brief Projects an undistorted 2D point p_u to the image plane
  *
@@ -634,6 +700,7 @@ void
 EquidistantCamera::setParameters( const EquidistantCamera::Parameters& parameters )
 {
     mParameters = parameters;
+    releaseLiftTable( );
 
     // Inverse camera projection matrix parameters
     m_inv_K11 = 1.0 / mParameters.mu( );
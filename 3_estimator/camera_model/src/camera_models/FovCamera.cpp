@@ -329,6 +329,7 @@ void
 FovCamera::setParameters( const FovCamera::Parameters& parameters )
 {
     mParameters = parameters;
+    releaseLiftTable( );
 
     calcKinvese( parameters.fx( ), parameters.fy( ), parameters.u0( ), parameters.v0( ) );
 
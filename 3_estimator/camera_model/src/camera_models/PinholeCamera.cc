@@ -615,6 +615,55 @@ PinholeCamera::spaceToPlane( const Eigen::Vector3d& P, Eigen::Vector2d& p, Eigen
     J << dudx, dudy, dudz, dvdx, dvdy, dvdz;
 }
 
+void
+PinholeCamera::spaceToPlaneJacobian( const double* const params,
+                                     const Eigen::Vector3d& P_c,
+                                     Eigen::Vector2d& p,
+                                     Eigen::Matrix< double, 2, 3 >& J_P,
+                                     Eigen::Matrix< double, 2, 8, Eigen::RowMajor >* J_params )
+{
+    double k1 = params[0];
+    double k2 = params[1];
+    double p1 = params[2];
+    double p2 = params[3];
+    double fx = params[4];
+    double fy = params[5];
+    double cx = params[6];
+    double cy = params[7];
+
+    // Transform to model plane
+    double inv_z = 1.0 / P_c( 2 );
+    double u     = P_c( 0 ) * inv_z;
+    double v     = P_c( 1 ) * inv_z;
+
+    double rho_sqr = u * u + v * v;
+    double L       = 1.0 + k1 * rho_sqr + k2 * rho_sqr * rho_sqr;
+    double u_d     = L * u + 2.0 * p1 * u * v + p2 * ( rho_sqr + 2.0 * u * u );
+    double v_d     = L * v + p1 * ( rho_sqr + 2.0 * v * v ) + 2.0 * p2 * u * v;
+
+    p << fx * u_d + cx, fy * v_d + cy;
+
+    // (u_d, v_d) on (u, v), dL/du = dL * u
+    double dL     = 2.0 * k1 + 4.0 * k2 * rho_sqr;
+    double dud_dv = dL * u * v + 2.0 * p1 * u + 2.0 * p2 * v;
+    Eigen::Matrix2d J_d;
+    J_d << L + dL * u * u + 2.0 * p1 * v + 6.0 * p2 * u, dud_dv, //
+    dud_dv, L + dL * v * v + 6.0 * p1 * v + 2.0 * p2 * u;
+
+    Eigen::Matrix< double, 2, 3 > J_uv;
+    J_uv << inv_z, 0.0, -u * inv_z, //
+    0.0, inv_z, -v * inv_z;
+
+    J_P = Eigen::Vector2d( fx, fy ).asDiagonal( ) * J_d * J_uv;
+
+    if ( J_params )
+    {
+        double rho_4 = rho_sqr * rho_sqr;
+        *J_params << fx * u * rho_sqr, fx * u * rho_4, fx * 2.0 * u * v, fx * ( rho_sqr + 2.0 * u * u ), u_d, 0.0, 1.0, 0.0, //
+        fy * v * rho_sqr, fy * v * rho_4, fy * ( rho_sqr + 2.0 * v * v ), fy * 2.0 * u * v, 0.0, v_d, 0.0, 1.0;
+    }
+}
+
 /**
  * \brief Projects an undistorted 2D point p_u to the image plane
  *
@@ -808,6 +857,7 @@ void
 PinholeCamera::setParameters( const PinholeCamera::Parameters& parameters )
 {
     mParameters = parameters;
+    releaseLiftTable( );
 
     if ( ( mParameters.k1( ) == 0.0 ) && ( mParameters.k2( ) == 0.0 ) && ( mParameters.p1( ) == 0.0 )
          && ( mParameters.p2( ) == 0.0 ) )
@@ -922,6 +922,7 @@ void
 PinholeFullCamera::setParameters( const PinholeFullCamera::Parameters& parameters )
 {
     mParameters = parameters;
+    releaseLiftTable( );
 
     if ( ( mParameters.k1( ) == 0.0 ) && ( mParameters.k2( ) == 0.0 )
          && ( mParameters.p1( ) == 0.0 ) && ( mParameters.p2( ) == 0.0 ) )
@@ -214,6 +214,101 @@ PolyFisheyeCamera::spaceToPlane( const Eigen::Vector3d& P,
     mParameters.A22( ) * p_u( 1 ) + mParameters.v0( );
 }
 
+void
+PolyFisheyeCamera::spaceToPlaneJacobian( const double* const params,
+                                         const Eigen::Vector3d& P_c,
+                                         Eigen::Vector2d& p,
+                                         Eigen::Matrix< double, 2, 3 >& J_P,
+                                         Eigen::Matrix< double, 2, FISHEYE_PARAMS_NUM, Eigen::RowMajor >* J_params )
+{
+    double A11 = params[0];
+    double A12 = params[1];
+    double A22 = params[2];
+    double u0  = params[3];
+    double v0  = params[4];
+    const double* k = params + 5; // k2 .. k7
+    double p1  = params[11];
+    double p2  = params[12];
+
+    double rho_sqr = P_c( 0 ) * P_c( 0 ) + P_c( 1 ) * P_c( 1 );
+    double rho     = sqrt( rho_sqr );
+    double len_sqr = rho_sqr + P_c( 2 ) * P_c( 2 );
+
+    // r( theta ) and its derivative, theta_i[i] = theta^i
+    double theta = atan2( rho, P_c( 2 ) );
+    double theta_i[8];
+    theta_i[0] = 1.0;
+    for ( int i = 1; i < 8; ++i )
+        theta_i[i] = theta_i[i - 1] * theta;
+    double r  = theta;
+    double dr = 1.0;
+    for ( int i = 2; i < 8; ++i )
+    {
+        r += k[i - 2] * theta_i[i];
+        dr += i * k[i - 2] * theta_i[i - 1];
+    }
+
+    double inv_z = 1.0 / P_c( 2 );
+    double r_x   = P_c( 0 ) * inv_z;
+    double r_y   = P_c( 1 ) * inv_z;
+
+    double cos_phi = 1.0, sin_phi = 0.0;
+    Eigen::RowVector3d J_r = Eigen::RowVector3d::Zero( );
+    Eigen::Matrix< double, 2, 3 > J_pu;
+    if ( rho > 1e-12 * P_c( 2 ) )
+    {
+        cos_phi = P_c( 0 ) / rho;
+        sin_phi = P_c( 1 ) / rho;
+
+        J_r << cos_phi * P_c( 2 ), sin_phi * P_c( 2 ), -rho;
+        J_r *= dr / len_sqr;
+
+        double r_rho = r / rho;
+        J_pu.row( 0 ) = cos_phi * J_r + r_rho * Eigen::RowVector3d( sin_phi * sin_phi, -cos_phi * sin_phi, 0.0 );
+        J_pu.row( 1 ) = sin_phi * J_r + r_rho * Eigen::RowVector3d( -cos_phi * sin_phi, cos_phi * cos_phi, 0.0 );
+    }
+    else
+    {
+        // on the optical axis r( theta ) * ( cos( phi ), sin( phi ) ) tends to ( x, y ) / z
+        J_pu << inv_z, 0.0, 0.0, //
+        0.0, inv_z, 0.0;
+    }
+
+    // tangential part
+    Eigen::RowVector3d J_rx( inv_z, 0.0, -r_x * inv_z );
+    Eigen::RowVector3d J_ry( 0.0, inv_z, -r_y * inv_z );
+    Eigen::RowVector3d J_rxry = r_y * J_rx + r_x * J_ry;
+    J_pu.row( 0 ) += 2.0 * p1 * J_rxry + p2 * ( J_r + 4.0 * r_x * J_rx );
+    J_pu.row( 1 ) += p1 * ( J_r + 4.0 * r_y * J_ry ) + 2.0 * p2 * J_rxry;
+
+    Eigen::Vector2d p_u( r * cos_phi + 2.0 * p1 * r_x * r_y + p2 * ( r + 2.0 * r_x * r_x ),
+                         r * sin_phi + p1 * ( r + 2.0 * r_y * r_y ) + 2.0 * p2 * r_x * r_y );
+
+    p << A11 * p_u( 0 ) + A12 * p_u( 1 ) + u0, A22 * p_u( 1 ) + v0;
+
+    Eigen::Matrix2d A;
+    A << A11, A12, 0.0, A22;
+    J_P = A * J_pu;
+
+    if ( J_params )
+    {
+        J_params->setZero( );
+        ( *J_params )( 0, 0 ) = p_u( 0 );
+        ( *J_params )( 0, 1 ) = p_u( 1 );
+        ( *J_params )( 1, 2 ) = p_u( 1 );
+        ( *J_params )( 0, 3 ) = 1.0;
+        ( *J_params )( 1, 4 ) = 1.0;
+
+        // r enters p_u through ( cos( phi ), sin( phi ) ) and the tangential part
+        Eigen::Vector2d A_dr = A * Eigen::Vector2d( cos_phi + p2, sin_phi + p1 );
+        for ( int i = 2; i < 8; ++i )
+            J_params->col( 3 + i ) = theta_i[i] * A_dr;
+
+        J_params->col( 11 ) = A * Eigen::Vector2d( 2.0 * r_x * r_y, r + 2.0 * r_y * r_y );
+        J_params->col( 12 ) = A * Eigen::Vector2d( r + 2.0 * r_x * r_x, 2.0 * r_x * r_y );
+    }
+}
+
 void
 PolyFisheyeCamera::estimateIntrinsics( const cv::Size& boardSize,
                                        const std::vector< std::vector< cv::Point3f > >& objectPoints,
@@ -481,6 +576,7 @@ void
 PolyFisheyeCamera::setParameters( const PolyFisheyeCamera::Parameters& parameters )
 {
     mParameters = parameters;
+    releaseLiftTable( );
 
     calcKinvese(
     parameters.A11( ), parameters.A12( ), parameters.A22( ), parameters.u0( ), parameters.v0( ) );
@@ -828,6 +828,7 @@ void
 OCAMCamera::setParameters( const OCAMCamera::Parameters& parameters )
 {
     mParameters = parameters;
+    releaseLiftTable( );
 
     m_inv_scale = 1.0 / ( parameters.C( ) - parameters.D( ) * parameters.E( ) );
 }
@@ -1,4 +1,5 @@
 #include <camera_model/camera_models/SplineCamera.h>
+#include <camera_model/camera_models/PolyFisheyeCamera.h>
 
 #include <cmath>
 #include <cstdio>
@@ -207,6 +208,18 @@ SplineCamera::spaceToPlane( const Eigen::Vector3d& P, Eigen::Vector2d& p, Eigen:
     mParameters.A22( ) * p_u( 1 ) + mParameters.v0( );
 }
 
+void
+SplineCamera::spaceToPlaneJacobian( const double* const params,
+                                    const Eigen::Vector3d& P_c,
+                                    Eigen::Vector2d& p,
+                                    Eigen::Matrix< double, 2, 3 >& J_P,
+                                    Eigen::Matrix< double, 2, SPLINE_PARAMS_NUM, Eigen::RowMajor >* J_params )
+{
+    // same projection and parameter layout as the poly fisheye model
+    static_assert( SPLINE_PARAMS_NUM == FISHEYE_PARAMS_NUM, "spline and poly fisheye parameters differ" );
+    PolyFisheyeCamera::spaceToPlaneJacobian( params, P_c, p, J_P, J_params );
+}
+
 void
 SplineCamera::estimateIntrinsics( const cv::Size& boardSize,
                                   const std::vector< std::vector< cv::Point3f > >& objectPoints,
@@ -471,6 +484,7 @@ void
 SplineCamera::setParameters( const SplineCamera::Parameters& parameters )
 {
     mParameters = parameters;
+    releaseLiftTable( );
 
     calcKinvese( parameters.A11( ), parameters.A12( ), parameters.A22( ), parameters.u0( ), parameters.v0( ) );
     if ( mParameters.isDistortion( ) )
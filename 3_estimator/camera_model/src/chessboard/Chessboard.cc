@@ -8,6 +8,9 @@
 
 #define MAX_CONTOUR_APPROX 7
 
+// images with a smaller side at least this long are searched at half resolution first
+#define COARSE_TO_FINE_MIN_SIDE 960
+
 namespace camera_model
 {
 
@@ -122,12 +125,6 @@ Chessboard::findChessboardCornersImproved( const cv::Mat& image,
 
     \************************************************************************************/
 
-    int bestDilation       = -1;
-    const int minDilations = 0;
-    const int maxDilations = 7;
-
-    std::vector< ChessboardQuadPtr > outputQuadGroup;
-
     if ( image.depth( ) != CV_8U || image.channels( ) == 2 )
         return false;
     if ( patternSize.width < 2 || patternSize.height < 2 )
@@ -154,11 +151,63 @@ Chessboard::findChessboardCornersImproved( const cv::Mat& image,
 
         if ( flags & CV_CALIB_CB_NORMALIZE_IMAGE )
         {
-            cv::equalizeHist( image, norm_img );
+            cv::equalizeHist( img, norm_img );
             img = norm_img;
         }
     }
 
+    // Coarse to fine: large images are searched at half resolution first, the
+    // corners are then refined on the full image. cornerSubPix converges from
+    // the one coarse pixel of error, the full resolution search is only the
+    // fallback when the coarse one fails.
+    bool found = false;
+    if ( std::min( img.cols, img.rows ) >= COARSE_TO_FINE_MIN_SIDE )
+    {
+        cv::Mat coarse;
+        cv::pyrDown( img, coarse );
+
+        if ( findBoardQuads( coarse, patternSize, corners, flags ) )
+        {
+            // pyrDown keeps the even pixels: coarse x is 2 x at full resolution
+            for ( size_t i = 0; i < corners.size( ); ++i )
+            {
+                corners[i] *= 2.0f;
+            }
+            found = true;
+        }
+    }
+
+    if ( !found )
+    {
+        found = findBoardQuads( img, patternSize, corners, flags );
+    }
+
+    if ( !found )
+    {
+        return false;
+    }
+
+    cv::cornerSubPix( image,
+                      corners,
+                      cv::Size( 11, 11 ),
+                      cv::Size( -1, -1 ),
+                      cv::TermCriteria( CV_TERMCRIT_EPS + CV_TERMCRIT_ITER, 30, 0.1 ) );
+
+    return true;
+}
+
+bool
+Chessboard::findBoardQuads( const cv::Mat& img,
+                            const cv::Size& patternSize,
+                            std::vector< cv::Point2f >& corners,
+                            int flags )
+{
+    const int minDilations = 0;
+    const int maxDilations = 7;
+    const int numDilations = maxDilations - minDilations + 1;
+    // dilations applied at most, like the serial search: the levels above search a copy of that image
+    const int maxDilateOps = 6;
+
     if ( flags & CV_CALIB_CB_FAST_CHECK )
     {
         if ( !checkChessboard( img, patternSize ) )
@@ -167,172 +216,209 @@ Chessboard::findChessboardCornersImproved( const cv::Mat& image,
         }
     }
 
+    // MARTIN's Code
+    // Use both a rectangular and a cross kernel. In this way, a more
+    // homogeneous dilation is performed, which is crucial for small,
+    // distorted checkers. Use the CROSS kernel first, since its action
+    // on the image is more subtle
+    cv::Mat kernel1 = cv::getStructuringElement( CV_SHAPE_CROSS, cv::Size( 3, 3 ), cv::Point( 1, 1 ) );
+    cv::Mat kernel2 = cv::getStructuringElement( CV_SHAPE_RECT, cv::Size( 3, 3 ), cv::Point( 1, 1 ) );
+
     // PART 1: FIND LARGEST PATTERN
     //-----------------------------------------------------------------------
     // Checker patterns are tried to be found by dilating the background and
     // then applying a canny edge finder on the closed contours (checkers).
-    // Try one dilation run, but if the pattern is not found, repeat until
-    // max_dilations is reached.
+    // All the dilation levels of a threshold run are tried in parallel, the
+    // lowest level that finds the pattern wins, like the serial search did.
+    // Under an outer parallel loop (batch detection) OpenMP runs the levels
+    // in order on one thread, and the levels above a found one are skipped.
 
     int prevSqrSize = 0;
     bool found      = false;
     std::vector< ChessboardCornerPtr > outputCorners;
 
-    for ( int k = 0; k < 6; ++k )
+    for ( int k = 0; k < 6 && !found; ++k )
     {
-        for ( int dilations = minDilations; dilations <= maxDilations; ++dilations )
+        std::vector< cv::Mat > threshImgs( numDilations );
+
+        // convert the input grayscale image to binary (black-n-white)
+        if ( flags & CV_CALIB_CB_ADAPTIVE_THRESH )
         {
-            if ( found )
-            {
-                break;
-            }
+            int blockSize = lround( prevSqrSize == 0 ?
+                                    std::min( img.cols, img.rows ) * ( k % 2 == 0 ? 0.2 : 0.1 ) :
+                                    prevSqrSize * 2 )
+                            | 1;
+
+            // convert to binary
+            cv::adaptiveThreshold(
+            img, threshImgs[0], 255, CV_ADAPTIVE_THRESH_MEAN_C, CV_THRESH_BINARY, blockSize, ( k / 2 ) * 5 );
+        }
+        else
+        {
+            // empiric threshold level
+            double mean      = ( cv::mean( img ) )[0];
+            int thresh_level = lround( mean - 10 );
+            thresh_level     = std::max( thresh_level, 10 );
 
-            cv::Mat thresh_img;
+            cv::threshold( img, threshImgs[0], thresh_level, 255, CV_THRESH_BINARY );
+        }
 
-            // convert the input grayscale image to binary (black-n-white)
-            if ( flags & CV_CALIB_CB_ADAPTIVE_THRESH )
+        // each level is one more dilation of the previous one, alternating the kernels
+        for ( int dilations = 1; dilations < numDilations; ++dilations )
+        {
+            if ( dilations > maxDilateOps )
             {
-                int blockSize = lround( prevSqrSize == 0 ?
-                                        std::min( img.cols, img.rows ) * ( k % 2 == 0 ? 0.2 : 0.1 ) :
-                                        prevSqrSize * 2 )
-                                | 1;
-
-                // convert to binary
-                cv::adaptiveThreshold(
-                img, thresh_img, 255, CV_ADAPTIVE_THRESH_MEAN_C, CV_THRESH_BINARY, blockSize, ( k / 2 ) * 5 );
+                threshImgs[dilations] = threshImgs[dilations - 1].clone( );
             }
             else
             {
-                // empiric threshold level
-                double mean      = ( cv::mean( img ) )[0];
-                int thresh_level = lround( mean - 10 );
-                thresh_level     = std::max( thresh_level, 10 );
-
-                cv::threshold( img, thresh_img, thresh_level, 255, CV_THRESH_BINARY );
+                cv::dilate( threshImgs[dilations - 1], threshImgs[dilations], dilations % 2 == 1 ? kernel1 : kernel2 );
             }
+        }
+
+        std::vector< std::vector< ChessboardCornerPtr > > levelCorners( numDilations );
+        std::vector< int > levelSqrSize( numDilations, -1 );
+        int firstFound = numDilations;
 
-            // MARTIN's Code
-            // Use both a rectangular and a cross kernel. In this way, a more
-            // homogeneous dilation is performed, which is crucial for small,
-            // distorted checkers. Use the CROSS kernel first, since its action
-            // on the image is more subtle
-            cv::Mat kernel1
-            = cv::getStructuringElement( CV_SHAPE_CROSS, cv::Size( 3, 3 ), cv::Point( 1, 1 ) );
-            cv::Mat kernel2
-            = cv::getStructuringElement( CV_SHAPE_RECT, cv::Size( 3, 3 ), cv::Point( 1, 1 ) );
-
-            if ( dilations >= 1 )
-                cv::dilate( thresh_img, thresh_img, kernel1 );
-            if ( dilations >= 2 )
-                cv::dilate( thresh_img, thresh_img, kernel2 );
-            if ( dilations >= 3 )
-                cv::dilate( thresh_img, thresh_img, kernel1 );
-            if ( dilations >= 4 )
-                cv::dilate( thresh_img, thresh_img, kernel2 );
-            if ( dilations >= 5 )
-                cv::dilate( thresh_img, thresh_img, kernel1 );
-            if ( dilations >= 6 )
-                cv::dilate( thresh_img, thresh_img, kernel2 );
-
-            // In order to find rectangles that go to the edge, we draw a white
-            // line around the image edge. Otherwise FindContours will miss those
-            // clipped rectangle contours. The border color will be the image mean,
-            // because otherwise we risk screwing up filters like cvSmooth()
-            cv::rectangle( thresh_img,
-                           cv::Point( 0, 0 ),
-                           cv::Point( thresh_img.cols - 1, thresh_img.rows - 1 ),
-                           CV_RGB( 255, 255, 255 ),
-                           3,
-                           8 );
-
-            // Generate quadrangles in the following function
-            std::vector< ChessboardQuadPtr > quads;
-
-            generateQuads( quads, thresh_img, flags, dilations, true );
-            if ( quads.empty( ) )
+#pragma omp parallel for schedule( dynamic, 1 )
+        for ( int level = 0; level < numDilations; ++level )
+        {
+            // read and updated in the same critical section, the updates are a min
+            int first;
+#pragma omp critical( chessboard_first_found )
+            first = firstFound;
+            if ( level > first )
             {
                 continue;
             }
 
-            // The following function finds and assigns neighbor quads to every
-            // quadrangle in the immediate vicinity fulfilling certain
-            // prerequisites
-            findQuadNeighbors( quads, dilations );
-
-            // The connected quads will be organized in groups. The following loop
-            // increases a "group_idx" identifier.
-            // The function "findConnectedQuads assigns all connected quads
-            // a unique group ID.
-            // If more quadrangles were assigned to a given group (i.e. connected)
-            // than are expected by the input variable "patternSize", the
-            // function "cleanFoundConnectedQuads" erases the surplus
-            // quadrangles by minimizing the convex hull of the remaining pattern.
-
-            for ( int group_idx = 0;; ++group_idx )
+            if ( findBoardAtDilation(
+                 threshImgs[level], patternSize, flags, minDilations + level, levelCorners[level], levelSqrSize[level] ) )
             {
-                std::vector< ChessboardQuadPtr > quadGroup;
-
-                findConnectedQuads( quads, quadGroup, group_idx, dilations );
-
-                if ( quadGroup.empty( ) )
-                {
-                    break;
-                }
-
-                cleanFoundConnectedQuads( quadGroup, patternSize );
-
-                // The following function labels all corners of every quad
-                // with a row and column entry.
-                // "count" specifies the number of found quads in "quad_group"
-                // with group identifier "group_idx"
-                // The last parameter is set to "true", because this is the
-                // first function call and some initializations need to be
-                // made.
-                labelQuadGroup( quadGroup, patternSize, true );
-
-                found = checkQuadGroup( quadGroup, outputCorners, patternSize );
-
-                float sumDist = 0;
-                int total     = 0;
-
-                for ( int i = 0; i < int( outputCorners.size( ) ); ++i )
-                {
-                    int ni     = 0;
-                    float avgi = outputCorners.at( i )->meanDist( ni );
-                    sumDist += avgi * ni;
-                    total += ni;
-                }
-                prevSqrSize = lround( sumDist / std::max( total, 1 ) );
+#pragma omp critical( chessboard_first_found )
+                firstFound = std::min( firstFound, level );
+            }
+        }
 
-                if ( found && !checkBoardMonotony( outputCorners, patternSize ) )
-                {
-                    found = false;
-                }
+        // the square size of the last level searched, as the serial loop left it
+        int lastLevel = std::min( firstFound, numDilations - 1 );
+        for ( int level = lastLevel; level >= 0; --level )
+        {
+            if ( levelSqrSize[level] >= 0 )
+            {
+                prevSqrSize = levelSqrSize[level];
+                break;
             }
         }
+
+        if ( firstFound < numDilations )
+        {
+            outputCorners = levelCorners[firstFound];
+            found         = true;
+        }
     }
 
     if ( !found )
     {
         return false;
     }
-    else
+
+    corners.clear( );
+    corners.reserve( outputCorners.size( ) );
+    for ( size_t i = 0; i < outputCorners.size( ); ++i )
     {
-        corners.clear( );
-        corners.reserve( outputCorners.size( ) );
-        for ( size_t i = 0; i < outputCorners.size( ); ++i )
+        corners.push_back( outputCorners.at( i )->pt );
+    }
+
+    return true;
+}
+
+bool
+Chessboard::findBoardAtDilation( cv::Mat& threshImg,
+                                 const cv::Size& patternSize,
+                                 int flags,
+                                 int dilations,
+                                 std::vector< ChessboardCornerPtr >& outputCorners,
+                                 int& sqrSize )
+{
+    // In order to find rectangles that go to the edge, we draw a white
+    // line around the image edge. Otherwise FindContours will miss those
+    // clipped rectangle contours. The border color will be the image mean,
+    // because otherwise we risk screwing up filters like cvSmooth()
+    cv::rectangle( threshImg,
+                   cv::Point( 0, 0 ),
+                   cv::Point( threshImg.cols - 1, threshImg.rows - 1 ),
+                   CV_RGB( 255, 255, 255 ),
+                   3,
+                   8 );
+
+    // Generate quadrangles in the following function
+    std::vector< ChessboardQuadPtr > quads;
+
+    generateQuads( quads, threshImg, flags, dilations, true );
+    if ( quads.empty( ) )
+    {
+        return false;
+    }
+
+    // The following function finds and assigns neighbor quads to every
+    // quadrangle in the immediate vicinity fulfilling certain
+    // prerequisites
+    findQuadNeighbors( quads, dilations );
+
+    // The connected quads will be organized in groups. The following loop
+    // increases a "group_idx" identifier.
+    // The function "findConnectedQuads assigns all connected quads
+    // a unique group ID.
+    // If more quadrangles were assigned to a given group (i.e. connected)
+    // than are expected by the input variable "patternSize", the
+    // function "cleanFoundConnectedQuads" erases the surplus
+    // quadrangles by minimizing the convex hull of the remaining pattern.
+
+    bool found = false;
+    for ( int group_idx = 0;; ++group_idx )
+    {
+        std::vector< ChessboardQuadPtr > quadGroup;
+
+        findConnectedQuads( quads, quadGroup, group_idx, dilations );
+
+        if ( quadGroup.empty( ) )
         {
-            corners.push_back( outputCorners.at( i )->pt );
+            break;
         }
 
-        cv::cornerSubPix( image,
-                          corners,
-                          cv::Size( 11, 11 ),
-                          cv::Size( -1, -1 ),
-                          cv::TermCriteria( CV_TERMCRIT_EPS + CV_TERMCRIT_ITER, 30, 0.1 ) );
+        cleanFoundConnectedQuads( quadGroup, patternSize );
 
-        return true;
+        // The following function labels all corners of every quad
+        // with a row and column entry.
+        // "count" specifies the number of found quads in "quad_group"
+        // with group identifier "group_idx"
+        // The last parameter is set to "true", because this is the
+        // first function call and some initializations need to be
+        // made.
+        labelQuadGroup( quadGroup, patternSize, true );
+
+        found = checkQuadGroup( quadGroup, outputCorners, patternSize, threshImg.size( ) );
+
+        float sumDist = 0;
+        int total     = 0;
+
+        for ( int i = 0; i < int( outputCorners.size( ) ); ++i )
+        {
+            int ni     = 0;
+            float avgi = outputCorners.at( i )->meanDist( ni );
+            sumDist += avgi * ni;
+            total += ni;
+        }
+        sqrSize = lround( sumDist / std::max( total, 1 ) );
+
+        if ( found && !checkBoardMonotony( outputCorners, patternSize ) )
+        {
+            found = false;
+        }
     }
+
+    return found;
 }
 
 //===========================================================================
@@ -1297,7 +1383,8 @@ Chessboard::generateQuads( std::vector< ChessboardQuadPtr >& quads, cv::Mat& ima
 bool
 Chessboard::checkQuadGroup( std::vector< ChessboardQuadPtr >& quads,
                             std::vector< ChessboardCornerPtr >& corners,
-                            cv::Size patternSize )
+                            cv::Size patternSize,
+                            cv::Size imageSize )
 {
     // Initialize
     bool flagRow    = false;
@@ -1462,14 +1549,15 @@ Chessboard::checkQuadGroup( std::vector< ChessboardQuadPtr >& quads,
         return false;
     }
 
-    // check that no corners lie at image boundary
+    // check that no corners lie at the boundary of the image searched, which is
+    // the half resolution one in the coarse pass
     float border = 5.0f;
     for ( int i = 0; i < corners.size( ); ++i )
     {
         ChessboardCornerPtr& c = corners.at( i );
 
-        if ( c->pt.x < border || c->pt.x > mImage.cols - border || c->pt.y < border
-             || c->pt.y > mImage.rows - border )
+        if ( c->pt.x < border || c->pt.x > imageSize.width - border || c->pt.y < border
+             || c->pt.y > imageSize.height - border )
         {
             return false;
         }
@@ -0,0 +1,128 @@
+#include "camera_model/chessboard/ChessboardCornerCache.h"
+
+#include <boost/filesystem.hpp>
+#include <cstdio>
+#include <cstdlib>
+
+namespace camera_model
+{
+
+ChessboardCornerCache::ChessboardCornerCache( const std::string& filename )
+: m_filename( filename )
+{
+}
+
+uint64_t
+ChessboardCornerCache::key( const cv::Mat& image, cv::Size boardSize, bool useOpenCV )
+{
+    // 64 bit FNV-1a over the header and the pixels, row by row for ROIs
+    const uint64_t prime = 1099511628211ULL;
+    uint64_t hash        = 14695981039346656037ULL;
+
+    int header[6] = { image.cols, image.rows, image.type( ), boardSize.width, boardSize.height, useOpenCV };
+    const unsigned char* bytes = reinterpret_cast< const unsigned char* >( header );
+    for ( size_t i = 0; i < sizeof( header ); ++i )
+        hash = ( hash ^ bytes[i] ) * prime;
+
+    const size_t rowBytes = image.cols * image.elemSize( );
+    for ( int r = 0; r < image.rows; ++r )
+    {
+        const unsigned char* row = image.ptr< unsigned char >( r );
+        for ( size_t i = 0; i < rowBytes; ++i )
+            hash = ( hash ^ row[i] ) * prime;
+    }
+
+    return hash;
+}
+
+bool
+ChessboardCornerCache::find( uint64_t key, bool& found, std::vector< cv::Point2f >& corners ) const
+{
+    std::map< uint64_t, Entry >::const_iterator it = m_entries.find( key );
+    if ( it == m_entries.end( ) )
+    {
+        return false;
+    }
+
+    found   = it->second.found;
+    corners = it->second.corners;
+    return true;
+}
+
+void
+ChessboardCornerCache::insert( uint64_t key, bool found, const std::vector< cv::Point2f >& corners )
+{
+    Entry& entry  = m_entries[key];
+    entry.found   = found;
+    entry.corners = found ? corners : std::vector< cv::Point2f >( );
+}
+
+int
+ChessboardCornerCache::load( void )
+{
+    if ( m_filename.empty( ) || !boost::filesystem::exists( m_filename ) )
+    {
+        return 0;
+    }
+
+    cv::FileStorage fs( m_filename, cv::FileStorage::READ );
+    if ( !fs.isOpened( ) )
+    {
+        return 0;
+    }
+
+    int count         = 0;
+    cv::FileNode list = fs["boards"];
+    for ( cv::FileNodeIterator it = list.begin( ); it != list.end( ); ++it )
+    {
+        // the key is stored as hex, yaml integers are only 32 bit in cv::FileStorage
+        std::string hex;
+        int found;
+        std::vector< cv::Point2f > corners;
+        ( *it )["key"] >> hex;
+        ( *it )["found"] >> found;
+        ( *it )["corners"] >> corners;
+
+        insert( strtoull( hex.c_str( ), 0, 16 ), found != 0, corners );
+        ++count;
+    }
+
+    return count;
+}
+
+bool
+ChessboardCornerCache::save( void ) const
+{
+    if ( m_filename.empty( ) )
+    {
+        return false;
+    }
+
+    cv::FileStorage fs( m_filename, cv::FileStorage::WRITE );
+    if ( !fs.isOpened( ) )
+    {
+        return false;
+    }
+
+    fs << "boards"
+       << "[";
+    for ( std::map< uint64_t, Entry >::const_iterator it = m_entries.begin( ); it != m_entries.end( ); ++it )
+    {
+        char hex[17];
+        snprintf( hex, sizeof( hex ), "%016llx", ( unsigned long long )it->first );
+
+        fs << "{"
+           << "key" << std::string( hex ) << "found" << ( int )it->second.found << "corners"
+           << it->second.corners << "}";
+    }
+    fs << "]";
+
+    return true;
+}
+
+size_t
+ChessboardCornerCache::size( void ) const
+{
+    return m_entries.size( );
+}
+}
@@ -6,6 +6,7 @@ backward::SignalHandling sh;
 }
 
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
 #include <iomanip>
@@ -37,6 +38,7 @@ main( int argc, char** argv )
     bool viewResults;
     bool verbose;
     bool is_save_images;
+    bool useCornerCache;
     std::string result_images_save_folder;
 
     float resize_scale = 1.0;
@@ -65,6 +67,7 @@ main( int argc, char** argv )
         ( "verbose,v", value< bool >( &verbose )->default_value( true ), "Verbose output" )
         ( "save_result", value< bool >( &is_save_images )->default_value( true ), "save calibration result chessboard point." )
         ( "result_images_save_folder", value< std::string  >( &result_images_save_folder )->default_value( "calib_images" ), " calibration result images save folder." )
+        ( "corner-cache", value< bool >( &useCornerCache )->default_value( true ), "Reuse and save the detected corners in <camera-name>_chessboard_corners.yaml" )
         ( "resize-scale", value< float >( &resize_scale )->default_value( 1.0f ), "resize scale" )
         ( "cropper_width", value< int >( &cropper_size.width )->default_value( 0 ), "cropper image width" )
         ( "cropper_height", value< int >( &cropper_size.height )->default_value( 0 ), "cropper image height" )
@@ -232,29 +235,29 @@ main( int argc, char** argv )
     camera_model::CameraCalibration calibration( modelType, cameraName, frameSize, boardSize, squareSize );
     calibration.setVerbose( verbose );
 
-    std::vector< bool > chessboardFound( imageFilenames.size( ), false );
-
-    size_t image_index;
-#pragma omp parallel for private( image_index )
-    for ( image_index = 0; image_index < imageFilenames.size( ); ++image_index )
+    std::string cornerCacheFile = cameraName + "_chessboard_corners.yaml";
+    camera_model::ChessboardCornerCache cornerCache( cornerCacheFile );
+    if ( useCornerCache )
     {
-        std::string image_name = imageFilenames.at( image_index );
-
-        cv::Mat image = preprocess->do_preprocess( cv::imread( image_name, -1 ) );
+        int cachedCount = cornerCache.load( );
+        if ( cachedCount > 0 )
+        {
+            std::cerr << "# INFO: Read " << cachedCount << " chessboard detections from " << cornerCacheFile << std::endl;
+        }
+    }
 
-        camera_model::Chessboard chessboard( boardSize, image );
+    std::vector< bool > chessboardFound
+    = calibration.addChessboardImages( imageFilenames,
+                                       useOpenCV,
+                                       boost::bind( &cv_utils::fisheye::PreProcess::do_preprocess, preprocess, _1 ),
+                                       useCornerCache ? &cornerCache : 0 );
 
-        chessboard.findCorners( useOpenCV );
-        if ( chessboard.cornersFound( ) )
+    for ( size_t image_index = 0; image_index < imageFilenames.size( ); ++image_index )
+    {
+        if ( chessboardFound.at( image_index ) )
         {
             std::cerr << "# INFO: Detected chessboard in image " << image_index + 1 << ", "
                       << imageFilenames.at( image_index ) << std::endl;
-
-            calibration.addChessboardData( chessboard.getCorners( ) );
-            calibration.addImage( image, image_name );
-
-            cv::Mat sketch;
-            chessboard.getSketch( ).copyTo( sketch );
         }
         else
         {
@@ -262,7 +265,14 @@ main( int argc, char** argv )
                       << "# INFO: Did not detect chessboard in image: "
                       << imageFilenames.at( image_index ) << "\033[0m" << std::endl;
         }
-        chessboardFound.at( image_index ) = chessboard.cornersFound( );
+    }
+
+    std::cerr << "# INFO: Chessboard detection took " << std::fixed << std::setprecision( 3 )
+              << camera_model::timeInSeconds( ) - startTime_0 << " sec." << std::endl;
+
+    if ( useCornerCache && !cornerCache.save( ) )
+    {
+        std::cerr << "# WARNING: Cannot write " << cornerCacheFile << std::endl;
     }
 
     if ( calibration.sampleCount( ) < 1 )
@@ -0,0 +1,185 @@
+#include <boost/program_options.hpp>
+#include <iomanip>
+#include <iostream>
+#include <opencv2/core/core.hpp>
+
+#include "camera_model/camera_models/CameraFactory.h"
+#include "camera_model/camera_models/CataCamera.h"
+#include "camera_model/camera_models/EquidistantCamera.h"
+#include "camera_model/camera_models/FovCamera.h"
+#include "camera_model/camera_models/PinholeCamera.h"
+#include "camera_model/camera_models/PinholeFullCamera.h"
+#include "camera_model/camera_models/PolyFisheyeCamera.h"
+#include "camera_model/camera_models/ScaramuzzaCamera.h"
+#include "camera_model/camera_models/SplineCamera.h"
+#include "camera_model/gpl/gpl.h"
+
+using namespace camera_model;
+
+// average time of f over the iterations, in ms
+template< typename F >
+double
+timeIt( int iterations, F f )
+{
+    double startTime = timeInSeconds( );
+    for ( int i = 0; i < iterations; ++i )
+        f( );
+    return ( timeInSeconds( ) - startTime ) * 1000 / iterations;
+}
+
+// one camera of every model of CameraFactory, with plausible intrinsics for the image size
+std::vector< CameraPtr >
+syntheticCameras( cv::Size size )
+{
+    int w = size.width, h = size.height;
+    double cx = w / 2.0, cy = h / 2.0;
+    std::vector< CameraPtr > cameras;
+
+    PinholeCameraPtr pinhole( new PinholeCamera );
+    pinhole->setParameters( PinholeCamera::Parameters( "pinhole", w, h, -0.3, 0.1, 5e-4, -3e-4, 800, 800, cx, cy ) );
+    cameras.push_back( pinhole );
+
+    PinholeFullCameraPtr pinholeFull( new PinholeFullCamera );
+    pinholeFull->setParameters( PinholeFullCamera::Parameters(
+    "pinhole_full", w, h, -0.3, 0.1, 0.0, 0.0, 0.0, 0.0, 5e-4, -3e-4, 800, 800, cx, cy ) );
+    cameras.push_back( pinholeFull );
+
+    EquidistantCameraPtr equidistant( new EquidistantCamera );
+    equidistant->setParameters(
+    EquidistantCamera::Parameters( "kannala_brandt", w, h, -0.01, 0.002, 0.0, 0.0, 300, 300, cx, cy ) );
+    cameras.push_back( equidistant );
+
+    CataCameraPtr cata( new CataCamera );
+    cata->setParameters( CataCamera::Parameters( "mei", w, h, 1.5, -0.2, 0.05, 0.0, 0.0, 750, 750, cx, cy ) );
+    cameras.push_back( cata );
+
+    OCAMCameraPtr ocam( new OCAMCamera );
+    OCAMCamera::Parameters ocamParams;
+    ocamParams.cameraName( )  = "scaramuzza";
+    ocamParams.imageWidth( )  = w;
+    ocamParams.imageHeight( ) = h;
+    ocamParams.C( )           = 1.0;
+    ocamParams.center_x( )    = cx;
+    ocamParams.center_y( )    = cy;
+    ocamParams.poly( 0 )      = -300;
+    ocamParams.poly( 2 )      = 1.0 / 600;
+    ocam->setParameters( ocamParams );
+    cameras.push_back( ocam );
+
+    FovCameraPtr fov( new FovCamera );
+    fov->setParameters( FovCamera::Parameters( "fov", w, h, 0.9, 400, 400, cx, cy ) );
+    cameras.push_back( fov );
+
+    // both the root solver and the FastCalcTABLE path of the polynomial models
+    for ( int isFast = 0; isFast <= 1; ++isFast )
+    {
+        PolyFisheyeCameraPtr polyFisheye( new PolyFisheyeCamera );
+        polyFisheye->setParameters( PolyFisheyeCamera::Parameters( isFast ? "polyfisheye_fast" : "polyfisheye",
+                                                                   w, h, 0.01, -0.02, 0.002, 0.0, 0.0, 0.0, 0.0, 0.0,
+                                                                   300, 0.0, 300, cx, cy, isFast ) );
+        cameras.push_back( polyFisheye );
+
+        SplineCameraPtr spline( new SplineCamera );
+        spline->setParameters( SplineCamera::Parameters( isFast ? "spline_fast" : "spline", w, h, 0.01, -0.02,
+                                                         0.002, 0.0, 0.0, 0.0, 0.0, 0.0, 300, 0.0, 300, cx, cy, isFast ) );
+        cameras.push_back( spline );
+    }
+
+    return cameras;
+}
+
+int
+main( int argc, char** argv )
+{
+    std::vector< std::string > cameraFiles;
+    int step;
+    int numPoints;
+    int iterations;
+    cv::Size imageSize;
+
+    /* clang-format off */
+    using namespace boost::program_options;
+    boost::program_options::options_description desc(
+    "Back projection benchmark: liftProjective, liftProjectiveBatch, and liftProjectiveBatch with a lift table.\n"
+    "Without camera files, one synthetic camera of every model is used." );
+    desc.add_options( )
+        ( "help", "produce help message" )
+        ( "camera", value< std::vector< std::string > >( &cameraFiles )->multitoken( ), "camera_model yaml files" )
+        ( "step,s", value< int >( &step )->default_value( 1 ), "pixels between the nodes of the lift table" )
+        ( "points,p", value< int >( &numPoints )->default_value( 500 ), "random image points per iteration" )
+        ( "iterations,n", value< int >( &iterations )->default_value( 200 ), "iterations of each method" )
+        ( "width,w", value< int >( &imageSize.width )->default_value( 1280 ), "synthetic image width" )
+        ( "height,h", value< int >( &imageSize.height )->default_value( 1024 ), "synthetic image height" )
+        ;
+    /* clang-format on */
+
+    boost::program_options::variables_map vm;
+    boost::program_options::store( boost::program_options::parse_command_line( argc, argv, desc ), vm );
+    boost::program_options::notify( vm );
+
+    if ( vm.count( "help" ) )
+    {
+        std::cout << desc << std::endl;
+        return 1;
+    }
+
+    std::vector< CameraPtr > cameras;
+    if ( cameraFiles.empty( ) )
+        cameras = syntheticCameras( imageSize );
+    for ( size_t i = 0; i < cameraFiles.size( ); ++i )
+    {
+        CameraPtr cam = CameraFactory::instance( )->generateCameraFromYamlFile( cameraFiles[i] );
+        if ( cam.get( ) == 0 )
+        {
+            std::cerr << "# ERROR: Cannot read " << cameraFiles[i] << std::endl;
+            return 1;
+        }
+        cameras.push_back( cam );
+    }
+
+    std::cout << std::fixed << std::setprecision( 4 );
+    std::cout << "# INFO: " << numPoints << " points, " << iterations << " iterations, table step " << step << "\n";
+    std::cout << "# INFO: times in us per point, error in degrees\n";
+    std::cout << "# INFO: " << std::setw( 18 ) << "camera" << std::setw( 10 ) << "single" << std::setw( 10 )
+              << "batch" << std::setw( 10 ) << "table" << std::setw( 12 ) << "build ms" << std::setw( 12 )
+              << "max err" << "\n";
+
+    cv::RNG rng( 0 );
+    for ( size_t c = 0; c < cameras.size( ); ++c )
+    {
+        CameraPtr cam = cameras[c];
+        cam->releaseLiftTable( );
+
+        std::vector< cv::Point2f > points( numPoints );
+        for ( int i = 0; i < numPoints; ++i )
+            points[i] = cv::Point2f( rng.uniform( 0.0f, ( float )cam->imageWidth( ) - 1 ),
+                                     rng.uniform( 0.0f, ( float )cam->imageHeight( ) - 1 ) );
+
+        std::vector< Eigen::Vector3d > reference( numPoints ), rays( numPoints );
+        double t_single = timeIt( iterations, [&]( ) {
+            for ( int i = 0; i < numPoints; ++i )
+                cam->liftProjective( Eigen::Vector2d( points[i].x, points[i].y ), reference[i] );
+        } );
+        double t_batch = timeIt( iterations, [&]( ) { cam->liftProjectiveBatch( &points[0], &rays[0], numPoints ); } );
+        reference = rays;
+
+        double t_build = timeIt( 1, [&]( ) { cam->initLiftTable( step ); } );
+        double t_table = timeIt( iterations, [&]( ) { cam->liftProjectiveBatch( &points[0], &rays[0], numPoints ); } );
+
+        // pixels whose ray is not defined, e.g. outside the image circle, are skipped
+        double maxError = 0.0;
+        for ( int i = 0; i < numPoints; ++i )
+        {
+            double cosAngle = reference[i].dot( rays[i] );
+            if ( cosAngle == cosAngle )
+                maxError = std::max( maxError, std::acos( std::min( cosAngle, 1.0 ) ) );
+        }
+
+        std::cout << "# INFO: " << std::setw( 18 ) << cam->cameraName( ) << std::setw( 10 )
+                  << t_single * 1000 / numPoints << std::setw( 10 ) << t_batch * 1000 / numPoints << std::setw( 10 )
+                  << t_table * 1000 / numPoints << std::setw( 12 ) << t_build << std::setw( 12 )
+                  << maxError * 180 / M_PI << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+/**
+ * Header only (error state) Extended Kalman Filter core for the history/ estimators
+ * Sizes are template parameters, so the covariance, the jacobians and every temporary
+ * are fixed size Eigen matrices: predict and update never touch the heap.
+ *
+ * The filter only keeps the covariance of the error state. The state itself stays in
+ * the node, since it may not be a vector space (e.g. a quaternion with a 3 dof error);
+ * update returns the correction dx for the node to inject.
+ */
+#ifndef EKF_CORE_EKF_H
+#define EKF_CORE_EKF_H
+
+#include <Eigen/Core>
+#include <Eigen/Cholesky>
+
+namespace ekf_core
+{
+
+/**
+ * @tparam N error state dimension
+ */
+template<int N>
+class Ekf
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    typedef Eigen::Matrix<double, N, 1> StateVector;
+    typedef Eigen::Matrix<double, N, N> StateMatrix;
+
+    Ekf() : P(StateMatrix::Identity()) {}
+
+    /**
+     * Covariance propagation with the process noise in its own space
+     *      P = F * P * F' + V * Q * V'
+     * @param F discrete transition jacobian, I + dt * A
+     * @param V discrete noise jacobian, dt * U
+     * @param Q process noise covariance, NU x NU
+     */
+    template<int NU>
+    void predict(const StateMatrix &F,
+                 const Eigen::Matrix<double, N, NU> &V,
+                 const Eigen::Matrix<double, NU, NU> &Q)
+    {
+        Eigen::Matrix<double, N, NU> VQ;
+        VQ.noalias() = V * Q;
+
+        FP.noalias() = F * P;
+        P.noalias() = FP * F.transpose();
+        P.noalias() += VQ * V.transpose();
+        symmetrize();
+    }
+
+    /**
+     * Covariance propagation with the process noise already in the state space
+     *      P = F * P * F' + Q
+     */
+    void predict(const StateMatrix &F, const StateMatrix &Q)
+    {
+        FP.noalias() = F * P;
+        P.noalias() = FP * F.transpose();
+        P += Q;
+        symmetrize();
+    }
+
+    /**
+     * Joseph form update, which keeps P symmetric positive semi-definite
+     *      S  = H * P * H' + R
+     *      K  = P * H' * S^-1, solved with a Cholesky factorization of S
+     *      dx = K * r
+     *      P  = (I - K * H) * P * (I - K * H)' + K * R * K'
+     * @param H measurement jacobian, M x N
+     * @param r residual, z - h(x)
+     * @param R measurement noise covariance, M x M
+     * @param dx correction of the error state, to be injected by the caller
+     * @return false when S is not positive definite, P and dx are left untouched
+     */
+    template<int M>
+    bool update(const Eigen::Matrix<double, M, N> &H,
+                const Eigen::Matrix<double, M, 1> &r,
+                const Eigen::Matrix<double, M, M> &R,
+                StateVector &dx)
+    {
+        Eigen::Matrix<double, M, N> HP;
+        HP.noalias() = H * P;
+        Eigen::Matrix<double, M, M> S = R;
+        S.noalias() += HP * H.transpose();
+
+        Eigen::LLT<Eigen::Matrix<double, M, M> > llt(S);
+        if (llt.info() != Eigen::Success) {
+            return false;
+        }
+
+        // P and S are symmetric, so K' = S^-1 * H * P
+        Eigen::Matrix<double, M, N> Kt = llt.solve(HP);
+        dx.noalias() = Kt.transpose() * r;
+
+        IKH.setIdentity();
+        IKH.noalias() -= Kt.transpose() * H;
+        Eigen::Matrix<double, N, M> KR;
+        KR.noalias() = Kt.transpose() * R;
+
+        FP.noalias() = IKH * P;
+        P.noalias() = FP * IKH.transpose();
+        P.noalias() += KR * Kt;
+        symmetrize();
+        return true;
+    }
+
+    /**
+     * Squared Mahalanobis distance of the residual, r' * S^-1 * r, for chi-square gating
+     * @return a negative value when S is not positive definite
+     */
+    template<int M>
+    double mahalanobis(const Eigen::Matrix<double, M, N> &H,
+                       const Eigen::Matrix<double, M, 1> &r,
+                       const Eigen::Matrix<double, M, M> &R) const
+    {
+        Eigen::Matrix<double, M, M> S = R;
+        S.noalias() += H * P * H.transpose();
+
+        Eigen::LLT<Eigen::Matrix<double, M, M> > llt(S);
+        if (llt.info() != Eigen::Success) {
+            return -1.0;
+        }
+        return r.dot(llt.solve(r));
+    }
+
+    StateMatrix P; // error state covariance
+
+private:
+    void symmetrize()
+    {
+        FP = 0.5 * (P + P.transpose());
+        P = FP;
+    }
+
+    // scratch for the products with P
+    StateMatrix FP;
+    StateMatrix IKH;
+};
+
+} // namespace ekf_core
+
+#endif // EKF_CORE_EKF_H
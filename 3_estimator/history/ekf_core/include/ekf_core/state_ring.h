@@ -0,0 +1,254 @@
+/**
+ * Timestamped state / covariance history for out-of-sequence (delayed) measurements
+ *
+ * Every propagation step is pushed into a ring preallocated at construction, together with
+ * its input and its transition matrix. A delayed measurement is found by binary search on
+ * the stamps and applied to the state of its time, then carried to the present, either
+ *      - REPROPAGATE: by running the propagation again over the inputs after it, bounded by
+ *        max_repropagation steps, beyond which CUMULATIVE is used, or
+ *      - CUMULATIVE: without propagation, with the cumulative transition Psi_j = F_j * .. * F_1
+ *        kept with every entry, so that Phi(j, k) = Psi_j * Psi_k^-1. The correction of the
+ *        past state and the covariance reduction are mapped to each later entry, which is exact
+ *        for a linear system, and first order otherwise.
+ */
+#ifndef EKF_CORE_STATE_RING_H
+#define EKF_CORE_STATE_RING_H
+
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Cholesky>
+#include <Eigen/LU>
+#include <Eigen/StdVector>
+#include "ekf_core/ekf.h"
+
+namespace ekf_core
+{
+
+enum OosmMode
+{
+    REPROPAGATE,
+    CUMULATIVE
+};
+
+/**
+ * @tparam NX nominal state dimension, e.g. 16 with a quaternion
+ * @tparam N error state dimension
+ * @tparam NI propagation input dimension, e.g. imu reading
+ */
+template<int NX, int N, int NI>
+class StateRing
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    typedef Eigen::Matrix<double, NX, 1> State;
+    typedef Eigen::Matrix<double, N, 1> StateVector;
+    typedef Eigen::Matrix<double, N, N> StateMatrix;
+    typedef Eigen::Matrix<double, NI, 1> Input;
+
+    struct Entry
+    {
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+        double t;
+        State x;
+        StateMatrix P;
+        Input u;        // input of the propagation from the previous entry to this one
+        StateMatrix F;  // transition from the previous entry to this one
+        StateMatrix Psi; // cumulative transition since the last rebase
+    };
+
+    explicit StateRing(int capacity = 400)
+        : mode(REPROPAGATE), max_repropagation(capacity),
+          entries(capacity), head(0), count(0), since_rebase(0)
+    {
+    }
+
+    void clear()
+    {
+        head = 0;
+        count = 0;
+        since_rebase = 0;
+    }
+
+    int size() const { return count; }
+    int capacity() const { return (int)entries.size(); }
+    bool empty() const { return count == 0; }
+
+    /**
+     * @param i 0 for the oldest entry, size() - 1 for the newest
+     */
+    Entry &at(int i) { return entries[index(i)]; }
+    const Entry &at(int i) const { return entries[index(i)]; }
+    Entry &back() { return at(count - 1); }
+    const Entry &back() const { return at(count - 1); }
+
+    /**
+     * Save the state after a propagation step, overwriting the oldest entry when full
+     * @param F transition from the previous entry, identity for the first one
+     */
+    void push(double t, const State &x, const StateMatrix &P, const Input &u, const StateMatrix &F)
+    {
+        if (count < capacity()) {
+            ++count;
+        }
+        else {
+            head = (head + 1) % capacity();
+        }
+        Entry &e = at(count - 1);
+        e.t = t;
+        e.x = x;
+        e.P = P;
+        e.u = u;
+        e.F = F;
+        if (count == 1) {
+            e.Psi.setIdentity();
+        }
+        else {
+            e.Psi.noalias() = F * at(count - 2).Psi;
+        }
+
+        // keep Psi well conditioned, relative to the oldest entry
+        if (++since_rebase >= capacity()) {
+            rebase();
+        }
+    }
+
+    /**
+     * Binary search of the stamps
+     * @return the newest entry not after t, -1 when t is older than the ring
+     */
+    int find(double t) const
+    {
+        if (count == 0 || t < at(0).t) {
+            return -1;
+        }
+        int lo = 0, hi = count - 1;
+        while (lo < hi) {
+            int mid = (lo + hi + 1) / 2;
+            if (at(mid).t <= t) {
+                lo = mid;
+            }
+            else {
+                hi = mid - 1;
+            }
+        }
+        return lo;
+    }
+
+    /**
+     * Update with a measurement of time t, at the state of that time, and bring the
+     * correction to every later entry. The newest entry is the corrected present.
+     * @param t measurement stamp
+     * @param measure functor (const State &x, Matrix<M, N> &H, Matrix<M, 1> &r),
+     *                jacobian and residual z - h(x) at the past state
+     * @param R measurement noise covariance
+     * @param inject functor (State &x, const StateVector &dx), error state injection
+     * @param propagate functor (const Entry &previous, Entry &e), which recomputes e.x, e.P
+     *                  and e.F from previous with e.u and e.t, for REPROPAGATE
+     * @return false when t is older than the ring or the innovation covariance is not
+     *         positive definite
+     */
+    template<int M, class Measure, class Inject, class Propagate>
+    bool update(double t,
+                Measure measure,
+                const Eigen::Matrix<double, M, M> &R,
+                Inject inject,
+                Propagate propagate)
+    {
+        int k = find(t);
+        if (k < 0) {
+            return false;
+        }
+        Entry &past = at(k);
+
+        Eigen::Matrix<double, M, N> H;
+        Eigen::Matrix<double, M, 1> r;
+        measure(past.x, H, r);
+
+        int later = count - 1 - k;
+        if (mode == REPROPAGATE && later <= max_repropagation) {
+            StateVector dx;
+            ekf.P = past.P;
+            if (!ekf.update(H, r, R, dx)) {
+                return false;
+            }
+            past.P = ekf.P;
+            inject(past.x, dx);
+
+            for (int j = k + 1; j < count; ++j) {
+                Entry &e = at(j);
+                const Entry &previous = at(j - 1);
+                propagate(previous, e);
+                e.Psi.noalias() = e.F * previous.Psi;
+            }
+            return true;
+        }
+
+        // S = L * L', B = L^-1 * H * P, then K * S * K' = B' * B and K * r = B' * L^-1 * r
+        Eigen::Matrix<double, M, N> HP;
+        HP.noalias() = H * past.P;
+        Eigen::Matrix<double, M, M> S = R;
+        S.noalias() += HP * H.transpose();
+        Eigen::LLT<Eigen::Matrix<double, M, M> > llt(S);
+        if (llt.info() != Eigen::Success) {
+            return false;
+        }
+        Eigen::Matrix<double, M, N> B = llt.matrixL().solve(HP);
+        Eigen::Matrix<double, M, 1> w = llt.matrixL().solve(r);
+
+        // in the coordinates of the last rebase: Phi(j, k) * v = Psi_j * (Psi_k^-1 * v)
+        Eigen::PartialPivLU<StateMatrix> lu(past.Psi);
+        Eigen::Matrix<double, N, M> C = lu.solve(B.transpose());
+        StateVector c = C * w;
+
+        StateVector dx;
+        Eigen::Matrix<double, N, M> E;
+        dx.noalias() = B.transpose() * w;
+        inject(past.x, dx);
+        past.P.noalias() -= B.transpose() * B;
+        for (int j = k + 1; j < count; ++j) {
+            Entry &e = at(j);
+            dx.noalias() = e.Psi * c;
+            inject(e.x, dx);
+            E.noalias() = e.Psi * C;
+            e.P.noalias() -= E * E.transpose();
+        }
+        return true;
+    }
+
+    OosmMode mode;
+    int max_repropagation; // steps, beyond which CUMULATIVE is used
+
+private:
+    int index(int i) const { return (head + i) % capacity(); }
+
+    /**
+     * Psi_i = Psi_i * Psi_0^-1, so that the oldest entry has Psi = I
+     */
+    void rebase()
+    {
+        since_rebase = 0;
+        if (count == 0) {
+            return;
+        }
+        Eigen::PartialPivLU<StateMatrix> lu(at(0).Psi.transpose());
+        for (int i = count - 1; i >= 0; --i) {
+            // Psi_i * Psi_0^-1 = (Psi_0^-T * Psi_i')'
+            tmp = lu.solve(at(i).Psi.transpose());
+            at(i).Psi = tmp.transpose();
+        }
+    }
+
+    std::vector<Entry, Eigen::aligned_allocator<Entry> > entries;
+    int head;  // oldest entry
+    int count;
+    int since_rebase;
+
+    Ekf<N> ekf; // past update of REPROPAGATE
+    StateMatrix tmp;
+};
+
+} // namespace ekf_core
+
+#endif // EKF_CORE_STATE_RING_H
@@ -0,0 +1,163 @@
+/**
+ * Microbenchmark of the ekf_core filter against the dynamic size filters it replaced
+ * in visual_ekf, ekf_uwb and prediction_kf: latency and heap allocations per predict
+ * and per update, for each state / noise / measurement size used by the nodes.
+ *
+ * usage: ekf_core_benchmark [iterations]
+ */
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <chrono>
+#include <Eigen/Dense>
+#include "ekf_core/ekf.h"
+
+using namespace std;
+using namespace Eigen;
+
+// Eigen allocates with malloc, so count every malloc of the process (glibc)
+static long alloc_count = 0;
+
+extern "C" void *__libc_malloc(size_t size);
+
+extern "C" void *malloc(size_t size)
+{
+    ++alloc_count;
+    return __libc_malloc(size);
+}
+
+struct Result
+{
+    double predict_us, update_us;
+    double predict_allocs, update_allocs;
+};
+
+/**
+ * The filter of the nodes before ekf_core, e.g. visual_ekf_node_translation_with_bias.cpp:
+ * jacobians assembled in MatrixXd every call, and the gain from the explicit inverse of S
+ */
+static Result run_dynamic(int n, int nu, int m, int iterations, MatrixXd &P_out)
+{
+    srand(0);
+    MatrixXd A = 0.1 * MatrixXd::Random(n, n) - MatrixXd::Identity(n, n); // stable
+    MatrixXd U = MatrixXd::Random(n, nu);
+    MatrixXd C = MatrixXd::Random(m, n);
+    MatrixXd R = 0.01 * MatrixXd::Identity(nu, nu);
+    MatrixXd Q = 0.1 * MatrixXd::Identity(m, m);
+    VectorXd x = VectorXd::Zero(n);
+    MatrixXd P = MatrixXd::Identity(n, n);
+    VectorXd z = VectorXd::Ones(m);
+    const double dt = 0.0025;
+
+    Result result;
+    long allocs = alloc_count;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        MatrixXd F, V;
+        F = MatrixXd::Identity(n, n) + dt * A;
+        V = dt * U;
+        P = F * P * F.transpose() + V * R * V.transpose();
+    }
+    result.predict_us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / iterations;
+    result.predict_allocs = double(alloc_count - allocs) / iterations;
+
+    // every update starts from the same prior
+    MatrixXd P_prior = P;
+    allocs = alloc_count;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        P = P_prior;
+        MatrixXd K(n, m);
+        K = P * C.transpose() * (C * P * C.transpose() + Q).inverse();
+        VectorXd r = z - C * x;
+        VectorXd _r = K * r;
+        x += 1e-6 * _r;
+        P = P - K * C * P;
+    }
+    result.update_us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / iterations;
+    result.update_allocs = double(alloc_count - allocs) / iterations;
+
+    P_out = P;
+    return result;
+}
+
+/**
+ * The same filter on ekf_core
+ */
+template<int N, int NU, int M>
+static Result run_fixed(int iterations, MatrixXd &P_out)
+{
+    srand(0);
+    Matrix<double, N, N> A = 0.1 * Matrix<double, N, N>::Random() - Matrix<double, N, N>::Identity();
+    Matrix<double, N, NU> U = Matrix<double, N, NU>::Random();
+    Matrix<double, M, N> C = Matrix<double, M, N>::Random();
+    Matrix<double, NU, NU> R = 0.01 * Matrix<double, NU, NU>::Identity();
+    Matrix<double, M, M> Q = 0.1 * Matrix<double, M, M>::Identity();
+    Matrix<double, N, 1> x = Matrix<double, N, 1>::Zero();
+    Matrix<double, M, 1> z = Matrix<double, M, 1>::Ones();
+    const double dt = 0.0025;
+    ekf_core::Ekf<N> ekf;
+
+    Result result;
+    long allocs = alloc_count;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        Matrix<double, N, N> F = Matrix<double, N, N>::Identity() + dt * A;
+        Matrix<double, N, NU> V = dt * U;
+        ekf.predict(F, V, R);
+    }
+    result.predict_us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / iterations;
+    result.predict_allocs = double(alloc_count - allocs) / iterations;
+
+    Matrix<double, N, N> P_prior = ekf.P;
+    allocs = alloc_count;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        ekf.P = P_prior;
+        Matrix<double, N, 1> dx;
+        Matrix<double, M, 1> r = z - C * x;
+        ekf.update(C, r, Q, dx);
+        x += 1e-6 * dx;
+    }
+    result.update_us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / iterations;
+    result.update_allocs = double(alloc_count - allocs) / iterations;
+
+    P_out = ekf.P;
+    return result;
+}
+
+template<int N, int NU, int M>
+static void compare(const char *name, int iterations)
+{
+    MatrixXd P_dynamic, P_fixed;
+    Result d = run_dynamic(N, NU, M, iterations, P_dynamic);
+    Result f = run_fixed<N, NU, M>(iterations, P_fixed);
+
+    cout << setw(34) << name
+         << setw(10) << d.predict_us << setw(10) << f.predict_us
+         << setw(10) << d.update_us << setw(10) << f.update_us
+         << setw(8) << d.predict_allocs + d.update_allocs << setw(8) << f.predict_allocs + f.update_allocs
+         << setw(12) << scientific << setprecision(1) << (P_dynamic - P_fixed).cwiseAbs().maxCoeff() / P_dynamic.cwiseAbs().maxCoeff()
+         << fixed << setprecision(3) << endl;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = (argc > 1) ? atoi(argv[1]) : 100000;
+
+    cout << "iterations " << iterations << ", times in us per call, allocations per predict + update" << endl;
+    cout << fixed << setprecision(3);
+    cout << setw(34) << "filter (N, noise, measurement)"
+         << setw(10) << "pred dyn" << setw(10) << "pred fix"
+         << setw(10) << "upd dyn" << setw(10) << "upd fix"
+         << setw(8) << "new dyn" << setw(8) << "new fix"
+         << setw(12) << "P rel diff" << endl;
+
+    compare<15, 12, 6>("visual_ekf / ekf_uwb 16 (15,12,6)", iterations);
+    compare<8, 6, 3>("ekf_uwb 2D (8,6,3)", iterations);
+    compare<6, 6, 3>("prediction_kf global (6,6,3)", iterations);
+    compare<6, 3, 3>("visual_ekf wo bias (6,3,3)", iterations);
+    compare<3, 3, 3>("visual_ekf rotation (3,3,3)", iterations);
+
+    return 0;
+}
@@ -0,0 +1,254 @@
+/**
+ * Synthetic delayed measurement test of the state ring
+ * a constant acceleration target, integrated by a 400 Hz accelerometer, with 30 Hz position
+ * measurements arriving 30 to 60 ms late; the filter with the delayed measurements must end
+ * where the filter that gets each measurement on time ends
+ */
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "ekf_core/state_ring.h"
+
+namespace
+{
+typedef ekf_core::StateRing<6, 6, 3> Ring;
+typedef Eigen::Matrix<double, 6, 1> Vector6d;
+typedef Eigen::Matrix<double, 6, 6> Matrix6d;
+
+const double imu_rate = 400.0;
+const double camera_rate = 30.0;
+const double duration = 10.0;
+
+struct Measurement
+{
+    double stamp;
+    double arrival;
+    Eigen::Vector3d z;
+};
+
+// x = [position; velocity], u = acceleration
+struct Model
+{
+    Eigen::Matrix3d Qa = 0.1 * Eigen::Matrix3d::Identity();
+    Eigen::Matrix3d R = 0.01 * Eigen::Matrix3d::Identity();
+
+    void propagate(const Vector6d &x_prev, const Matrix6d &P_prev, const Eigen::Vector3d &a, double dt,
+                   Vector6d &x, Matrix6d &P, Matrix6d &F) const
+    {
+        F.setIdentity();
+        F.topRightCorner<3, 3>() = dt * Eigen::Matrix3d::Identity();
+        Eigen::Matrix<double, 6, 3> V;
+        V << 0.5 * dt * dt * Eigen::Matrix3d::Identity(), dt * Eigen::Matrix3d::Identity();
+
+        x = F * x_prev + V * a;
+        P = F * P_prev * F.transpose() + V * Qa * V.transpose();
+    }
+
+    void measure(const Vector6d &x, const Eigen::Vector3d &z,
+                 Eigen::Matrix<double, 3, 6> &H, Eigen::Vector3d &r) const
+    {
+        H.setZero();
+        H.leftCols<3>().setIdentity();
+        r = z - H * x;
+    }
+};
+
+struct Sequence
+{
+    std::vector<double> t;
+    std::vector<Eigen::Vector3d> a;
+    std::vector<Measurement> measurements; // in order of arrival
+
+    explicit Sequence(double min_delay, double max_delay)
+    {
+        std::mt19937 rng(42);
+        std::normal_distribution<double> acc_noise(0.0, 0.3), pos_noise(0.0, 0.1);
+        std::uniform_real_distribution<double> delay(min_delay, max_delay);
+
+        Eigen::Vector3d p(1, 2, 3), v(0.5, 0, -0.2), acc(0.1, -0.2, 0.05);
+        double next_camera = 0.01;
+        for (int i = 0; i <= duration * imu_rate; ++i) {
+            double time = i / imu_rate;
+            t.push_back(time);
+            a.push_back(acc + Eigen::Vector3d(acc_noise(rng), acc_noise(rng), acc_noise(rng)));
+            if (time >= next_camera && time + max_delay < duration) {
+                Measurement m;
+                m.stamp = time + 0.001;
+                m.arrival = m.stamp + delay(rng);
+                m.z = p + Eigen::Vector3d(pos_noise(rng), pos_noise(rng), pos_noise(rng));
+                measurements.push_back(m);
+                next_camera += 1.0 / camera_rate;
+            }
+            p += v / imu_rate + 0.5 * acc / (imu_rate * imu_rate);
+            v += acc / imu_rate;
+        }
+        std::stable_sort(measurements.begin(), measurements.end(),
+                         [](const Measurement &l, const Measurement &r) { return l.arrival < r.arrival; });
+    }
+};
+
+/**
+ * Every measurement applied on time, after the propagation to the last imu stamp before it
+ */
+void runOnTime(const Model &model, const Sequence &seq, Vector6d &x, Matrix6d &P)
+{
+    std::vector<Measurement> by_stamp = seq.measurements;
+    std::sort(by_stamp.begin(), by_stamp.end(),
+              [](const Measurement &l, const Measurement &r) { return l.stamp < r.stamp; });
+
+    ekf_core::Ekf<6> ekf;
+    x.setZero();
+    size_t m = 0;
+    for (size_t i = 0; i < seq.t.size(); ++i) {
+        Matrix6d F;
+        if (i > 0) {
+            Vector6d x_prev = x;
+            model.propagate(x_prev, ekf.P, seq.a[i], seq.t[i] - seq.t[i - 1], x, ekf.P, F);
+        }
+        double next = (i + 1 < seq.t.size()) ? seq.t[i + 1] : 1e9;
+        for (; m < by_stamp.size() && by_stamp[m].stamp < next; ++m) {
+            Eigen::Matrix<double, 3, 6> H;
+            Eigen::Vector3d r;
+            Vector6d dx;
+            model.measure(x, by_stamp[m].z, H, r);
+            ASSERT_TRUE(ekf.update(H, r, model.R, dx));
+            x += dx;
+        }
+    }
+    P = ekf.P;
+}
+
+/**
+ * The measurements applied when they arrive, through the ring
+ * @return the time spent in the delayed updates, in ms
+ */
+double runDelayed(const Model &model, const Sequence &seq, ekf_core::OosmMode mode, Vector6d &x, Matrix6d &P)
+{
+    Ring ring(100);
+    ring.mode = mode;
+
+    auto measure_with = [&model](const Eigen::Vector3d &z) {
+        return [&model, z](const Vector6d &x, Eigen::Matrix<double, 3, 6> &H, Eigen::Vector3d &r) {
+            model.measure(x, z, H, r);
+        };
+    };
+    auto inject = [](Vector6d &x, const Vector6d &dx) { x += dx; };
+    auto propagate = [&model](const Ring::Entry &previous, Ring::Entry &e) {
+        model.propagate(previous.x, previous.P, e.u, e.t - previous.t, e.x, e.P, e.F);
+    };
+
+    double update_ms = 0.0;
+    size_t m = 0;
+    for (size_t i = 0; i < seq.t.size(); ++i) {
+        if (ring.empty()) {
+            ring.push(seq.t[i], Vector6d::Zero(), Matrix6d::Identity(), seq.a[i], Matrix6d::Identity());
+        }
+        else {
+            const Ring::Entry &back = ring.back();
+            Vector6d x_new;
+            Matrix6d P_new, F;
+            model.propagate(back.x, back.P, seq.a[i], seq.t[i] - back.t, x_new, P_new, F);
+            ring.push(seq.t[i], x_new, P_new, seq.a[i], F);
+        }
+
+        for (; m < seq.measurements.size() && seq.measurements[m].arrival <= seq.t[i]; ++m) {
+            auto start = std::chrono::steady_clock::now();
+            EXPECT_TRUE(ring.update(seq.measurements[m].stamp, measure_with(seq.measurements[m].z),
+                                    model.R, inject, propagate));
+            update_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+    x = ring.back().x;
+    P = ring.back().P;
+    return update_ms;
+}
+} // namespace
+
+TEST(StateRing, FindsTheEntryBeforeTheStamp)
+{
+    Ring ring(8);
+    for (int i = 0; i < 20; ++i) {
+        ring.push(i, Vector6d::Zero(), Matrix6d::Identity(), Eigen::Vector3d::Zero(), Matrix6d::Identity());
+    }
+    // entries 12 to 19 are left
+    ASSERT_EQ(8, ring.size());
+    EXPECT_EQ(-1, ring.find(11.5));
+    EXPECT_EQ(0, ring.find(12.0));
+    EXPECT_EQ(0, ring.find(12.5));
+    EXPECT_EQ(3, ring.find(15.5));
+    EXPECT_EQ(7, ring.find(19.0));
+    EXPECT_EQ(7, ring.find(50.0));
+    EXPECT_DOUBLE_EQ(19.0, ring.back().t);
+}
+
+TEST(StateRing, RepropagationMatchesOnTimeFilter)
+{
+    Model model;
+    Sequence seq(0.03, 0.06);
+
+    Vector6d x_ref, x;
+    Matrix6d P_ref, P;
+    runOnTime(model, seq, x_ref, P_ref);
+    runDelayed(model, seq, ekf_core::REPROPAGATE, x, P);
+
+    EXPECT_LT((x - x_ref).cwiseAbs().maxCoeff(), 1e-9);
+    EXPECT_LT((P - P_ref).cwiseAbs().maxCoeff(), 1e-9);
+}
+
+TEST(StateRing, CumulativeTransitionMatchesOnTimeFilter)
+{
+    Model model;
+    Sequence seq(0.03, 0.06);
+
+    Vector6d x_ref, x;
+    Matrix6d P_ref, P;
+    runOnTime(model, seq, x_ref, P_ref);
+    runDelayed(model, seq, ekf_core::CUMULATIVE, x, P);
+
+    // exact for this linear model, up to the rebases of the cumulative transition
+    EXPECT_LT((x - x_ref).cwiseAbs().maxCoeff(), 1e-6);
+    EXPECT_LT((P - P_ref).cwiseAbs().maxCoeff(), 1e-6);
+}
+
+TEST(StateRing, RejectsMeasurementsOlderThanTheRing)
+{
+    Model model;
+    Sequence seq(0.3, 0.4); // longer than the 100 entries of the ring, 250 ms
+
+    Ring ring(100);
+    for (int i = 0; i < 200; ++i) {
+        ring.push(seq.t[i], Vector6d::Zero(), Matrix6d::Identity(), seq.a[i], Matrix6d::Identity());
+    }
+    auto measure = [&model](const Vector6d &x, Eigen::Matrix<double, 3, 6> &H, Eigen::Vector3d &r) {
+        model.measure(x, Eigen::Vector3d::Zero(), H, r);
+    };
+    auto inject = [](Vector6d &x, const Vector6d &dx) { x += dx; };
+    auto propagate = [](const Ring::Entry &, Ring::Entry &) {};
+
+    EXPECT_FALSE(ring.update(seq.t[50], measure, model.R, inject, propagate));
+    EXPECT_TRUE(ring.update(seq.t[150], measure, model.R, inject, propagate));
+}
+
+TEST(StateRing, CpuTime)
+{
+    Model model;
+    Sequence seq(0.03, 0.06);
+
+    Vector6d x;
+    Matrix6d P;
+    double repropagate_ms = runDelayed(model, seq, ekf_core::REPROPAGATE, x, P);
+    double cumulative_ms  = runDelayed(model, seq, ekf_core::CUMULATIVE, x, P);
+
+    std::cout << seq.measurements.size() << " delayed updates, repropagate " << repropagate_ms
+              << " ms, cumulative " << cumulative_ms << " ms" << std::endl;
+    RecordProperty("repropagate_us_per_update", int(1000 * repropagate_ms / seq.measurements.size()));
+    RecordProperty("cumulative_us_per_update", int(1000 * cumulative_ms / seq.measurements.size()));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -14,6 +14,7 @@
 #include <uwb_msgs/uwb.h>
 #include <Eigen/Eigen>
 #include <queue>
+#include <ekf_core/ekf.h>
 #include <vector>
 #include <cmath>
 
@@ -31,10 +32,10 @@ ros::Publisher odom_pub;
  * Define noises:
  *      n = [n_gyro, n_acc_x, n_acc_y, n_bias_gyro, n_bias_acc_x, n_bias_acc_y]
  */
-VectorXd x(8);                          // state
-MatrixXd P = MatrixXd::Identity(8, 8);  // covariance
-MatrixXd Q = MatrixXd::Identity(6, 6);  // prediction noise covariance
-MatrixXd R = MatrixXd::Identity(3, 3);  // observation noise covariance
+Matrix<double, 8, 1> x;                 // state
+ekf_core::Ekf<8> ekf;                   // covariance ekf.P, identity
+Matrix<double, 6, 6> Q = Matrix<double, 6, 6>::Identity(); // prediction noise covariance
+Matrix3d R = Matrix3d::Identity();      // observation noise covariance
 
 // Buffers to save imu reading and the uwb reading
 // for time synchronization
@@ -99,7 +100,7 @@ void propagate(const sensor_msgs::ImuConstPtr &imu_msg)
 //    x(6) += dt * 0;
 //    x(7) += dt * 0;
 
-    MatrixXd A = MatrixXd::Zero(8, 8);
+    Matrix<double, 8, 8> A = Matrix<double, 8, 8>::Zero();
     A(0, 3) =  1;
     A(1, 4) =  1;
     A(2, 5) = -1;
@@ -112,21 +113,20 @@ void propagate(const sensor_msgs::ImuConstPtr &imu_msg)
     A(3, 7) = -sin(x(2));
     A(4, 7) = -cos(x(2));
 
-    MatrixXd U = MatrixXd::Zero(8, 6);
+    Matrix<double, 8, 6> U = Matrix<double, 8, 6>::Zero();
     U(2, 0) = -1;
     U(3, 1) = -cos(x(2));
     U(4, 1) = -sin(x(2));
     U(3, 2) =  sin(x(2));
     U(4, 2) = -cos(x(2));
-    U.block<3,3>(5, 3) = MatrixXd::Identity(3, 3);
+    U.block<3,3>(5, 3) = Matrix3d::Identity();
 
-    MatrixXd F, V;
-    F = dt * A + MatrixXd::Identity(8, 8);
-    V = dt * U;
+    Matrix<double, 8, 8> F = dt * A + Matrix<double, 8, 8>::Identity();
+    Matrix<double, 8, 6> V = dt * U;
     /**
      * P_t_hat = F * P_t * F' + V * Q * V'
      */
-    P = F * P * F.transpose() + V * Q * V.transpose();
+    ekf.predict(F, V, Q);
 
     t = cur_t;
 }
@@ -137,7 +137,7 @@ void propagate(const sensor_msgs::ImuConstPtr &imu_msg)
  */
 void update(const uwb_msgs::uwb &msg)
 {
-    MatrixXd C = MatrixXd::Zero(3, 8);
+    Matrix<double, 3, 8> C = Matrix<double, 3, 8>::Zero();
     C.block<3, 3>(0, 0) = Matrix3d::Identity();
 
     double pos_x = msg.pos_x;
@@ -145,10 +145,13 @@ void update(const uwb_msgs::uwb &msg)
     double angle_yaw = msg.pos_theta;
     Vector3d y(pos_x, pos_y, angle_yaw);
 
-    MatrixXd K(8, 3);
-    K = P * C.transpose() * (C * P * C.transpose() + R).inverse();
-    x = x + K * (y - C * x);
-    P = P - K * C * P;
+    Vector3d r = y - C * x;
+    Matrix<double, 8, 1> dx;
+    if (!ekf.update(C, r, R, dx)) {
+        ROS_WARN("update skipped, innovation covariance not positive definite");
+        return;
+    }
+    x += dx;
 }
 
 void pub_odom(std_msgs::Header header)
@@ -161,11 +164,11 @@ void pub_odom(std_msgs::Header header)
     odom.pose.pose.orientation.z= x(2);
     odom.twist.twist.linear.x   = x(3);
     odom.twist.twist.linear.y   = x(4);
-    odom.pose.covariance[0]     = P(0, 0);
-    odom.pose.covariance[7]     = P(1, 1);
-    odom.pose.covariance[35]    = P(2, 2);
-    odom.twist.covariance[0]    = P(3, 3);
-    odom.twist.covariance[7]    = P(4, 4);
+    odom.pose.covariance[0]     = ekf.P(0, 0);
+    odom.pose.covariance[7]     = ekf.P(1, 1);
+    odom.pose.covariance[35]    = ekf.P(2, 2);
+    odom.twist.covariance[0]    = ekf.P(3, 3);
+    odom.twist.covariance[7]    = ekf.P(4, 4);
 
     odom_pub.publish(odom);
 }
@@ -211,7 +214,7 @@ void imu_callback(const sensor_msgs::Imu::ConstPtr &imu_msg)
         imu_buf.push(imu_msg);
         propagate(imu_msg);
         x_history.push(x);
-        P_history.push(P);
+        P_history.push(ekf.P);
         pub_odom(imu_msg->header);
     }
 }
@@ -292,7 +295,7 @@ void odom_callback(const uwb_msgs::uwb &msg)
         {
             // if x_history is empty then the odom is the same time as the imu
             x = x_history.front();
-            P = P_history.front();
+            ekf.P = P_history.front();
             // trace the time backwards to imu time
             t = imu_buf.front()->header.stamp.toSec();
             imu_buf.pop();
@@ -313,7 +316,7 @@ void odom_callback(const uwb_msgs::uwb &msg)
             propagate(imu_buf.front());
             temp_imu_buf.push(imu_buf.front());
             x_history.push(x);
-            P_history.push(P);
+            P_history.push(ekf.P);
             imu_buf.pop();
         }
         std::swap(imu_buf, temp_imu_buf);
@@ -13,6 +13,7 @@
 #include <uwb_msgs/uwb.h>
 #include <Eigen/Eigen>
 #include <queue>
+#include <ekf_core/ekf.h>
 
 // #define INIT_Q_R_BY_MEASUREMENT
 
@@ -31,10 +32,10 @@ double acc_weight, gyro_weight, acc_bias_weight, gyro_bias_weight;
  * Define noises:
  *      n = [n_gyro, n_acc, n_bias_acc, n_bias_gyro]
  */
-VectorXd x(16);                             // state
-MatrixXd P = MatrixXd::Zero(15, 15);        // covariance
-MatrixXd Q = MatrixXd::Identity(12, 12);    // prediction noise covariance
-MatrixXd R = MatrixXd::Identity(6, 6);      // observation noise covariance
+Matrix<double, 16, 1> x;                    // state
+ekf_core::Ekf<15> ekf;                      // error state covariance ekf.P
+Matrix<double, 12, 12> Q = Matrix<double, 12, 12>::Identity(); // prediction noise covariance
+Matrix<double, 6, 6> R = Matrix<double, 6, 6>::Identity();     // observation noise covariance
 
 // buffers to save imu and uwb reading for time synchronization
 queue <sensor_msgs::Imu::ConstPtr> imu_buf;
@@ -113,7 +114,7 @@ void propagate(const sensor_msgs::Imu::ConstPtr &imu_msg) {
     x.segment<3>(7) += (Rt * (a - G)) * dt;
 
     // propagate the covariance with skew-symmetric matrix
-    MatrixXd I = MatrixXd::Identity(3, 3);
+    Matrix3d I = Matrix3d::Identity();
     Matrix3d R_omg, R_a;
     R_omg << 0, -omg(2), omg(1),
             omg(2), 0, -omg(0),
@@ -122,7 +123,7 @@ void propagate(const sensor_msgs::Imu::ConstPtr &imu_msg) {
             a(2), 0, -a(0),
             -a(1), a(0), 0;
 
-    MatrixXd A = MatrixXd::Zero(15, 15);
+    Matrix<double, 15, 15> A = Matrix<double, 15, 15>::Zero();
     A.block<3, 3>(0, 0) = -R_omg;
     A.block<3, 3>(0, 12)= -1 * I;
     A.block<3, 3>(3, 6) = I;
@@ -130,18 +131,17 @@ void propagate(const sensor_msgs::Imu::ConstPtr &imu_msg) {
     A.block<3, 3>(6, 9) = (-1 * Rt.toRotationMatrix());
     // cout << "DEBUG:: propagate A" << endl << A << endl;
 
-    MatrixXd U = MatrixXd::Zero(15, 12);
+    Matrix<double, 15, 12> U = Matrix<double, 15, 12>::Zero();
     U.block<3, 3>(0, 0) = -1 * I;
     U.block<3, 3>(6, 3) = -1 * Rt.toRotationMatrix();
     U.block<3, 3>(9, 6) = I;
     U.block<3, 3>(12, 9)= I;
     // cout << "DEBUG:: propagate U" << endl << U << endl;
 
-    MatrixXd F, V;
-    F = MatrixXd::Identity(15, 15) + dt * A;
-    V = dt * U;
+    Matrix<double, 15, 15> F = Matrix<double, 15, 15>::Identity() + dt * A;
+    Matrix<double, 15, 12> V = dt * U;
 
-    P = F * P * F.transpose() + V * Q * V.transpose();
+    ekf.predict(F, V, Q);
     // cout << "DEBUG:: P after propagate" << endl << P << endl;
 
     t_prev = cur_t;
@@ -168,31 +168,31 @@ void update_loosely(const uwb_msgs::uwb &msg,
 */
 
     double theta_z = msg.pos_theta - theta_bias;
-    VectorXd T(3);
+    Vector3d T;
     T(0) = msg.pos_x;
     T(1) = msg.pos_y;
     T(2) = 0;
 
-    MatrixXd C = MatrixXd::Zero(6, 15);
+    Matrix<double, 6, 15> C = Matrix<double, 6, 15>::Zero();
     C.block<3, 3>(0, 0) = Matrix3d::Identity();
 //    C(2, 2) = 1;
     C.block<3, 3>(3, 3) = Matrix3d::Identity();
 
-    MatrixXd K(15, 6);
-    K = P * C.transpose() * (C * P * C.transpose() + R).inverse();
-//    cout << "DEBUG:: update K" << endl << K << endl;
-
     // Matrix3d uwb_R_world = AngleAxisd(theta_z, Vector3d::UnitZ()) * imu_R_world * q_g.toRotationMatrix();
 	Matrix3d uwb_R_world = AngleAxisd(theta_z, Vector3d::UnitZ()) * q_g.toRotationMatrix();
 //    cout << "DEBUG:: measured angle" << endl << uwb_R_world << endl;
 
-    VectorXd r(6);
+    Matrix<double, 6, 1> r;
     Quaterniond qm(uwb_R_world);
     Quaterniond q = Quaterniond(x(0), x(1), x(2), x(3));
     Quaterniond dq = q.conjugate() * qm; // Hamilton style
-    r.head(3) = 2 * dq.vec();
-    r.tail(3) = T - x.segment<3>(4);
-    VectorXd _r = K * r;
+    r.head<3>() = 2 * dq.vec();
+    r.tail<3>() = T - x.segment<3>(4);
+    Matrix<double, 15, 1> _r;
+    if (!ekf.update(C, r, R, _r)) {
+        ROS_WARN("update skipped, innovation covariance not positive definite");
+        return;
+    }
     Vector3d dw(0.5 * _r(0), 0.5 * _r(1), 0.5 * _r(2));
     Quaterniond _dq = Quaterniond(1, dw(0), dw(1), dw(2)).normalized();
     q = q * _dq;
@@ -202,7 +202,6 @@ void update_loosely(const uwb_msgs::uwb &msg,
     x(2) = q.y();
     x(3) = q.z();
     x.segment<12>(4) += _r.segment<12>(3);
-    P = P - K * C * P;
 //    cout << "DEBUG:: P after update" << endl << P << endl;
 }
 
@@ -284,7 +283,7 @@ void imu_callback(const sensor_msgs::Imu::ConstPtr &imu_msg) {
 
         imu_buf.push(imu_msg);
         x_history.push(x);
-        P_history.push(P);
+        P_history.push(ekf.P);
     }
 }
 
@@ -367,7 +366,7 @@ void odom_callback(const uwb_msgs::uwb &msg) {
         // If not, use the oldest time in the x_history
         if (!x_history.empty()) {
             x = x_history.front();
-            P = P_history.front();
+            ekf.P = P_history.front();
             t_prev = imu_buf.front()->header.stamp.toSec();
             imu_buf.pop();
             x_history.pop();
@@ -391,7 +390,7 @@ void odom_callback(const uwb_msgs::uwb &msg) {
             propagate(imu_buf.front());
             temp_imu_buf.push(imu_buf.front());
             x_history.push(x);
-            P_history.push(P);
+            P_history.push(ekf.P);
             imu_buf.pop();
         }
         std::swap(imu_buf, temp_imu_buf);
@@ -416,6 +415,8 @@ int main(int argc, char **argv) {
     n.param("acc_bias_weight" , acc_bias_weight, 0.01);
     n.param("gyro_bias_weight", gyro_bias_weight, 0.01);
 
+    ekf.P.setZero();
+
     ros::Subscriber s1 = n.subscribe(imu_topic, 100, imu_callback);
     ros::Subscriber s2 = n.subscribe(uwb_topic, 10, odom_callback);
     odom_pub = n.advertise<nav_msgs::Odometry>(publisher_topic, 100);
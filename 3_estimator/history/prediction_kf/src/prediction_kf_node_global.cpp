@@ -12,6 +12,7 @@
 #include <Eigen/Core>
 #include <Eigen/Dense>
 #include <queue>
+#include <ekf_core/ekf.h>
 #include "rm_cv/ArmorRecord.h"
 
 using namespace std;
@@ -20,15 +21,16 @@ using namespace Eigen;
 string attitude_topic, publisher_topic, debug_topic, real_visual_topic, transform_topic;
 string debug_angle_topic;
 ros::Publisher filter_pub, debug_pub, transform_pub, debug_angle_pub;
-MatrixXd gimbal_R_camera = MatrixXd::Identity(3, 3); // rotation matrix from camera to imu
-MatrixXd init_R_gimbal= MatrixXd::Identity(3, 3);
+Matrix3d gimbal_R_camera = Matrix3d::Identity(); // rotation matrix from camera to imu
+Matrix3d init_R_gimbal= Matrix3d::Identity();
 Vector3d gimbal_T_camera = MatrixXd::Zero(3, 1);
 
-VectorXd x(6);      // state
-MatrixXd P = MatrixXd::Identity(6, 6); // covariance
-MatrixXd Q = MatrixXd::Identity(6, 6); // prediction noise covariance
-MatrixXd R = MatrixXd::Identity(3, 3); // observation noise covariance
-MatrixXd A = MatrixXd::Identity(6, 6); // state transfer function
+Matrix<double, 6, 1> x; // state
+ekf_core::Ekf<6> ekf;   // covariance ekf.P
+Matrix<double, 6, 6> Q = Matrix<double, 6, 6>::Identity(); // prediction noise covariance
+Matrix3d R = Matrix3d::Identity(); // observation noise covariance
+Matrix<double, 6, 6> A = Matrix<double, 6, 6>::Identity(); // state transfer function
+Matrix<double, 3, 6> H = Matrix<double, 3, 6>::Identity(); // observation matrix
 
 bool visual_initialized = false, visual_valid = false;
 
@@ -122,9 +124,8 @@ static double imu_to_yaw_angle(const geometry_msgs::QuaternionStamped::ConstPtr
 // Chi-square test for outlier rejection
 static bool translation_is_outlier(const Vector3d &pos)
 {
-    VectorXd r = MatrixXd::Zero(3, 1);
-    VectorXd z = MatrixXd::Zero(3, 1);
-    MatrixXd S = MatrixXd::Zero(3, 3);
+    Vector3d r, z;
+    Matrix3d S;
     z << pos[0], pos[1], pos[2];
 
     double pos_norm   = z.segment<3>(0).norm();
@@ -138,14 +139,12 @@ static bool translation_is_outlier(const Vector3d &pos)
 
     // r = z - H * x, residual
     // S = H P H' + R, residual covariance
-    MatrixXd H = MatrixXd::Identity(3, 6); // observation matrix
-
 //    MatrixXd K_next = (H * P * H.transpose() + R).ldlt().solve(P * H.transpose());
 //    MatrixXd x_next = x + K_next * (z - H * x);
 //    MatrixXd P_next = P - K_next * H * P;
 
     r = z - H * x;
-    S = H * P * H.transpose() + R;
+    S = H * ekf.P * H.transpose() + R;
     chi_square = r.transpose() * S * r;
     // cout << "chi_square " << endl << chi_square << endl;
 
@@ -219,22 +218,20 @@ static void preprocess_visual(const std_msgs::Header &header,
  * Core Kalman Filter math, propagate and update
  */
 static void propagate(const double &dt) {
-    A.topRightCorner(3, 3) = dt * MatrixXd::Identity(3, 3);
+    A.topRightCorner<3, 3>() = dt * Matrix3d::Identity();
     x = A * x;
-    P = A * P * A.transpose() + Q;
+    ekf.predict(A, Q);
 }
 
 static void update(const Vector3d &pos)
 {
-    MatrixXd H, K, z;
-
-    H = MatrixXd::Identity(3, 6); // observation matrix
-    K = P * H.transpose() * (H * P * H.transpose() + R).inverse();
-    z = MatrixXd::Zero(3, 1);
-    z << pos[0], pos[1], pos[2];
-
-    x = x + K * (z - H * x);
-    P = P - K * H * P;
+    Vector3d r = pos - H * x;
+    Matrix<double, 6, 1> dx;
+    if (!ekf.update(H, r, R, dx)) {
+        ROS_WARN("update skipped, innovation covariance not positive definite");
+        return;
+    }
+    x += dx;
 }
 
 /**
@@ -294,12 +291,12 @@ static void initialize_visual(const std_msgs::Header &header,
         x.segment<3>(0) = T_sum / MAX_VISUAL_QUEUE_SIZE; // init velocity with zero
         x.segment<3>(3).setZero(); // init velocity with zero
 
-        P.setZero();
-        P.topLeftCorner(3, 3)     = P_weight * MatrixXd::Identity(3, 3);
-        P.bottomRightCorner(3, 3) = 2 * P_weight * MatrixXd::Identity(3, 3);
+        ekf.P.setZero();
+        ekf.P.topLeftCorner<3, 3>()     = P_weight * Matrix3d::Identity();
+        ekf.P.bottomRightCorner<3, 3>() = 2 * P_weight * Matrix3d::Identity();
 
         cout << "DEBUG: x initialized with " << endl << x.transpose() << endl;
-        cout << "P " << endl << P << endl;
+        cout << "P " << endl << ekf.P << endl;
 
         init_T_shield_prev = init_T_shield;
         visual_initialized = true;
@@ -397,9 +394,9 @@ int main(int argc, char **argv)
     OUTPUT_BOUND << 10.0, 10.0, 20.0;
 
     x.setZero();
-    R = R_pos * MatrixXd::Identity(3, 3);
-    Q.topLeftCorner(3, 3)     = Q_pos * MatrixXd::Identity(3, 3);
-    Q.bottomRightCorner(3, 3) = Q_vel * MatrixXd::Identity(3, 3);
+    R = R_pos * Matrix3d::Identity();
+    Q.topLeftCorner<3, 3>()     = Q_pos * Matrix3d::Identity();
+    Q.bottomRightCorner<3, 3>() = Q_vel * Matrix3d::Identity();
     cout << "R " << endl << R << endl;
     cout << "Q " << endl << Q << endl;
 
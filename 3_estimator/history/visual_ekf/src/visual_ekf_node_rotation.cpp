@@ -17,6 +17,7 @@
 // #include <Eigen/Eigen>
 #include <Eigen/Geometry>
 #include <queue>
+#include <ekf_core/ekf.h>
 //#include "rm_cv/ArmorRecord.h"
 
 using namespace std;
@@ -35,11 +36,10 @@ int sleep_time;
  * Define noises:
  *      n = [n_gyro]
  */
-VectorXd x(4);                        // state
-// MatrixXd P = MatrixXd::Zero(3, 3);     // covariance
-MatrixXd P = MatrixXd::Identity(3, 3); // covariance
-MatrixXd R = MatrixXd::Identity(3, 3); // prediction noise covariance
-MatrixXd Q = MatrixXd::Identity(3, 3); // observation noise covariance
+Vector4d x;                           // state
+ekf_core::Ekf<3> ekf;                 // error state covariance ekf.P, identity
+Matrix3d R = Matrix3d::Identity();    // prediction noise covariance
+Matrix3d Q = Matrix3d::Identity();    // observation noise covariance
 
 // buffers to save gyro and visual reading
 queue<geometry_msgs::Vector3Stamped::ConstPtr> gyro_buf;
@@ -58,7 +58,7 @@ int gyro_count  = 0;
 bool gyro_initialized = false;
 bool visual_initialized = false;
 bool visual_valid = false;
-MatrixXd imu_R_camera = MatrixXd::Identity(3, 3); // rotation matrix from camera to imu
+Matrix3d imu_R_camera = Matrix3d::Identity(); // rotation matrix from camera to imu
 Vector3d imu_T_camera = MatrixXd::Zero(3, 1);
 
 void pub_fused_pose(std_msgs::Header header)
@@ -69,9 +69,9 @@ void pub_fused_pose(std_msgs::Header header)
     pose.pose.pose.orientation.x = x(1);
     pose.pose.pose.orientation.y = x(2);
     pose.pose.pose.orientation.z = x(3);
-    pose.pose.covariance[0] = P(0, 0);
-    pose.pose.covariance[1] = P(1, 1);
-    pose.pose.covariance[2] = P(2, 2);
+    pose.pose.covariance[0] = ekf.P(0, 0);
+    pose.pose.covariance[1] = ekf.P(1, 1);
+    pose.pose.covariance[2] = ekf.P(2, 2);
 
     pose_pub.publish(pose);
 }
@@ -99,9 +99,9 @@ void pub_fused_angleAxis(std_msgs::Header header)
     angleAxis.pose.pose.orientation.x = angle_state.axis()[0];
     angleAxis.pose.pose.orientation.y = angle_state.axis()[1];
     angleAxis.pose.pose.orientation.z = angle_state.axis()[2];
-    angleAxis.pose.covariance[0] = P(0, 0);
-    angleAxis.pose.covariance[1] = P(1, 1);
-    angleAxis.pose.covariance[2] = P(2, 2);
+    angleAxis.pose.covariance[0] = ekf.P(0, 0);
+    angleAxis.pose.covariance[1] = ekf.P(1, 1);
+    angleAxis.pose.covariance[2] = ekf.P(2, 2);
     pose_pub.publish(angleAxis);
 }
 
@@ -147,13 +147,12 @@ void propagate(const geometry_msgs::Vector3Stamped &gyro)
            -w(1), w(0), 0;
     Matrix3d A = -w_hat;
 
-    MatrixXd U = -MatrixXd::Identity(3, 3);
+    Matrix3d U = -Matrix3d::Identity();
 
-    MatrixXd F, V;
-    F = MatrixXd::Identity(3, 3) + dt * A;
-    V = dt * U;
+    Matrix3d F = Matrix3d::Identity() + dt * A;
+    Matrix3d V = dt * U;
 
-    P = F * P * F.transpose() + V * R * V.transpose();
+    ekf.predict(F, V, R);
 	
     t_prev = cur_t;
 	// cout << "P " << endl << P << endl;
@@ -195,16 +194,17 @@ static void update(const geometry_msgs::TwistStamped::ConstPtr &pnp)
 
     Matrix3d C = Matrix3d::Identity();
 
-    MatrixXd K(3, 3);
-    K = P * C.transpose() * (C * P* C.transpose() + Q).inverse();
-
-    VectorXd r(3); // residual
+    Vector3d r; // residual
     Quaterniond qm = camera_q_shield;
     Quaterniond q  = Quaterniond(x(0), x(1), x(2), x(3));
     Quaterniond dq = q.conjugate() * qm;
     // ROS_INFO("dq w x y z %f %f %f %f", dq.w(), dq.x(), dq.y(), dq.z() );
     r = 2 * dq.vec();
-    Vector3d _r = K * r;
+    Vector3d _r;
+    if (!ekf.update(C, r, Q, _r)) {
+        ROS_WARN("update skipped, innovation covariance not positive definite");
+        return;
+    }
     // ROS_INFO("dr x y z %f %f %f", _r[0], _r[1], _r[2] );
     Vector3d dw(_r(0) * 0.5, _r(1) * 0.5, _r(2) * 0.5);
     dq = Quaterniond(sqrt(1 - dw.squaredNorm()), dw(0), dw(1), dw(2)).normalized();
@@ -214,8 +214,6 @@ static void update(const geometry_msgs::TwistStamped::ConstPtr &pnp)
     x(1) = q.x();
     x(2) = q.y();
     x(3) = q.z();
-
-    P = P - K * C * P;
 	// cout << "P " << endl << P << endl;
 	// cout << "x " << endl << x.transpose() << endl;
 }
@@ -228,7 +226,7 @@ static void initialize_gyro(const geometry_msgs::Vector3Stamped::ConstPtr &gyro)
 {
     t_prev = gyro->header.stamp.toSec();
     x_history.push(x);
-    P_history.push(P);
+    P_history.push(ekf.P);
     gyro_buf.push(gyro);
     gyro_count++;
     if (gyro_count == GYRO_INIT_COUNT) {
@@ -271,7 +269,7 @@ static void initialize_visual(const geometry_msgs::TwistStamped::ConstPtr &pnp)
     x(1) = camera_q_shield.x();
     x(2) = camera_q_shield.y();
     x(3) = camera_q_shield.z();
-    P = MatrixXd::Identity(3, 3);
+    ekf.P.setIdentity();
 	ROS_INFO("visual init at %f", cur_t);
     cout << "DEBUG: x initialized with " << endl << x.transpose() << endl;
 
@@ -321,7 +319,7 @@ static void state_machine_process(void)
             propagate(*gyro_buf.front());
             temp_gyro_buf.push(gyro_buf.front());
             x_history.push(x);
-            P_history.push(P);
+            P_history.push(ekf.P);
             gyro_buf.pop();
         }
         swap(gyro_buf, temp_gyro_buf);
@@ -366,7 +364,7 @@ void gyro_callback(const geometry_msgs::Vector3Stamped::ConstPtr &gyro)
         // pub_fused_pose(gyro->header);
         pub_fused_angleAxis(gyro->header);
         x_history.push(x);
-        P_history.push(P);
+        P_history.push(ekf.P);
         gyro_buf.push(gyro);
 		if (gyro_buf.size() > MAX_GYRO_QUEUE_SIZE) {
 			x_history.pop();
@@ -389,12 +387,12 @@ int main(int argc, char **argv)
     n.param("node_sleep_time", sleep_time, 10);
 
     // TODO: initalize the R and Q matrix
-    R =     gyro_weight * MatrixXd::Identity(3, 3); // gyro noise
-    Q = visual_q_weight * MatrixXd::Identity(3, 3); // observation noise
+    R =     gyro_weight * Matrix3d::Identity(); // gyro noise
+    Q = visual_q_weight * Matrix3d::Identity(); // observation noise
 
     x.setZero();
     x(0) = 1; // set quaternion to identity
-    P = 1.0 * P;
+    ekf.P = 1.0 * ekf.P;
 
     imu_R_camera <<  0, 0, 1,
                     -1, 0, 0,
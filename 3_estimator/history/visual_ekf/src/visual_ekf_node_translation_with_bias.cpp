@@ -6,7 +6,9 @@
  * V1: estimation for rotation only
  * V2: give the translation of the shield, added acc bias
  * V3: estimate the translation and rotation
+ * V4: delayed visual measurements applied at their stamp through ekf_core::StateRing
  */
+#include <algorithm>
 #include <iostream>
 #include <ros/ros.h>
 #include <std_msgs/String.h>
@@ -19,6 +21,8 @@
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 #include <queue>
+#include <ekf_core/ekf.h>
+#include <ekf_core/state_ring.h>
 //#include "rm_cv/ArmorRecord.h"
 
 using namespace std;
@@ -39,29 +43,28 @@ int sleep_time;
  * Define noises:
  *      n = [n_acc, n_gyro, n_bias_acc, n_bias_gyro]
  */
-VectorXd x(16);         // state
-MatrixXd P = MatrixXd::Identity(15, 15); // covariance
-MatrixXd R = MatrixXd::Identity(12, 12); // prediction noise covariance
-MatrixXd Q = MatrixXd::Identity(6, 6); // observation noise covariance
-
-// buffers to save gyro and visual reading
-queue<sensor_msgs::Imu::ConstPtr> imu_buf;
-queue<geometry_msgs::TwistStamped::ConstPtr> visual_buf;
-queue<Matrix<double, 16, 1>> x_history;
-queue<Matrix<double, 15, 15>> P_history;
-Vector3d G = {0, 0, 9.8}; // Consider to add initialization later
-
-double t_prev;          // previous propagated time
+Matrix<double, 16, 1> x;                // state
+ekf_core::Ekf<15> ekf;                  // error state covariance ekf.P
+Matrix<double, 12, 12> R = Matrix<double, 12, 12>::Identity(); // prediction noise covariance
+Matrix<double, 6, 6> Q = Matrix<double, 6, 6>::Identity(); // observation noise covariance
 
 // Initialization
 const int IMU_INIT_COUNT = 10;
 const int MAX_GYRO_QUEUE_SIZE = 400;
+
+// state, covariance and imu input of every propagation, for the delayed visual measurements
+typedef ekf_core::StateRing<16, 15, 10> Ring;
+Ring ring(MAX_GYRO_QUEUE_SIZE);
+queue<geometry_msgs::TwistStamped::ConstPtr> visual_buf;
+Vector3d G = {0, 0, 9.8}; // Consider to add initialization later
+
 const double IMU_UPDATE_TIME = 0.0025; // 1 / 400Hz
 int imu_count  = 0;
 bool imu_initialized = false;
 bool visual_initialized = false;
+double visual_init_t = 0.0;  // stamp of the visual initialization, older measurements are dropped
 bool visual_valid = false;
-MatrixXd imu_R_camera = MatrixXd::Identity(3, 3); // rotation matrix from camera to imu
+Matrix3d imu_R_camera = Matrix3d::Identity(); // rotation matrix from camera to imu
 Vector3d imu_T_camera = MatrixXd::Zero(3, 1);
 
 //// DEBUG only
@@ -87,18 +90,18 @@ void pub_shield_odom(const std_msgs::Header& header)
     odom.twist.twist.linear.y = x(8);
     odom.twist.twist.linear.z = x(9);
 
-    odom.pose.covariance[0]  = P(0, 0);
-    odom.pose.covariance[7]  = P(1, 1);
-    odom.pose.covariance[14] = P(2, 2);
-    odom.pose.covariance[21] = P(3, 3);
-    odom.pose.covariance[28] = P(4, 4);
-    odom.pose.covariance[35] = P(5, 5);
-    odom.pose.covariance[3]  = P(0, 3);
-    odom.pose.covariance[10] = P(1, 4);
-    odom.pose.covariance[17] = P(2, 5);
-    odom.pose.covariance[18] = P(3, 0);
-    odom.pose.covariance[25] = P(4, 1);
-    odom.pose.covariance[32] = P(5, 2);
+    odom.pose.covariance[0]  = ekf.P(0, 0);
+    odom.pose.covariance[7]  = ekf.P(1, 1);
+    odom.pose.covariance[14] = ekf.P(2, 2);
+    odom.pose.covariance[21] = ekf.P(3, 3);
+    odom.pose.covariance[28] = ekf.P(4, 4);
+    odom.pose.covariance[35] = ekf.P(5, 5);
+    odom.pose.covariance[3]  = ekf.P(0, 3);
+    odom.pose.covariance[10] = ekf.P(1, 4);
+    odom.pose.covariance[17] = ekf.P(2, 5);
+    odom.pose.covariance[18] = ekf.P(3, 0);
+    odom.pose.covariance[25] = ekf.P(4, 1);
+    odom.pose.covariance[32] = ekf.P(5, 2);
     odom_pub.publish(odom);
 }
 
@@ -153,37 +156,50 @@ void pub_debug_propagate(const std_msgs::Header& header,
 }
 
 
-void propagate(const sensor_msgs::Imu &imu)
+/**
+ * imu input of a propagation step, u = [acc; gyro; orientation w, x, y, z]
+ */
+static Ring::Input imu_input(const sensor_msgs::Imu &imu)
+{
+    Ring::Input u;
+    u << imu.linear_acceleration.x, imu.linear_acceleration.y, imu.linear_acceleration.z,
+         imu.angular_velocity.x, imu.angular_velocity.y, imu.angular_velocity.z,
+         imu.orientation.w, imu.orientation.x, imu.orientation.y, imu.orientation.z;
+    return u;
+}
+
+static Vector3d acc_without_gravity(const Ring::State &x, const Ring::Input &u)
 {
-    double cur_t = imu.header.stamp.toSec();
-    Vector3d a, a_x, acc_wo_g, w, w_x;
-    a(0) = imu.linear_acceleration.x;
-    a(1) = imu.linear_acceleration.y;
-    a(2) = imu.linear_acceleration.z;
-    w(0) = imu.angular_velocity.x;
-    w(1) = imu.angular_velocity.y;
-    w(2) = imu.angular_velocity.z;
-    a_x = a - x.segment<3>(10);
-    w_x = w - x.segment<3>(13);
     Quaterniond world_R_imu(x(0), x(1), x(2), x(3));
+    // return world_R_imu.toRotationMatrix() * (a - x.segment<3>(6)) - G;
+    return u.head<3>() - x.segment<3>(10) - world_R_imu.toRotationMatrix().transpose() * G;
+}
 
-    double dt = cur_t - t_prev;
-    dt = (dt < IMU_UPDATE_TIME * 5) ? dt : IMU_UPDATE_TIME * 5;
-    ROS_INFO("dt in propagate is %f, at the cur_t %f", dt, cur_t);
-    // acc_wo_g = world_R_imu.toRotationMatrix() * (a - x.segment<3>(6)) - G;
-    acc_wo_g = a_x - world_R_imu.toRotationMatrix().transpose() * G;
-    x.segment<3>(4) += x.segment<3>(7) * dt + 0.5 * acc_wo_g * dt * dt;
-    x.segment<3>(7) += acc_wo_g * dt;
+/**
+ * propagate the state and the covariance of previous to e.t with the imu input e.u,
+ * also when a delayed visual measurement is repropagated
+ */
+static void propagate(const Ring::Entry &previous, Ring::Entry &e)
+{
+    const Ring::State &x = previous.x;
+    Vector3d a_x, acc_wo_g, w_x;
+    a_x = e.u.segment<3>(0) - x.segment<3>(10);
+    w_x = e.u.segment<3>(3) - x.segment<3>(13);
+    Quaterniond world_R_imu(x(0), x(1), x(2), x(3));
 
-    a_int_int += a_int * dt + 0.5 * acc_wo_g * dt * dt;
-    a_int += acc_wo_g * dt;
-    pub_debug_propagate(imu.header, acc_wo_g, a_int);
+    double dt = e.t - previous.t;
+    dt = (dt < IMU_UPDATE_TIME * 5) ? dt : IMU_UPDATE_TIME * 5;
+    ROS_DEBUG("dt in propagate is %f, at the cur_t %f", dt, e.t);
+    acc_wo_g = acc_without_gravity(x, e.u);
+    e.x = x;
+    e.x.segment<3>(4) += x.segment<3>(7) * dt + 0.5 * acc_wo_g * dt * dt;
+    e.x.segment<3>(7) += acc_wo_g * dt;
 
     Vector3d domg = w_x * dt / 2;
     Quaterniond dR(sqrt(1 - domg.squaredNorm()), domg(0), domg(1), domg(2));
     Quaterniond R_now;
     R_now = (world_R_imu * dR).normalized();
-    x.segment<4>(0) << R_now.w(), R_now.x(), R_now.y(), R_now.z();
+    e.x.segment<4>(0) << R_now.w(), R_now.x(), R_now.y(), R_now.z();
 
 
     Matrix3d R_w_x, R_a_x;
@@ -194,66 +210,61 @@ void propagate(const sensor_msgs::Imu &imu)
              a_x(2),  0, -a_x(0),
             -a_x(1), a_x(0), 0;
 
-    MatrixXd A = MatrixXd::Zero(15, 15);
+    Matrix<double, 15, 15> A = Matrix<double, 15, 15>::Zero();
     A.block<3, 3>(0, 0) = -R_w_x;
-    A.block<3, 3>(0, 12)= -MatrixXd::Identity(3, 3);
-    A.block<3, 3>(3, 6) =  MatrixXd::Identity(3, 3);
+    A.block<3, 3>(0, 12)= -Matrix3d::Identity();
+    A.block<3, 3>(3, 6) =  Matrix3d::Identity();
     A.block<3, 3>(6, 0) = -R_a_x;
     A.block<3, 3>(6, 9) = -world_R_imu.toRotationMatrix();
 
-    MatrixXd U = -MatrixXd::Zero(15, 12);
-    U.block<3, 3>(0, 0) = -MatrixXd::Identity(3, 3);
+    Matrix<double, 15, 12> U = Matrix<double, 15, 12>::Zero();
+    U.block<3, 3>(0, 0) = -Matrix3d::Identity();
     U.block<3, 3>(6, 3) = -world_R_imu.toRotationMatrix();
-    U.block<3, 3>(9, 6) =  MatrixXd::Identity(3, 3);
-    U.block<3, 3>(12,9) =  MatrixXd::Identity(3, 3);
+    U.block<3, 3>(9, 6) =  Matrix3d::Identity();
+    U.block<3, 3>(12,9) =  Matrix3d::Identity();
 
-    MatrixXd F, V;
-    F = MatrixXd::Identity(15, 15) + dt * A;
-    V = dt * U;
+    e.F = Matrix<double, 15, 15>::Identity() + dt * A;
+    Matrix<double, 15, 12> V = dt * U;
 //    cout << "F " << endl << F << endl;
 //    cout << "R " << endl << R << endl;
 //    cout << "V " << endl << V << endl;
-    P = F * P * F.transpose() + V * R * V.transpose();
-	
-    t_prev = cur_t;
-//    cout << "P " << endl << P << endl;
-//    cout << "x " << endl << x.transpose() << endl;
+    ekf.P = previous.P;
+    ekf.predict(e.F, V, R);
+    e.P = ekf.P;
 }
 
-static void throwState(double current_time)
+/**
+ * error state injection, the quaternion is corrected by the small rotation of dx(0:3)
+ */
+static void inject(Ring::State &x, const Ring::StateVector &dx)
 {
-    while(imu_buf.size() > 1 &&
-          imu_buf.front()->header.stamp.toSec() < current_time)
-    {
-        // trace backward the time to the imu timestamp
-        t_prev = imu_buf.front()->header.stamp.toSec();
-        ROS_INFO("throw state with time: %f", t_prev);
-        imu_buf.pop();
-        x_history.pop();
-        P_history.pop();
-    }
+    Quaterniond q = Quaterniond(x(0), x(1), x(2), x(3));
+    Vector3d dw(0.5 * dx(0), 0.5 * dx(1), 0.5 * dx(2));
+    Quaterniond dq = Quaterniond(1, dw(0), dw(1), dw(2)).normalized();
+    q = q * dq;
+
+    x(0) = q.w();
+    x(1) = q.x();
+    x(2) = q.y();
+    x(3) = q.z();
+
+    x.segment<12>(4) += dx.tail<12>();
 }
 
-static void repropagate()
+/**
+ * the current state is the newest of the ring
+ */
+static void sync_state()
 {
-    while (!x_history.empty()) x_history.pop();
-    while (!P_history.empty()) P_history.pop();
-
-    queue <sensor_msgs::Imu::ConstPtr> temp_imu_buf;
-    while (!imu_buf.empty() && imu_buf.size() > 1)
-    {
-        propagate(*imu_buf.front());
-        temp_imu_buf.push(imu_buf.front());
-        x_history.push(x);
-        P_history.push(P);
-        imu_buf.pop();
-    }
-    if (!temp_imu_buf.empty()) {
-        pub_shield_odom(temp_imu_buf.back()->header);
-    }
-    swap(imu_buf, temp_imu_buf);
+    x = ring.back().x;
+    ekf.P = ring.back().P;
 }
 
+/**
+ * update with the visual measurement at its time stamp, the imu propagation since
+ * then is repropagated or corrected with the cumulative transition
+ * @param pnp
+ */
 static void update(const geometry_msgs::TwistStamped &pnp)
 {
     double cur_t = pnp.header.stamp.toSec();
@@ -266,63 +277,44 @@ static void update(const geometry_msgs::TwistStamped &pnp)
 
     imu_T_shield *= 0.001; // Convert millimeter to meter
 
-    throwState(cur_t);
-
-    ROS_INFO("Update, at time %f", cur_t);
-    Quaterniond world_R_imu;
-
-    if (imu_buf.empty()) {
-        world_R_imu.setIdentity();
+    if (cur_t < visual_init_t) {
+        ROS_WARN("visual measurement at %f older than the initialization at %f, dropped", cur_t, visual_init_t);
+        return;
     }
-    else {
-        world_R_imu = Quaterniond(imu_buf.front()->orientation.w,
-                                  imu_buf.front()->orientation.x,
-                                  imu_buf.front()->orientation.y,
-                                  imu_buf.front()->orientation.z);
+
+    int k = ring.find(cur_t);
+    if (k < 0) {
+        ROS_WARN("visual measurement at %f older than the state history, dropped", cur_t);
+        return;
     }
+
+    ROS_INFO("Update, at time %f, %d imu steps late", cur_t, ring.size() - 1 - k);
+    const Ring::Input &u = ring.at(k).u;
+    Quaterniond world_R_imu(u(6), u(7), u(8), u(9));
     Vector3d world_T_shield = world_R_imu.toRotationMatrix() * imu_T_shield;
     // pub_debug_update(pnp.header, world_T_shield, world_R_imu, cur_t);
     pub_debug_update(pnp.header, imu_T_shield, world_R_imu, cur_t);
 
-    MatrixXd C = MatrixXd::Zero(6, 15);
-    C.block<3, 3>(0, 0) = MatrixXd::Identity(3, 3);
-    C.block<3, 3>(3, 3) = MatrixXd::Identity(3, 3);
-
     // Matrix3d W = MatrixXd::Identity(6, 6);
-
-    MatrixXd K(15, 6);
-    K = P * C.transpose() * (C * P * C.transpose() + Q).inverse();
-//    cout << "C " << endl << C << endl;
-//    cout << "K " << endl << K << endl;
-//    cout << "Q " << endl << Q << endl;
-    // x = x + K * (world_T_shield - C * x);
-    // x = x + K * (imu_T_shield - C * x);
-
-    VectorXd r(6);
-    // Quaterniond qm(world_R_imu);
-    Quaterniond q  = Quaterniond(x(0), x(1), x(2), x(3));
-    Quaterniond dq = q.conjugate() * world_R_imu;
-    r.head<3>() = 2 * dq.vec();
-    r.tail<3>() = imu_T_shield - x.segment<3>(4);
-    VectorXd _r = K * r;
-    Vector3d dw(0.5 * _r(0), 0.5 * _r(1), 0.5 * _r(2));
-    dq = Quaterniond(1, dw(0), dw(1), dw(2)).normalized();
-    q = q * dq;
-
-    x(0) = q.w();
-    x(1) = q.x();
-    x(2) = q.y();
-    x(3) = q.z();
-
-    x.segment<12>(4) += _r.tail(12);
-
-    P = P - K * C * P;
-//    cout << "P " << endl << P << endl;
-//    cout << "x " << endl << x.transpose() << endl;
-
-    if (imu_buf.size() > 1) {
-        // repropagate();
+    auto measure = [&](const Ring::State &x, Matrix<double, 6, 15> &C, Matrix<double, 6, 1> &r) {
+        C.setZero();
+        C.block<3, 3>(0, 0) = Matrix3d::Identity();
+        C.block<3, 3>(3, 3) = Matrix3d::Identity();
+
+        // Quaterniond qm(world_R_imu);
+        Quaterniond q  = Quaterniond(x(0), x(1), x(2), x(3));
+        Quaterniond dq = q.conjugate() * world_R_imu;
+        r.head<3>() = 2 * dq.vec();
+        r.tail<3>() = imu_T_shield - x.segment<3>(4);
+    };
+
+    if (!ring.update(cur_t, measure, Q, inject, propagate)) {
+        ROS_WARN("update skipped, innovation covariance not positive definite");
+        return;
     }
+    sync_state();
+//    cout << "P " << endl << ekf.P << endl;
+//    cout << "x " << endl << x.transpose() << endl;
 }
 
 /**
@@ -331,10 +323,7 @@ static void update(const geometry_msgs::TwistStamped &pnp)
  */
 static void initialize_imu(const sensor_msgs::Imu::ConstPtr &imu)
 {
-    t_prev = imu->header.stamp.toSec();
-    x_history.push(x);
-    P_history.push(P);
-    imu_buf.push(imu);
+    ring.push(imu->header.stamp.toSec(), x, ekf.P, imu_input(*imu), Matrix<double, 15, 15>::Identity());
     imu_count++;
     if (imu_count == IMU_INIT_COUNT) {
         imu_initialized = true;
@@ -358,18 +347,15 @@ static void initialize_visual(const geometry_msgs::TwistStamped::ConstPtr &pnp)
 
     imu_T_shield *= 0.001; // Convert millimeter to meter
 
-    throwState(cur_t);
-
     Quaterniond world_R_imu;
 
-    if (imu_buf.empty()) {
+    int k = ring.find(cur_t);
+    if (k < 0) {
         world_R_imu.setIdentity();
     }
     else {
-        world_R_imu = Quaterniond(imu_buf.front()->orientation.w,
-                                  imu_buf.front()->orientation.x,
-                                  imu_buf.front()->orientation.y,
-                                  imu_buf.front()->orientation.z);
+        const Ring::Input &u = ring.at(k).u;
+        world_R_imu = Quaterniond(u(6), u(7), u(8), u(9));
     }
     // Vector3d world_T_shield = world_R_imu.toRotationMatrix() * imu_T_shield;
     pub_debug_update(pnp->header, imu_T_shield, world_R_imu, cur_t);
@@ -381,9 +367,14 @@ static void initialize_visual(const geometry_msgs::TwistStamped::ConstPtr &pnp)
 
     cout << "DEBUG: x initialized with " << endl << x.transpose() << endl;
 
-    visual_initialized = true;
+    // the entries from the measurement time on were propagated from the zero state: the
+    // next, delayed, updates start from one of them
+    for (int i = std::max(k, 0); i < ring.size(); ++i) {
+        ring.at(i).x = x;
+    }
 
-    // repropagate();
+    visual_init_t = cur_t;
+    visual_initialized = true;
 }
 
 /**
@@ -416,15 +407,19 @@ void imu_callback(const sensor_msgs::Imu::ConstPtr &imu)
         initialize_imu(imu);
     }
     else {
-        propagate(*imu);
-        x_history.push(x);
-        P_history.push(P);
-        imu_buf.push(imu);
-		if (imu_buf.size() > MAX_GYRO_QUEUE_SIZE) {
-			x_history.pop();
-			P_history.pop();
-			imu_buf.pop();
-		}
+        Ring::Entry e;
+        e.t = imu->header.stamp.toSec();
+        e.u = imu_input(*imu);
+        propagate(ring.back(), e);
+        ring.push(e.t, e.x, e.P, e.u, e.F);
+
+        double dt = e.t - ring.at(ring.size() - 2).t;
+        Vector3d acc_wo_g = acc_without_gravity(ring.at(ring.size() - 2).x, e.u);
+        a_int_int += a_int * dt + 0.5 * acc_wo_g * dt * dt;
+        a_int += acc_wo_g * dt;
+        pub_debug_propagate(imu->header, acc_wo_g, a_int);
+
+        sync_state();
         pub_shield_odom(imu->header);
     }
 }
@@ -444,14 +439,20 @@ int main(int argc, char **argv)
     n.param("gravity_pose_weight", gravity_q_weight, 10.0);
     n.param("visual_translation_weight", visual_t_weight, 10.0);
     n.param("node_sleep_time", sleep_time, 0);
+    // delayed visual measurements: "repropagate" the imu since the measurement, up to
+    // max_repropagation steps, or correct it with the "cumulative" transition
+    string oosm_mode;
+    n.param("oosm_mode", oosm_mode, string("repropagate"));
+    n.param("max_repropagation", ring.max_repropagation, 40);
+    ring.mode = (oosm_mode == "cumulative") ? ekf_core::CUMULATIVE : ekf_core::REPROPAGATE;
 
     ros::Duration(sleep_time).sleep();
 
     // TODO: initalize the R and Q matrix
-    R.topLeftCorner(6, 6)     = acc_weight * MatrixXd::Identity(6, 6); // gyro, accelerometer noise
-    R.bottomRightCorner(6, 6) = acc_bias_weight * MatrixXd::Identity(6, 6); // accelerometer bias, gyro bias noise
-    Q.topLeftCorner(3, 3)     = gravity_q_weight * MatrixXd::Identity(3, 3); // orientation noise
-    Q.bottomRightCorner(3, 3) = visual_t_weight * MatrixXd::Identity(3, 3); // position noise
+    R.topLeftCorner<6, 6>()     = acc_weight * Matrix<double, 6, 6>::Identity(); // gyro, accelerometer noise
+    R.bottomRightCorner<6, 6>() = acc_bias_weight * Matrix<double, 6, 6>::Identity(); // accelerometer bias, gyro bias noise
+    Q.topLeftCorner<3, 3>()     = gravity_q_weight * Matrix3d::Identity(); // orientation noise
+    Q.bottomRightCorner<3, 3>() = visual_t_weight * Matrix3d::Identity(); // position noise
 
     x.setZero();
 
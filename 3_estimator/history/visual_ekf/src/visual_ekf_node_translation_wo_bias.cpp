@@ -18,6 +18,7 @@
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 #include <queue>
+#include <ekf_core/ekf.h>
 //#include "rm_cv/ArmorRecord.h"
 
 using namespace std;
@@ -38,10 +39,10 @@ int sleep_time;
  * Define noises:
  *      n = [n_acc]
  */
-VectorXd x(6);         // state
-MatrixXd P = MatrixXd::Identity(6, 6); // covariance
-MatrixXd R = MatrixXd::Identity(3, 3); // prediction noise covariance
-MatrixXd Q = MatrixXd::Identity(3, 3); // observation noise covariance
+Matrix<double, 6, 1> x; // state
+ekf_core::Ekf<6> ekf;    // covariance ekf.P
+Matrix3d R = Matrix3d::Identity(); // prediction noise covariance
+Matrix3d Q = Matrix3d::Identity(); // observation noise covariance
 
 // buffers to save gyro and visual reading
 queue<sensor_msgs::Imu::ConstPtr> imu_buf;
@@ -60,7 +61,7 @@ int imu_count  = 0;
 bool imu_initialized = false;
 bool visual_initialized = false;
 bool visual_valid = false;
-MatrixXd imu_R_camera = MatrixXd::Identity(3, 3); // rotation matrix from camera to imu
+Matrix3d imu_R_camera = Matrix3d::Identity(); // rotation matrix from camera to imu
 Vector3d imu_T_camera = MatrixXd::Zero(3, 1);
 
 //// DEBUG only
@@ -79,18 +80,18 @@ void pub_shield_odom(const std_msgs::Header& header)
     odom.twist.twist.linear.y = x(4);
     odom.twist.twist.linear.z = x(5);
 
-    odom.pose.covariance[0]  = P(0, 0);
-    odom.pose.covariance[7]  = P(1, 1);
-    odom.pose.covariance[14] = P(2, 2);
-    odom.pose.covariance[21] = P(3, 3);
-    odom.pose.covariance[28] = P(4, 4);
-    odom.pose.covariance[35] = P(5, 5);
-    odom.pose.covariance[3]  = P(0, 3);
-    odom.pose.covariance[10] = P(1, 4);
-    odom.pose.covariance[17] = P(2, 5);
-    odom.pose.covariance[18] = P(3, 0);
-    odom.pose.covariance[25] = P(4, 1);
-    odom.pose.covariance[32] = P(5, 2);
+    odom.pose.covariance[0]  = ekf.P(0, 0);
+    odom.pose.covariance[7]  = ekf.P(1, 1);
+    odom.pose.covariance[14] = ekf.P(2, 2);
+    odom.pose.covariance[21] = ekf.P(3, 3);
+    odom.pose.covariance[28] = ekf.P(4, 4);
+    odom.pose.covariance[35] = ekf.P(5, 5);
+    odom.pose.covariance[3]  = ekf.P(0, 3);
+    odom.pose.covariance[10] = ekf.P(1, 4);
+    odom.pose.covariance[17] = ekf.P(2, 5);
+    odom.pose.covariance[18] = ekf.P(3, 0);
+    odom.pose.covariance[25] = ekf.P(4, 1);
+    odom.pose.covariance[32] = ekf.P(5, 2);
     odom_pub.publish(odom);
 }
 
@@ -167,19 +168,18 @@ void propagate(const sensor_msgs::Imu &imu)
     a_int += acc_wo_g * dt;
     pub_debug_propagate(imu.header, acc_wo_g, a_int_int);
 
-    MatrixXd A = MatrixXd::Zero(6, 6);
-    A.block<3, 3>(0, 3) = MatrixXd::Identity(3, 3);
+    Matrix<double, 6, 6> A = Matrix<double, 6, 6>::Zero();
+    A.block<3, 3>(0, 3) = Matrix3d::Identity();
 
-    MatrixXd U = -MatrixXd::Zero(6, 3);
+    Matrix<double, 6, 3> U = Matrix<double, 6, 3>::Zero();
     U.block<3, 3>(3, 0) = -world_R_imu.toRotationMatrix();
 
-    MatrixXd F, V;
-    F = MatrixXd::Identity(6, 6) + dt * A;
-    V = dt * U;
+    Matrix<double, 6, 6> F = Matrix<double, 6, 6>::Identity() + dt * A;
+    Matrix<double, 6, 3> V = dt * U;
 //    cout << "F " << endl << F << endl;
 //    cout << "R " << endl << R << endl;
 //    cout << "V " << endl << V << endl;
-    P = F * P * F.transpose() + V * R * V.transpose();
+    ekf.predict(F, V, R);
 	
     t_prev = cur_t;
 //    cout << "P " << endl << P << endl;
@@ -211,7 +211,7 @@ static void repropagate()
         propagate(*imu_buf.front());
         temp_imu_buf.push(imu_buf.front());
         x_history.push(x);
-        P_history.push(P);
+        P_history.push(ekf.P);
         imu_buf.pop();
     }
     if (!temp_imu_buf.empty()) {
@@ -249,18 +249,20 @@ static void update(const geometry_msgs::TwistStamped &pnp)
     Vector3d world_T_shield = world_R_imu.toRotationMatrix() * imu_T_shield;
     pub_debug_update(pnp.header, world_T_shield, world_R_imu, cur_t);
 
-    MatrixXd C = MatrixXd::Zero(3, 6);
-    C.block<3, 3>(0, 0) = MatrixXd::Identity(3, 3);
+    Matrix<double, 3, 6> C = Matrix<double, 3, 6>::Zero();
+    C.block<3, 3>(0, 0) = Matrix3d::Identity();
 
-    Matrix3d W = MatrixXd::Identity(3, 3);
+    Matrix3d W = Matrix3d::Identity();
 
-    MatrixXd K(6, 3);
-    K = P * C.transpose() * (C * P * C.transpose() + W * Q * W.transpose()).inverse();
 //    cout << "C " << endl << C << endl;
-//    cout << "K " << endl << K << endl;
 //    cout << "Q " << endl << Q << endl;
-    x = x + K * (world_T_shield - C * x);
-    P = P - K * C * P;
+    Vector3d r = world_T_shield - C * x;
+    Matrix<double, 6, 1> dx;
+    if (!ekf.update(C, r, Matrix3d(W * Q * W.transpose()), dx)) {
+        ROS_WARN("update skipped, innovation covariance not positive definite");
+        return;
+    }
+    x += dx;
 //    cout << "P " << endl << P << endl;
 //    cout << "x " << endl << x.transpose() << endl;
 
@@ -277,7 +279,7 @@ static void initialize_imu(const sensor_msgs::Imu::ConstPtr &imu)
 {
     t_prev = imu->header.stamp.toSec();
     x_history.push(x);
-    P_history.push(P);
+    P_history.push(ekf.P);
     imu_buf.push(imu);
     imu_count++;
     if (imu_count == IMU_INIT_COUNT) {
@@ -361,7 +363,7 @@ void imu_callback(const sensor_msgs::Imu::ConstPtr &imu)
     else {
         propagate(*imu);
         x_history.push(x);
-        P_history.push(P);
+        P_history.push(ekf.P);
         imu_buf.push(imu);
 		if (imu_buf.size() > MAX_GYRO_QUEUE_SIZE) {
 			x_history.pop();
@@ -389,8 +391,8 @@ int main(int argc, char **argv)
     ros::Duration(sleep_time).sleep();
 
     // TODO: initalize the R and Q matrix
-    R =      acc_weight * MatrixXd::Identity(3, 3); // accelerometer noise
-    Q = visual_q_weight * MatrixXd::Identity(3, 3); // observation noise
+    R =      acc_weight * Matrix3d::Identity(); // accelerometer noise
+    Q = visual_q_weight * Matrix3d::Identity(); // observation noise
 
     x.setZero();
 
@@ -28,18 +28,21 @@
 void
 wheel_odom::MecanumWheel::calcOdom( )
 {
-    Eigen::MatrixXd F( 3, 4 );
+    // fixed size, no allocation per sample
+    const double k = 1 / ( m_a + m_b );
+    Eigen::Matrix< double, 3, 4 > F;
     F << 1, 1, 1, 1,
       1, -1, 1, -1,
-    - 1 / ( m_a + m_b ), 1 / ( m_a + m_b ), 1 / ( m_a + m_b ), -1 / ( m_a + m_b );
+    - k, k, k, -k;
 
-    F = 0.25 * F;
+    F *= 0.25;
 
     Eigen::Vector4d vel;
     vel << m_speed0, m_speed1, m_speed2, m_speed3;
 
-    Eigen::Vector3d vel_xyo = F * vel;
-    m_vel                   = Pose2Dd( vel_xyo( 0 ), vel_xyo( 1 ), vel_xyo( 2 ) );
+    Eigen::Vector3d vel_xyo;
+    vel_xyo.noalias( ) = F * vel;
+    m_vel              = Pose2Dd( vel_xyo( 0 ), vel_xyo( 1 ), vel_xyo( 2 ) );
     m_pose = m_pose.add( vel_xyo( 0 ) * m_deltaT, vel_xyo( 1 ) * m_deltaT, vel_xyo( 2 ) * m_deltaT );
 }
 
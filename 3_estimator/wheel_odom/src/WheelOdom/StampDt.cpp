@@ -0,0 +1,110 @@
+#include "StampDt.h"
+#include <cmath>
+
+wheel_odom::StampDt::StampDt( )
+: StampDt( 0.02, 0.1, 0.005 )
+{
+}
+
+wheel_odom::StampDt::StampDt( double nominal_dt, double max_dt, double jitter )
+: m_nominalDt( nominal_dt )
+, m_maxDt( max_dt )
+, m_jitter( jitter )
+{
+    reset( );
+}
+
+wheel_odom::StampDt::Status
+wheel_odom::StampDt::update( double stamp )
+{
+    if ( m_isFirst )
+    {
+        m_isFirst  = false;
+        m_timePrev = stamp;
+        m_dt       = 0.0;
+        return FIRST;
+    }
+
+    double dt = stamp - m_timePrev;
+    if ( dt <= 0.0 )
+    {
+        ++m_dropped;
+        m_dt = 0.0;
+        return DROPPED;
+    }
+    m_timePrev = stamp;
+    ++m_samples;
+
+    if ( dt > m_maxDt )
+    {
+        ++m_gaps;
+        m_dt = m_nominalDt;
+        return GAP;
+    }
+
+    m_dt            = dt;
+    double dt_error = std::fabs( dt - m_nominalDt );
+    if ( dt_error > m_jitterMax )
+        m_jitterMax = dt_error;
+    if ( dt_error > m_jitter )
+    {
+        ++m_jitters;
+        return JITTER;
+    }
+    return OK;
+}
+
+void
+wheel_odom::StampDt::reset( )
+{
+    m_isFirst   = true;
+    m_timePrev  = 0.0;
+    m_dt        = 0.0;
+    m_samples   = 0;
+    m_jitters   = 0;
+    m_gaps      = 0;
+    m_dropped   = 0;
+    m_jitterMax = 0.0;
+}
+
+double
+wheel_odom::StampDt::dt( ) const
+{
+    return m_dt;
+}
+
+double
+wheel_odom::StampDt::nominalDt( ) const
+{
+    return m_nominalDt;
+}
+
+double
+wheel_odom::StampDt::jitterMax( ) const
+{
+    return m_jitterMax;
+}
+
+long
+wheel_odom::StampDt::samples( ) const
+{
+    return m_samples;
+}
+
+long
+wheel_odom::StampDt::jitters( ) const
+{
+    return m_jitters;
+}
+
+long
+wheel_odom::StampDt::gaps( ) const
+{
+    return m_gaps;
+}
+
+long
+wheel_odom::StampDt::dropped( ) const
+{
+    return m_dropped;
+}
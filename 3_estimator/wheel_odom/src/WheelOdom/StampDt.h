@@ -0,0 +1,58 @@
+#ifndef STAMPDT_H
+#define STAMPDT_H
+
+namespace wheel_odom
+{
+
+// Integration step from the stamps of consecutive wheel samples
+//
+//   dt <= 0            : repeated or reordered stamp, the sample is dropped
+//   dt > max_dt        : gap (lost CAN frames, driver restart), the speed over
+//                        the gap is unknown, so only nominal_dt is integrated
+//   |dt - nominal| > j : jitter, integrated with the true dt but counted
+//
+class StampDt
+{
+    public:
+    enum Status
+    {
+        FIRST = 0,
+        OK,
+        JITTER,
+        GAP,
+        DROPPED
+    };
+
+    StampDt( );
+    StampDt( double nominal_dt, double max_dt, double jitter );
+
+    // stamp of the new sample, in sec
+    Status update( double stamp );
+    void reset( );
+
+    double dt( ) const;
+    double nominalDt( ) const;
+    double jitterMax( ) const;
+    long samples( ) const;
+    long jitters( ) const;
+    long gaps( ) const;
+    long dropped( ) const;
+
+    private:
+    double m_nominalDt;
+    double m_maxDt;
+    double m_jitter;
+
+    bool m_isFirst;
+    double m_timePrev;
+    double m_dt;
+
+    long m_samples;
+    long m_jitters;
+    long m_gaps;
+    long m_dropped;
+    double m_jitterMax; // largest |dt - nominal| seen, sec
+};
+}
+
+#endif // STAMPDT_H
@@ -1,14 +1,29 @@
 #include "WheelOdometryROS.h"
 
-wheel_odom::WheelOdometryROS::WheelOdometryROS( ros::NodeHandle nh, double length, double width )
-: is_first_run( true )
+wheel_odom::WheelOdometryROS::WheelOdometryROS( ros::NodeHandle nh, ros::NodeHandle pnh, double length, double width )
 {
     model_type = MECANUM_WHEEL;
     odom = wheel_odom::WheelOdomFactory::newWheelOdom( )->init( model_type, length, width );
 
-	std::string wheel_odom_topic;
-	nh.param("wheel_odom_topic", wheel_odom_topic, std::string("/wheel_odom_output"));
-	
+    std::string wheel_odom_topic;
+    pnh.param( "wheel_odom_topic", wheel_odom_topic, std::string( "/wheel_odom_output" ) );
+    pnh.param( "frame_id", m_frameId, std::string( "world" ) );
+    pnh.param( "child_frame_id", m_childFrameId, std::string( "base_link" ) );
+
+    // dt from the stamps, the motors report at 50Hz
+    double nominal_dt, max_dt, jitter;
+    pnh.param( "nominal_dt", nominal_dt, 0.02 );
+    pnh.param( "max_dt", max_dt, 5 * nominal_dt );
+    pnh.param( "jitter", jitter, 0.25 * nominal_dt );
+    m_stampDt = StampDt( nominal_dt, max_dt, jitter );
+
+    // either the raw motor speeds, or the wheelSpeeds of wheel_pub / a bag
+    bool use_motor_debug;
+    std::string motor_debug_topic;
+    pnh.param( "use_motor_debug", use_motor_debug, false );
+    pnh.param( "motor_debug_topic", motor_debug_topic, std::string( "/can_receive_1/motor_debug" ) );
+    pnh.param( "radius_wheel", m_radius, 0.076 );
+
     steering_sub
     = nh.subscribe< wheel_odom::steeringAngle >( "steering", //
                                                  1,
@@ -16,12 +31,20 @@ wheel_odom::WheelOdometryROS::WheelOdometryROS( ros::NodeHandle nh, double lengt
                                                  this,
                                                  ros::TransportHints( ).tcpNoDelay( true ) );
 
-    wheel_speeds_sub
-    = nh.subscribe< wheel_odom::wheelSpeeds >( "wheelSpeeds", //
-                                               1,
-                                               &WheelOdometryROS::speedCallback,
-                                               this,
-                                               ros::TransportHints( ).tcpNoDelay( true ) );
+    if ( use_motor_debug )
+        wheel_speeds_sub
+        = nh.subscribe< can_receive_msg::motor_debug >( motor_debug_topic, //
+                                                        10,
+                                                        &WheelOdometryROS::motorCallback,
+                                                        this,
+                                                        ros::TransportHints( ).tcpNoDelay( true ) );
+    else
+        wheel_speeds_sub
+        = nh.subscribe< wheel_odom::wheelSpeeds >( "wheelSpeeds", //
+                                                   10,
+                                                   &WheelOdometryROS::speedCallback,
+                                                   this,
+                                                   ros::TransportHints( ).tcpNoDelay( true ) );
 
     odom_pub = nh.advertise< nav_msgs::Odometry >( wheel_odom_topic, 1 );
 
@@ -38,95 +61,132 @@ wheel_odom::WheelOdometryROS::steeringCallback( const wheel_odom::steeringAngleC
 void
 wheel_odom::WheelOdometryROS::speedCallback( const wheel_odom::wheelSpeedsConstPtr& speed )
 {
-    if ( is_first_run )
-    {
-        is_first_run = false;
-        m_timePrev   = speed->header.stamp.toSec( );
-        return;
-    }
-    else
+    integrate( speed->header, speed->speedRF, speed->speedLF, speed->speedLB, speed->speedRB );
+}
+
+void
+wheel_odom::WheelOdometryROS::motorCallback( const can_receive_msg::motor_debugConstPtr& motor )
+{
+    integrate( motor->header,
+               motor->speed_[0] * m_radius,
+               motor->speed_[1] * m_radius,
+               motor->speed_[2] * m_radius,
+               motor->speed_[3] * m_radius );
+}
+
+void
+wheel_odom::WheelOdometryROS::integrate( const std_msgs::Header& header,
+                                         double speedRF,
+                                         double speedLF,
+                                         double speedLB,
+                                         double speedRB )
+{
+    switch ( m_stampDt.update( header.stamp.toSec( ) ) )
     {
-        m_dt       = speed->header.stamp.toSec( ) - m_timePrev;
-        m_timePrev = speed->header.stamp.toSec( );
+        case StampDt::FIRST:
+            return;
+        case StampDt::DROPPED:
+            ROS_WARN_THROTTLE( 1.0, "wheel_odom: non increasing stamp %f, sample dropped (%ld so far)",
+                               header.stamp.toSec( ), m_stampDt.dropped( ) );
+            return;
+        case StampDt::GAP:
+            ROS_WARN_THROTTLE( 1.0, "wheel_odom: gap in the wheel speeds before %f, integrated %f s only (%ld so far)",
+                               header.stamp.toSec( ), m_stampDt.dt( ), m_stampDt.gaps( ) );
+            break;
+        case StampDt::JITTER:
+            ROS_DEBUG( "wheel_odom: dt %f, nominal %f", m_stampDt.dt( ), m_stampDt.nominalDt( ) );
+            break;
+        default:
+            break;
     }
 
     switch ( model_type )
     {
         case FRONT_WHEEL:
-            odom->setSpeedIndex( speed->speedRF, 0 );
-            odom->setSpeedIndex( speed->speedLF, 1 );
+            odom->setSpeedIndex( speedRF, 0 );
+            odom->setSpeedIndex( speedLF, 1 );
             break;
         case REAR_WHEEL:
-            odom->setSpeedIndex( speed->speedRB, 0 );
-            odom->setSpeedIndex( speed->speedLB, 1 );
+            odom->setSpeedIndex( speedRB, 0 );
+            odom->setSpeedIndex( speedLB, 1 );
             break;
         case TRICYCLE:
-            odom->setSpeedIndex( ( speed->speedLF + speed->speedRF ) / 2, 0 );
+            odom->setSpeedIndex( ( speedLF + speedRF ) / 2, 0 );
             break;
         case OMNI_WHEEL:
-            odom->setSpeedIndex( speed->speedRF, 0 );
-            odom->setSpeedIndex( speed->speedLF, 1 );
-            odom->setSpeedIndex( speed->speedLB, 2 );
+            odom->setSpeedIndex( speedRF, 0 );
+            odom->setSpeedIndex( speedLF, 1 );
+            odom->setSpeedIndex( speedLB, 2 );
             break;
         case MECANUM_WHEEL:
-            odom->setSpeedIndex( speed->speedRF, 0 );
-            odom->setSpeedIndex( speed->speedLF, 1 );
-            odom->setSpeedIndex( speed->speedLB, 2 );
-            odom->setSpeedIndex( speed->speedRB, 3 );
+            odom->setSpeedIndex( speedRF, 0 );
+            odom->setSpeedIndex( speedLF, 1 );
+            odom->setSpeedIndex( speedLB, 2 );
+            odom->setSpeedIndex( speedRB, 3 );
             break;
         default:
             break;
     }
 
-    // odom->setDt( m_dt );
-    odom->setDt(0.02);
+    odom->setDt( m_stampDt.dt( ) );
 
     odom->calcOdom( );
 
+    publish( header.stamp );
+}
+
+void
+wheel_odom::WheelOdometryROS::publish( const ros::Time& stamp )
+{
     Pose2Dd odom2d = odom->getPose( );
     Pose2Dd vel2d  = odom->getVel( );
 
+    // the message published last is still queued for an intra process subscriber,
+    // which must not see it change: take a new one then, else fill the same one
+    if ( !odom_msg || !odom_msg.unique( ) )
     {
-        double yaw = odom2d.yaw;
+        odom_msg.reset( new nav_msgs::Odometry );
+        odom_msg->header.frame_id = m_frameId;
+        odom_msg->child_frame_id  = m_childFrameId;
+    }
+
+    double yaw = odom2d.yaw;
 
-        nav_msgs::OdometryPtr odom_msg( new nav_msgs::Odometry );
-        // odom_msg->header.stamp    = speed->header.stamp;
-        odom_msg->header.stamp = ros::Time::now();
-        odom_msg->header.frame_id = "world";
-        odom_msg->child_frame_id  = "base_link";
+    odom_msg->header.stamp = stamp;
 
-        odom_msg->pose.pose.position.x = odom2d.x;
-        odom_msg->pose.pose.position.y = odom2d.y;
-        odom_msg->pose.pose.position.z = 0;
+    odom_msg->pose.pose.position.x = odom2d.x;
+    odom_msg->pose.pose.position.y = odom2d.y;
+    odom_msg->pose.pose.position.z = 0;
 
-        odom_msg->pose.pose.orientation.w = cos( yaw / 2 );
-        odom_msg->pose.pose.orientation.x = 0.0;
-        odom_msg->pose.pose.orientation.y = 0.0;
-        odom_msg->pose.pose.orientation.z = sin( yaw / 2 );
+    odom_msg->pose.pose.orientation.w = cos( yaw / 2 );
+    odom_msg->pose.pose.orientation.x = 0.0;
+    odom_msg->pose.pose.orientation.y = 0.0;
+    odom_msg->pose.pose.orientation.z = sin( yaw / 2 );
 
-        odom_msg->twist.twist.linear.x = vel2d.x;
-        odom_msg->twist.twist.linear.y = vel2d.y; // assume velocity y is 0
-        odom_msg->twist.twist.linear.z = 0;
+    odom_msg->twist.twist.linear.x = vel2d.x;
+    odom_msg->twist.twist.linear.y = vel2d.y; // assume velocity y is 0
+    odom_msg->twist.twist.linear.z = 0;
 
-        odom_msg->twist.twist.angular.x = 0;
-        odom_msg->twist.twist.angular.y = 0;
-        odom_msg->twist.twist.angular.z = vel2d.yaw;
+    odom_msg->twist.twist.angular.x = 0;
+    odom_msg->twist.twist.angular.y = 0;
+    odom_msg->twist.twist.angular.z = vel2d.yaw;
 
+    if ( std::abs( vel2d.x * 5 ) > std::abs( pre_vx ) )
+    {
+        odom_pub.publish( odom_msg );
 
-        if (abs(vel2d.x * 5) > abs(pre_vx)) {
+        pre_vx = vel2d.x;
+        count  = 0;
+    }
+    else
+    {
+        count++;
+        if ( count > 3 )
+        {
             odom_pub.publish( odom_msg );
 
             pre_vx = vel2d.x;
-            count = 0;
-        }
-        else {
-            count++;
-            if (count > 3) {
-                odom_pub.publish( odom_msg );
-
-                pre_vx = vel2d.x;
-                count = 0;
-            }
+            count  = 0;
         }
     }
 }
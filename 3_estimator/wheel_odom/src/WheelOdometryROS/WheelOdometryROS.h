@@ -1,7 +1,9 @@
 #ifndef WHEELODOMETRYROS_H
 #define WHEELODOMETRYROS_H
 
+#include "../WheelOdom/StampDt.h"
 #include "../WheelOdom/WheelOdomFactory.h"
+#include <can_receive_msg/motor_debug.h>
 #include <nav_msgs/Odometry.h>
 #include <ros/ros.h>
 #include <wheel_odom/steeringAngle.h>
@@ -13,13 +15,21 @@ namespace wheel_odom
 class WheelOdometryROS
 {
     public:
-    WheelOdometryROS( ros::NodeHandle nh, double length, double width );
+    // nh for the topics, pnh for the parameters
+    WheelOdometryROS( ros::NodeHandle nh, ros::NodeHandle pnh, double length, double width );
 
     void steeringCallback( const wheel_odom::steeringAngleConstPtr& steeringAngle );
 
     void speedCallback( const wheel_odom::wheelSpeedsConstPtr& speed );
 
+    // raw motor speeds from can_receive, converted with the wheel radius
+    // (formerly wheel_preprocess/wtrans_node)
+    void motorCallback( const can_receive_msg::motor_debugConstPtr& motor );
+
     private:
+    void integrate( const std_msgs::Header& header, double speedRF, double speedLF, double speedLB, double speedRB );
+    void publish( const ros::Time& stamp );
+
     WheelOdomPtr odom;
     WheelModel model_type;
 
@@ -27,9 +37,13 @@ class WheelOdometryROS
     ros::Subscriber wheel_speeds_sub;
     ros::Publisher odom_pub;
 
-    double m_dt;
-    double m_timePrev;
-    bool is_first_run;
+    StampDt m_stampDt;
+    double m_radius; // wheel radius, for motor_debug
+
+    // reused while no subscriber holds the previous one
+    nav_msgs::OdometryPtr odom_msg;
+    std::string m_frameId;
+    std::string m_childFrameId;
 
     // for error bag only
     double pre_vx;
@@ -6,8 +6,13 @@ main( int argc, char** argv )
 {
     ros::init( argc, argv, "WheelOdometry" );
     ros::NodeHandle n;
+    ros::NodeHandle pn( "~" );
 
-    wheel_odom::WheelOdometryROS odom( n, 0.307, 0.419 );
+    double length, width;
+    pn.param( "vehicle_wheelbase", length, 0.307 );
+    pn.param( "vehicle_width", width, 0.419 );
+
+    wheel_odom::WheelOdometryROS odom( n, pn, length, width );
 
     ros::spin( );
 
@@ -0,0 +1,30 @@
+#include "WheelOdometryROS/WheelOdometryROS.h"
+#include <boost/scoped_ptr.hpp>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+namespace wheel_odom
+{
+
+// wheel_odom as a nodelet, so that the nodelets loaded in the same manager get the
+// odometry by pointer. can_receive is a plain node: its motor speeds still arrive
+// serialized, until it is loaded in the same manager
+class WheelOdometryNodelet : public nodelet::Nodelet
+{
+    private:
+    virtual void onInit( )
+    {
+        ros::NodeHandle& pn = getPrivateNodeHandle( );
+
+        double length, width;
+        pn.param( "vehicle_wheelbase", length, 0.307 );
+        pn.param( "vehicle_width", width, 0.419 );
+
+        odom.reset( new WheelOdometryROS( getNodeHandle( ), pn, length, width ) );
+    }
+
+    boost::scoped_ptr< WheelOdometryROS > odom;
+};
+}
+
+PLUGINLIB_EXPORT_CLASS( wheel_odom::WheelOdometryNodelet, nodelet::Nodelet )
@@ -0,0 +1,229 @@
+// Replay of a recorded motor_debug stream through the former wheel_preprocess + wheel_odom
+// pipeline and through the stamp driven one, e.g.
+//
+//   rosbag record /can_receive_1/motor_debug
+//   rosrun wheel_odom wheel_odom_benchmark motor.bag [topic] [radius_wheel]
+//
+// drift: both pipelines integrate the same speeds, the former one with dt = 0.02 whatever
+// the spacing of the stamps, so its pose drifts from the stamp driven one as the CAN bus
+// jitters and drops frames.
+// latency: cpu time per sample from the motor_debug to the odometry message, including the
+// wheelSpeeds hop of wtrans_node (its serialize + deserialize, not its transport).
+
+#include "WheelOdom/StampDt.h"
+#include "WheelOdom/WheelOdomFactory.h"
+#include <can_receive_msg/motor_debug.h>
+#include <nav_msgs/Odometry.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+#include <wheel_odom/wheelSpeeds.h>
+
+#include <boost/foreach.hpp>
+#include <boost/shared_array.hpp>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+// Eigen and roscpp allocate with malloc, so count every malloc of the process (glibc)
+static long alloc_count = 0;
+
+extern "C" void* __libc_malloc( size_t size );
+
+extern "C" void*
+malloc( size_t size )
+{
+    ++alloc_count;
+    return __libc_malloc( size );
+}
+
+struct Result
+{
+    Pose2Dd pose;
+    double time; // integrated time, sec
+    double us_per_sample;
+    double allocs_per_sample;
+};
+
+// MecanumWheel::calcOdom before the fixed size kinematics
+static void
+calcOdomDynamic( double a, double b, const Eigen::Vector4d& vel, double dt, Pose2Dd& pose, Pose2Dd& vel2d )
+{
+    Eigen::MatrixXd F( 3, 4 );
+    F << 1, 1, 1, 1,
+      1, -1, 1, -1,
+    - 1 / ( a + b ), 1 / ( a + b ), 1 / ( a + b ), -1 / ( a + b );
+
+    F = 0.25 * F;
+
+    Eigen::Vector3d vel_xyo = F * vel;
+    vel2d                   = Pose2Dd( vel_xyo( 0 ), vel_xyo( 1 ), vel_xyo( 2 ) );
+    pose = pose.add( vel_xyo( 0 ) * dt, vel_xyo( 1 ) * dt, vel_xyo( 2 ) * dt );
+}
+
+static void
+fillOdom( nav_msgs::Odometry& msg, const ros::Time& stamp, const Pose2Dd& pose, const Pose2Dd& vel )
+{
+    msg.header.stamp            = stamp;
+    msg.pose.pose.position.x    = pose.x;
+    msg.pose.pose.position.y    = pose.y;
+    msg.pose.pose.orientation.w = cos( pose.yaw / 2 );
+    msg.pose.pose.orientation.z = sin( pose.yaw / 2 );
+    msg.twist.twist.linear.x    = vel.x;
+    msg.twist.twist.linear.y    = vel.y;
+    msg.twist.twist.angular.z   = vel.yaw;
+}
+
+// wtrans_node -> wheelSpeeds -> wheel_odom with setDt( 0.02 ), new message per sample
+static Result
+runFormer( const std::vector< can_receive_msg::motor_debug >& samples, double R, double length, double width )
+{
+    Result result;
+    result.time = 0;
+    Pose2Dd vel2d;
+    bool is_first_run = true;
+    double sink       = 0;
+
+    long allocs = alloc_count;
+    auto start  = std::chrono::steady_clock::now( );
+    for ( size_t i = 0; i < samples.size( ); ++i )
+    {
+        const can_receive_msg::motor_debug& msg = samples[i];
+
+        wheel_odom::wheelSpeeds speeds;
+        speeds.header.frame_id = "wheel";
+        speeds.header.stamp    = msg.header.stamp;
+        speeds.header.seq      = msg.header.seq;
+        speeds.speedRF         = msg.speed_[0] * R;
+        speeds.speedLF         = msg.speed_[1] * R;
+        speeds.speedLB         = msg.speed_[2] * R;
+        speeds.speedRB         = msg.speed_[3] * R;
+
+        uint32_t length_msg = ros::serialization::serializationLength( speeds );
+        boost::shared_array< uint8_t > buffer( new uint8_t[length_msg] );
+        ros::serialization::OStream out( buffer.get( ), length_msg );
+        ros::serialization::serialize( out, speeds );
+        wheel_odom::wheelSpeeds received;
+        ros::serialization::IStream in( buffer.get( ), length_msg );
+        ros::serialization::deserialize( in, received );
+
+        if ( is_first_run )
+        {
+            is_first_run = false;
+            continue;
+        }
+
+        Eigen::Vector4d vel( received.speedRF, received.speedLF, received.speedLB, received.speedRB );
+        calcOdomDynamic( width / 2, length / 2, vel, 0.02, result.pose, vel2d );
+        result.time += 0.02;
+
+        nav_msgs::OdometryPtr odom_msg( new nav_msgs::Odometry );
+        odom_msg->header.frame_id = "world";
+        odom_msg->child_frame_id  = "base_link";
+        fillOdom( *odom_msg, received.header.stamp, result.pose, vel2d );
+        sink += odom_msg->pose.pose.position.x;
+    }
+    double us = std::chrono::duration< double, std::micro >( std::chrono::steady_clock::now( ) - start ).count( );
+    result.us_per_sample     = us / samples.size( );
+    result.allocs_per_sample = double( alloc_count - allocs ) / samples.size( );
+    if ( sink == 12345.6789 )
+        std::cout << sink;
+    return result;
+}
+
+// WheelOdometryROS::motorCallback
+static Result
+runStamped( const std::vector< can_receive_msg::motor_debug >& samples,
+            double R,
+            double length,
+            double width,
+            wheel_odom::StampDt& stampDt )
+{
+    Result result;
+    result.time = 0;
+    wheel_odom::WheelOdomPtr odom
+    = wheel_odom::WheelOdomFactory::newWheelOdom( )->init( wheel_odom::MECANUM_WHEEL, length, width );
+    nav_msgs::OdometryPtr odom_msg( new nav_msgs::Odometry );
+    odom_msg->header.frame_id = "world";
+    odom_msg->child_frame_id  = "base_link";
+
+    long allocs = alloc_count;
+    auto start  = std::chrono::steady_clock::now( );
+    for ( size_t i = 0; i < samples.size( ); ++i )
+    {
+        const can_receive_msg::motor_debug& msg = samples[i];
+
+        wheel_odom::StampDt::Status status = stampDt.update( msg.header.stamp.toSec( ) );
+        if ( status == wheel_odom::StampDt::FIRST || status == wheel_odom::StampDt::DROPPED )
+            continue;
+
+        odom->setSpeedIndex( msg.speed_[0] * R, 0 );
+        odom->setSpeedIndex( msg.speed_[1] * R, 1 );
+        odom->setSpeedIndex( msg.speed_[2] * R, 2 );
+        odom->setSpeedIndex( msg.speed_[3] * R, 3 );
+        odom->setDt( stampDt.dt( ) );
+        odom->calcOdom( );
+        result.time += stampDt.dt( );
+
+        fillOdom( *odom_msg, msg.header.stamp, odom->getPose( ), odom->getVel( ) );
+    }
+    double us = std::chrono::duration< double, std::micro >( std::chrono::steady_clock::now( ) - start ).count( );
+    result.us_per_sample     = us / samples.size( );
+    result.allocs_per_sample = double( alloc_count - allocs ) / samples.size( );
+    result.pose              = odom->getPose( );
+    return result;
+}
+
+int
+main( int argc, char** argv )
+{
+    if ( argc < 2 )
+    {
+        std::cout << "usage: wheel_odom_benchmark <bag> [topic = /can_receive_1/motor_debug] [radius_wheel = 0.076]\n";
+        return 1;
+    }
+    std::string topic = ( argc > 2 ) ? argv[2] : "/can_receive_1/motor_debug";
+    double R          = ( argc > 3 ) ? atof( argv[3] ) : 0.076;
+    double length = 0.307, width = 0.419;
+
+    std::vector< can_receive_msg::motor_debug > samples;
+    rosbag::Bag bag( argv[1], rosbag::bagmode::Read );
+    rosbag::View view( bag, rosbag::TopicQuery( topic ) );
+    BOOST_FOREACH ( const rosbag::MessageInstance& m, view )
+    {
+        can_receive_msg::motor_debug::ConstPtr msg = m.instantiate< can_receive_msg::motor_debug >( );
+        if ( msg )
+            samples.push_back( *msg );
+    }
+    bag.close( );
+    if ( samples.size( ) < 2 )
+    {
+        std::cout << "less than 2 " << topic << " messages in " << argv[1] << "\n";
+        return 1;
+    }
+
+    wheel_odom::StampDt stampDt( 0.02, 0.1, 0.005 );
+    Result former  = runFormer( samples, R, length, width );
+    Result stamped = runStamped( samples, R, length, width, stampDt );
+
+    double span = samples.back( ).header.stamp.toSec( ) - samples.front( ).header.stamp.toSec( );
+    std::cout << std::fixed << std::setprecision( 4 );
+    std::cout << samples.size( ) << " samples over " << span << " s, mean dt " << span / ( samples.size( ) - 1 )
+              << ", max |dt - 0.02| " << stampDt.jitterMax( ) << ", jitter > 5 ms " << stampDt.jitters( )
+              << ", gaps > 0.1 s " << stampDt.gaps( ) << ", dropped " << stampDt.dropped( ) << "\n\n";
+
+    std::cout << std::setw( 10 ) << "" << std::setw( 12 ) << "time (s)" << std::setw( 10 ) << "x" << std::setw( 10 )
+              << "y" << std::setw( 10 ) << "yaw" << std::setw( 12 ) << "us/sample" << std::setw( 14 ) << "allocs/sample"
+              << "\n";
+    const Result* results[] = { &former, &stamped };
+    const char* names[]     = { "former", "stamped" };
+    for ( int i = 0; i < 2; ++i )
+        std::cout << std::setw( 10 ) << names[i] << std::setw( 12 ) << results[i]->time << std::setw( 10 )
+                  << results[i]->pose.x << std::setw( 10 ) << results[i]->pose.y << std::setw( 10 )
+                  << results[i]->pose.yaw << std::setw( 12 ) << results[i]->us_per_sample << std::setw( 14 )
+                  << results[i]->allocs_per_sample << "\n";
+
+    std::cout << "\ndrift of the fixed dt: "
+              << hypot( former.pose.x - stamped.pose.x, former.pose.y - stamped.pose.y ) << " m, "
+              << former.pose.yaw - stamped.pose.yaw << " rad\n";
+    return 0;
+}
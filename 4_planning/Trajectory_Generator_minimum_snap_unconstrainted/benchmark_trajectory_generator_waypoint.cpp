@@ -0,0 +1,59 @@
+#include "trajectory_generator_waypoint.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+using namespace Eigen;
+
+/*   Compare the dense and the banded waypoint solver on random paths:
+ * g++ -O3 -std=c++11 -I/usr/include/eigen3 benchmark_trajectory_generator_waypoint.cpp trajectory_generator_waypoint.cpp  */
+
+static double timeSolve(TrajectoryGeneratorWaypoint &generator, bool banded, int runs,
+                        const MatrixXd &Path, const Vector3d &Vel, const Vector3d &Acc,
+                        const VectorXd &Time, MatrixXd &coeff)
+{
+      auto start = chrono::steady_clock::now();
+
+      for(int i = 0; i < runs; i ++)
+          coeff = banded ? generator.PolyQPGenerationBanded(Path, Vel, Acc, Time)
+                         : generator.PolyQPGeneration(Path, Vel, Acc, Time);
+
+      return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / runs;
+}
+
+int main(int argc, char **argv)
+{
+      const int segments[] = {5, 10, 20, 50, 100, 200, 500};
+      const int max_dense  = (argc > 1) ? atoi(argv[1]) : 200;
+
+      srand(0);
+      printf("%6s %14s %14s %14s %14s\n", "m", "dense [ms]", "banded [ms]", "max |dc|", "d cost");
+
+      for(int m : segments){
+          MatrixXd Path = MatrixXd::Random(m + 1, 3) * 5.0;
+          VectorXd Time = VectorXd::Random(m).cwiseAbs() + VectorXd::Constant(m, 0.5);
+          Vector3d Vel  = Vector3d::Random();
+          Vector3d Acc  = Vector3d::Random();
+
+          TrajectoryGeneratorWaypoint generator;
+          MatrixXd dense, banded;
+          int runs = max(1, 2000 / m);
+
+          double t_banded = timeSolve(generator, true, runs, Path, Vel, Acc, Time, banded);
+          double c_banded = generator.getObjective();
+
+          if( m > max_dense ){
+              printf("%6d %14s %14.4f %14s %14s\n", m, "-", t_banded, "-", "-");
+              continue;
+          }
+
+          double t_dense = timeSolve(generator, false, max(1, runs / 10), Path, Vel, Acc, Time, dense);
+          double c_dense = generator.getObjective();
+
+          printf("%6d %14.4f %14.4f %14.3e %14.3e\n", m, t_dense, t_banded,
+                 (dense - banded).cwiseAbs().maxCoeff(), fabs(c_dense - c_banded) / c_dense);
+      }
+
+      return 0;
+}
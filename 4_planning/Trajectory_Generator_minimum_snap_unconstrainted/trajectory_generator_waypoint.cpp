@@ -1,7 +1,5 @@
 #include "trajectory_generator_waypoint.h"
 #include <stdio.h>
-#include <ros/ros.h>
-#include <ros/console.h>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -101,6 +99,7 @@ Eigen::MatrixXd TrajectoryGeneratorWaypoint::PolyQPGeneration(
       cout<<"H1d:\n"<<H1d<<endl;*/
 
       _Q = H; // Now only minumum snap is used in the cost
+      _Q_seg.clear();
 
       if( m > 1)
       {   
@@ -208,8 +207,140 @@ Eigen::MatrixXd TrajectoryGeneratorWaypoint::PolyQPGeneration(
       return PolyCoeff;
 }  
 
+Eigen::MatrixXd TrajectoryGeneratorWaypoint::PolyQPGenerationBanded(
+            const Eigen::MatrixXd &Path,
+            const Eigen::Vector3d &Vel,
+            const Eigen::Vector3d &Acc,
+            const Eigen::VectorXd &Time)
+{
+      typedef Matrix<double, 6, 6> Matrix6d;
+      typedef Matrix<double, 6, 3> Matrix63d;
+      typedef Matrix<double, 2, 3> Matrix23d;
+
+      int m = Time.size();
+      MatrixXd PolyCoeff(m, 3 * 6);
+      VectorXd Px(6 * m), Py(6 * m), Pz(6 * m);
+
+      /*   Per-segment mapping from the boundary derivatives
+       * [p(0) p(T) v(0) v(T) a(0) a(T)] to the quintic coefficients, in closed form,
+       * and the cost expressed on the boundary derivatives M = A_inv^T * Q * A_inv.  */
+      vector<Matrix6d, aligned_allocator<Matrix6d>> A_inv(m), M(m);
+      vector<Matrix63d, aligned_allocator<Matrix63d>> D(m);
+      _Q_seg.resize(m);
+
+      for(int k = 0; k < m; k++){
+          double t1 = Time(k), t2 = t1 * t1, t3 = t2 * t1, t4 = t3 * t1, t5 = t4 * t1;
+          Matrix6d &Ai = A_inv[k];
+
+          Ai.setZero();
+          Ai(0, 0) = 1.0;
+          Ai(1, 2) = 1.0;
+          Ai(2, 4) = 0.5;
+          Ai(3, 0) = -10.0 / t3; Ai(3, 1) =  10.0 / t3; Ai(3, 2) = -6.0 / t2; Ai(3, 3) = -4.0 / t2; Ai(3, 4) = -1.5 / t1; Ai(3, 5) =  0.5 / t1;
+          Ai(4, 0) =  15.0 / t4; Ai(4, 1) = -15.0 / t4; Ai(4, 2) =  8.0 / t3; Ai(4, 3) =  7.0 / t3; Ai(4, 4) =  1.5 / t2; Ai(4, 5) = -1.0 / t2;
+          Ai(5, 0) =  -6.0 / t5; Ai(5, 1) =   6.0 / t5; Ai(5, 2) = -3.0 / t4; Ai(5, 3) = -3.0 / t4; Ai(5, 4) = -0.5 / t3; Ai(5, 5) =  0.5 / t3;
+
+          Matrix6d &Qk = _Q_seg[k];
+          Qk.setZero();
+          for(int i = 3; i < 6; i ++)
+              for(int j = 3; j < 6; j ++)
+                  Qk(i, j) = (double)i * (i - 1) * (i - 2) * j * (j - 1) * (j - 2) / (double)(i + j - 5) * pow( Time(k), (i + j - 5) );
+
+          M[k] = Ai.transpose() * Qk * Ai;
+
+          /*   Fixed derivatives of this segment, zero at the free slots.  */
+          D[k].setZero();
+          D[k].row(0) = Path.row(k);
+          D[k].row(1) = Path.row(k + 1);
+      }
+
+      D[0].row(2) = Vel.transpose();
+      D[0].row(4) = Acc.transpose();
+      _Q.resize(0, 0);
+
+      if( m > 1)
+      {
+          /*   The free variables x_j = [v_j a_j] of waypoint j = 1 .. m - 1 are the end (R)
+           * slots of segment j - 1 and the start (L) slots of segment j, so the reduced
+           * Hessian is block tridiagonal with 2x2 blocks. Eliminate it with a block
+           * Cholesky sweep for the three axes at once.  */
+          const int L[2] = {2, 4}, R[2] = {3, 5};
+          const auto Sub = [](const Matrix6d &X, const int *r, const int *c){
+              Matrix2d S;
+              S << X(r[0], c[0]), X(r[0], c[1]), X(r[1], c[0]), X(r[1], c[1]);
+              return S;
+          };
+          const auto Rows = [](const Matrix6d &X, const int *r){
+              Matrix<double, 2, 6> S;
+              S << X.row(r[0]), X.row(r[1]);
+              return S;
+          };
+
+          int n = m - 1;
+          vector<LLT<Matrix2d>, aligned_allocator<LLT<Matrix2d>>> S(n);
+          vector<Matrix2d, aligned_allocator<Matrix2d>> U(n);
+          vector<Matrix23d, aligned_allocator<Matrix23d>> y(n), x(n);
+
+          for(int j = 0; j < n; j ++){
+              Matrix2d  Dj = Sub(M[j], R, R) + Sub(M[j + 1], L, L);
+              Matrix23d bj = - Rows(M[j], R) * D[j] - Rows(M[j + 1], L) * D[j + 1];
+
+              if( j > 0 ){
+                  Matrix2d W = S[j - 1].solve(U[j - 1]);
+                  Dj -= U[j - 1].transpose() * W;
+                  bj -= W.transpose() * y[j - 1];
+              }
+
+              S[j].compute(Dj);
+              y[j] = bj;
+
+              if( j < n - 1 )
+                  U[j] = Sub(M[j + 1], L, R);
+          }
+
+          x[n - 1] = S[n - 1].solve(y[n - 1]);
+          for(int j = n - 2; j >= 0; j --)
+              x[j] = S[j].solve(y[j] - U[j] * x[j + 1]);
+
+          for(int j = 0; j < n; j ++){
+              D[j].row(3)     = x[j].row(0);
+              D[j].row(5)     = x[j].row(1);
+              D[j + 1].row(2) = x[j].row(0);
+              D[j + 1].row(4) = x[j].row(1);
+          }
+      }
+
+      for(int k = 0; k < m; k ++)
+      {
+          Matrix63d P = A_inv[k] * D[k];
+
+          Px.segment(k * 6, 6) = P.col(0);
+          Py.segment(k * 6, 6) = P.col(1);
+          Pz.segment(k * 6, 6) = P.col(2);
+
+          PolyCoeff.block(k, 0,  1, 6) = P.col(0).transpose();
+          PolyCoeff.block(k, 6,  1, 6) = P.col(1).transpose();
+          PolyCoeff.block(k, 12, 1, 6) = P.col(2).transpose();
+      }
+
+      _Px = Px;
+      _Py = Py;
+      _Pz = Pz;
+
+      return PolyCoeff;
+}
+
 double TrajectoryGeneratorWaypoint::getObjective()
 { 
+      if( !_Q_seg.empty() ){
+          _qp_cost = 0.0;
+          for(int k = 0; k < (int)_Q_seg.size(); k ++)
+              _qp_cost += _Px.segment(k * 6, 6).dot(_Q_seg[k] * _Px.segment(k * 6, 6))
+                        + _Py.segment(k * 6, 6).dot(_Q_seg[k] * _Py.segment(k * 6, 6))
+                        + _Pz.segment(k * 6, 6).dot(_Q_seg[k] * _Pz.segment(k * 6, 6));
+          return _qp_cost;
+      }
+
       _qp_cost = (_Px.transpose() * _Q * _Px + _Py.transpose() * _Q * _Py + _Pz.transpose() * _Q * _Pz)(0);
       return _qp_cost; 
 }
@@ -7,6 +7,8 @@ class TrajectoryGeneratorWaypoint {
 private:
 		double _qp_cost;
 		Eigen::MatrixXd _Q;
+		std::vector<Eigen::Matrix<double, 6, 6>,
+		    Eigen::aligned_allocator<Eigen::Matrix<double, 6, 6>>> _Q_seg;
 		Eigen::VectorXd _Px, _Py, _Pz;
 public:
         TrajectoryGeneratorWaypoint();
@@ -19,6 +21,14 @@ public:
             const Eigen::Vector3d &Acc,
             const Eigen::VectorXd &Time);
 
+        // Same problem as PolyQPGeneration, solved in O(m) by eliminating the
+        // block-tridiagonal system of the free velocities/accelerations
+        Eigen::MatrixXd PolyQPGenerationBanded(
+            const Eigen::MatrixXd &Path,
+            const Eigen::Vector3d &Vel,
+            const Eigen::Vector3d &Acc,
+            const Eigen::VectorXd &Time);
+
         double getObjective();
 };
 
@@ -0,0 +1,58 @@
+#ifndef _GLOBAL_PLANNER_GRID_GRID_MAP_H_
+#define _GLOBAL_PLANNER_GRID_GRID_MAP_H_
+
+#include <Eigen/Eigen>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * Static occupancy grid loaded from a map_server style yaml/pgm pair, with a
+ * Euclidean distance field to the nearest obstacle and an inflated obstacle mask.
+ * Cell (0, 0) is the bottom-left pixel of the image, as in map_server.
+ */
+class GridMap {
+private:
+    int _width, _height;
+    double _resolution;
+    Eigen::Vector2d _origin;
+    double _inflation_radius;
+
+    std::vector<uint8_t> _occupied;   // raw obstacles, unknown cells count as occupied
+    std::vector<uint8_t> _blocked;    // obstacles inflated by the robot radius
+    std::vector<float> _distance;     // distance to the nearest obstacle [m]
+
+    void computeDistanceField();
+
+public:
+    GridMap();
+
+    // load the yaml file written by map_saver; the image path is relative to it
+    bool load(const std::string &yaml_file);
+
+    bool loadPGM(const std::string &pgm_file, double resolution, const Eigen::Vector2d &origin,
+                 bool negate, double free_thresh);
+
+    // mark every cell closer than radius to an obstacle as blocked
+    void inflate(double radius);
+
+    inline int width() const { return _width; }
+    inline int height() const { return _height; }
+    inline double resolution() const { return _resolution; }
+    inline const Eigen::Vector2d &origin() const { return _origin; }
+    inline double inflationRadius() const { return _inflation_radius; }
+
+    inline int index(int x, int y) const { return y * _width + x; }
+    inline bool inside(int x, int y) const { return x >= 0 && y >= 0 && x < _width && y < _height; }
+    inline bool isOccupied(int x, int y) const { return _occupied[index(x, y)] != 0; }
+    inline bool isBlocked(int x, int y) const { return !inside(x, y) || _blocked[index(x, y)] != 0; }
+    inline double distance(int x, int y) const { return _distance[index(x, y)]; }
+
+    Eigen::Vector2i worldToGrid(const Eigen::Vector2d &p) const;
+    Eigen::Vector2d gridToWorld(const Eigen::Vector2i &c) const;
+
+    // nearest free cell to c within max_radius cells, or c itself if none is found
+    Eigen::Vector2i nearestFree(const Eigen::Vector2i &c, int max_radius) const;
+};
+
+#endif
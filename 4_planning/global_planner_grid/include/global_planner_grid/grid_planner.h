@@ -0,0 +1,72 @@
+#ifndef _GLOBAL_PLANNER_GRID_GRID_PLANNER_H_
+#define _GLOBAL_PLANNER_GRID_GRID_PLANNER_H_
+
+#include "global_planner_grid/grid_map.h"
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+/**
+ * 8-connected grid search over a GridMap, diagonal moves never cut obstacle corners.
+ *
+ * planJPS:   Jump Point Search on the inflated obstacle mask, uniform cost.
+ * planAStar: A* whose step cost grows close to obstacles (distance field), with an
+ *            incremental mode that keeps the heuristics learned by previous searches
+ *            and corrects them when the goal moves (Moving Target / Generalized
+ *            Adaptive A*, Sun, Koenig and Yeoh 2008), so replanning towards a drifting
+ *            goal from a drifting start expands far fewer cells than a fresh search.
+ */
+class GridPlanner {
+private:
+    const GridMap &_map;
+    double _clearance_weight, _clearance;
+    size_t _expansions;
+
+    // per-cell A* state, tagged with the id of the search that last touched it
+    std::vector<float> _g, _h;
+    std::vector<int> _parent;
+    std::vector<uint32_t> _search, _closed;
+    uint32_t _counter;
+    std::vector<float> _pathcost, _deltah;
+    int _goal;
+
+    // per-cell JPS state
+    std::vector<float> _jps_g;
+    std::vector<int> _jps_parent;
+    std::vector<uint32_t> _jps_search, _jps_closed;
+    uint32_t _jps_counter;
+
+    std::vector<std::pair<float, int>> _open;
+
+    float octile(int a, int b) const;
+    float stepCost(int to, int dx, int dy) const;
+    void initializeState(int s);
+    int jump(int x, int y, int dx, int dy, int gx, int gy) const;
+    void pushOpen(float f, int s);
+    int popOpen();
+
+public:
+    GridPlanner(const GridMap &map);
+
+    // A* step cost is multiplied by 1 + weight * max(0, 1 - d / clearance), d being the obstacle distance
+    void setClearanceCost(double weight, double clearance);
+
+    bool planJPS(const Eigen::Vector2i &start, const Eigen::Vector2i &goal, std::vector<Eigen::Vector2i> &path);
+
+    bool planAStar(const Eigen::Vector2i &start, const Eigen::Vector2i &goal, std::vector<Eigen::Vector2i> &path,
+                   bool incremental = true);
+
+    // forget the heuristics learned by previous incremental searches
+    void reset();
+
+    // drop every waypoint that the previous kept waypoint can see directly
+    std::vector<Eigen::Vector2i> simplify(const std::vector<Eigen::Vector2i> &path) const;
+
+    bool lineOfSight(const Eigen::Vector2i &a, const Eigen::Vector2i &b) const;
+
+    static double length(const std::vector<Eigen::Vector2i> &path);
+
+    inline size_t expansions() const { return _expansions; }
+};
+
+#endif
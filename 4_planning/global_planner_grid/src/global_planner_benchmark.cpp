@@ -0,0 +1,131 @@
+#include "global_planner_grid/grid_map.h"
+#include "global_planner_grid/grid_planner.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+using namespace Eigen;
+
+/*   Planning time on the competition maps, random start/goal pairs:
+ * global_planner_benchmark <map.yaml> [map.yaml ...] [-n pairs] [-r inflation_radius]  */
+
+static double now()
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static Vector2i randomFree(const GridMap &map)
+{
+    while (true) {
+        Vector2i c(rand() % map.width(), rand() % map.height());
+        if (!map.isBlocked(c(0), c(1)))
+            return c;
+    }
+}
+
+static void benchmark(const char *yaml, int pairs, double radius)
+{
+    GridMap map;
+    if (!map.load(yaml)) {
+        printf("cannot load %s\n", yaml);
+        return;
+    }
+    map.inflate(radius);
+
+    GridPlanner planner(map);
+    vector<Vector2i> path, reference;
+    double t_jps = 0, t_astar = 0, max_error = 0;
+    size_t e_jps = 0, e_astar = 0;
+    int solved = 0;
+
+    srand(0);
+    for (int i = 0; i < pairs; i++) {
+        Vector2i start = randomFree(map), goal = randomFree(map);
+
+        double t0 = now();
+        bool ok_jps = planner.planJPS(start, goal, path);
+        double t1 = now();
+        e_jps += planner.expansions();
+        bool ok_astar = planner.planAStar(start, goal, reference, false);
+        double t2 = now();
+        e_astar += planner.expansions();
+
+        if (ok_jps != ok_astar) {
+            printf("  pair %d: jps %d astar %d disagree on reachability\n", i, ok_jps, ok_astar);
+            continue;
+        }
+        if (!ok_jps)
+            continue;
+
+        solved++;
+        t_jps += t1 - t0;
+        t_astar += t2 - t1;
+        max_error = max(max_error, fabs(GridPlanner::length(path) - GridPlanner::length(reference)));
+    }
+
+    printf("%s: %dx%d cells, %.2f m inflation, %d/%d pairs connected\n",
+           yaml, map.width(), map.height(), radius, solved, pairs);
+    printf("  %-22s %10.4f ms %10.1f expansions\n", "jps", t_jps / max(solved, 1), (double) e_jps / pairs);
+    printf("  %-22s %10.4f ms %10.1f expansions\n", "astar", t_astar / max(solved, 1), (double) e_astar / pairs);
+    printf("  max |jps - astar| path length %.2e cells\n", max_error);
+
+    // moving goal: the robot advances along its path while the goal drifts, replanning every step
+    planner.setClearanceCost(2.0, 0.5);
+    for (int incremental = 0; incremental < 2; incremental++) {
+        srand(1);
+        double t = 0;
+        size_t expansions = 0;
+        int plans = 0;
+
+        for (int i = 0; i < pairs / 10 + 1; i++) {
+            Vector2i start = randomFree(map), goal = randomFree(map);
+            planner.reset();
+
+            for (int step = 0; step < 30; step++) {
+                double t0 = now();
+                bool ok = planner.planAStar(start, goal, path, incremental != 0);
+                t += now() - t0;
+                expansions += planner.expansions();
+                plans++;
+                if (!ok || path.size() < 3)
+                    break;
+
+                start = path[2];
+                Vector2i next = goal + Vector2i(rand() % 3 - 1, rand() % 3 - 1);
+                if (!map.isBlocked(next(0), next(1)))
+                    goal = next;
+            }
+        }
+
+        printf("  %-22s %10.4f ms %10.1f expansions\n", incremental ? "moving goal, adaptive" : "moving goal, fresh",
+               t / max(plans, 1), (double) expansions / max(plans, 1));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int pairs = 1000;
+    double radius = 0.25;
+    vector<const char *> maps;
+
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "-n" && i + 1 < argc)
+            pairs = atoi(argv[++i]);
+        else if (string(argv[i]) == "-r" && i + 1 < argc)
+            radius = atof(argv[++i]);
+        else
+            maps.push_back(argv[i]);
+    }
+
+    if (maps.empty()) {
+        printf("usage: %s <map.yaml> [map.yaml ...] [-n pairs] [-r inflation_radius]\n", argv[0]);
+        return 1;
+    }
+
+    for (size_t i = 0; i < maps.size(); i++)
+        benchmark(maps[i], pairs, radius);
+
+    return 0;
+}
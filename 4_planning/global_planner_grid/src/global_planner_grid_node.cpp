@@ -0,0 +1,144 @@
+/**
+ * Occupancy-grid global planner: plans on the competition map from the current
+ * odometry to the latest goal and feeds the waypoints to the local planner, in
+ * place of global_planner_hardcode.
+ */
+
+#include "global_planner_grid/grid_map.h"
+#include "global_planner_grid/grid_planner.h"
+#include <geometry_msgs/PoseStamped.h>
+#include <nav_msgs/OccupancyGrid.h>
+#include <nav_msgs/Odometry.h>
+#include <nav_msgs/Path.h>
+#include <ros/console.h>
+#include <ros/ros.h>
+#include <memory>
+
+using namespace std;
+using namespace Eigen;
+
+ros::Publisher path_pub, map_pub;
+string odom_topic, goal_topic, publisher_topic, frame_id, mode;
+bool has_odom = false, has_goal = false, incremental;
+Vector2d odom_position, goal_position;
+
+GridMap grid_map;
+unique_ptr<GridPlanner> planner;
+
+void odom_callback(const nav_msgs::Odometry::ConstPtr &odom)
+{
+    odom_position << odom->pose.pose.position.x, odom->pose.pose.position.y;
+    has_odom = true;
+}
+
+void goal_callback(const geometry_msgs::PoseStamped::ConstPtr &goal)
+{
+    goal_position << goal->pose.position.x, goal->pose.position.y;
+    has_goal = true;
+}
+
+void publishMap()
+{
+    nav_msgs::OccupancyGrid map;
+    map.header.frame_id = frame_id;
+    map.header.stamp = ros::Time::now();
+    map.info.resolution = grid_map.resolution();
+    map.info.width = grid_map.width();
+    map.info.height = grid_map.height();
+    map.info.origin.position.x = grid_map.origin()(0);
+    map.info.origin.position.y = grid_map.origin()(1);
+    map.info.origin.orientation.w = 1;
+
+    map.data.resize(grid_map.width() * grid_map.height());
+    for (int y = 0; y < grid_map.height(); y++)
+        for (int x = 0; x < grid_map.width(); x++)
+            map.data[grid_map.index(x, y)] = grid_map.isOccupied(x, y) ? 100 : (grid_map.isBlocked(x, y) ? 50 : 0);
+
+    map_pub.publish(map);
+}
+
+void plan()
+{
+    Vector2i start = grid_map.nearestFree(grid_map.worldToGrid(odom_position), 10);
+    Vector2i goal = grid_map.nearestFree(grid_map.worldToGrid(goal_position), 10);
+
+    vector<Vector2i> cells;
+    ros::WallTime t0 = ros::WallTime::now();
+    bool ok = (mode == "jps") ? planner->planJPS(start, goal, cells)
+                              : planner->planAStar(start, goal, cells, incremental);
+    double elapsed = (ros::WallTime::now() - t0).toSec() * 1000.0;
+
+    if (!ok) {
+        ROS_WARN_THROTTLE(1.0, "global_planner_grid: no path from (%.2f, %.2f) to (%.2f, %.2f)",
+                          odom_position(0), odom_position(1), goal_position(0), goal_position(1));
+        return;
+    }
+    ROS_DEBUG("global_planner_grid: %s %.3f ms, %zu expansions", mode.c_str(), elapsed, planner->expansions());
+
+    cells = planner->simplify(cells);
+
+    nav_msgs::Path path;
+    path.header.frame_id = frame_id;
+    path.header.stamp = ros::Time::now();
+
+    for (unsigned int i = 0; i < cells.size(); i++) {
+        // keep the exact start and goal, the cell centers in between
+        Vector2d p = (i == 0) ? odom_position
+                   : (i + 1 == cells.size()) ? goal_position : grid_map.gridToWorld(cells[i]);
+
+        geometry_msgs::PoseStamped pose;
+        pose.pose.position.x = p(0);
+        pose.pose.position.y = p(1);
+        pose.pose.position.z = 0;
+        pose.pose.orientation.w = 1;
+        path.poses.push_back(pose);
+    }
+
+    path_pub.publish(path);
+}
+
+int main(int argc, char **argv) {
+    ros::init(argc, argv, "global_planner_grid");
+    ros::NodeHandle n("~");
+
+    string map_yaml;
+    double inflation_radius, clearance_weight, clearance, rate;
+
+    n.param("map_yaml", map_yaml, string(""));
+    n.param("inflation_radius", inflation_radius, 0.3);
+    n.param("clearance_weight", clearance_weight, 2.0);
+    n.param("clearance", clearance, 0.6);
+    n.param("mode", mode, string("astar"));
+    n.param("incremental", incremental, true);
+    n.param("rate", rate, 10.0);
+    n.param("frame_id", frame_id, string("world"));
+    n.param("odom_topic", odom_topic, string("/ekf_odom"));
+    n.param("goal_topic", goal_topic, string("/move_base_simple/goal"));
+    n.param("publisher_topic", publisher_topic, string("/global_path_hardcode"));
+
+    if (!grid_map.load(map_yaml)) {
+        ROS_ERROR("global_planner_grid: cannot load map %s", map_yaml.c_str());
+        return 1;
+    }
+    grid_map.inflate(inflation_radius);
+
+    planner.reset(new GridPlanner(grid_map));
+    planner->setClearanceCost(clearance_weight, clearance);
+
+    path_pub = n.advertise<nav_msgs::Path>(publisher_topic, 100);
+    map_pub = n.advertise<nav_msgs::OccupancyGrid>("map", 1, true);
+    ros::Subscriber odom_sub = n.subscribe(odom_topic, 10, odom_callback);
+    ros::Subscriber goal_sub = n.subscribe(goal_topic, 10, goal_callback);
+
+    publishMap();
+
+    // replan every period: the start follows the odometry, the goal may move at any time
+    ros::Rate r(rate);
+    while (ros::ok())
+    {
+        ros::spinOnce();
+        if (has_odom && has_goal)
+            plan();
+        r.sleep();
+    }
+}
@@ -0,0 +1,202 @@
+#include "global_planner_grid/grid_map.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+using namespace std;
+using namespace Eigen;
+
+GridMap::GridMap() : _width(0), _height(0), _resolution(0.05), _origin(Vector2d::Zero()), _inflation_radius(0.0) {}
+
+bool GridMap::load(const string &yaml_file)
+{
+    ifstream file(yaml_file.c_str());
+    if (!file)
+        return false;
+
+    // the map_saver yaml is flat "key: value", no need for a yaml parser here
+    string image, line;
+    double resolution = 0.05, free_thresh = 0.196;
+    int negate = 0;
+    Vector2d origin = Vector2d::Zero();
+
+    while (getline(file, line)) {
+        size_t colon = line.find(':');
+        if (colon == string::npos)
+            continue;
+
+        string key = line.substr(0, colon);
+        string value = line.substr(colon + 1);
+        key.erase(remove_if(key.begin(), key.end(), ::isspace), key.end());
+        replace(value.begin(), value.end(), '[', ' ');
+        replace(value.begin(), value.end(), ']', ' ');
+        replace(value.begin(), value.end(), ',', ' ');
+        istringstream stream(value);
+
+        if (key == "image") stream >> image;
+        else if (key == "resolution") stream >> resolution;
+        else if (key == "origin") stream >> origin(0) >> origin(1);
+        else if (key == "negate") stream >> negate;
+        else if (key == "free_thresh") stream >> free_thresh;
+    }
+
+    if (image.empty())
+        return false;
+
+    if (image[0] != '/') {
+        size_t slash = yaml_file.find_last_of('/');
+        if (slash != string::npos)
+            image = yaml_file.substr(0, slash + 1) + image;
+    }
+
+    return loadPGM(image, resolution, origin, negate != 0, free_thresh);
+}
+
+bool GridMap::loadPGM(const string &pgm_file, double resolution, const Vector2d &origin,
+                      bool negate, double free_thresh)
+{
+    ifstream file(pgm_file.c_str(), ios::binary);
+    if (!file)
+        return false;
+
+    // header tokens: magic, width, height, max value; '#' starts a comment
+    string tokens[4];
+    for (int i = 0; i < 4; i++) {
+        while (file >> ws && file.peek() == '#') {
+            string comment;
+            getline(file, comment);
+        }
+        if (!(file >> tokens[i]))
+            return false;
+    }
+    file.get();
+
+    if (tokens[0] != "P5")
+        return false;
+
+    int width = atoi(tokens[1].c_str()), height = atoi(tokens[2].c_str()), max_value = atoi(tokens[3].c_str());
+    if (width <= 0 || height <= 0 || max_value <= 0 || max_value > 255)
+        return false;
+
+    vector<uint8_t> pixels(width * height);
+    if (!file.read(reinterpret_cast<char *>(pixels.data()), pixels.size()))
+        return false;
+
+    _width = width;
+    _height = height;
+    _resolution = resolution;
+    _origin = origin;
+    _occupied.assign(_width * _height, 0);
+
+    for (int y = 0; y < _height; y++) {
+        for (int x = 0; x < _width; x++) {
+            double value = (double) pixels[(_height - 1 - y) * _width + x] / max_value;
+            double occupancy = negate ? value : 1.0 - value;
+            // occupied and unknown cells (between free_thresh and occupied_thresh) are both obstacles
+            _occupied[index(x, y)] = (occupancy < free_thresh) ? 0 : 1;
+        }
+    }
+
+    computeDistanceField();
+    inflate(_inflation_radius);
+
+    return true;
+}
+
+/**
+ * Exact Euclidean distance transform (Felzenszwalb and Huttenlocher), one
+ * lower-envelope pass over the columns and one over the rows, O(width * height).
+ */
+void GridMap::computeDistanceField()
+{
+    const double inf = 1e20;
+    int n = max(_width, _height);
+    vector<double> f(n), d(n), z(n + 1);
+    vector<int> v(n);
+
+    auto transform1D = [&](int len) {
+        int k = 0;
+        v[0] = 0;
+        z[0] = -inf;
+        z[1] = inf;
+        for (int q = 1; q < len; q++) {
+            double s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+            while (s <= z[k]) {
+                k--;
+                s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+            }
+            k++;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = inf;
+        }
+        k = 0;
+        for (int q = 0; q < len; q++) {
+            while (z[k + 1] < q)
+                k++;
+            d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+        }
+    };
+
+    _distance.resize(_width * _height);
+    for (int i = 0; i < _width * _height; i++)
+        _distance[i] = _occupied[i] ? 0.0f : (float) inf;
+
+    for (int x = 0; x < _width; x++) {
+        for (int y = 0; y < _height; y++) f[y] = _distance[index(x, y)];
+        transform1D(_height);
+        for (int y = 0; y < _height; y++) _distance[index(x, y)] = d[y];
+    }
+    for (int y = 0; y < _height; y++) {
+        for (int x = 0; x < _width; x++) f[x] = _distance[index(x, y)];
+        transform1D(_width);
+        for (int x = 0; x < _width; x++) _distance[index(x, y)] = sqrt(d[x]) * _resolution;
+    }
+}
+
+void GridMap::inflate(double radius)
+{
+    _inflation_radius = radius;
+    _blocked.resize(_width * _height);
+    for (int i = 0; i < _width * _height; i++)
+        _blocked[i] = (_occupied[i] || _distance[i] < radius) ? 1 : 0;
+}
+
+Vector2i GridMap::worldToGrid(const Vector2d &p) const
+{
+    return Vector2i((int) floor((p(0) - _origin(0)) / _resolution),
+                    (int) floor((p(1) - _origin(1)) / _resolution));
+}
+
+Vector2d GridMap::gridToWorld(const Vector2i &c) const
+{
+    return Vector2d(_origin(0) + (c(0) + 0.5) * _resolution,
+                    _origin(1) + (c(1) + 0.5) * _resolution);
+}
+
+Vector2i GridMap::nearestFree(const Vector2i &c, int max_radius) const
+{
+    if (!isBlocked(c(0), c(1)))
+        return c;
+
+    for (int r = 1; r <= max_radius; r++) {
+        Vector2i best = c;
+        int best_d2 = numeric_limits<int>::max();
+        for (int dy = -r; dy <= r; dy++) {
+            for (int dx = -r; dx <= r; dx++) {
+                if (max(abs(dx), abs(dy)) != r || isBlocked(c(0) + dx, c(1) + dy))
+                    continue;
+                if (dx * dx + dy * dy < best_d2) {
+                    best_d2 = dx * dx + dy * dy;
+                    best = Vector2i(c(0) + dx, c(1) + dy);
+                }
+            }
+        }
+        if (best_d2 != numeric_limits<int>::max())
+            return best;
+    }
+
+    return c;
+}
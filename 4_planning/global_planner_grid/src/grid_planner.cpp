@@ -0,0 +1,376 @@
+#include "global_planner_grid/grid_planner.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+using namespace Eigen;
+
+static const float INF = numeric_limits<float>::infinity();
+static const float SQRT2 = 1.41421356f;
+
+GridPlanner::GridPlanner(const GridMap &map)
+        : _map(map), _clearance_weight(0.0), _clearance(1.0), _expansions(0),
+          _counter(0), _goal(-1), _jps_counter(0)
+{
+    int n = _map.width() * _map.height();
+
+    _g.assign(n, INF);
+    _h.assign(n, 0.0f);
+    _parent.assign(n, -1);
+    _search.assign(n, 0);
+    _closed.assign(n, 0);
+
+    _jps_g.assign(n, INF);
+    _jps_parent.assign(n, -1);
+    _jps_search.assign(n, 0);
+    _jps_closed.assign(n, 0);
+}
+
+void GridPlanner::setClearanceCost(double weight, double clearance)
+{
+    _clearance_weight = weight;
+    _clearance = max(clearance, 1e-6);
+    reset();
+}
+
+float GridPlanner::octile(int a, int b) const
+{
+    int dx = abs(a % _map.width() - b % _map.width());
+    int dy = abs(a / _map.width() - b / _map.width());
+
+    return (float) (max(dx, dy) - min(dx, dy)) + SQRT2 * min(dx, dy);
+}
+
+float GridPlanner::stepCost(int to, int dx, int dy) const
+{
+    float length = (dx && dy) ? SQRT2 : 1.0f;
+    double d = _map.distance(to % _map.width(), to / _map.width());
+
+    return length * (float) (1.0 + _clearance_weight * max(0.0, 1.0 - d / _clearance));
+}
+
+void GridPlanner::pushOpen(float f, int s)
+{
+    _open.push_back(make_pair(f, s));
+    push_heap(_open.begin(), _open.end(), greater<pair<float, int>>());
+}
+
+int GridPlanner::popOpen()
+{
+    pop_heap(_open.begin(), _open.end(), greater<pair<float, int>>());
+    int s = _open.back().second;
+    _open.pop_back();
+
+    return s;
+}
+
+void GridPlanner::reset()
+{
+    fill(_search.begin(), _search.end(), 0);
+    fill(_closed.begin(), _closed.end(), 0);
+    _counter = 0;
+    _goal = -1;
+    _deltah.assign(1, 0.0f);
+    _pathcost.assign(1, INF);
+}
+
+/**
+ * Lazily bring the g and h values of a cell up to date for the current search:
+ * a cell expanded by search k learns h = pathcost(k) - g, and the learned value
+ * is lowered by how much the goal has moved since then (deltah), never below the
+ * octile distance to the current goal.
+ */
+void GridPlanner::initializeState(int s)
+{
+    if (_search[s] == _counter)
+        return;
+
+    if (_search[s] != 0) {
+        uint32_t k = _search[s];
+        if (_pathcost[k] < INF && _g[s] + _h[s] < _pathcost[k])
+            _h[s] = _pathcost[k] - _g[s];
+        _h[s] = max(_h[s] - (_deltah[_counter] - _deltah[k]), octile(s, _goal));
+    } else {
+        _h[s] = octile(s, _goal);
+    }
+
+    _g[s] = INF;
+    _search[s] = _counter;
+}
+
+bool GridPlanner::planAStar(const Vector2i &start, const Vector2i &goal, vector<Vector2i> &path, bool incremental)
+{
+    path.clear();
+    _expansions = 0;
+
+    if (_map.isBlocked(start(0), start(1)) || _map.isBlocked(goal(0), goal(1)))
+        return false;
+
+    int s = _map.index(start(0), start(1));
+    int t = _map.index(goal(0), goal(1));
+
+    if (!incremental || _goal < 0 || _counter > (1u << 20))
+        reset();
+
+    float deltah = _deltah[_counter];
+    if (_goal >= 0 && t != _goal) {
+        // the learned distance between the old and the new goal bounds how much any h may shrink
+        initializeState(t);
+        if (_pathcost[_counter] < INF && _g[t] + _h[t] < _pathcost[_counter])
+            _h[t] = _pathcost[_counter] - _g[t];
+        deltah += _h[t];
+    }
+
+    _goal = t;
+    _counter++;
+    _deltah.push_back(deltah);
+    _pathcost.push_back(INF);
+
+    initializeState(s);
+    initializeState(t);
+    _g[s] = 0.0f;
+    _parent[s] = s;
+
+    _open.clear();
+    pushOpen(_h[s], s);
+
+    const int dirs[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+    bool found = false;
+
+    while (!_open.empty()) {
+        int u = popOpen();
+        if (_closed[u] == _counter)
+            continue;
+        if (u == t) {
+            found = true;
+            break;
+        }
+
+        _closed[u] = _counter;
+        _expansions++;
+
+        int ux = u % _map.width(), uy = u / _map.width();
+        for (int i = 0; i < 8; i++) {
+            int dx = dirs[i][0], dy = dirs[i][1];
+            int vx = ux + dx, vy = uy + dy;
+
+            if (_map.isBlocked(vx, vy) || (dx && dy && (_map.isBlocked(ux + dx, uy) || _map.isBlocked(ux, uy + dy))))
+                continue;
+
+            int v = _map.index(vx, vy);
+            initializeState(v);
+            if (_closed[v] == _counter)
+                continue;
+
+            float g = _g[u] + stepCost(v, dx, dy);
+            if (g < _g[v]) {
+                _g[v] = g;
+                _parent[v] = u;
+                pushOpen(g + _h[v], v);
+            }
+        }
+    }
+
+    if (!found)
+        return false;
+
+    _pathcost[_counter] = _g[t];
+
+    for (int u = t; ; u = _parent[u]) {
+        path.push_back(Vector2i(u % _map.width(), u / _map.width()));
+        if (u == s)
+            break;
+    }
+    reverse(path.begin(), path.end());
+
+    return true;
+}
+
+/**
+ * Follow (dx, dy) from (x, y) until a jump point is found: the goal, a cell with a
+ * forced neighbour, or for diagonal moves a cell from which a straight jump succeeds.
+ * Diagonal moves may not cut corners, so a diagonal run stops at any adjacent obstacle.
+ */
+int GridPlanner::jump(int x, int y, int dx, int dy, int gx, int gy) const
+{
+    while (true) {
+        if (_map.isBlocked(x, y))
+            return -1;
+        if (x == gx && y == gy)
+            return _map.index(x, y);
+
+        if (dx && dy) {
+            if (jump(x + dx, y, dx, 0, gx, gy) >= 0 || jump(x, y + dy, 0, dy, gx, gy) >= 0)
+                return _map.index(x, y);
+            if (_map.isBlocked(x + dx, y) || _map.isBlocked(x, y + dy))
+                return -1;
+        } else if (dx) {
+            if ((!_map.isBlocked(x, y - 1) && _map.isBlocked(x - dx, y - 1)) ||
+                (!_map.isBlocked(x, y + 1) && _map.isBlocked(x - dx, y + 1)))
+                return _map.index(x, y);
+        } else {
+            if ((!_map.isBlocked(x - 1, y) && _map.isBlocked(x - 1, y - dy)) ||
+                (!_map.isBlocked(x + 1, y) && _map.isBlocked(x + 1, y - dy)))
+                return _map.index(x, y);
+        }
+
+        x += dx;
+        y += dy;
+    }
+}
+
+bool GridPlanner::planJPS(const Vector2i &start, const Vector2i &goal, vector<Vector2i> &path)
+{
+    path.clear();
+    _expansions = 0;
+
+    if (_map.isBlocked(start(0), start(1)) || _map.isBlocked(goal(0), goal(1)))
+        return false;
+
+    int s = _map.index(start(0), start(1));
+    int t = _map.index(goal(0), goal(1));
+
+    _jps_counter++;
+    _jps_search[s] = _jps_counter;
+    _jps_g[s] = 0.0f;
+    _jps_parent[s] = s;
+
+    _open.clear();
+    pushOpen(octile(s, t), s);
+
+    bool found = false;
+    int dirs[8][2];
+
+    while (!_open.empty()) {
+        int u = popOpen();
+        if (_jps_closed[u] == _jps_counter)
+            continue;
+        if (u == t) {
+            found = true;
+            break;
+        }
+
+        _jps_closed[u] = _jps_counter;
+        _expansions++;
+
+        int ux = u % _map.width(), uy = u / _map.width();
+        int n = 0;
+
+        if (_jps_parent[u] == u) {
+            for (int dx = -1; dx <= 1; dx++)
+                for (int dy = -1; dy <= 1; dy++)
+                    if ((dx || dy) && (!(dx && dy) || (!_map.isBlocked(ux + dx, uy) && !_map.isBlocked(ux, uy + dy)))) {
+                        dirs[n][0] = dx;
+                        dirs[n++][1] = dy;
+                    }
+        } else {
+            // prune the neighbours that a path through the parent reaches at least as cheaply
+            int px = _jps_parent[u] % _map.width(), py = _jps_parent[u] / _map.width();
+            int dx = (ux > px) - (ux < px), dy = (uy > py) - (uy < py);
+
+            if (dx && dy) {
+                bool walk_x = !_map.isBlocked(ux + dx, uy), walk_y = !_map.isBlocked(ux, uy + dy);
+                if (walk_y) { dirs[n][0] = 0;  dirs[n++][1] = dy; }
+                if (walk_x) { dirs[n][0] = dx; dirs[n++][1] = 0; }
+                if (walk_x && walk_y) { dirs[n][0] = dx; dirs[n++][1] = dy; }
+            } else if (dx) {
+                bool next = !_map.isBlocked(ux + dx, uy);
+                bool up = !_map.isBlocked(ux, uy + 1), down = !_map.isBlocked(ux, uy - 1);
+                if (next) {
+                    dirs[n][0] = dx; dirs[n++][1] = 0;
+                    if (up)   { dirs[n][0] = dx; dirs[n++][1] = 1; }
+                    if (down) { dirs[n][0] = dx; dirs[n++][1] = -1; }
+                }
+                if (up)   { dirs[n][0] = 0; dirs[n++][1] = 1; }
+                if (down) { dirs[n][0] = 0; dirs[n++][1] = -1; }
+            } else {
+                bool next = !_map.isBlocked(ux, uy + dy);
+                bool right = !_map.isBlocked(ux + 1, uy), left = !_map.isBlocked(ux - 1, uy);
+                if (next) {
+                    dirs[n][0] = 0; dirs[n++][1] = dy;
+                    if (right) { dirs[n][0] = 1;  dirs[n++][1] = dy; }
+                    if (left)  { dirs[n][0] = -1; dirs[n++][1] = dy; }
+                }
+                if (right) { dirs[n][0] = 1;  dirs[n++][1] = 0; }
+                if (left)  { dirs[n][0] = -1; dirs[n++][1] = 0; }
+            }
+        }
+
+        for (int i = 0; i < n; i++) {
+            int v = jump(ux + dirs[i][0], uy + dirs[i][1], dirs[i][0], dirs[i][1], goal(0), goal(1));
+            if (v < 0)
+                continue;
+
+            if (_jps_search[v] != _jps_counter) {
+                _jps_search[v] = _jps_counter;
+                _jps_g[v] = INF;
+            }
+            if (_jps_closed[v] == _jps_counter)
+                continue;
+
+            float g = _jps_g[u] + octile(u, v);
+            if (g < _jps_g[v]) {
+                _jps_g[v] = g;
+                _jps_parent[v] = u;
+                pushOpen(g + octile(v, t), v);
+            }
+        }
+    }
+
+    if (!found)
+        return false;
+
+    for (int u = t; ; u = _jps_parent[u]) {
+        path.push_back(Vector2i(u % _map.width(), u / _map.width()));
+        if (u == s)
+            break;
+    }
+    reverse(path.begin(), path.end());
+
+    return true;
+}
+
+bool GridPlanner::lineOfSight(const Vector2i &a, const Vector2i &b) const
+{
+    // sample the segment at quarter-cell steps; the inflation margin covers the gaps in between
+    Vector2d d = (b - a).cast<double>();
+    int steps = max(1, (int) ceil(d.norm() * 4.0));
+
+    for (int i = 0; i <= steps; i++) {
+        Vector2d p = a.cast<double>() + d * ((double) i / steps);
+        if (_map.isBlocked((int) floor(p(0) + 0.5), (int) floor(p(1) + 0.5)))
+            return false;
+    }
+
+    return true;
+}
+
+vector<Vector2i> GridPlanner::simplify(const vector<Vector2i> &path) const
+{
+    if (path.size() < 3)
+        return path;
+
+    vector<Vector2i> result;
+    result.push_back(path.front());
+
+    size_t i = 0;
+    while (i + 1 < path.size()) {
+        size_t j = i + 1;
+        while (j + 1 < path.size() && lineOfSight(path[i], path[j + 1]))
+            j++;
+        result.push_back(path[j]);
+        i = j;
+    }
+
+    return result;
+}
+
+double GridPlanner::length(const vector<Vector2i> &path)
+{
+    double l = 0.0;
+    for (size_t i = 1; i < path.size(); i++)
+        l += (path[i] - path[i - 1]).cast<double>().norm();
+
+    return l;
+}
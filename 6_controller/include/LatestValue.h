@@ -0,0 +1,58 @@
+//
+// Latest value slot between one writer thread and one reader thread
+//
+#ifndef ROS_ENVIRONMENT_LATESTVALUE_H
+#define ROS_ENVIRONMENT_LATESTVALUE_H
+
+#include <atomic>
+
+#pragma once
+
+/**
+ * Triple buffer: write() and read() never block nor allocate, the reader always
+ * gets the last complete write, older ones are overwritten.
+ * A single thread may write and a single thread may read.
+ */
+template <typename T>
+class LatestValue {
+public:
+    LatestValue() : front(0), shared(1), back(2) {}
+
+    explicit LatestValue(const T &value) : front(0), shared(1), back(2)
+    {
+        for (int i = 0; i < 3; ++i) buffers[i] = value;
+    }
+
+    /**
+     * Copy value to the back buffer, then swap it with the shared one
+     */
+    void write(const T &value)
+    {
+        buffers[back] = value;
+        back = shared.exchange(back | NEW_DATA, std::memory_order_acq_rel) & INDEX;
+    }
+
+    /**
+     * @return the last value written, valid until the next read
+     */
+    const T &read()
+    {
+        if (shared.load(std::memory_order_acquire) & NEW_DATA) {
+            front = shared.exchange(front, std::memory_order_acq_rel) & INDEX;
+        }
+        return buffers[front];
+    }
+
+private:
+    enum { INDEX = 3, NEW_DATA = 4 };
+
+    T buffers[3];
+    // owned by the reader
+    int front;
+    // index of the last complete write, with NEW_DATA until the reader takes it
+    std::atomic<int> shared;
+    // owned by the writer
+    int back;
+};
+
+#endif //ROS_ENVIRONMENT_LATESTVALUE_H
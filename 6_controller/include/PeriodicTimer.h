@@ -0,0 +1,101 @@
+//
+// Absolute periodic wake up of a control thread, on CLOCK_MONOTONIC
+//
+#ifndef ROS_ENVIRONMENT_PERIODICTIMER_H
+#define ROS_ENVIRONMENT_PERIODICTIMER_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
+#include <string>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#pragma once
+
+/**
+ * timerfd based period: the ticks are on a fixed grid from the start, so a late wake
+ * up does not shift the following ones, and the ticks missed are counted.
+ */
+class PeriodicTimer {
+public:
+    explicit PeriodicTimer(const double period)
+    {
+        period_ns = static_cast<int64_t>(period * 1e9);
+        if (period_ns <= 0)
+            throw std::runtime_error("timer period must be positive.");
+
+        fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+        if (fd < 0)
+            throw std::runtime_error(std::string("timerfd_create: ") + strerror(errno));
+
+        tick_ns = now() + period_ns;
+        itimerspec spec;
+        spec.it_value    = toTimespec(tick_ns);
+        spec.it_interval = toTimespec(period_ns);
+        if (timerfd_settime(fd, TFD_TIMER_ABSTIME, &spec, NULL) < 0) {
+            close(fd);
+            throw std::runtime_error(std::string("timerfd_settime: ") + strerror(errno));
+        }
+        tick_ns -= period_ns;
+    }
+
+    ~PeriodicTimer() { close(fd); }
+
+    /**
+     * Block until the next tick
+     * @return the number of ticks since the previous wait, more than 1 if some were missed
+     */
+    uint64_t wait()
+    {
+        uint64_t expirations = 0;
+        while (read(fd, &expirations, sizeof(expirations)) < 0 && errno == EINTR) {}
+        tick_ns += static_cast<int64_t>(expirations) * period_ns;
+        return expirations;
+    }
+
+    /**
+     * @return CLOCK_MONOTONIC time of the last tick waited for, in ns
+     */
+    int64_t tickTime() const { return tick_ns; }
+
+    /**
+     * @return CLOCK_MONOTONIC time in ns
+     */
+    static int64_t now()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    /**
+     * Switch the calling thread to SCHED_FIFO
+     * @return false if not permitted, e.g. without CAP_SYS_NICE or an rtprio limit
+     */
+    static bool setRealtimePriority(const int priority)
+    {
+        sched_param param;
+        param.sched_priority = priority;
+        return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+    }
+
+private:
+    static timespec toTimespec(const int64_t ns)
+    {
+        timespec ts;
+        ts.tv_sec  = ns / 1000000000LL;
+        ts.tv_nsec = ns % 1000000000LL;
+        return ts;
+    }
+
+    int fd;
+    int64_t period_ns;
+    int64_t tick_ns;
+};
+
+#endif //ROS_ENVIRONMENT_PERIODICTIMER_H
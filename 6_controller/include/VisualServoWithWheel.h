@@ -0,0 +1,162 @@
+//
+// The perspective visual servo with wheel command, as a ROS node or nodelet
+//
+#ifndef ROS_ENVIRONMENT_VISUALSERVOWITHWHEEL_H
+#define ROS_ENVIRONMENT_VISUALSERVOWITHWHEEL_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <Eigen/Dense>
+#include <ros/ros.h>
+#include <geometry_msgs/TwistStamped.h>
+#include <dynamic_reconfigure/server.h>
+#include <visual_servo_control/tuningConfig.h>
+#include "rm_cv/vertice.h"
+#include "camera_model/camera_models/CameraFactory.h"
+#include "III_VisualServoController.h"
+#include "LatestValue.h"
+#include "PeriodicTimer.h"
+#include "filt.h"
+
+#pragma once
+
+/**
+ * The control runs in its own thread, woken by a PeriodicTimer at ctrl_freq, optionally
+ * SCHED_FIFO. The callbacks run in the threads of the caller's spinner (an AsyncSpinner,
+ * or the nodelet manager), process each message as it arrives, and hand the result to
+ * the control thread through LatestValue slots, so a tick neither waits for the callbacks
+ * nor for the messages queued behind them.
+ *
+ * The messages are subscribed and published as shared pointers: in a nodelet manager,
+ * the detection input and the command to the CAN transmitter are not copied.
+ */
+class VisualServoWithWheel {
+public:
+    /**
+     * Read the parameters, set up the controller and start the control thread
+     * @param nh private node handle, for the parameters and topics
+     */
+    explicit VisualServoWithWheel(ros::NodeHandle &nh);
+
+    /**
+     * Stop the callbacks, then the control thread
+     */
+    ~VisualServoWithWheel();
+
+private:
+    // size of the points taken
+    enum { n = 4, m = 2 };
+
+    // depth of the gyro delay line of VisualServoController::timestamp_sync
+    enum { GYRO_HISTORY = 4 };
+
+    enum class fsm {idle = 0, once = 1, multi = 2};
+
+    /**
+     * Armor vertices in image frame, with the filtered distance
+     */
+    struct VisualMeasurement {
+        Eigen::Matrix<double, n, m, Eigen::DontAlign> image_frame;
+        double z_filt;
+        double error_z;
+        // CLOCK_MONOTONIC time of the callback, ns
+        int64_t receive_ns;
+        unsigned long seq;
+    };
+
+    /**
+     * Last GYRO_HISTORY angular velocities in camera frame, sample k at k % GYRO_HISTORY
+     */
+    struct GyroHistory {
+        Eigen::Vector3d omega[GYRO_HISTORY];
+        unsigned long count;
+    };
+
+    /**
+     * Samples of one statistics period of the control loop
+     */
+    struct ControlLoopStatistics {
+        enum { SAMPLES = 1024 };
+        // from the tick to the command published
+        double tick_to_command_us[SAMPLES];
+        int tick_to_command_count;
+        // from the visual feature callback to the command computed from it
+        double latency_us[SAMPLES];
+        int latency_count;
+        unsigned long ticks;
+        unsigned long missed_ticks;
+        unsigned long seq;
+    };
+
+    void visualFeatureCb(const rm_cv::vertice::ConstPtr &cv_ptr);
+    void omegaCamCb(const geometry_msgs::TwistStamped::ConstPtr &omega_ptr);
+
+    void controlLoop();
+
+    void publishCmd(const Eigen::VectorXd &cmd);
+    void publishAngularVelocity(const Eigen::VectorXd &estimated_omega, const ros::Publisher &pub);
+    void publishDistanceDebug(double z_in, double z_out);
+
+    void addStatistics(int64_t tick_ns, int64_t command_ns, uint64_t ticks, int64_t receive_ns);
+    void printStatistics(const ros::WallTimerEvent &event);
+
+    ros::Publisher cmd_pub;
+    ros::Publisher kalman_output_pub;
+    ros::Publisher omega_raw_pub;
+    ros::Publisher omega_visual_pub;
+    ros::Publisher kalman_input_pub;
+    ros::Publisher delayed_gyro_pub;
+    ros::Publisher debug_z_pub;
+    ros::Subscriber visual_sub;
+    ros::Subscriber omega_sub;
+    ros::WallTimer statistics_timer;
+
+    dynamic_reconfigure::Server<visual_servo_control::tuningConfig> dr_server;
+
+    double ctrl_freq;
+    double distance_cuttoff_freq;
+    double target_Z;
+    double pixel_x_max;
+    double pixel_y_max;
+    double pixel_dx;
+    double pixel_dy;
+    int realtime_priority;
+    double statistics_period;
+
+    // Used by the visual feature callback only
+    camera_model::CameraPtr m_camera;
+    std::unique_ptr<Filter> z_low_pass;
+    VisualMeasurement visual_measurement;
+
+    // Used by the gyro callback only
+    Eigen::Matrix3d end_R_cam;
+    GyroHistory gyro_history;
+
+    LatestValue<VisualMeasurement> visual_slot;
+    LatestValue<GyroHistory> gyro_slot;
+    LatestValue<ControlLoopStatistics> statistics_slot;
+
+    // Used by the control thread only
+    VisualServoController ctl;
+    Eigen::MatrixXd cam_R_end;
+    Eigen::MatrixXd input_image_frame;
+    Eigen::VectorXd prev_ctl_val;
+    double error_z;
+    fsm finite_state;
+    unsigned long visual_seq;
+    unsigned long gyro_count;
+    ControlLoopStatistics statistics;
+    int64_t statistics_deadline;
+
+    // Used by the statistics timer only
+    unsigned long statistics_seq;
+
+    std::unique_ptr<PeriodicTimer> timer;
+    std::atomic<bool> running;
+    std::thread control_thread;
+};
+
+#endif //ROS_ENVIRONMENT_VISUALSERVOWITHWHEEL_H
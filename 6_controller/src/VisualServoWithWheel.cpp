@@ -0,0 +1,413 @@
+/**
+ * Beck Pang, 20181029, the perspective controller with wheel command
+ * Reference:
+ *  Chaumette, François, and Seth Hutchinson. "Visual servo control. I. Basic approaches.
+ *  Chaumette, François, and Seth Hutchinson. "Visual servo control. II. Advanced approaches.
+ */
+
+#include "VisualServoWithWheel.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <geometry_msgs/Twist.h>
+
+using namespace std;
+using namespace Eigen;
+
+const double MAX_DISTANCE = 3.0;
+
+VisualServoWithWheel::VisualServoWithWheel(ros::NodeHandle &nh)
+    : dr_server(nh)
+    , pixel_x_max(640)
+    , pixel_y_max(512)
+    , cam_R_end(6, 6)
+    , input_image_frame(n, m)
+    , prev_ctl_val(6)
+    , error_z(0.0)
+    , finite_state(fsm::idle)
+    , visual_seq(0)
+    , gyro_count(0)
+    , statistics_seq(0)
+    , running(true)
+{
+    string cv_topic;
+    string omega_input_topic;
+    string kalman_input_topic;
+    string kalman_output_topic;
+    string omega_raw_topic;
+    string omega_visual_topic;
+    string publisher_topic;
+    string delayed_gyro_topic;
+    string debug_distance_topic;
+    string cfg_file_name;
+    double Kf_r0 = 0.01;
+    double Kf_q0 = 1.0;
+
+    nh.param("Kf_r0", Kf_r0, 0.01);
+    nh.param("Kf_r0", Kf_r0, 1.0);
+    nh.param("ctrl_freq", ctrl_freq, 30.0);
+    nh.param("distance_cuttoff_freq", distance_cuttoff_freq, 3.0);
+    nh.param("target_Z", target_Z, 1.0);
+    nh.param("pixel_dx", pixel_dx, 68.0);
+    nh.param("pixel_dy", pixel_dy, 25.0);
+    nh.param("cv_topic", cv_topic, string("/detected_vertice"));
+    nh.param("omega_input_topic", omega_input_topic, string("/can_receive_1/end_effector_omega"));
+
+    nh.param("publisher_topic", publisher_topic, string("/cmd_vel"));
+    nh.param("kalman_input_topic",  kalman_input_topic,  string("/visual_servo/kalman_input"));
+    nh.param("kalman_output_topic", kalman_output_topic, string("/visual_servo/kalman_output"));
+    nh.param("omega_raw_topic", omega_raw_topic, string("/visual_servo/raw_omega_cam"));
+    nh.param("omega_visual_topic", omega_visual_topic, string("/visual_servo/omega_visual"));
+    nh.param("delayed_gyro_topic", delayed_gyro_topic, string("/visual_servo/delayed_gyro"));
+    nh.param("debug_distance_topic", debug_distance_topic, string("/visual_servo/distance_compare"));
+
+    nh.param("cfg_file_name", cfg_file_name, string("/home/nvidia/ws/src/6_controller/gimbal_controller/cfg/camera_tracking_camera_calib.yaml"));
+
+    // 0: the control thread keeps the scheduling of the process
+    nh.param("realtime_priority", realtime_priority, 0);
+    // period of the control loop statistics on the console, 0 for none
+    nh.param("statistics_period", statistics_period, 10.0);
+
+    // create a camera model
+    m_camera = camera_model::CameraFactory::instance()->generateCameraFromYamlFile(cfg_file_name);
+
+    // create the low pass filter
+    z_low_pass.reset(new Filter(LPF, 10, 2 * ctrl_freq, distance_cuttoff_freq));
+
+    // setup the target coordinate
+    MatrixXd target_pixel(n, m);
+    MatrixXd target_image_frame(n, m);
+
+    double pixel_x_down= (pixel_x_max - pixel_dx) * 0.5;
+    double pixel_x_top_= (pixel_x_max + pixel_dx) * 0.5;
+    double pixel_y_down= (pixel_y_max - pixel_dy) * 0.5;
+    double pixel_y_top_= (pixel_y_max + pixel_dy) * 0.5;
+
+    target_pixel <<
+            pixel_x_down, pixel_y_down,
+            pixel_x_down, pixel_y_top_,
+            pixel_x_top_, pixel_y_down,
+            pixel_x_top_, pixel_y_top_; // 1000 mm
+
+    Vector3d target_pixel_output[n];
+
+    for (int i = 0; i < n; ++i) {
+        m_camera->liftSphere(target_pixel.row(i), target_pixel_output[i] );
+        target_image_frame.row(i) << target_pixel_output[i](0), target_pixel_output[i](1);
+    }
+    std::cout << "target in image frame " << std::endl << target_image_frame << std::endl;
+
+    // set up the controller
+    ctl.setTarget(target_image_frame);
+
+    ctl.setTargetZ(target_Z);
+
+    ctl.setZ(target_Z);
+
+    ctl.setControlFrequency(ctrl_freq);
+
+    ctl.initKalmanFilter(Kf_r0, Kf_q0, 1 / ctrl_freq);
+
+    prev_ctl_val.setZero();
+
+    cam_R_end.setIdentity();
+
+    // linear velocity vx, vy, and vz also need to switch to chassis frame
+    cam_R_end.block(0, 0, 3, 3) <<
+           0, -1, 0,
+           -1, 0, 0,
+           0,  0, 1;
+
+    cam_R_end.block(3, 3, 3, 3) <<
+         0, 0, 1,
+        -1, 0, 0,
+         0,-1, 0;
+    std::cout << "cam_R_end_effector: " << std::endl << cam_R_end << std::endl;
+
+    end_R_cam <<
+        0, -1, 0,
+        0, 0, -1,
+        1, 0, 0;
+
+    visual_measurement.seq = 0;
+    visual_slot.write(visual_measurement);
+    gyro_history.count = 0;
+    gyro_slot.write(gyro_history);
+    statistics.tick_to_command_count = 0;
+    statistics.latency_count = 0;
+    statistics.ticks = 0;
+    statistics.missed_ticks = 0;
+    statistics.seq = 0;
+    statistics_slot.write(statistics);
+
+    cmd_pub = nh.advertise<geometry_msgs::Twist>(publisher_topic, 10);
+    omega_raw_pub     = nh.advertise<geometry_msgs::TwistStamped>(omega_raw_topic, 10);
+    omega_visual_pub  = nh.advertise<geometry_msgs::TwistStamped>(omega_visual_topic, 10);
+    kalman_input_pub  = nh.advertise<geometry_msgs::TwistStamped>(kalman_input_topic, 10);
+    kalman_output_pub = nh.advertise<geometry_msgs::TwistStamped>(kalman_output_topic, 10);
+    delayed_gyro_pub  = nh.advertise<geometry_msgs::TwistStamped>(delayed_gyro_topic, 10);
+    debug_z_pub       = nh.advertise<geometry_msgs::TwistStamped>(debug_distance_topic, 10);
+
+    visual_sub = nh.subscribe(cv_topic, 10, &VisualServoWithWheel::visualFeatureCb, this);
+    omega_sub  = nh.subscribe(omega_input_topic, 10, &VisualServoWithWheel::omegaCamCb, this);
+
+    if (statistics_period > 0) {
+        statistics_deadline = PeriodicTimer::now() + static_cast<int64_t>(statistics_period * 1e9);
+        statistics_timer = nh.createWallTimer(ros::WallDuration(statistics_period),
+                                              &VisualServoWithWheel::printStatistics, this);
+    }
+
+    timer.reset(new PeriodicTimer(1 / ctrl_freq));
+    control_thread = std::thread(&VisualServoWithWheel::controlLoop, this);
+}
+
+VisualServoWithWheel::~VisualServoWithWheel()
+{
+    // waits for the callbacks in progress
+    visual_sub.shutdown();
+    omega_sub.shutdown();
+    statistics_timer.stop();
+
+    running = false;
+    control_thread.join();
+}
+
+/**
+ * Publish the linear and angular command to the chassis
+ * @param cmd
+ */
+void
+VisualServoWithWheel::publishCmd(const Eigen::VectorXd &cmd)
+{
+    geometry_msgs::TwistPtr vel_msg(new geometry_msgs::Twist);
+    vel_msg->linear.x  = cmd[0];
+    vel_msg->linear.y  = cmd[1];
+    vel_msg->linear.z  = cmd[2];
+    vel_msg->angular.x = cmd[3];
+    vel_msg->angular.y = cmd[4];
+    vel_msg->angular.z = cmd[5];
+    cmd_pub.publish(vel_msg);
+}
+
+void
+VisualServoWithWheel::publishAngularVelocity(const Eigen::VectorXd &estimated_omega, const ros::Publisher &pub)
+{
+    geometry_msgs::TwistStampedPtr omega_msg(new geometry_msgs::TwistStamped);
+    omega_msg->header.stamp = ros::Time::now();
+    omega_msg->twist.angular.x = estimated_omega[0];
+    omega_msg->twist.angular.y = estimated_omega[1];
+    omega_msg->twist.angular.z = estimated_omega[2];
+    pub.publish(omega_msg);
+}
+
+void
+VisualServoWithWheel::publishDistanceDebug(double z_in, double z_out)
+{
+    geometry_msgs::TwistStampedPtr distance_msg(new geometry_msgs::TwistStamped);
+    distance_msg->header.stamp = ros::Time::now();
+    distance_msg->twist.linear.z = z_in;
+    distance_msg->twist.angular.z = z_out;
+    debug_z_pub.publish(distance_msg);
+}
+
+void
+VisualServoWithWheel::visualFeatureCb(const rm_cv::vertice::ConstPtr &cv_ptr)
+{
+    visual_measurement.receive_ns = PeriodicTimer::now();
+
+    // convert the pixel value to image coordinate value
+    Vector2d input_pixel[n];
+    Vector3d input_pixel_output;
+
+    for (int i = 0; i < n; ++i) {
+        input_pixel[i] << cv_ptr->vertex[i].x, cv_ptr->vertex[i].y;
+        m_camera->liftSphere(input_pixel[i], input_pixel_output);
+        visual_measurement.image_frame.row(i) << input_pixel_output(0), input_pixel_output(1);
+    }
+
+    // every distance sample goes through the low pass filter, as it arrives
+    double pixel_dy_n = 0.5 * ( input_pixel[1](1) - input_pixel[0](1) + input_pixel[3](1) - input_pixel[2](1) );
+
+    double z_raw;
+    if (pixel_dy_n * MAX_DISTANCE > pixel_dy) {
+        z_raw  = target_Z * pixel_dy / pixel_dy_n;
+    }
+    else {
+        z_raw  = target_Z;
+    }
+
+    double z_filt = dr_server.getSnapshot()->FIR_gain * z_low_pass->do_sample(z_raw);
+
+    publishDistanceDebug(z_raw * 1000, z_filt * 1000);
+
+    visual_measurement.z_filt  = z_filt;
+    visual_measurement.error_z = target_Z - z_filt;
+    ++visual_measurement.seq;
+    visual_slot.write(visual_measurement);
+}
+
+void
+VisualServoWithWheel::omegaCamCb(const geometry_msgs::TwistStamped::ConstPtr &omega_ptr)
+{
+    Vector3d input_omega(omega_ptr->twist.angular.x, omega_ptr->twist.angular.y, omega_ptr->twist.angular.z);
+
+    Vector3d input_omega_cam = end_R_cam * input_omega;
+    publishAngularVelocity(input_omega_cam, omega_raw_pub);
+
+    gyro_history.omega[gyro_history.count % GYRO_HISTORY] = input_omega_cam;
+    ++gyro_history.count;
+    gyro_slot.write(gyro_history);
+}
+
+void
+VisualServoWithWheel::controlLoop()
+{
+    if (realtime_priority > 0 && !PeriodicTimer::setRealtimePriority(realtime_priority)) {
+        ROS_WARN("Could not switch the control thread to SCHED_FIFO priority %d, it keeps the scheduling of the process",
+                 realtime_priority);
+    }
+
+    dynamic_reconfigure::SnapshotReader<visual_servo_control::tuningConfig> config(dr_server);
+
+    while (running) {
+        const uint64_t ticks = timer->wait();
+
+        /**
+         * Change setable values in the controller with dynamics configure
+         */
+        config.update();
+        ctl.setKp(config->Kp);
+        ctl.setKd(config->Kd);
+        ctl.setKalmanR(config->Kf_r0);
+        ctl.setKalmanQ(config->Kf_q0);
+
+        /**
+         * Measurements since the previous tick
+         */
+        const VisualMeasurement &visual = visual_slot.read();
+        const bool visual_updated = visual.seq != visual_seq;
+        if (visual_updated) {
+            visual_seq = visual.seq;
+            input_image_frame = visual.image_frame;
+            ctl.setZ(visual.z_filt);
+            error_z = visual.error_z;
+        }
+
+        const GyroHistory &gyro = gyro_slot.read();
+        const bool gyro_updated = gyro.count != gyro_count;
+        if (gyro_updated) {
+            // older samples would leave the delay line of the controller anyway
+            unsigned long fresh = std::min<unsigned long>(gyro.count - gyro_count, GYRO_HISTORY);
+            for (unsigned long k = gyro.count - fresh; k < gyro.count; ++k) {
+                ctl.updateOmega(gyro.omega[k % GYRO_HISTORY]);
+            }
+            gyro_count = gyro.count;
+        }
+
+        /**
+         * finite finite_state machine
+         */
+        switch (finite_state){
+            case fsm::idle:
+                if (visual_updated) finite_state = fsm::once;
+                else                finite_state = fsm::idle;
+                break;
+            case fsm::once:
+                if (visual_updated) finite_state = fsm::multi;
+                else                finite_state = fsm::idle;
+                break;
+            case fsm::multi:
+                if (visual_updated) finite_state = fsm::multi;
+                else                finite_state = fsm::idle;
+                break;
+        }
+
+        if (finite_state == fsm::idle) {
+            ctl.finite_state = 0;
+
+            publishCmd(prev_ctl_val);
+            prev_ctl_val.setZero();
+        }
+        else {
+            ctl.finite_state = finite_state == fsm::once ? 1 : 2;
+
+            ctl.updateFeatures(input_image_frame);
+            VectorXd ctl_val = ctl.control();
+
+            VectorXd ctl_val_rot = cam_R_end * ctl_val;
+            ctl_val_rot(0) += config->Kp_z * error_z;
+
+            publishCmd(ctl_val_rot);
+            prev_ctl_val = ctl_val_rot;
+        }
+
+        addStatistics(timer->tickTime(), PeriodicTimer::now(), ticks, visual_updated ? visual.receive_ns : -1);
+
+        if (finite_state == fsm::multi && gyro_updated) {
+            VectorXd kalman_output = ctl.getKalmanOutput();
+            VectorXd kalman_input  = ctl.getKalmanInput();
+            VectorXd raw_visual_w  = ctl.getRawVisualOmega();
+            VectorXd delay_gyro    = ctl.getDelayedGyro();
+            publishAngularVelocity(kalman_output, kalman_output_pub);
+            publishAngularVelocity(kalman_input, kalman_input_pub);
+            publishAngularVelocity(raw_visual_w, omega_visual_pub);
+            publishAngularVelocity(delay_gyro, delayed_gyro_pub);
+        }
+    }
+}
+
+/**
+ * Record a tick, and hand the samples over to printStatistics once per statistics_period
+ * @param receive_ns time of the visual feature callback the command comes from, -1 if none
+ */
+void
+VisualServoWithWheel::addStatistics(int64_t tick_ns, int64_t command_ns, uint64_t ticks, int64_t receive_ns)
+{
+    if (statistics_period <= 0)
+        return;
+
+    ++statistics.ticks;
+    statistics.missed_ticks += ticks - 1;
+    if (statistics.tick_to_command_count < ControlLoopStatistics::SAMPLES) {
+        statistics.tick_to_command_us[statistics.tick_to_command_count++] = (command_ns - tick_ns) * 1e-3;
+    }
+    if (receive_ns >= 0 && statistics.latency_count < ControlLoopStatistics::SAMPLES) {
+        statistics.latency_us[statistics.latency_count++] = (command_ns - receive_ns) * 1e-3;
+    }
+
+    if (command_ns >= statistics_deadline) {
+        ++statistics.seq;
+        statistics_slot.write(statistics);
+        statistics.tick_to_command_count = 0;
+        statistics.latency_count = 0;
+        statistics.ticks = 0;
+        statistics.missed_ticks = 0;
+        statistics_deadline += static_cast<int64_t>(statistics_period * 1e9);
+    }
+}
+
+void
+VisualServoWithWheel::printStatistics(const ros::WallTimerEvent &event __attribute__((unused)))
+{
+    const ControlLoopStatistics &s = statistics_slot.read();
+    if (s.seq == statistics_seq)
+        return;
+    statistics_seq = s.seq;
+
+    std::vector<double> tick_to_command(s.tick_to_command_us, s.tick_to_command_us + s.tick_to_command_count);
+    std::vector<double> latency(s.latency_us, s.latency_us + s.latency_count);
+    std::sort(tick_to_command.begin(), tick_to_command.end());
+    std::sort(latency.begin(), latency.end());
+
+    if (!tick_to_command.empty()) {
+        size_t k = tick_to_command.size();
+        ROS_INFO("control loop: %lu ticks, %lu missed, tick to command p50 %.1f us, p99 %.1f us, max %.1f us",
+                 s.ticks, s.missed_ticks, tick_to_command[k / 2], tick_to_command[k * 99 / 100], tick_to_command.back());
+    }
+    if (!latency.empty()) {
+        size_t k = latency.size();
+        ROS_INFO("control loop: visual feature to command p50 %.1f us, p99 %.1f us, max %.1f us",
+                 latency[k / 2], latency[k * 99 / 100], latency.back());
+    }
+}
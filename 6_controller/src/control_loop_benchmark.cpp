@@ -0,0 +1,254 @@
+/**
+ * Timing of the control loop of III_visual_servo_with_wheel, without ROS: the single
+ * threaded loop (ros::Rate, then ros::spinOnce serving the callbacks queued, then the
+ * control) against the control thread of VisualServoWithWheel (PeriodicTimer, the
+ * callbacks in their own threads handing over through LatestValue slots).
+ *
+ * The messages and the work of the callbacks and of the control are simulated by busy
+ * waits of the given durations.
+ *
+ * usage: control_loop_benchmark [seconds] [ctrl_freq] [visual_us] [gyro_us] [control_us] [realtime_priority]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "LatestValue.h"
+#include "PeriodicTimer.h"
+
+namespace {
+
+// not a multiple of the control rate: the camera is not synchronised with the control
+// tick, so the arrivals sweep the control period
+const double VISUAL_FREQ = 57.0;
+const double GYRO_FREQ   = 500.0;
+
+enum MessageType { VISUAL = 0, GYRO = 1 };
+
+struct Message {
+    MessageType type;
+    // CLOCK_MONOTONIC time of the arrival, ns
+    int64_t receive_ns;
+};
+
+struct VisualMeasurement {
+    int64_t receive_ns;
+    unsigned long seq;
+};
+
+struct Results {
+    std::vector<double> tick_to_command_us;
+    std::vector<double> latency_us;
+    unsigned long ticks;
+    unsigned long missed_ticks;
+};
+
+struct Options {
+    double seconds;
+    double ctrl_freq;
+    int64_t visual_ns;
+    int64_t gyro_ns;
+    int64_t control_ns;
+    int realtime_priority;
+};
+
+void
+busyWait(int64_t ns)
+{
+    const int64_t end = PeriodicTimer::now() + ns;
+    while (PeriodicTimer::now() < end) {}
+}
+
+/**
+ * Sensor at freq, calling handle(receive_ns) until running is cleared
+ */
+template <typename Handler>
+void
+sensorLoop(double freq, const std::atomic<bool> &running, Handler handle)
+{
+    PeriodicTimer timer(1 / freq);
+    while (running) {
+        timer.wait();
+        handle(PeriodicTimer::now());
+    }
+}
+
+/**
+ * The loop of the former main: the control on the state left by the last spin, the
+ * sleep of ros::Rate, then ros::spinOnce serving the messages queued during the sleep
+ */
+Results
+singleThread(const Options &opt)
+{
+    Results results = Results();
+    std::mutex queue_mutex;
+    std::deque<Message> queue;
+    std::atomic<bool> running(true);
+
+    auto enqueue = [&](MessageType type) {
+        return [&queue_mutex, &queue, type](int64_t receive_ns) {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            queue.push_back(Message{type, receive_ns});
+        };
+    };
+    std::thread visual_thread(sensorLoop<decltype(enqueue(VISUAL))>, VISUAL_FREQ, std::cref(running), enqueue(VISUAL));
+    std::thread gyro_thread(sensorLoop<decltype(enqueue(GYRO))>, GYRO_FREQ, std::cref(running), enqueue(GYRO));
+
+    if (opt.realtime_priority > 0 && !PeriodicTimer::setRealtimePriority(opt.realtime_priority))
+        fprintf(stderr, "SCHED_FIFO not permitted, running with the default policy\n");
+
+    const int64_t period_ns = static_cast<int64_t>(1e9 / opt.ctrl_freq);
+    const int64_t end_ns = PeriodicTimer::now() + static_cast<int64_t>(opt.seconds * 1e9);
+    std::vector<Message> spun;
+    int64_t tick_ns = -1;
+    int64_t visual_receive_ns = -1;
+    bool visual_updated = false;
+    // ros::Rate: the next deadline from the previous one, reset to now if it is overrun
+    int64_t start_ns = PeriodicTimer::now();
+
+    while (PeriodicTimer::now() < end_ns) {
+        busyWait(opt.control_ns);
+        const int64_t command_ns = PeriodicTimer::now();
+        if (tick_ns >= 0) {
+            ++results.ticks;
+            results.tick_to_command_us.push_back((command_ns - tick_ns) * 1e-3);
+            if (visual_updated)
+                results.latency_us.push_back((command_ns - visual_receive_ns) * 1e-3);
+        }
+        visual_updated = false;
+
+        const int64_t expected_ns = start_ns + period_ns;
+        if (PeriodicTimer::now() < expected_ns) {
+            timespec ts;
+            ts.tv_sec  = expected_ns / 1000000000LL;
+            ts.tv_nsec = expected_ns % 1000000000LL;
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+            start_ns = expected_ns;
+        } else {
+            results.missed_ticks += (PeriodicTimer::now() - start_ns) / period_ns - 1;
+            start_ns = PeriodicTimer::now();
+        }
+        tick_ns = start_ns;
+
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            spun.assign(queue.begin(), queue.end());
+            queue.clear();
+        }
+        for (size_t i = 0; i < spun.size(); ++i) {
+            if (spun[i].type == VISUAL) {
+                busyWait(opt.visual_ns);
+                visual_receive_ns = spun[i].receive_ns;
+                visual_updated = true;
+            } else {
+                busyWait(opt.gyro_ns);
+            }
+        }
+    }
+
+    running = false;
+    visual_thread.join();
+    gyro_thread.join();
+    return results;
+}
+
+/**
+ * The structure of VisualServoWithWheel: each callback as its message arrives, the
+ * control woken by a PeriodicTimer on the latest values
+ */
+Results
+controlThread(const Options &opt)
+{
+    Results results = Results();
+    LatestValue<VisualMeasurement> visual_slot(VisualMeasurement{-1, 0});
+    LatestValue<unsigned long> gyro_slot(0);
+    std::atomic<bool> running(true);
+
+    unsigned long visual_seq = 0;
+    auto visual_cb = [&](int64_t receive_ns) {
+        busyWait(opt.visual_ns);
+        visual_slot.write(VisualMeasurement{receive_ns, ++visual_seq});
+    };
+    unsigned long gyro_count = 0;
+    auto gyro_cb = [&](int64_t) {
+        busyWait(opt.gyro_ns);
+        gyro_slot.write(++gyro_count);
+    };
+    std::thread visual_thread(sensorLoop<decltype(visual_cb)>, VISUAL_FREQ, std::cref(running), visual_cb);
+    std::thread gyro_thread(sensorLoop<decltype(gyro_cb)>, GYRO_FREQ, std::cref(running), gyro_cb);
+
+    if (opt.realtime_priority > 0 && !PeriodicTimer::setRealtimePriority(opt.realtime_priority))
+        fprintf(stderr, "SCHED_FIFO not permitted, running with the default policy\n");
+
+    PeriodicTimer timer(1 / opt.ctrl_freq);
+    const int64_t end_ns = PeriodicTimer::now() + static_cast<int64_t>(opt.seconds * 1e9);
+    unsigned long last_visual_seq = 0;
+
+    while (PeriodicTimer::now() < end_ns) {
+        const uint64_t ticks = timer.wait();
+        const VisualMeasurement &visual = visual_slot.read();
+        gyro_slot.read();
+        const bool visual_updated = visual.seq != last_visual_seq;
+        last_visual_seq = visual.seq;
+
+        busyWait(opt.control_ns);
+        const int64_t command_ns = PeriodicTimer::now();
+        ++results.ticks;
+        results.missed_ticks += ticks - 1;
+        results.tick_to_command_us.push_back((command_ns - timer.tickTime()) * 1e-3);
+        if (visual_updated)
+            results.latency_us.push_back((command_ns - visual.receive_ns) * 1e-3);
+    }
+
+    running = false;
+    visual_thread.join();
+    gyro_thread.join();
+    return results;
+}
+
+void
+printPercentiles(const char *name, std::vector<double> samples)
+{
+    if (samples.empty()) {
+        printf("  %-26s no samples\n", name);
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    const size_t k = samples.size();
+    printf("  %-26s p50 %8.1f us  p99 %8.1f us  max %8.1f us\n",
+           name, samples[k / 2], samples[k * 99 / 100], samples.back());
+}
+
+void
+printResults(const char *name, const Results &results)
+{
+    printf("%s: %lu ticks, %lu missed\n", name, results.ticks, results.missed_ticks);
+    printPercentiles("tick to command", results.tick_to_command_us);
+    printPercentiles("visual feature to command", results.latency_us);
+}
+}
+
+int main(int argc, char **argv) {
+    Options opt;
+    opt.seconds           = argc > 1 ? atof(argv[1]) : 10.0;
+    opt.ctrl_freq         = argc > 2 ? atof(argv[2]) : 30.0;
+    opt.visual_ns         = static_cast<int64_t>((argc > 3 ? atof(argv[3]) : 300.0) * 1e3);
+    opt.gyro_ns           = static_cast<int64_t>((argc > 4 ? atof(argv[4]) : 20.0) * 1e3);
+    opt.control_ns        = static_cast<int64_t>((argc > 5 ? atof(argv[5]) : 150.0) * 1e3);
+    opt.realtime_priority = argc > 6 ? atoi(argv[6]) : 0;
+
+    printf("%.0f s at %.0f Hz, visual feature %.0f Hz / %.0f us, gyro %.0f Hz / %.0f us, control %.0f us\n",
+           opt.seconds, opt.ctrl_freq, VISUAL_FREQ, opt.visual_ns * 1e-3, GYRO_FREQ, opt.gyro_ns * 1e-3,
+           opt.control_ns * 1e-3);
+
+    printResults("single thread (ros::Rate + spinOnce)", singleThread(opt));
+    printResults("control thread (PeriodicTimer + slots)", controlThread(opt));
+    return 0;
+}
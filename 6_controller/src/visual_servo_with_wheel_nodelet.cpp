@@ -0,0 +1,24 @@
+#include "VisualServoWithWheel.h"
+#include <boost/scoped_ptr.hpp>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+namespace visual_servo_control
+{
+
+// the visual servo in the nodelet manager of the detection and of can_transmit, so that
+// the vertices and the commands are passed by pointer instead of serialized
+class VisualServoWithWheelNodelet : public nodelet::Nodelet
+{
+    private:
+    virtual void onInit( )
+    {
+        // multi threaded queue: the gyro is not delayed by a visual feature callback
+        visual_servo.reset( new VisualServoWithWheel( getMTPrivateNodeHandle( ) ) );
+    }
+
+    boost::scoped_ptr< VisualServoWithWheel > visual_servo;
+};
+}
+
+PLUGINLIB_EXPORT_CLASS( visual_servo_control::VisualServoWithWheelNodelet, nodelet::Nodelet )
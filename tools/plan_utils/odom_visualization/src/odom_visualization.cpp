@@ -47,6 +47,67 @@ visualization_msgs::Marker meshROS;
 sensor_msgs::Range         heightROS;
 string _frame_id;
 
+double path_period, traj_period;
+bool   traj_incremental = false;
+int    traj_max_segments;
+unsigned int trajSegments = 0;
+
+// Trail of the last poses with a fixed capacity: the oldest pose is overwritten
+// when full or dropped once it falls out of the time window, and poses closer
+// than min_distance to the newest one are skipped.
+class PoseRing
+{
+public:
+  void init(int capacity, double window, double min_distance)
+  {
+    buffer.resize(capacity > 0 ? capacity : 1);
+    head = size = 0;
+    time_window = window;
+    min_dist = min_distance;
+  }
+
+  bool push(const geometry_msgs::PoseStamped& pose)
+  {
+    if (size > 0)
+    {
+      const geometry_msgs::Point& last = buffer[(head + size - 1) % buffer.size()].pose.position;
+      double dx = pose.pose.position.x - last.x;
+      double dy = pose.pose.position.y - last.y;
+      double dz = pose.pose.position.z - last.z;
+      if (dx * dx + dy * dy + dz * dz < min_dist * min_dist)
+        return false;
+    }
+    if (size == buffer.size())
+    {
+      head = (head + 1) % buffer.size();
+      size--;
+    }
+    buffer[(head + size) % buffer.size()] = pose;
+    size++;
+    while (time_window > 0 && size > 1 &&
+           (pose.header.stamp - buffer[head].header.stamp).toSec() > time_window)
+    {
+      head = (head + 1) % buffer.size();
+      size--;
+    }
+    return true;
+  }
+
+  void copyTo(vector<geometry_msgs::PoseStamped>& poses) const
+  {
+    poses.resize(size);
+    for (size_t i = 0; i < size; i++)
+      poses[i] = buffer[(head + i) % buffer.size()];
+  }
+
+private:
+  vector<geometry_msgs::PoseStamped> buffer;
+  size_t head, size;
+  double time_window, min_dist;
+};
+
+PoseRing pathRing;
+
 void odom_callback(const nav_msgs::Odometry::ConstPtr& msg)
 {
   if (msg->header.frame_id == string("null"))
@@ -122,12 +183,15 @@ void odom_callback(const nav_msgs::Odometry::ConstPtr& msg)
 
   // Path
   static ros::Time prevt = msg->header.stamp;
-  if ((msg->header.stamp - prevt).toSec() > 0.1)
+  if ((msg->header.stamp - prevt).toSec() > path_period)
   {
     prevt = msg->header.stamp;
-    pathROS.header = poseROS.header;
-    pathROS.poses.push_back(poseROS);
-    pathPub.publish(pathROS);
+    if (pathRing.push(poseROS))
+    {
+      pathROS.header = poseROS.header;
+      pathRing.copyTo(pathROS.poses);
+      pathPub.publish(pathROS);
+    }
   }
 
   // Covariance color
@@ -244,8 +308,21 @@ void odom_callback(const nav_msgs::Odometry::ConstPtr& msg)
   static colvec ppose = pose;
   static ros::Time pt = msg->header.stamp;
   ros::Time t = msg->header.stamp;
-  if ((t - pt).toSec() > 0.5)
+  if ((t - pt).toSec() > traj_period)
   {
+    if (traj_incremental)
+    {
+      // one marker per segment, ids wrap so RViz replaces the oldest ones
+      trajROS.id = trajSegments % traj_max_segments;
+      trajROS.points.clear();
+      trajROS.colors.clear();
+    }
+    else if (trajROS.points.size() >= 2 * (size_t)traj_max_segments)
+    {
+      trajROS.points.erase(trajROS.points.begin(), trajROS.points.begin() + 2);
+      trajROS.colors.erase(trajROS.colors.begin(), trajROS.colors.begin() + 2);
+    }
+    trajSegments++;
     trajROS.header.frame_id = string("/world");
     trajROS.header.stamp    = ros::Time::now();
     trajROS.ns              = string("trajectory");
@@ -450,8 +527,23 @@ int main(int argc, char** argv)
   n.param("covariance_scale",    cov_scale,  100.0);
   n.param("covariance_position", cov_pos,    false);    
   n.param("covariance_velocity", cov_vel,    false);    
-  n.param("covariance_color",    cov_color,  false);    
-  
+  n.param("covariance_color",    cov_color,  false);
+
+  // path and trajectory stay bounded however long the node runs
+  int    path_max_poses;
+  double path_time_window, path_min_distance;
+  n.param("path/period",                 path_period,       0.1);
+  n.param("path/max_poses",              path_max_poses,    3000);
+  n.param("path/time_window",            path_time_window,  0.0);
+  n.param("path/min_distance",           path_min_distance, 0.0);
+  n.param("trajectory/period",           traj_period,       0.5);
+  n.param("trajectory/max_segments",     traj_max_segments, 1000);
+  n.param("trajectory/incremental",      traj_incremental,  false);
+  pathRing.init(path_max_poses, path_time_window, path_min_distance);
+  if (traj_max_segments < 1)
+    traj_max_segments = 1;
+  pathROS.poses.reserve(path_max_poses > 0 ? path_max_poses : 1);
+
   ros::Subscriber sub_odom = n.subscribe("odom", 100,  odom_callback);
   ros::Subscriber sub_cmd  = n.subscribe("cmd",  100,  cmd_callback);
   posePub   = n.advertise<geometry_msgs::PoseStamped>("pose",                100, true);
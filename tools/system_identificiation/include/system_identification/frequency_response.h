@@ -0,0 +1,37 @@
+/**
+ * Frequency response of one sine sweep step, estimated from the sampled
+ * command and measured response (empirical transfer function estimate).
+ */
+
+#ifndef SYSTEM_IDENTIFICATION_FREQUENCY_RESPONSE_H
+#define SYSTEM_IDENTIFICATION_FREQUENCY_RESPONSE_H
+
+#include <complex>
+#include <cstddef>
+
+namespace system_identification {
+
+struct BodePoint {
+    double frequency;   // [Hz]
+    double magnitude;   // |G|, the dB value is 20 * log10(magnitude)
+    double phase;       // arg G [rad]
+    double coherence;   // |Suy|^2 / (Suu * Syy), 1 for a noise-free linear response
+    int segments;
+};
+
+/**
+ * The step is cut into segments of a whole number of excitation periods; each
+ * segment is Hann windowed and transformed at the excitation frequency only,
+ * which is the single FFT bin the sine excites, in O(length). Averaging the
+ * auto and cross spectra over the segments gives G = Suy / Suu and the coherence.
+ *
+ * u, y:      command and response sampled at sample_rate, same length
+ * frequency: excitation frequency [Hz]
+ * segment_periods: excitation periods per segment, raised so a segment has at least 32 samples
+ */
+BodePoint estimateFrequencyResponse(const double *u, const double *y, size_t length,
+                                    double sample_rate, double frequency, int segment_periods);
+
+}
+
+#endif
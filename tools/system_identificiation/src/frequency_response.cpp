@@ -0,0 +1,62 @@
+#include "system_identification/frequency_response.h"
+#include <algorithm>
+#include <cmath>
+
+namespace system_identification {
+
+BodePoint estimateFrequencyResponse(const double *u, const double *y, size_t length,
+                                    double sample_rate, double frequency, int segment_periods)
+{
+    BodePoint point;
+    point.frequency = frequency;
+    point.magnitude = 0;
+    point.phase = 0;
+    point.coherence = 0;
+    point.segments = 0;
+
+    // at high frequencies a few periods are too short for the window, keep at least 32 samples per segment
+    int periods = std::max(segment_periods, (int) std::ceil(32.0 * frequency / sample_rate));
+    size_t segment = std::max<size_t>((size_t) std::lround(std::max(periods, 1) * sample_rate / frequency), 2);
+
+    double suu = 0, syy = 0;
+    std::complex<double> suy(0, 0);
+    double omega = 2 * M_PI * frequency / sample_rate;
+    // e^{-j omega n} by recurrence, renormalised once per segment
+    std::complex<double> step(std::cos(omega), -std::sin(omega));
+
+    for (size_t start = 0; start + segment <= length; start += segment) {
+        std::complex<double> U(0, 0), Y(0, 0), phasor(1, 0);
+        double mean_u = 0, mean_y = 0;
+
+        for (size_t n = 0; n < segment; n++) {
+            mean_u += u[start + n];
+            mean_y += y[start + n];
+        }
+        mean_u /= segment;
+        mean_y /= segment;
+
+        for (size_t n = 0; n < segment; n++) {
+            double w = 0.5 - 0.5 * std::cos(2 * M_PI * n / segment);
+            U += (w * (u[start + n] - mean_u)) * phasor;
+            Y += (w * (y[start + n] - mean_y)) * phasor;
+            phasor *= step;
+        }
+
+        suu += std::norm(U);
+        syy += std::norm(Y);
+        suy += std::conj(U) * Y;
+        point.segments++;
+    }
+
+    if (point.segments == 0 || suu <= 0)
+        return point;
+
+    std::complex<double> G = suy / suu;
+    point.magnitude = std::abs(G);
+    point.phase = std::arg(G);
+    point.coherence = (syy > 0) ? std::norm(suy) / (suu * syy) : 0;
+
+    return point;
+}
+
+}
@@ -1,100 +1,227 @@
 /**
  * Beck Pang, system identification node, hardcode
+ *
+ * The log-spaced sine sweep is generated by a SCHED_FIFO thread on an absolute
+ * clock; every tick records the command and the latest gimbal rate from the CAN
+ * feedback into buffers sized for the whole sweep. When a frequency step ends,
+ * the main thread estimates its frequency response and appends the Bode point
+ * to bode_file and to the bode topic.
  */
 
 #include <ros/ros.h>
 #include <geometry_msgs/Twist.h>
+#include <geometry_msgs/TwistStamped.h>
+#include <geometry_msgs/Vector3Stamped.h>
+#include <system_identification/frequency_response.h>
+#include <atomic>
 #include <cmath>
-#include <chrono>
+#include <cstdio>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <thread>
+#include <time.h>
+#include <vector>
 
 using namespace std;
-using namespace std::chrono;
+using namespace system_identification;
 
 ros::Publisher cmd_vel_publisher;
+ros::Publisher bode_publisher;
 
 string cmd_topic;
+string omega_topic;
+string bode_file;
 
 /**
  * create excitement signal with N frequency, P period in each frequency
  * for the 2017/12/06, N = 30, and the excitation signal are generated by matlab
  */
-volatile double stop_time_table[31];
-
 int P = 5;
 int N = 30;
 double gain;
 int YAW_or_PITCH = 0;
 
+double freq_min, freq_max, sample_rate;
+int priority, settle_periods, segment_periods;
+
+vector<double> freq_log_space;
+vector<size_t> step_begin;          // first sample of each step, step_begin[N] is the sweep length
+vector<double> input_buffer;
+vector<double> output_buffer;
+
+atomic<double> measured_omega(0.0);
+atomic<int> steps_done(0);
+atomic<bool> running(true);
+atomic<long> max_lateness_ns(0);
+
+void omegaCallback(const geometry_msgs::TwistStamped::ConstPtr &msg)
+{
+    measured_omega.store(YAW_or_PITCH == 1 ? msg->twist.angular.y : msg->twist.angular.z, memory_order_relaxed);
+}
+
+void publishCommand(double excit_cmd)
+{
+    geometry_msgs::Twist cmd_vel;
+    switch( YAW_or_PITCH ) {
+        case 0: cmd_vel.angular.z = excit_cmd; break;
+        case 1: cmd_vel.angular.y = excit_cmd; break;
+        default:cmd_vel.angular.y = 0;
+                cmd_vel.angular.z = 0; break;
+    }
+    cmd_vel_publisher.publish(cmd_vel);
+}
+
+void excitationThread()
+{
+    sched_param param;
+    param.sched_priority = priority;
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+        ROS_WARN("system identification: cannot switch to SCHED_FIFO, the excitation timing is best effort");
+
+    const long period_ns = (long) (1e9 / sample_rate);
+    const size_t length = step_begin[N];
+    timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    int n = 0;
+    size_t k = 0;
+    for (; k < length && running.load(memory_order_relaxed); k++) {
+        next.tv_nsec += period_ns;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long lateness = (now.tv_sec - next.tv_sec) * 1000000000L + (now.tv_nsec - next.tv_nsec);
+        if (lateness > max_lateness_ns.load(memory_order_relaxed))
+            max_lateness_ns.store(lateness, memory_order_relaxed);
+
+        while (k >= step_begin[n + 1]) {
+            n++;
+            steps_done.store(n, memory_order_release);
+        }
+
+        double period_time = (k - step_begin[n]) / sample_rate;
+        double excit_cmd = gain * sin(2 * M_PI * freq_log_space[n] * period_time);
+
+        // the response sampled here is the latest CAN feedback, one tick behind the command
+        input_buffer[k] = excit_cmd;
+        output_buffer[k] = measured_omega.load(memory_order_relaxed);
+
+        publishCommand(excit_cmd);
+    }
+
+    if (k == length)
+        steps_done.store(N, memory_order_release);
+    publishCommand(0);
+}
+
+void analyseStep(int n, FILE *file)
+{
+    // skip the transient at the start of each step
+    size_t skip = (size_t) lround(settle_periods * sample_rate / freq_log_space[n]);
+    size_t begin = min(step_begin[n] + skip, step_begin[n + 1]);
+
+    BodePoint point = estimateFrequencyResponse(&input_buffer[begin], &output_buffer[begin],
+                                                step_begin[n + 1] - begin, sample_rate,
+                                                freq_log_space[n], segment_periods);
+
+    double magnitude_db = 20 * log10(max(point.magnitude, 1e-12));
+    double phase_deg = point.phase * 180.0 / M_PI;
+
+    if (file) {
+        fprintf(file, "%.6f,%.4f,%.4f,%.4f,%d\n", point.frequency, magnitude_db, phase_deg,
+                point.coherence, point.segments);
+        fflush(file);
+    }
+
+    geometry_msgs::Vector3Stamped bode;
+    bode.header.stamp = ros::Time::now();
+    bode.vector.x = point.frequency;
+    bode.vector.y = magnitude_db;
+    bode.vector.z = phase_deg;
+    bode_publisher.publish(bode);
+
+    ROS_INFO("step %2d: %8.3f Hz  %7.2f dB  %8.2f deg  coherence %.3f",
+             n, point.frequency, magnitude_db, phase_deg, point.coherence);
+}
+
 int main(int argc, char* argv[]){
     ros::init(argc,argv,"system_identification_node");
     ros::NodeHandle nh("~");
 
     nh.param("cmd_topic", cmd_topic, string("/system_iden_cmd_vel"));
+    nh.param("omega_topic", omega_topic, string("/can_receive_1/end_effector_omega"));
+    nh.param("bode_file", bode_file, string("system_iden_bode.csv"));
     nh.param("gain", gain, 0.1);
     nh.param("Period", P, 5);
+    nh.param("N", N, 30);
+    nh.param("freq_min", freq_min, 1.0);
+    nh.param("freq_max", freq_max, 500.0);
+    nh.param("sample_rate", sample_rate, 1000.0);
+    nh.param("priority", priority, 80);
+    nh.param("settle_periods", settle_periods, 1);
+    nh.param("segment_periods", segment_periods, 1);
     nh.param("YAW_or_PITCH", YAW_or_PITCH, 0);
 
-	cmd_vel_publisher = nh.advertise<geometry_msgs::Twist>(cmd_topic, 10);
-
-    ros::Duration(1).sleep();
+    // sweeping frequency from freq_min to freq_max in log space, P periods each
+    freq_log_space.resize(N);
+    step_begin.resize(N + 1);
+    step_begin[0] = 0;
+    for (int i = 0; i < N; ++i) {
+        freq_log_space[i] = (N > 1) ? freq_min * pow(freq_max / freq_min, (double) i / (N - 1)) : freq_min;
+        step_begin[i + 1] = step_begin[i] + (size_t) lround(P * sample_rate / freq_log_space[i]);
+    }
 
-    // 1000 Hz command value
-    ros::Rate r(1000);
+    input_buffer.assign(step_begin[N], 0.0);
+    output_buffer.assign(step_begin[N], 0.0);
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        ROS_WARN("system identification: cannot lock memory, page faults may delay the excitation");
 
-    int i = 0;
-    int n = 0;
+	cmd_vel_publisher = nh.advertise<geometry_msgs::Twist>(cmd_topic, 10);
+    bode_publisher = nh.advertise<geometry_msgs::Vector3Stamped>("bode", 100);
+    ros::Subscriber omega_subscriber = nh.subscribe(omega_topic, 100, omegaCallback,
+                                                    ros::TransportHints().tcpNoDelay());
 
-    // Hardcoded sweeping frequency from 1Hz to 500Hz in log space
-    double freq_log_space[30] = {1.0f,	1.23899037094209f,	1.53509713928722f,	1.90197057403762f,	    \
-    2.35652322704781f,	2.91970958721362f,	3.61749206450498f,	4.48203783488109f,	5.55320171961581f,  \
-    6.88036345850305f,	8.52470407366710f,	10.5620262624044f,	13.0862488367565f,	16.2137363004934f,  \
-    20.0886631533056f,	24.8896602120448f,	30.8380493387440f,	38.2080461893409f,	47.3394013211040f,	\
-    58.6530624030112f,	72.6705795435965f,	90.0381483052973f,	111.556398767719f,	138.217303890180f,	\
-    171.249908617510f,	212.176987801808f,	262.885244821938f,	325.712286997135f,	403.554387286977f,	500.0f};
+    FILE *file = fopen(bode_file.c_str(), "w");
+    if (file)
+        fprintf(file, "frequency_hz,magnitude_db,phase_deg,coherence,segments\n");
+    else
+        ROS_WARN("system identification: cannot open %s", bode_file.c_str());
 
-    // convert the frequency to build the stop time
-    stop_time_table[0] = P * (1 / freq_log_space[0]);
+    ros::AsyncSpinner spinner(1);
+    spinner.start();
 
-    for (int i = 0; i < N; ++i) {
-        stop_time_table[i] = stop_time_table[i-1] + P * (1 / freq_log_space[i]);
-    }
+    ros::Duration(1).sleep();
+    ROS_INFO("system identification: %d steps, %.1f s sweep", N, step_begin[N] / sample_rate);
 
-    chrono::steady_clock::time_point start_time = chrono::steady_clock::now();
+    thread excitation(excitationThread);
 
-    while (ros::ok())
-    {
-        chrono::steady_clock::time_point cur_time_global   = chrono::steady_clock::now();
-        double cur_time = chrono::duration_cast<chrono::duration<double>>(cur_time_global - start_time).count();
+    int analysed = 0;
+    while (analysed < N) {
+        if (!ros::ok())
+            running.store(false);
 
-        if (n < N) {
-            if(cur_time > stop_time_table[n]) {
-                n++;
-            }
+        int done = steps_done.load(memory_order_acquire);
+        if (done == analysed) {
+            if (!running.load())
+                break;
+            ros::WallDuration(0.01).sleep();
+            continue;
+        }
 
-            double period_time = cur_time - stop_time_table[n - 1];
-            double frequency = freq_log_space[n];
-            double excit_cmd = gain * sin(2 * M_PI * frequency * period_time);
+        for (; analysed < done; analysed++)
+            analyseStep(analysed, file);
+    }
 
-            // publish the message
-            geometry_msgs::Twist cmd_vel;
-            switch( YAW_or_PITCH ) {
-                case 0: cmd_vel.angular.z = excit_cmd; break;
-                case 1: cmd_vel.angular.y = excit_cmd; break;
-                default:cmd_vel.angular.y = 0;
-                        cmd_vel.angular.z = 0; break;
-            }
+    excitation.join();
+    ROS_INFO("system identification: finished, worst tick lateness %.1f us", max_lateness_ns.load() * 1e-3);
 
-            cmd_vel_publisher.publish(cmd_vel);
-        }
-        else
-        {
-            // publish the message
-            geometry_msgs::Twist cmd_vel;
-            cmd_vel.angular.z = 0;
-            cmd_vel_publisher.publish(cmd_vel);
-        }
+    if (file)
+        fclose(file);
 
-        r.sleep();
-        ros::spinOnce();
-    }
+    return 0;
 }